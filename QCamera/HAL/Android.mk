@@ -1,3 +1,4 @@
 LOCAL_PATH:= $(call my-dir)
 include $(LOCAL_PATH)/core/Android.mk
+include $(LOCAL_PATH)/usbcamcore/test/Android.mk
 #include $(LOCAL_PATH)/test/Android.mk
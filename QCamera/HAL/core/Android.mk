@@ -81,7 +81,8 @@ LOCAL_HAL_FILES := \
         src/QCameraStream.cpp\
         ../usbcamcore/src/QualcommUsbCamera.cpp\
         ../usbcamcore/src/QCameraMjpegDecode.cpp\
-        ../usbcamcore/src/QCameraUsbParm.cpp
+        ../usbcamcore/src/QCameraUsbParm.cpp\
+        ../usbcamcore/src/QCameraUsbColorConv.cpp
 
 LOCAL_HAL_WRAPPER_FILES := ../wrapper/QualcommCamera.cpp
 
@@ -0,0 +1,88 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __QCAMERA_USB_COLOR_CONV_H
+#define __QCAMERA_USB_COLOR_CONV_H
+
+#include <stdint.h>
+
+/* Output layouts produced from a packed YUYV (YUV 4:2:2) capture frame.   */
+/* All outputs are 4:2:0 with the luma plane first, tightly packed.        */
+typedef enum {
+    USBCAM_CONV_NV12,   /* Y plane, interleaved CbCr plane                */
+    USBCAM_CONV_NV21,   /* Y plane, interleaved CrCb plane                */
+    USBCAM_CONV_I420,   /* Y plane, Cb plane, Cr plane                    */
+} usbcam_conv_fmt_t;
+
+/******************************************************************************
+ * Function: usbcam_convert_yuyv
+ * Description: Converts a packed YUYV frame to a 4:2:0 layout using the
+ *              vector backend built for this target. Chroma is taken from
+ *              the even rows, matching the original scalar converter.
+ *
+ * Input parameters:
+ *   in_buf              - YUYV input, wd * 2 bytes per row
+ *   out_buf             - output buffer of at least wd * ht * 3 / 2 bytes,
+ *                         must not overlap in_buf
+ *   wd, ht              - frame dimensions, both must be even
+ *   fmt                 - output layout
+ *
+ * Return values:
+ *      0   Success
+ *      -1  Error
+ * Notes: none
+ *****************************************************************************/
+int usbcam_convert_yuyv(const uint8_t *in_buf, uint8_t *out_buf,
+                        int wd, int ht, usbcam_conv_fmt_t fmt);
+
+/******************************************************************************
+ * Function: usbcam_convert_yuyv_scalar
+ * Description: Portable reference implementation of usbcam_convert_yuyv.
+ *
+ * Input parameters: same as usbcam_convert_yuyv
+ *
+ * Return values:
+ *      0   Success
+ *      -1  Error
+ * Notes: none
+ *****************************************************************************/
+int usbcam_convert_yuyv_scalar(const uint8_t *in_buf, uint8_t *out_buf,
+                               int wd, int ht, usbcam_conv_fmt_t fmt);
+
+/******************************************************************************
+ * Function: usbcam_convert_backend
+ * Description: Name of the backend picked by usbcam_convert_yuyv
+ *
+ * Input parameters: none
+ *
+ * Return values: "neon", "sse2" or "scalar"
+ * Notes: none
+ *****************************************************************************/
+const char *usbcam_convert_backend(void);
+
+#endif /* __QCAMERA_USB_COLOR_CONV_H */
@@ -0,0 +1,372 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//#define ALOG_NDEBUG 0
+#define ALOG_NIDEBUG 0
+#define LOG_TAG "QCameraUsbColorConv"
+#include <utils/Log.h>
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define USBCAM_CONV_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define USBCAM_CONV_SSE2
+#endif
+
+#include "QCameraUsbColorConv.h"
+
+/* A YUYV row holds two pixels in every four bytes: Y0 U Y1 V. Each        */
+/* backend provides a luma-only row kernel, used for odd rows, and a       */
+/* luma+chroma row kernel, used for even rows. Vector kernels hand the     */
+/* remainder of a row that does not fill a full vector to the scalar ones. */
+
+/******************************************************************************
+ * Function: luma_row_scalar
+ * Description: Extracts luma of pixels [x, wd) from a YUYV row
+ *
+ * Input parameters:
+ *   in                  - YUYV row
+ *   y                   - luma row
+ *   x                   - first pixel to convert, even
+ *   wd                  - row width in pixels
+ *
+ * Return values: none
+ * Notes: none
+ *****************************************************************************/
+static void luma_row_scalar(const uint8_t *in, uint8_t *y, int x, int wd)
+{
+    const uint8_t *src = in + 2 * x;
+    uint8_t *dst = y + x;
+    uint8_t *end = y + wd;
+
+    while (dst < end) {
+        dst[0] = src[0];
+        dst[1] = src[2];
+        dst += 2;
+        src += 4;
+    }
+}
+
+/******************************************************************************
+ * Function: luma_chroma_row_scalar
+ * Description: Extracts luma and chroma of pixels [x, wd) from a YUYV row
+ *
+ * Input parameters:
+ *   in                  - YUYV row
+ *   y                   - luma row
+ *   c0                  - interleaved chroma row (NV12/NV21) or Cb row (I420)
+ *   c1                  - Cr row (I420 only)
+ *   x                   - first pixel to convert, even
+ *   wd                  - row width in pixels
+ *   fmt                 - output layout
+ *
+ * Return values: none
+ * Notes: none
+ *****************************************************************************/
+static void luma_chroma_row_scalar(const uint8_t *in, uint8_t *y,
+    uint8_t *c0, uint8_t *c1, int x, int wd, usbcam_conv_fmt_t fmt)
+{
+    const uint8_t *src = in + 2 * x;
+    uint8_t *dst = y + x;
+    uint8_t *end = y + wd;
+
+    switch (fmt) {
+    case USBCAM_CONV_NV12:
+        c0 += x;
+        while (dst < end) {
+            dst[0] = src[0];
+            dst[1] = src[2];
+            c0[0] = src[1];
+            c0[1] = src[3];
+            dst += 2;
+            c0 += 2;
+            src += 4;
+        }
+        break;
+    case USBCAM_CONV_NV21:
+        c0 += x;
+        while (dst < end) {
+            dst[0] = src[0];
+            dst[1] = src[2];
+            c0[0] = src[3];
+            c0[1] = src[1];
+            dst += 2;
+            c0 += 2;
+            src += 4;
+        }
+        break;
+    case USBCAM_CONV_I420:
+        c0 += x / 2;
+        c1 += x / 2;
+        while (dst < end) {
+            dst[0] = src[0];
+            dst[1] = src[2];
+            *c0++ = src[1];
+            *c1++ = src[3];
+            dst += 2;
+            src += 4;
+        }
+        break;
+    }
+}
+
+#if defined(USBCAM_CONV_NEON)
+/******************************************************************************
+ * Function: luma_row_neon
+ * Description: NEON version of luma_row_scalar, 16 pixels per iteration
+ *****************************************************************************/
+static void luma_row_neon(const uint8_t *in, uint8_t *y, int wd)
+{
+    int x = 0;
+
+    for (; x + 16 <= wd; x += 16) {
+        uint8x16x2_t yuyv = vld2q_u8(in + 2 * x);
+        vst1q_u8(y + x, yuyv.val[0]);
+    }
+    luma_row_scalar(in, y, x, wd);
+}
+
+/******************************************************************************
+ * Function: luma_chroma_row_neon
+ * Description: NEON version of luma_chroma_row_scalar, 32 pixels per
+ *              iteration. vld4 splits the row into Y0, U, Y1 and V lanes.
+ *****************************************************************************/
+static void luma_chroma_row_neon(const uint8_t *in, uint8_t *y,
+    uint8_t *c0, uint8_t *c1, int wd, usbcam_conv_fmt_t fmt)
+{
+    int x = 0;
+
+    for (; x + 32 <= wd; x += 32) {
+        uint8x16x4_t yuyv = vld4q_u8(in + 2 * x);
+        uint8x16x2_t luma;
+        uint8x16x2_t chroma;
+
+        luma.val[0] = yuyv.val[0];
+        luma.val[1] = yuyv.val[2];
+        vst2q_u8(y + x, luma);
+
+        switch (fmt) {
+        case USBCAM_CONV_NV12:
+            chroma.val[0] = yuyv.val[1];
+            chroma.val[1] = yuyv.val[3];
+            vst2q_u8(c0 + x, chroma);
+            break;
+        case USBCAM_CONV_NV21:
+            chroma.val[0] = yuyv.val[3];
+            chroma.val[1] = yuyv.val[1];
+            vst2q_u8(c0 + x, chroma);
+            break;
+        case USBCAM_CONV_I420:
+            vst1q_u8(c0 + x / 2, yuyv.val[1]);
+            vst1q_u8(c1 + x / 2, yuyv.val[3]);
+            break;
+        }
+    }
+    luma_chroma_row_scalar(in, y, c0, c1, x, wd, fmt);
+}
+#endif
+
+#if defined(USBCAM_CONV_SSE2)
+/******************************************************************************
+ * Function: luma_row_sse2
+ * Description: SSE2 version of luma_row_scalar, 16 pixels per iteration
+ *****************************************************************************/
+static void luma_row_sse2(const uint8_t *in, uint8_t *y, int wd)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    int x = 0;
+
+    for (; x + 16 <= wd; x += 16) {
+        const __m128i *src = (const __m128i *)(in + 2 * x);
+        __m128i a = _mm_loadu_si128(src);
+        __m128i b = _mm_loadu_si128(src + 1);
+        _mm_storeu_si128((__m128i *)(y + x),
+            _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+    }
+    luma_row_scalar(in, y, x, wd);
+}
+
+/******************************************************************************
+ * Function: luma_chroma_row_sse2
+ * Description: SSE2 version of luma_chroma_row_scalar, 32 pixels per
+ *              iteration. Luma is the low byte of every 16-bit word and
+ *              chroma the high byte, packed back down with packus.
+ *****************************************************************************/
+static void luma_chroma_row_sse2(const uint8_t *in, uint8_t *y,
+    uint8_t *c0, uint8_t *c1, int wd, usbcam_conv_fmt_t fmt)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    int x = 0;
+
+    for (; x + 32 <= wd; x += 32) {
+        const __m128i *src = (const __m128i *)(in + 2 * x);
+        __m128i a = _mm_loadu_si128(src);
+        __m128i b = _mm_loadu_si128(src + 1);
+        __m128i c = _mm_loadu_si128(src + 2);
+        __m128i d = _mm_loadu_si128(src + 3);
+        /* CbCr pairs of pixels x..x+15 and x+16..x+31 */
+        __m128i uv0 = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+        __m128i uv1 = _mm_packus_epi16(_mm_srli_epi16(c, 8), _mm_srli_epi16(d, 8));
+
+        _mm_storeu_si128((__m128i *)(y + x),
+            _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+        _mm_storeu_si128((__m128i *)(y + x + 16),
+            _mm_packus_epi16(_mm_and_si128(c, mask), _mm_and_si128(d, mask)));
+
+        switch (fmt) {
+        case USBCAM_CONV_NV12:
+            _mm_storeu_si128((__m128i *)(c0 + x), uv0);
+            _mm_storeu_si128((__m128i *)(c0 + x + 16), uv1);
+            break;
+        case USBCAM_CONV_NV21:
+            uv0 = _mm_or_si128(_mm_slli_epi16(uv0, 8), _mm_srli_epi16(uv0, 8));
+            uv1 = _mm_or_si128(_mm_slli_epi16(uv1, 8), _mm_srli_epi16(uv1, 8));
+            _mm_storeu_si128((__m128i *)(c0 + x), uv0);
+            _mm_storeu_si128((__m128i *)(c0 + x + 16), uv1);
+            break;
+        case USBCAM_CONV_I420:
+            _mm_storeu_si128((__m128i *)(c0 + x / 2),
+                _mm_packus_epi16(_mm_and_si128(uv0, mask), _mm_and_si128(uv1, mask)));
+            _mm_storeu_si128((__m128i *)(c1 + x / 2),
+                _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8)));
+            break;
+        }
+    }
+    luma_chroma_row_scalar(in, y, c0, c1, x, wd, fmt);
+}
+#endif
+
+/******************************************************************************
+ * Function: luma_row_scalar_full / luma_chroma_row_scalar_full
+ * Description: Whole-row adapters of the scalar kernels
+ *****************************************************************************/
+static void luma_row_scalar_full(const uint8_t *in, uint8_t *y, int wd)
+{
+    luma_row_scalar(in, y, 0, wd);
+}
+
+static void luma_chroma_row_scalar_full(const uint8_t *in, uint8_t *y,
+    uint8_t *c0, uint8_t *c1, int wd, usbcam_conv_fmt_t fmt)
+{
+    luma_chroma_row_scalar(in, y, c0, c1, 0, wd, fmt);
+}
+
+typedef void (*luma_row_fn_t)(const uint8_t *in, uint8_t *y, int wd);
+typedef void (*luma_chroma_row_fn_t)(const uint8_t *in, uint8_t *y,
+    uint8_t *c0, uint8_t *c1, int wd, usbcam_conv_fmt_t fmt);
+
+/******************************************************************************
+ * Function: convert_yuyv
+ * Description: Walks the frame two rows at a time and runs the given row
+ *              kernels on it
+ *
+ * Input parameters:
+ *   in_buf, out_buf, wd, ht, fmt - see usbcam_convert_yuyv
+ *   luma_row            - luma-only row kernel
+ *   luma_chroma_row     - luma+chroma row kernel
+ *
+ * Return values:
+ *      0   Success
+ *      -1  Error
+ * Notes: none
+ *****************************************************************************/
+static int convert_yuyv(const uint8_t *in_buf, uint8_t *out_buf,
+    int wd, int ht, usbcam_conv_fmt_t fmt,
+    luma_row_fn_t luma_row, luma_chroma_row_fn_t luma_chroma_row)
+{
+    const uint8_t *in = in_buf;
+    uint8_t *y = out_buf;
+    uint8_t *c0 = out_buf + wd * ht;
+    uint8_t *c1 = NULL;
+    int c0_step = wd;
+    int c1_step = 0;
+    int in_step = wd * 2;
+    int row;
+
+    if (!in_buf || !out_buf || (wd <= 0) || (ht <= 0) || (wd & 1) || (ht & 1)) {
+        ALOGE("%s: invalid args %p %p %dx%d", __func__, in_buf, out_buf, wd, ht);
+        return -1;
+    }
+
+    if (USBCAM_CONV_I420 == fmt) {
+        c0_step = wd / 2;
+        c1_step = wd / 2;
+        c1 = c0 + (wd / 2) * (ht / 2);
+    } else if ((USBCAM_CONV_NV12 != fmt) && (USBCAM_CONV_NV21 != fmt)) {
+        ALOGE("%s: invalid output format %d", __func__, fmt);
+        return -1;
+    }
+
+    for (row = 0; row < ht; row += 2) {
+        luma_chroma_row(in, y, c0, c1, wd, fmt);
+        luma_row(in + in_step, y + wd, wd);
+        in += 2 * in_step;
+        y += 2 * wd;
+        c0 += c0_step;
+        if (c1) {
+            c1 += c1_step;
+        }
+    }
+
+    return 0;
+}
+
+int usbcam_convert_yuyv_scalar(const uint8_t *in_buf, uint8_t *out_buf,
+                               int wd, int ht, usbcam_conv_fmt_t fmt)
+{
+    return convert_yuyv(in_buf, out_buf, wd, ht, fmt,
+        luma_row_scalar_full, luma_chroma_row_scalar_full);
+}
+
+int usbcam_convert_yuyv(const uint8_t *in_buf, uint8_t *out_buf,
+                        int wd, int ht, usbcam_conv_fmt_t fmt)
+{
+#if defined(USBCAM_CONV_NEON)
+    return convert_yuyv(in_buf, out_buf, wd, ht, fmt,
+        luma_row_neon, luma_chroma_row_neon);
+#elif defined(USBCAM_CONV_SSE2)
+    return convert_yuyv(in_buf, out_buf, wd, ht, fmt,
+        luma_row_sse2, luma_chroma_row_sse2);
+#else
+    return usbcam_convert_yuyv_scalar(in_buf, out_buf, wd, ht, fmt);
+#endif
+}
+
+const char *usbcam_convert_backend(void)
+{
+#if defined(USBCAM_CONV_NEON)
+    return "neon";
+#elif defined(USBCAM_CONV_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -46,6 +46,7 @@
 #include "QCameraUsbPriv.h"
 #include "QCameraMjpegDecode.h"
 #include "QCameraUsbParm.h"
+#include "QCameraUsbColorConv.h"
 #include <gralloc_priv.h>
 #include <genlock.h>
 
@@ -116,7 +117,6 @@ static int put_buf_to_display(   camera_hardware_t *camHal, int buffer_id);
 static int convert_data_frm_cam_to_disp(camera_hardware_t *camHal, int buffer_id);
 static void * previewloop(void *);
 static void * takePictureThread(void *);
-static int convert_YUYV_to_420_NV12(char *in_buf, char *out_buf, int wd, int ht);
 static int get_uvc_device(char *devname);
 static int getPreviewCaptureFmt(camera_hardware_t *camHal);
 static int allocate_ion_memory(QCameraHalMemInfo_t *mem_info, int ion_type);
@@ -698,48 +698,6 @@ int usbcam_dump(struct camera_device * device, int fd)
 *  Static function definitions below
 *****************************************************************************/
 
-/******************************************************************************/
-/* No in place conversion supported. Output buffer and input MUST should be   */
-/* different input buffer for a 4x4 pixel video                             ***/
-/******                  YUYVYUYV          00 01 02 03 04 05 06 07 ************/
-/******                  YUYVYUYV          08 09 10 11 12 13 14 15 ************/
-/******                  YUYVYUYV          16 17 18 19 20 21 22 23 ************/
-/******                  YUYVYUYV          24 25 26 27 28 29 30 31 ************/
-/******************************************************************************/
-/* output generated by this function ******************************************/
-/************************** YYYY            00 02 04 06            ************/
-/************************** YYYY            08 10 12 14            ************/
-/************************** YYYY            16 18 20 22            ************/
-/************************** YYYY            24 26 28 30            ************/
-/************************** VUVU            03 01 07 05            ************/
-/************************** VUVU            19 17 23 21            ************/
-/******************************************************************************/
-
-static int convert_YUYV_to_420_NV12(char *in_buf, char *out_buf, int wd, int ht)
-{
-    int rc =0;
-    int row, col, uv_row;
-
-    ALOGD("%s: E", __func__);
-    /* Arrange Y */
-    for(row = 0; row < ht; row++)
-        for(col = 0; col < wd * 2; col += 2)
-        {
-            out_buf[row * wd + col / 2] = in_buf[row * wd * 2 + col];
-        }
-
-    /* Arrange UV */
-    for(row = 0, uv_row = ht; row < ht; row += 2, uv_row++)
-        for(col = 1; col < wd * 2; col += 4)
-        {
-            out_buf[uv_row * wd + col / 2]= in_buf[row * wd * 2 + col + 2];
-            out_buf[uv_row * wd + col / 2 + 1]  = in_buf[row * wd * 2 + col];
-        }
-
-    ALOGD("%s: X", __func__);
-    return rc;
-}
-
 /******************************************************************************
  * Function: initDisplayBuffers
  * Description: This function initializes the preview buffers
@@ -1930,11 +1888,12 @@ static int convert_data_frm_cam_to_disp(camera_hardware_t *camHal, int buffer_id
     if( (V4L2_PIX_FMT_YUYV == camHal->captureFormat) &&
         (HAL_PIXEL_FORMAT_YCrCb_420_SP == camHal->dispFormat))
     {
-        convert_YUYV_to_420_NV12(
-            (char *)camHal->buffers[camHal->curCaptureBuf.index].data,
-            (char *)camHal->previewMem.camera_memory[buffer_id]->data,
+        usbcam_convert_yuyv(
+            (const uint8_t *)camHal->buffers[camHal->curCaptureBuf.index].data,
+            (uint8_t *)camHal->previewMem.camera_memory[buffer_id]->data,
             camHal->prevWidth,
-            camHal->prevHeight);
+            camHal->prevHeight,
+            USBCAM_CONV_NV21);
         ALOGD("%s: Copied %d bytes from camera buffer %d to display buffer: %d",
              __func__, camHal->curCaptureBuf.bytesused,
              camHal->curCaptureBuf.index, buffer_id);
@@ -2827,10 +2786,11 @@ int encodeJpeg(camera_hardware_t *camHal)
         return -1;
     }
 
-    rc = convert_YUYV_to_420_NV12(
-        (char *)camHal->buffers[camHal->curCaptureBuf.index].data,
-        (char *)jpegInMem->data, camHal->pictWidth, camHal->pictHeight);
-    ERROR_CHECK_EXIT(rc, "convert_YUYV_to_420_NV12");
+    rc = usbcam_convert_yuyv(
+        (const uint8_t *)camHal->buffers[camHal->curCaptureBuf.index].data,
+        (uint8_t *)jpegInMem->data, camHal->pictWidth, camHal->pictHeight,
+        USBCAM_CONV_NV21);
+    ERROR_CHECK_EXIT(rc, "usbcam_convert_yuyv");
     /************************************************************************/
     /* - Populate JPEG encoding parameters from the camHal context          */
     /************************************************************************/
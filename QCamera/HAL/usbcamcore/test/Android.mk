@@ -0,0 +1,31 @@
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+LOCAL_PATH := $(call my-dir)
+
+# YUYV converter correctness test and benchmark. The host variant checks the
+# scalar and SSE2 paths, the target variant checks the NEON path on device.
+
+usbcam_colorconv_test_src := \
+        QCameraUsbColorConvTest.cpp \
+        ../src/QCameraUsbColorConv.cpp
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := usbcam-colorconv-test
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../inc
+LOCAL_SRC_FILES := $(usbcam_colorconv_test_src)
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_32_BIT_ONLY := $(BOARD_QTI_CAMERA_32BIT_ONLY)
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := usbcam-colorconv-test
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../inc
+LOCAL_SRC_FILES := $(usbcam_colorconv_test_src)
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_LDLIBS := -lrt
+include $(BUILD_HOST_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
@@ -0,0 +1,332 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* Correctness test and throughput benchmark for QCameraUsbColorConv.
+ *
+ * Every layout is checked at a set of frame sizes, including ones that are
+ * not a multiple of the vector width, against the legacy HAL converter:
+ *   - usbcam_convert_yuyv_scalar against the legacy routine
+ *   - usbcam_convert_yuyv (NEON/SSE2/scalar backend) against the scalar one
+ * Outputs are guarded at both ends and inputs are also fed misaligned so
+ * the unaligned load/store paths of the vector kernels are exercised.
+ *
+ * Times are only comparable within one build. Sanitizer and -O0 builds
+ * slow the legacy and scalar columns several times more than the vector
+ * one, so report the optimization level with any figure.
+ *
+ * Usage: usbcam-colorconv-test [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "QCameraUsbColorConv.h"
+
+#define GUARD_SIZE      64
+#define GUARD_BYTE      0xA5
+#define DEFAULT_ITERS   200
+
+typedef struct {
+    int wd;
+    int ht;
+} test_size_t;
+
+static const test_size_t g_test_sizes[] = {
+    {2, 2}, {34, 6}, {62, 2}, {66, 4}, {176, 144}, {638, 480},
+    {1280, 720}, {1920, 1080},
+};
+
+static const test_size_t g_bench_sizes[] = {
+    {1280, 720}, {1920, 1080},
+};
+
+static const char *const g_fmt_names[] = {"NV12", "NV21", "I420"};
+
+/******************************************************************************
+ * Function: legacy_convert_nv21
+ * Description: The original HAL converter (convert_YUYV_to_420_NV12), kept
+ *              verbatim as reference. Despite its name it writes CrCb.
+ *
+ * Input parameters:
+ *   in_buf              - YUYV input
+ *   out_buf             - 4:2:0 output, wd * ht * 3 / 2 bytes
+ *   wd, ht              - frame dimensions
+ *
+ * Return values: none
+ * Notes: none
+ *****************************************************************************/
+static void legacy_convert_nv21(const uint8_t *in_buf, uint8_t *out_buf,
+                                int wd, int ht)
+{
+    int row, col, uv_row;
+
+    for (row = 0; row < ht; row++)
+        for (col = 0; col < wd * 2; col += 2)
+            out_buf[row * wd + col / 2] = in_buf[row * wd * 2 + col];
+
+    for (row = 0, uv_row = ht; row < ht; row += 2, uv_row++)
+        for (col = 1; col < wd * 2; col += 4) {
+            out_buf[uv_row * wd + col / 2] = in_buf[row * wd * 2 + col + 2];
+            out_buf[uv_row * wd + col / 2 + 1] = in_buf[row * wd * 2 + col];
+        }
+}
+
+/******************************************************************************
+ * Function: legacy_convert
+ * Description: Builds the expected output for any layout by reordering the
+ *              chroma written by the legacy converter.
+ *
+ * Input parameters:
+ *   in_buf              - YUYV input
+ *   out_buf             - 4:2:0 output, wd * ht * 3 / 2 bytes
+ *   wd, ht              - frame dimensions
+ *   fmt                 - output layout
+ *
+ * Return values: none
+ * Notes: none
+ *****************************************************************************/
+static void legacy_convert(const uint8_t *in_buf, uint8_t *out_buf,
+                           int wd, int ht, usbcam_conv_fmt_t fmt)
+{
+    size_t y_size = (size_t)wd * ht;
+    size_t c_size = y_size / 4;
+    uint8_t *vu = out_buf + y_size;
+    uint8_t *tmp;
+    size_t i;
+
+    legacy_convert_nv21(in_buf, out_buf, wd, ht);
+    if (USBCAM_CONV_NV21 == fmt) {
+        return;
+    }
+
+    tmp = (uint8_t *)malloc(c_size * 2);
+    memcpy(tmp, vu, c_size * 2);
+    for (i = 0; i < c_size; i++) {
+        if (USBCAM_CONV_NV12 == fmt) {
+            vu[2 * i] = tmp[2 * i + 1];
+            vu[2 * i + 1] = tmp[2 * i];
+        } else {
+            vu[i] = tmp[2 * i + 1];
+            vu[c_size + i] = tmp[2 * i];
+        }
+    }
+    free(tmp);
+}
+
+/******************************************************************************
+ * Function: check_output
+ * Description: Compares an output frame against the expected one and
+ *              verifies the guard bytes around it are untouched.
+ *
+ * Input parameters:
+ *   what                - name of the path under test
+ *   buf                 - output frame, with GUARD_SIZE bytes on each side
+ *   expected            - expected frame
+ *   len                 - frame size in bytes
+ *   wd, ht, fmt         - frame description for the report
+ *
+ * Return values:
+ *      0   Match
+ *      -1  Mismatch
+ * Notes: none
+ *****************************************************************************/
+static int check_output(const char *what, const uint8_t *buf,
+                        const uint8_t *expected, size_t len,
+                        int wd, int ht, usbcam_conv_fmt_t fmt)
+{
+    size_t i;
+
+    for (i = 0; i < GUARD_SIZE; i++) {
+        if ((buf[i] != GUARD_BYTE) ||
+            (buf[GUARD_SIZE + len + i] != GUARD_BYTE)) {
+            printf("FAIL %s %dx%d %s: write outside the frame\n",
+                what, wd, ht, g_fmt_names[fmt]);
+            return -1;
+        }
+    }
+    for (i = 0; i < len; i++) {
+        if (buf[GUARD_SIZE + i] != expected[i]) {
+            printf("FAIL %s %dx%d %s: byte %zu is 0x%02x, expected 0x%02x\n",
+                what, wd, ht, g_fmt_names[fmt], i, buf[GUARD_SIZE + i],
+                expected[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function: test_size
+ * Description: Runs the correctness checks for one frame size, all layouts
+ *              and both input alignments.
+ *
+ * Input parameters:
+ *   wd, ht              - frame dimensions
+ *
+ * Return values: number of failed checks
+ * Notes: none
+ *****************************************************************************/
+static int test_size(int wd, int ht)
+{
+    size_t in_len = (size_t)wd * ht * 2;
+    size_t out_len = (size_t)wd * ht * 3 / 2;
+    uint8_t *in = (uint8_t *)malloc(in_len + 1);
+    uint8_t *expected = (uint8_t *)malloc(out_len);
+    uint8_t *out = (uint8_t *)malloc(out_len + 2 * GUARD_SIZE);
+    int failures = 0;
+    int fmt, offset;
+    size_t i;
+
+    for (offset = 0; offset < 2; offset++) {
+        uint8_t *src = in + offset;
+
+        for (i = 0; i < in_len; i++) {
+            src[i] = (uint8_t)rand();
+        }
+        for (fmt = USBCAM_CONV_NV12; fmt <= USBCAM_CONV_I420; fmt++) {
+            legacy_convert(src, expected, wd, ht, (usbcam_conv_fmt_t)fmt);
+
+            memset(out, GUARD_BYTE, out_len + 2 * GUARD_SIZE);
+            if ((usbcam_convert_yuyv_scalar(src, out + GUARD_SIZE, wd, ht,
+                    (usbcam_conv_fmt_t)fmt) != 0) ||
+                (check_output("scalar", out, expected, out_len, wd, ht,
+                    (usbcam_conv_fmt_t)fmt) != 0)) {
+                failures++;
+            }
+
+            memset(out, GUARD_BYTE, out_len + 2 * GUARD_SIZE);
+            if ((usbcam_convert_yuyv(src, out + GUARD_SIZE, wd, ht,
+                    (usbcam_conv_fmt_t)fmt) != 0) ||
+                (check_output(usbcam_convert_backend(), out, expected,
+                    out_len, wd, ht, (usbcam_conv_fmt_t)fmt) != 0)) {
+                failures++;
+            }
+        }
+    }
+
+    free(in);
+    free(expected);
+    free(out);
+    return failures;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/******************************************************************************
+ * Function: bench_size
+ * Description: Reports the per frame time and input bandwidth of the legacy
+ *              converter, the scalar path and the selected backend.
+ *
+ * Input parameters:
+ *   wd, ht              - frame dimensions
+ *   iters               - frames converted per measurement
+ *
+ * Return values: none
+ * Notes: none
+ *****************************************************************************/
+static void bench_size(int wd, int ht, int iters)
+{
+    size_t in_len = (size_t)wd * ht * 2;
+    uint8_t *in = (uint8_t *)malloc(in_len);
+    uint8_t *out = (uint8_t *)malloc((size_t)wd * ht * 3 / 2);
+    double t[4];
+    int i, fmt;
+    size_t j;
+
+    for (j = 0; j < in_len; j++) {
+        in[j] = (uint8_t)rand();
+    }
+
+    for (fmt = USBCAM_CONV_NV12; fmt <= USBCAM_CONV_I420; fmt++) {
+        t[0] = now_ms();
+        for (i = 0; i < iters; i++) {
+            legacy_convert_nv21(in, out, wd, ht);
+        }
+        t[1] = now_ms();
+        for (i = 0; i < iters; i++) {
+            usbcam_convert_yuyv_scalar(in, out, wd, ht, (usbcam_conv_fmt_t)fmt);
+        }
+        t[2] = now_ms();
+        for (i = 0; i < iters; i++) {
+            usbcam_convert_yuyv(in, out, wd, ht, (usbcam_conv_fmt_t)fmt);
+        }
+        t[3] = now_ms();
+
+        printf("%4dx%-4d %s: legacy %7.3f ms  scalar %7.3f ms  "
+            "%s %7.3f ms (%.0f MB/s)\n", wd, ht, g_fmt_names[fmt],
+            (t[1] - t[0]) / iters, (t[2] - t[1]) / iters,
+            usbcam_convert_backend(), (t[3] - t[2]) / iters,
+            in_len * iters / ((t[3] - t[2]) * 1000.0));
+    }
+
+    free(in);
+    free(out);
+}
+
+int main(int argc, char *argv[])
+{
+    int iters = DEFAULT_ITERS;
+    int failures = 0;
+    size_t i;
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+        if (iters <= 0) {
+            printf("Usage: %s [iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    srand(1);
+    printf("backend: %s\n", usbcam_convert_backend());
+    for (i = 0; i < sizeof(g_test_sizes) / sizeof(g_test_sizes[0]); i++) {
+        failures += test_size(g_test_sizes[i].wd, g_test_sizes[i].ht);
+    }
+    if (usbcam_convert_yuyv(NULL, NULL, 34, 6, USBCAM_CONV_NV12) == 0 ||
+        usbcam_convert_yuyv_scalar(NULL, NULL, 33, 6, USBCAM_CONV_NV12) == 0) {
+        printf("FAIL invalid arguments accepted\n");
+        failures++;
+    }
+    printf("correctness: %s (%d failures)\n", failures ? "FAIL" : "PASS",
+        failures);
+
+    for (i = 0; i < sizeof(g_bench_sizes) / sizeof(g_bench_sizes[0]); i++) {
+        bench_size(g_bench_sizes[i].wd, g_bench_sizes[i].ht, iters);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -43,6 +43,7 @@
 
 #include "QCamera2HWI.h"
 #include "QCameraMem.h"
+#include "QCameraDebugConfig.h"
 
 #define MAP_TO_DRIVER_COORDINATE(val, base, scale, offset) \
   ((int32_t)val * (int32_t)scale / (int32_t)base + (int32_t)offset)
@@ -1115,7 +1116,10 @@ QCamera2HardwareInterface::QCamera2HardwareInterface(uint32_t cameraId)
       mOutputCount(0),
       mInputCount(0),
       mAdvancedCaptureConfigured(false),
-      mHDRBracketingEnabled(false)
+      mHDRBracketingEnabled(false),
+      mPreviewCbPoolCnt(0),
+      mPreviewCbBufSize(0),
+      mMemPoolIdleLimit(QCAMERA_MEM_POOL_NO_LIMIT)
 {
     getLogLevel();
     ATRACE_CALL();
@@ -1129,6 +1133,7 @@ QCamera2HardwareInterface::QCamera2HardwareInterface(uint32_t cameraId)
     pthread_cond_init(&m_cond, NULL);
 
     m_apiResultList = NULL;
+    m_bExifTemplateReady = false;
 
     pthread_mutex_init(&m_evtLock, NULL);
     pthread_cond_init(&m_evtCond, NULL);
@@ -1139,6 +1144,9 @@ QCamera2HardwareInterface::QCamera2HardwareInterface(uint32_t cameraId)
     pthread_mutex_init(&m_int_lock, NULL);
     pthread_cond_init(&m_int_cond, NULL);
 
+    pthread_mutex_init(&mPreviewCbPoolLock, NULL);
+    memset(mPreviewCbPool, 0, sizeof(mPreviewCbPool));
+
     memset(m_channels, 0, sizeof(m_channels));
     memset(&mExifParams, 0, sizeof(mm_jpeg_exif_params_t));
 
@@ -1187,6 +1195,7 @@ QCamera2HardwareInterface::~QCamera2HardwareInterface()
     pthread_mutex_destroy(&m_parm_lock);
     pthread_mutex_destroy(&m_int_lock);
     pthread_cond_destroy(&m_int_cond);
+    pthread_mutex_destroy(&mPreviewCbPoolLock);
 }
 
 /*===========================================================================
@@ -1302,8 +1311,10 @@ int QCamera2HardwareInterface::openCamera()
 
     mParameters.init(gCamCaps[mCameraId], mCameraHandle, this);
     mParameters.setMinPpMask(gCamCaps[mCameraId]->min_required_pp_mask);
+    initMemoryPoolLimits();
 
     mCameraOpened = true;
+    QCameraDebugConfig::start();
 
     return NO_ERROR;
 }
@@ -1334,6 +1345,7 @@ int QCamera2HardwareInterface::closeCamera()
 
     // set open flag to false
     mCameraOpened = false;
+    QCameraDebugConfig::stop();
 
     // Reset Stream config info
     mParameters.setStreamConfigure(false, false, true);
@@ -1345,6 +1357,7 @@ int QCamera2HardwareInterface::closeCamera()
 
     // exit notifier
     m_cbNotifier.exit();
+    flushPreviewCbPool();
 
     // stop and deinit postprocessor
     waitDefferedWork(mReprocJob);
@@ -2305,8 +2318,13 @@ int QCamera2HardwareInterface::stopPreview()
     stopChannel(QCAMERA_CH_TYPE_PREVIEW);
 
     m_cbNotifier.flushPreviewNotifications();
+    flushPreviewCbPool();
     // delete all channels from preparePreview
     unpreparePreview();
+    // stream buffers went back to the pool, cap what it keeps while idle
+    if (mMemPoolIdleLimit != QCAMERA_MEM_POOL_NO_LIMIT) {
+        m_memoryPool.trim(mMemPoolIdleLimit);
+    }
     CDBG_HIGH("%s: X", __func__);
     return NO_ERROR;
 }
@@ -4169,11 +4187,13 @@ int QCamera2HardwareInterface::dump(int fd)
     dprintf(fd, "StoreMetaDataInFrame: %d \n", mStoreMetaDataInFrame);
     dprintf(fd, "\n Configuration: %s", mParameters.dump().string());
     dprintf(fd, "\n State Information: %s", m_stateMachine.dump().string());
+    dprintf(fd, "\n Memory Pool: %s", m_memoryPool.dump().string());
     dprintf(fd, "\n Camera HAL information End \n");
 
     /* send UPDATE_DEBUG_LEVEL to the backend so that they can read the
        debug level property */
     mParameters.updateDebugLevel();
+    QCameraDebugConfig::refresh();
     return NO_ERROR;
 }
 
@@ -6546,6 +6566,176 @@ void QCamera2HardwareInterface::returnStreamBuffer(void *data,
     }
 }
 
+/*===========================================================================
+ * FUNCTION   : returnPreviewCbMemory
+ *
+ * DESCRIPTION: returns an app-facing preview callback buffer to the pool
+ *
+ * PARAMETERS :
+ *   @data    : buffer to be returned
+ *   @cookie  : context data
+ *   @cbStatus: callback status
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera2HardwareInterface::returnPreviewCbMemory(void *data,
+                                                      void *cookie,
+                                                      int32_t /*cbStatus*/)
+{
+    QCamera2HardwareInterface *pme = (QCamera2HardwareInterface *)cookie;
+    camera_memory_t *mem = (camera_memory_t *)data;
+    if (NULL == mem) {
+        return;
+    }
+    if (NULL != pme) {
+        pme->putPreviewCbMemory(mem);
+    } else {
+        mem->release(mem);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : getPreviewCbMemory
+ *
+ * DESCRIPTION: get an app-facing preview callback buffer, reusing a pooled
+ *              one when its size matches
+ *
+ * PARAMETERS :
+ *   @size    : required buffer size in bytes
+ *
+ * RETURN     : camera memory ptr, NULL on failure
+ *==========================================================================*/
+camera_memory_t *QCamera2HardwareInterface::getPreviewCbMemory(size_t size)
+{
+    camera_memory_t *mem = NULL;
+
+    pthread_mutex_lock(&mPreviewCbPoolLock);
+    if (size != mPreviewCbBufSize) {
+        // preview size changed, pooled buffers are of no further use
+        while (mPreviewCbPoolCnt > 0) {
+            camera_memory_t *stale = mPreviewCbPool[--mPreviewCbPoolCnt];
+            mPreviewCbPool[mPreviewCbPoolCnt] = NULL;
+            stale->release(stale);
+        }
+        mPreviewCbBufSize = size;
+    } else if (mPreviewCbPoolCnt > 0) {
+        mem = mPreviewCbPool[--mPreviewCbPoolCnt];
+        mPreviewCbPool[mPreviewCbPoolCnt] = NULL;
+    }
+    pthread_mutex_unlock(&mPreviewCbPoolLock);
+
+    if (NULL == mem && NULL != mGetMemory) {
+        mem = mGetMemory(-1, size, 1, mCallbackCookie);
+        if ((NULL != mem) && (NULL == mem->data)) {
+            mem->release(mem);
+            mem = NULL;
+        }
+    }
+
+    return mem;
+}
+
+/*===========================================================================
+ * FUNCTION   : putPreviewCbMemory
+ *
+ * DESCRIPTION: put an app-facing preview callback buffer back to the pool.
+ *              Buffers of a stale size or exceeding the pool depth are
+ *              released.
+ *
+ * PARAMETERS :
+ *   @mem     : buffer to be returned
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera2HardwareInterface::putPreviewCbMemory(camera_memory_t *mem)
+{
+    if (NULL == mem) {
+        return;
+    }
+
+    pthread_mutex_lock(&mPreviewCbPoolLock);
+    if ((mem->size == mPreviewCbBufSize) &&
+            (mPreviewCbPoolCnt < QCAMERA_PREVIEW_CB_POOL_SIZE)) {
+        mPreviewCbPool[mPreviewCbPoolCnt++] = mem;
+        mem = NULL;
+    }
+    pthread_mutex_unlock(&mPreviewCbPoolLock);
+
+    if (NULL != mem) {
+        mem->release(mem);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : flushPreviewCbPool
+ *
+ * DESCRIPTION: release all pooled preview callback buffers. Buffers still
+ *              held by the notifier are released when they are returned.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera2HardwareInterface::flushPreviewCbPool()
+{
+    pthread_mutex_lock(&mPreviewCbPoolLock);
+    mPreviewCbBufSize = 0;
+    while (mPreviewCbPoolCnt > 0) {
+        camera_memory_t *mem = mPreviewCbPool[--mPreviewCbPoolCnt];
+        mPreviewCbPool[mPreviewCbPoolCnt] = NULL;
+        mem->release(mem);
+    }
+    pthread_mutex_unlock(&mPreviewCbPoolLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : initMemoryPoolLimits
+ *
+ * DESCRIPTION: read the stream buffer pool limits from properties, all in MB:
+ *              persist.camera.mem.pool.limit: per stream type, 0 for none
+ *              persist.camera.mem.pool.snapshot/raw: override for the
+ *                  largest buffers, 0 to use the per type limit
+ *              persist.camera.mem.pool.idle: total kept after stopPreview,
+ *                  negative to keep everything
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera2HardwareInterface::initMemoryPoolLimits()
+{
+    static const struct {
+        cam_stream_type_t type;
+        const char *prop;
+    } overrides[] = {
+        { CAM_STREAM_TYPE_SNAPSHOT, "persist.camera.mem.pool.snapshot" },
+        { CAM_STREAM_TYPE_RAW,      "persist.camera.mem.pool.raw" },
+    };
+    char value[PROPERTY_VALUE_MAX];
+    int mb;
+
+    property_get("persist.camera.mem.pool.limit", value, "0");
+    mb = atoi(value);
+    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++) {
+        m_memoryPool.setRetentionLimit((cam_stream_type_t)i, (mb > 0) ?
+                (size_t)mb * 1024 * 1024 : QCAMERA_MEM_POOL_NO_LIMIT);
+    }
+    for (size_t i = 0; i < sizeof(overrides) / sizeof(overrides[0]); i++) {
+        property_get(overrides[i].prop, value, "0");
+        mb = atoi(value);
+        if (mb > 0) {
+            m_memoryPool.setRetentionLimit(overrides[i].type,
+                    (size_t)mb * 1024 * 1024);
+        }
+    }
+
+    property_get("persist.camera.mem.pool.idle", value, "64");
+    mb = atoi(value);
+    mMemPoolIdleLimit = (mb >= 0) ?
+            (size_t)mb * 1024 * 1024 : QCAMERA_MEM_POOL_NO_LIMIT;
+    CDBG_HIGH("%s: pool idle limit %d MB", __func__, mb);
+}
+
 /*===========================================================================
  * FUNCTION   : processHistogramStats
  *
@@ -7313,27 +7503,32 @@ QCameraExif *QCamera2HardwareInterface::getExifData()
         ALOGE("%s: getExifGpsDataTimeStamp failed", __func__);
     }
 
-    char value[PROPERTY_VALUE_MAX];
-    if (property_get("ro.product.manufacturer", value, "QCOM-AA") > 0) {
-        exif->addEntry(EXIFTAGID_MAKE, EXIF_ASCII,
-                (uint32_t)(strlen(value) + 1), (void *)value);
-    } else {
-        ALOGE("%s: getExifMaker failed", __func__);
-    }
+    // make, model and software are read once, later jobs copy the template
+    if (!m_bExifTemplateReady) {
+        char value[PROPERTY_VALUE_MAX];
+        if (property_get("ro.product.manufacturer", value, "QCOM-AA") > 0) {
+            m_exifTemplate.addEntry(EXIFTAGID_MAKE, EXIF_ASCII,
+                    (uint32_t)(strlen(value) + 1), (void *)value);
+        } else {
+            ALOGE("%s: getExifMaker failed", __func__);
+        }
 
-    if (property_get("ro.product.model", value, "QCAM-AA") > 0) {
-        exif->addEntry(EXIFTAGID_MODEL, EXIF_ASCII,
-                (uint32_t)(strlen(value) + 1), (void *)value);
-    } else {
-        ALOGE("%s: getExifModel failed", __func__);
-    }
+        if (property_get("ro.product.model", value, "QCAM-AA") > 0) {
+            m_exifTemplate.addEntry(EXIFTAGID_MODEL, EXIF_ASCII,
+                    (uint32_t)(strlen(value) + 1), (void *)value);
+        } else {
+            ALOGE("%s: getExifModel failed", __func__);
+        }
 
-    if (property_get("ro.build.description", value, "QCAM-AA") > 0) {
-        exif->addEntry(EXIFTAGID_SOFTWARE, EXIF_ASCII,
-                (uint32_t)(strlen(value) + 1), (void *)value);
-    } else {
-        ALOGE("%s: getExifSoftware failed", __func__);
+        if (property_get("ro.build.description", value, "QCAM-AA") > 0) {
+            m_exifTemplate.addEntry(EXIFTAGID_SOFTWARE, EXIF_ASCII,
+                    (uint32_t)(strlen(value) + 1), (void *)value);
+        } else {
+            ALOGE("%s: getExifSoftware failed", __func__);
+        }
+        m_bExifTemplateReady = true;
     }
+    exif->addEntries(m_exifTemplate);
 
     if (mParameters.useJpegExifRotation()) {
         int16_t orientation;
@@ -125,6 +125,9 @@ typedef struct {
 
 #define QCAMERA_ION_USE_CACHE   true
 #define QCAMERA_ION_USE_NOCACHE false
+
+// Number of app-facing preview callback buffers kept for reuse
+#define QCAMERA_PREVIEW_CB_POOL_SIZE 4
 #define MAX_ONGOING_JOBS 25
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
@@ -515,6 +518,9 @@ private:
     static void returnStreamBuffer(void *data,
                                    void *cookie,
                                    int32_t cbStatus);
+    static void returnPreviewCbMemory(void *data,
+                                      void *cookie,
+                                      int32_t cbStatus);
     static void getLogLevel();
 
 private:
@@ -550,6 +556,8 @@ private:
     qcamera_api_result_t m_evtResult;
 
     pthread_mutex_t m_parm_lock;
+    QCameraExif m_exifTemplate;         // exif tags constant for the session, under m_parm_lock
+    bool m_bExifTemplateReady;
 
     QCameraChannel *m_channels[QCAMERA_CH_TYPE_MAX]; // array holding channel ptr
 
@@ -654,6 +662,20 @@ private:
     uint32_t mInputCount;
     bool mAdvancedCaptureConfigured;
     bool mHDRBracketingEnabled;
+
+    // app-facing preview callback buffers, recycled across frames
+    camera_memory_t *getPreviewCbMemory(size_t size);
+    void putPreviewCbMemory(camera_memory_t *mem);
+    void flushPreviewCbPool();
+
+    camera_memory_t *mPreviewCbPool[QCAMERA_PREVIEW_CB_POOL_SIZE];
+    uint32_t mPreviewCbPoolCnt;
+    size_t mPreviewCbBufSize;
+    pthread_mutex_t mPreviewCbPoolLock;
+
+    // stream buffer pool retention, read from properties on open
+    void initMemoryPoolLimits();
+    size_t mMemPoolIdleLimit;       // bytes kept in m_memoryPool after stopPreview
 };
 
 }; // namespace qcamera
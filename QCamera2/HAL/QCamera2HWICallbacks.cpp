@@ -38,6 +38,7 @@
 #include <utils/Timers.h>
 #include <QComOMXMetadata.h>
 #include "QCamera2HWI.h"
+#include "QCameraDebugConfig.h"
 
 namespace qcamera {
 
@@ -62,7 +63,6 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
 {
     ATRACE_CALL();
     CDBG_HIGH("[KPI Perf] %s: E",__func__);
-    char value[PROPERTY_VALUE_MAX];
     bool dump_raw = false;
     bool dump_yuv = false;
     bool log_matching = false;
@@ -92,15 +92,14 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
           __func__, recvd_frame->bUnlockAEC, pme->m_bLedAfAecLock);
     if(recvd_frame->bUnlockAEC && pme->m_bLedAfAecLock) {
         qcamera_sm_internal_evt_payload_t *payload =
-                (qcamera_sm_internal_evt_payload_t *)malloc(
-                        sizeof(qcamera_sm_internal_evt_payload_t));
+                pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_RETRO_AEC_UNLOCK;
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt for retro AEC unlock failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
             }
         } else {
@@ -114,14 +113,14 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
       // Send an event
       CDBG_HIGH("%s: [ZSL Retro] Ready for Prepare Snapshot, signal ", __func__);
       qcamera_sm_internal_evt_payload_t *payload =
-         (qcamera_sm_internal_evt_payload_t *)malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+         pme->m_stateMachine.allocEvtPayload();
       if (NULL != payload) {
         memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
         payload->evt_type = QCAMERA_INTERNAL_EVT_READY_FOR_SNAPSHOT;
         int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
         if (rc != NO_ERROR) {
           ALOGE("%s: processEvt Ready for Snaphot failed", __func__);
-          free(payload);
+          pme->m_stateMachine.releaseEvtPayload(payload);
           payload = NULL;
         }
       } else {
@@ -148,8 +147,7 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
     }
 
     // DUMP RAW if available
-    property_get("persist.camera.zsl_raw", value, "0");
-    dump_raw = atoi(value) > 0 ? true : false;
+    dump_raw = QCameraDebugConfig::isEnabled(QCAMERA_DBG_ZSL_RAW);
     if (dump_raw) {
         for (uint32_t i = 0; i < recvd_frame->num_bufs; i++) {
             if (recvd_frame->bufs[i]->stream_type == CAM_STREAM_TYPE_RAW) {
@@ -164,8 +162,7 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
     }
 
     // DUMP YUV before reprocess if needed
-    property_get("persist.camera.zsl_yuv", value, "0");
-    dump_yuv = atoi(value) > 0 ? true : false;
+    dump_yuv = QCameraDebugConfig::isEnabled(QCAMERA_DBG_ZSL_YUV);
     if (dump_yuv) {
         for (uint32_t i = 0; i < recvd_frame->num_bufs; i++) {
             if (recvd_frame->bufs[i]->stream_type == CAM_STREAM_TYPE_SNAPSHOT) {
@@ -214,7 +211,7 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
                     __func__, faces_data.num_faces_detected);
             }
             qcamera_sm_internal_evt_payload_t *payload =
-                (qcamera_sm_internal_evt_payload_t *)malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+                pme->m_stateMachine.allocEvtPayload();
             if (NULL != payload) {
                 memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
                 payload->evt_type = QCAMERA_INTERNAL_EVT_FACE_DETECT_RESULT;
@@ -222,7 +219,7 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
                 int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
                 if (rc != NO_ERROR) {
                     ALOGE("%s: processEvt face_detection_result failed", __func__);
-                    free(payload);
+                    pme->m_stateMachine.releaseEvtPayload(payload);
                     payload = NULL;
                 }
             } else {
@@ -231,9 +228,7 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
         }
     }
 
-    property_get("persist.camera.dumpmetadata", value, "0");
-    int32_t enabled = atoi(value);
-    if (enabled) {
+    if (QCameraDebugConfig::isEnabled(QCAMERA_DBG_DUMP_METADATA)) {
         mm_camera_buf_def_t *pMetaFrame = NULL;
         QCameraStream *pStream = NULL;
         for (uint32_t i = 0; i < frame->num_bufs; i++) {
@@ -251,8 +246,7 @@ void QCamera2HardwareInterface::zsl_channel_cb(mm_camera_super_buf_t *recvd_fram
         }
     }
 
-    property_get("persist.camera.zsl_matching", value, "0");
-    log_matching = atoi(value) > 0 ? true : false;
+    log_matching = QCameraDebugConfig::isEnabled(QCAMERA_DBG_ZSL_MATCHING);
     if (log_matching) {
         CDBG_HIGH("%s : ZSL super buffer contains:", __func__);
         QCameraStream *pStream = NULL;
@@ -383,7 +377,6 @@ void QCamera2HardwareInterface::capture_channel_cb_routine(mm_camera_super_buf_t
                                                            void *userdata)
 {
     ATRACE_CALL();
-    char value[PROPERTY_VALUE_MAX];
     CDBG_HIGH("[KPI Perf] %s: E PROFILE_YUV_CB_TO_HAL", __func__);
     QCamera2HardwareInterface *pme = (QCamera2HardwareInterface *)userdata;
     if (pme == NULL ||
@@ -409,9 +402,7 @@ void QCamera2HardwareInterface::capture_channel_cb_routine(mm_camera_super_buf_t
     }
     *frame = *recvd_frame;
 
-    property_get("persist.camera.dumpmetadata", value, "0");
-    int32_t enabled = atoi(value);
-    if (enabled) {
+    if (QCameraDebugConfig::isEnabled(QCAMERA_DBG_DUMP_METADATA)) {
         mm_camera_buf_def_t *pMetaFrame = NULL;
         QCameraStream *pStream = NULL;
         for (uint32_t i = 0; i < frame->num_bufs; i++) {
@@ -615,6 +606,38 @@ void QCamera2HardwareInterface::preview_stream_cb_routine(mm_camera_super_buf_t
     return;
 }
 
+/*===========================================================================
+ * FUNCTION   : repackPlane
+ *
+ * DESCRIPTION: copy an image plane between buffers of different strides.
+ *              Planes whose strides already match the row width are moved
+ *              with a single copy instead of one copy per row.
+ *
+ * PARAMETERS :
+ *   @dst       : destination plane
+ *   @dstStride : destination stride in bytes
+ *   @src       : source plane
+ *   @srcStride : source stride in bytes
+ *   @width     : row width in bytes
+ *   @height    : number of rows
+ *
+ * RETURN     : None
+ *==========================================================================*/
+static void repackPlane(uint8_t *dst, size_t dstStride,
+        const uint8_t *src, size_t srcStride, size_t width, size_t height)
+{
+    if ((srcStride == width) && (dstStride == width)) {
+        memcpy(dst, src, width * height);
+        return;
+    }
+
+    for (size_t i = 0; i < height; i++) {
+        memcpy(dst, src, width);
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : sendPreviewCallback
  *
@@ -652,11 +675,6 @@ int32_t QCamera2HardwareInterface::sendPreviewCallback(QCameraStream *stream,
     int32_t uvStrideToApp = 0;
     int32_t yScanlineToApp = 0;
     int32_t uvScanlineToApp = 0;
-    int32_t srcOffset = 0;
-    int32_t dstOffset = 0;
-    int32_t srcBaseOffset = 0;
-    int32_t dstBaseOffset = 0;
-    int i;
 
     if ((NULL == stream) || (NULL == memory)) {
         ALOGE("%s: Invalid preview callback input", __func__);
@@ -719,32 +737,20 @@ int32_t QCamera2HardwareInterface::sendPreviewCallback(QCameraStream *stream,
             }
         } else {
             data = memory->getMemory(idx, false);
-            dataToApp = mGetMemory(-1, previewBufSize, 1, mCallbackCookie);
+            dataToApp = getPreviewCbMemory(previewBufSize);
             if (!dataToApp || !dataToApp->data) {
-                ALOGE("%s: mGetMemory failed.\n", __func__);
+                ALOGE("%s: getPreviewCbMemory failed.\n", __func__);
                 return NO_MEMORY;
             }
 
-            for (i = 0; i < preview_dim.height; i++) {
-                srcOffset = i * yStride;
-                dstOffset = i * yStrideToApp;
-
-                memcpy((unsigned char *) dataToApp->data + dstOffset,
-                        (unsigned char *) data->data + srcOffset,
-                        (size_t)yStrideToApp);
-            }
-
-            srcBaseOffset = yStride * yScanline;
-            dstBaseOffset = yStrideToApp * yScanlineToApp;
-
-            for (i = 0; i < preview_dim.height/2; i++) {
-                srcOffset = i * uvStride + srcBaseOffset;
-                dstOffset = i * uvStrideToApp + dstBaseOffset;
-
-                memcpy((unsigned char *) dataToApp->data + dstOffset,
-                        (unsigned char *) data->data + srcOffset,
-                        (size_t)yStrideToApp);
-            }
+            repackPlane((uint8_t *)dataToApp->data, (size_t)yStrideToApp,
+                    (const uint8_t *)data->data, (size_t)yStride,
+                    (size_t)preview_dim.width, (size_t)preview_dim.height);
+            repackPlane((uint8_t *)dataToApp->data + (yStrideToApp * yScanlineToApp),
+                    (size_t)uvStrideToApp,
+                    (const uint8_t *)data->data + (yStride * yScanline),
+                    (size_t)uvStride,
+                    (size_t)preview_dim.width, (size_t)(preview_dim.height / 2));
         }
     } else {
         data = memory->getMemory(idx, false);
@@ -766,7 +772,7 @@ int32_t QCamera2HardwareInterface::sendPreviewCallback(QCameraStream *stream,
         cbArg.release_cb = releaseCameraMemory;
     } else if (dataToApp) {
         cbArg.user_data = dataToApp;
-        cbArg.release_cb = releaseCameraMemory;
+        cbArg.release_cb = returnPreviewCbMemory;
     }
     cbArg.cookie = this;
     rc = m_cbNotifier.notifyCallback(cbArg);
@@ -775,7 +781,7 @@ int32_t QCamera2HardwareInterface::sendPreviewCallback(QCameraStream *stream,
         if (previewMem) {
             previewMem->release(previewMem);
         } else if (dataToApp) {
-            dataToApp->release(dataToApp);
+            putPreviewCbMemory(dataToApp);
         }
     }
 
@@ -1208,7 +1214,6 @@ void QCamera2HardwareInterface::snapshot_channel_cb_routine(mm_camera_super_buf_
        void *userdata)
 {
     ATRACE_CALL();
-    char value[PROPERTY_VALUE_MAX];
 
     CDBG_HIGH("[KPI Perf] %s: E", __func__);
     QCamera2HardwareInterface *pme = (QCamera2HardwareInterface *)userdata;
@@ -1227,9 +1232,7 @@ void QCamera2HardwareInterface::snapshot_channel_cb_routine(mm_camera_super_buf_
         return;
     }
 
-    property_get("persist.camera.dumpmetadata", value, "0");
-    int32_t enabled = atoi(value);
-    if (enabled) {
+    if (QCameraDebugConfig::isEnabled(QCAMERA_DBG_DUMP_METADATA)) {
         if (pChannel == NULL ||
             pChannel->getMyHandle() != super_frame->ch_id) {
             ALOGE("%s: Capture channel doesn't exist, return here", __func__);
@@ -1327,7 +1330,6 @@ void QCamera2HardwareInterface::preview_raw_stream_cb_routine(mm_camera_super_bu
 {
     ATRACE_CALL();
     CDBG_HIGH("[KPI Perf] %s : BEGIN", __func__);
-    char value[PROPERTY_VALUE_MAX];
     bool dump_raw = false;
 
     QCamera2HardwareInterface *pme = (QCamera2HardwareInterface *)userdata;
@@ -1340,8 +1342,7 @@ void QCamera2HardwareInterface::preview_raw_stream_cb_routine(mm_camera_super_bu
         return;
     }
 
-    property_get("persist.camera.preview_raw", value, "0");
-    dump_raw = atoi(value) > 0 ? true : false;
+    dump_raw = QCameraDebugConfig::isEnabled(QCAMERA_DBG_PREVIEW_RAW);
 
     for (uint32_t i = 0; i < super_frame->num_bufs; i++) {
         if (super_frame->bufs[i]->stream_type == CAM_STREAM_TYPE_RAW) {
@@ -1382,7 +1383,6 @@ void QCamera2HardwareInterface::snapshot_raw_stream_cb_routine(mm_camera_super_b
 {
     ATRACE_CALL();
     CDBG_HIGH("[KPI Perf] %s : BEGIN", __func__);
-    char value[PROPERTY_VALUE_MAX];
     bool dump_raw = false;
 
     QCamera2HardwareInterface *pme = (QCamera2HardwareInterface *)userdata;
@@ -1395,8 +1395,7 @@ void QCamera2HardwareInterface::snapshot_raw_stream_cb_routine(mm_camera_super_b
         return;
     }
 
-    property_get("persist.camera.snapshot_raw", value, "0");
-    dump_raw = atoi(value) > 0 ? true : false;
+    dump_raw = QCameraDebugConfig::isEnabled(QCAMERA_DBG_SNAPSHOT_RAW);
 
     for (uint32_t i = 0; i < super_frame->num_bufs; i++) {
         if (super_frame->bufs[i]->stream_type == CAM_STREAM_TYPE_RAW) {
@@ -1536,8 +1535,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
     IF_META_AVAILABLE(cam_hist_stats_t, stats_data, CAM_INTF_META_HISTOGRAM, pMetaData) {
         // process histogram statistics info
         qcamera_sm_internal_evt_payload_t *payload =
-            (qcamera_sm_internal_evt_payload_t *)
-                malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+            pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_HISTOGRAM_STATS;
@@ -1545,7 +1543,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt histogram failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
 
             }
@@ -1565,8 +1563,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
                 CDBG_HIGH("[KPI Perf] %s: PROFILE_NUMBER_OF_FACES_DETECTED %d",
                     __func__,faces_data->num_faces_detected);
             faces_data->fd_type = QCAMERA_FD_PREVIEW; //HARD CODE here before MCT can support
-            qcamera_sm_internal_evt_payload_t *payload = (qcamera_sm_internal_evt_payload_t *)
-                malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+            qcamera_sm_internal_evt_payload_t *payload = pme->m_stateMachine.allocEvtPayload();
             if (NULL != payload) {
                 memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
                 payload->evt_type = QCAMERA_INTERNAL_EVT_FACE_DETECT_RESULT;
@@ -1574,7 +1571,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
                 int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
                 if (rc != NO_ERROR) {
                     ALOGE("%s: processEvt face detection failed", __func__);
-                    free(payload);
+                    pme->m_stateMachine.releaseEvtPayload(payload);
                     payload = NULL;
                 }
             } else {
@@ -1586,7 +1583,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
     IF_META_AVAILABLE(cam_auto_focus_data_t, focus_data,
             CAM_INTF_META_AUTOFOCUS_DATA, pMetaData) {
         qcamera_sm_internal_evt_payload_t *payload =
-            (qcamera_sm_internal_evt_payload_t *)malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+            pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_FOCUS_UPDATE;
@@ -1595,7 +1592,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt focus failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
 
             }
@@ -1610,8 +1607,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
                 crop_data->num_of_streams);
         } else {
             qcamera_sm_internal_evt_payload_t *payload =
-                (qcamera_sm_internal_evt_payload_t *)
-                    malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+                pme->m_stateMachine.allocEvtPayload();
             if (NULL != payload) {
                 memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
                 payload->evt_type = QCAMERA_INTERNAL_EVT_CROP_INFO;
@@ -1619,7 +1615,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
                 int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
                 if (rc != NO_ERROR) {
                     ALOGE("%s: processEvt crop info failed", __func__);
-                    free(payload);
+                    pme->m_stateMachine.releaseEvtPayload(payload);
                     payload = NULL;
 
                 }
@@ -1633,7 +1629,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
     IF_META_AVAILABLE(int32_t, prep_snapshot_done_state,
             CAM_INTF_META_PREP_SNAPSHOT_DONE, pMetaData) {
         qcamera_sm_internal_evt_payload_t *payload =
-        (qcamera_sm_internal_evt_payload_t *)malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+        pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_PREP_SNAPSHOT_DONE;
@@ -1641,7 +1637,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt prep_snapshot failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
 
             }
@@ -1657,8 +1653,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
         //Handle this HDR meta data only if capture is not in process
         if (!pme->m_stateMachine.isCaptureRunning()) {
             qcamera_sm_internal_evt_payload_t *payload =
-                    (qcamera_sm_internal_evt_payload_t *)
-                    malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+                    pme->m_stateMachine.allocEvtPayload();
             if (NULL != payload) {
                 memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
                 payload->evt_type = QCAMERA_INTERNAL_EVT_HDR_UPDATE;
@@ -1666,7 +1661,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
                 int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
                 if (rc != NO_ERROR) {
                     ALOGE("%s: processEvt hdr update failed", __func__);
-                    free(payload);
+                    pme->m_stateMachine.releaseEvtPayload(payload);
                     payload = NULL;
                 }
             } else {
@@ -1678,7 +1673,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
 
     IF_META_AVAILABLE(int32_t, scene, CAM_INTF_META_ASD_SCENE_TYPE, pMetaData) {
         qcamera_sm_internal_evt_payload_t *payload =
-            (qcamera_sm_internal_evt_payload_t *)malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+            pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_ASD_UPDATE;
@@ -1686,7 +1681,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt asd_update failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
             }
         } else {
@@ -1697,8 +1692,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
     IF_META_AVAILABLE(cam_awb_params_t, awb_params, CAM_INTF_META_AWB_INFO, pMetaData) {
         CDBG_HIGH("%s, metadata for awb params.", __func__);
         qcamera_sm_internal_evt_payload_t *payload =
-                (qcamera_sm_internal_evt_payload_t *)
-                malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+                pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_AWB_UPDATE;
@@ -1706,7 +1700,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt awb_update failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
             }
         } else {
@@ -1732,8 +1726,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
         pme->mFlashNeeded = ae_params->flash_needed;
         pme->mExifParams.cam_3a_params.brightness = (float) pme->mParameters.getBrightness();
         qcamera_sm_internal_evt_payload_t *payload =
-                (qcamera_sm_internal_evt_payload_t *)
-                malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+                pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_AE_UPDATE;
@@ -1741,7 +1734,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt ae_update failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
             }
         } else {
@@ -1789,8 +1782,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
 
     IF_META_AVAILABLE(uint32_t, led_mode, CAM_INTF_META_LED_MODE_OVERRIDE, pMetaData) {
         qcamera_sm_internal_evt_payload_t *payload =
-                (qcamera_sm_internal_evt_payload_t *)
-                malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+                pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_LED_MODE_OVERRIDE;
@@ -1798,7 +1790,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt led mode override failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
             }
         } else {
@@ -1819,7 +1811,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
     IF_META_AVAILABLE(cam_focus_pos_info_t, cur_pos_info,
             CAM_INTF_META_FOCUS_POSITION, pMetaData) {
         qcamera_sm_internal_evt_payload_t *payload =
-            (qcamera_sm_internal_evt_payload_t *)malloc(sizeof(qcamera_sm_internal_evt_payload_t));
+            pme->m_stateMachine.allocEvtPayload();
         if (NULL != payload) {
             memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
             payload->evt_type = QCAMERA_INTERNAL_EVT_FOCUS_POS_UPDATE;
@@ -1827,7 +1819,7 @@ void QCamera2HardwareInterface::metadata_stream_cb_routine(mm_camera_super_buf_t
             int32_t rc = pme->processEvt(QCAMERA_SM_EVT_EVT_INTERNAL, payload);
             if (rc != NO_ERROR) {
                 ALOGE("%s: processEvt focus_pos_update failed", __func__);
-                free(payload);
+                pme->m_stateMachine.releaseEvtPayload(payload);
                 payload = NULL;
             }
         } else {
@@ -1899,9 +1891,8 @@ void QCamera2HardwareInterface::reprocess_stream_cb_routine(mm_camera_super_buf_
 void QCamera2HardwareInterface::dumpJpegToFile(const void *data,
         size_t size, uint32_t index)
 {
-    char value[PROPERTY_VALUE_MAX];
-    property_get("persist.camera.dumpimg", value, "0");
-    uint32_t enabled = (uint32_t) atoi(value);
+    uint32_t enabled = QCameraDebugConfig::isEnabled(QCAMERA_DBG_DUMP_IMG) ?
+            (uint32_t)QCameraDebugConfig::getValue(QCAMERA_DBG_DUMP_IMG) : 0;
     uint32_t frm_num = 0;
     uint32_t skip_mode = 0;
 
@@ -1960,11 +1951,10 @@ void QCamera2HardwareInterface::dumpJpegToFile(const void *data,
 void QCamera2HardwareInterface::dumpMetadataToFile(QCameraStream *stream,
                                                    mm_camera_buf_def_t *frame,char *type)
 {
-    char value[PROPERTY_VALUE_MAX];
     uint32_t frm_num = 0;
     metadata_buffer_t *metadata = (metadata_buffer_t *)frame->buffer;
-    property_get("persist.camera.dumpmetadata", value, "0");
-    uint32_t enabled = (uint32_t) atoi(value);
+    uint32_t enabled = QCameraDebugConfig::isEnabled(QCAMERA_DBG_DUMP_METADATA) ?
+            (uint32_t)QCameraDebugConfig::getValue(QCAMERA_DBG_DUMP_METADATA) : 0;
     if (stream == NULL) {
         CDBG_HIGH("No op");
         return;
@@ -2060,9 +2050,8 @@ void QCamera2HardwareInterface::dumpMetadataToFile(QCameraStream *stream,
 void QCamera2HardwareInterface::dumpFrameToFile(QCameraStream *stream,
         mm_camera_buf_def_t *frame, uint32_t dump_type)
 {
-    char value[PROPERTY_VALUE_MAX];
-    property_get("persist.camera.dumpimg", value, "0");
-    uint32_t enabled = (uint32_t) atoi(value);
+    uint32_t enabled = QCameraDebugConfig::isEnabled(QCAMERA_DBG_DUMP_IMG) ?
+            (uint32_t)QCameraDebugConfig::getValue(QCAMERA_DBG_DUMP_IMG) : 0;
     uint32_t frm_num = 0;
     uint32_t skip_mode = 0;
 
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <cutils/properties.h>
 #include <utils/Errors.h>
 #include <utils/Trace.h>
 #include <utils/Log.h>
@@ -570,7 +571,17 @@ void QCameraMemory::deallocOneBuffer(QCameraMemInfo &memInfo)
  * RETURN     : None
  *==========================================================================*/
 QCameraMemoryPool::QCameraMemoryPool()
+    : mSeq(0),
+      mHits(0),
+      mMisses(0),
+      mEvictions(0)
 {
+    // limits are set by the owner through setRetentionLimit
+    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++) {
+        mRetainedBytes[i] = 0;
+        mRetainedCnt[i] = 0;
+        mRetentionLimit[i] = QCAMERA_MEM_POOL_NO_LIMIT;
+    }
     pthread_mutex_init(&mLock, NULL);
 }
 
@@ -590,6 +601,28 @@ QCameraMemoryPool::~QCameraMemoryPool()
     pthread_mutex_destroy(&mLock);
 }
 
+/*===========================================================================
+ * FUNCTION   : getSizeClass
+ *
+ * DESCRIPTION: get the size class bucket of a buffer size
+ *
+ * PARAMETERS :
+ *   @size    : size of the buffer
+ *
+ * RETURN     : index of the size class
+ *==========================================================================*/
+size_t QCameraMemoryPool::getSizeClass(size_t size)
+{
+    size_t cls = 0;
+    size_t cap = (size_t)1 << QCAMERA_MEM_POOL_MIN_CLASS_SHIFT;
+
+    while ((cap < size) && (cls < QCAMERA_MEM_POOL_SIZE_CLASSES - 1)) {
+        cap <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
 /*===========================================================================
  * FUNCTION   : releaseBuffer
  *
@@ -605,11 +638,32 @@ void QCameraMemoryPool::releaseBuffer(
         struct QCameraMemory::QCameraMemInfo &memInfo,
         cam_stream_type_t streamType)
 {
+    EvictList evicted;
+    QCameraPoolEntry entry;
+
     pthread_mutex_lock(&mLock);
 
-    mPools[streamType].push_back(memInfo);
+    entry.memInfo = memInfo;
+    entry.seq = mSeq++;
+
+    android::Vector<QCameraPoolEntry> &bucket =
+            mPools[streamType][getSizeClass(memInfo.size)];
+    size_t pos = 0;
+    while ((pos < bucket.size()) &&
+            (bucket.itemAt(pos).memInfo.size <= memInfo.size)) {
+        pos++;
+    }
+    bucket.insertAt(entry, pos);
+    mRetainedBytes[streamType] += memInfo.size;
+    mRetainedCnt[streamType]++;
+
+    if (mRetainedBytes[streamType] > mRetentionLimit[streamType]) {
+        evictLocked(streamType, mRetentionLimit[streamType], evicted);
+    }
 
     pthread_mutex_unlock(&mLock);
+
+    deallocEvicted(evicted);
 }
 
 /*===========================================================================
@@ -626,22 +680,158 @@ void QCameraMemoryPool::clear()
     pthread_mutex_lock(&mLock);
 
     for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++ ) {
-        List<struct QCameraMemory::QCameraMemInfo>::iterator it;
-        it = mPools[i].begin();
-        for( ; it != mPools[i].end() ; it++) {
-            QCameraMemory::deallocOneBuffer(*it);
+        for (size_t c = 0; c < QCAMERA_MEM_POOL_SIZE_CLASSES; c++) {
+            android::Vector<QCameraPoolEntry> &bucket = mPools[i][c];
+            for (size_t k = 0; k < bucket.size(); k++) {
+                QCameraMemory::deallocOneBuffer(bucket.editItemAt(k).memInfo);
+            }
+            bucket.clear();
         }
+        mRetainedBytes[i] = 0;
+        mRetainedCnt[i] = 0;
+    }
+
+    pthread_mutex_unlock(&mLock);
+}
 
-        mPools[i].clear();
+/*===========================================================================
+ * FUNCTION   : trim
+ *
+ * DESCRIPTION: evict least recently released buffers of all stream types
+ *              until the pool retains at most the given amount of memory
+ *
+ * PARAMETERS :
+ *   @bytes   : max bytes to keep cached, 0 to drop everything
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::trim(size_t bytes)
+{
+    EvictList evicted;
+
+    pthread_mutex_lock(&mLock);
+    evictLocked(CAM_STREAM_TYPE_MAX, bytes, evicted);
+    pthread_mutex_unlock(&mLock);
+
+    deallocEvicted(evicted);
+}
+
+/*===========================================================================
+ * FUNCTION   : setRetentionLimit
+ *
+ * DESCRIPTION: set the max amount of memory cached for a stream type,
+ *              evicting buffers above the new limit right away
+ *
+ * PARAMETERS :
+ *   @streamType: type of stream the limit applies to
+ *   @bytes   : max bytes to keep cached, QCAMERA_MEM_POOL_NO_LIMIT for none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::setRetentionLimit(cam_stream_type_t streamType,
+        size_t bytes)
+{
+    EvictList evicted;
+
+    if (streamType >= CAM_STREAM_TYPE_MAX) {
+        return;
     }
 
+    pthread_mutex_lock(&mLock);
+    mRetentionLimit[streamType] = bytes;
+    evictLocked(streamType, bytes, evicted);
     pthread_mutex_unlock(&mLock);
+
+    deallocEvicted(evicted);
+}
+
+/*===========================================================================
+ * FUNCTION   : evictLocked
+ *
+ * DESCRIPTION: remove least recently released buffers from the pool until
+ *              retained memory fits the given amount. Buffers are handed
+ *              back to be freed after the pool lock is dropped.
+ *
+ * PARAMETERS :
+ *   @streamType: stream type to evict from, CAM_STREAM_TYPE_MAX for all
+ *   @bytes   : max bytes to keep cached
+ *   @evicted : [output] list of evicted buffers
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::evictLocked(int streamType, size_t bytes,
+        EvictList &evicted)
+{
+    int first = (streamType == CAM_STREAM_TYPE_MAX) ?
+            CAM_STREAM_TYPE_DEFAULT : streamType;
+    int last = (streamType == CAM_STREAM_TYPE_MAX) ?
+            CAM_STREAM_TYPE_MAX - 1 : streamType;
+
+    while (true) {
+        size_t retained = 0;
+        for (int i = first; i <= last; i++) {
+            retained += mRetainedBytes[i];
+        }
+        if (retained <= bytes) {
+            break;
+        }
+
+        // find the oldest released buffer
+        android::Vector<QCameraPoolEntry> *oldestBucket = NULL;
+        size_t oldestPos = 0;
+        int oldestType = first;
+        for (int i = first; i <= last; i++) {
+            for (size_t c = 0; c < QCAMERA_MEM_POOL_SIZE_CLASSES; c++) {
+                android::Vector<QCameraPoolEntry> &bucket = mPools[i][c];
+                for (size_t k = 0; k < bucket.size(); k++) {
+                    if ((oldestBucket == NULL) ||
+                            ((int32_t)(bucket.itemAt(k).seq -
+                            oldestBucket->itemAt(oldestPos).seq) < 0)) {
+                        oldestBucket = &bucket;
+                        oldestPos = k;
+                        oldestType = i;
+                    }
+                }
+            }
+        }
+        if (oldestBucket == NULL) {
+            break;
+        }
+
+        const QCameraPoolEntry &entry = oldestBucket->itemAt(oldestPos);
+        mRetainedBytes[oldestType] -= entry.memInfo.size;
+        mRetainedCnt[oldestType]--;
+        evicted.add(entry.memInfo);
+        oldestBucket->removeAt(oldestPos);
+        mEvictions++;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : deallocEvicted
+ *
+ * DESCRIPTION: free buffers evicted from the pool
+ *
+ * PARAMETERS :
+ *   @evicted : list of evicted buffers
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::deallocEvicted(EvictList &evicted)
+{
+    for (size_t i = 0; i < evicted.size(); i++) {
+        CDBG_HIGH("%s : Evicting cached buffer of size %zu", __func__,
+                evicted.itemAt(i).size);
+        QCameraMemory::deallocOneBuffer(evicted.editItemAt(i));
+    }
+    evicted.clear();
 }
 
 /*===========================================================================
  * FUNCTION   : findBufferLocked
  *
- * DESCRIPTION: search for a appropriate cached buffer
+ * DESCRIPTION: search for the smallest cached buffer that fits, looking at
+ *              the size class of the request and a few classes above it
  *
  * PARAMETERS :
  *   @memInfo : reference to struct that stores additional memory allocation info
@@ -658,33 +848,40 @@ int QCameraMemoryPool::findBufferLocked(
         struct QCameraMemory::QCameraMemInfo &memInfo, unsigned int heap_id,
         size_t size, bool cached, cam_stream_type_t streamType)
 {
-    int rc = NAME_NOT_FOUND;
-
-    if (mPools[streamType].empty()) {
+    if (0 == mRetainedCnt[streamType]) {
         return NAME_NOT_FOUND;
     }
 
-    List<struct QCameraMemory::QCameraMemInfo>::iterator it;
-    it = mPools[streamType].begin();
-    for ( ; it != mPools[streamType].end() ; it++) {
-        if ( ((*it).size >= size) &&
-            ((*it).heap_id == heap_id) &&
-            ((*it).cached == cached) ) {
-            memInfo = *it;
-            mPools[streamType].erase(it);
-            rc = NO_ERROR;
-            break;
+    size_t cls = getSizeClass(size);
+    for (size_t c = cls; (c < QCAMERA_MEM_POOL_SIZE_CLASSES) &&
+            (c <= cls + QCAMERA_MEM_POOL_MAX_FIT_CLASSES); c++) {
+        android::Vector<QCameraPoolEntry> &bucket = mPools[streamType][c];
+        // bucket is sorted by size, so the first fit is the best fit
+        for (size_t k = 0; k < bucket.size(); k++) {
+            const struct QCameraMemory::QCameraMemInfo &info =
+                    bucket.itemAt(k).memInfo;
+            if ((info.size >= size) &&
+                (info.heap_id == heap_id) &&
+                (info.cached == cached)) {
+                memInfo = info;
+                bucket.removeAt(k);
+                mRetainedBytes[streamType] -= memInfo.size;
+                mRetainedCnt[streamType]--;
+                return NO_ERROR;
+            }
         }
     }
 
-    return rc;
+    return NAME_NOT_FOUND;
 }
 
 /*===========================================================================
  * FUNCTION   : allocateBuffer
  *
  * DESCRIPTION: allocates a buffer from the memory pool,
- *              it will re-use cached buffers if possible
+ *              it will re-use cached buffers if possible. A new buffer is
+ *              allocated without holding the pool lock, and if that fails
+ *              all cached buffers are dropped before a second attempt.
  *
  * PARAMETERS :
  *   @memInfo : reference to struct that stores additional memory allocation info
@@ -705,17 +902,75 @@ int QCameraMemoryPool::allocateBuffer(
     int rc = NO_ERROR;
 
     pthread_mutex_lock(&mLock);
-
     rc = findBufferLocked(memInfo, heap_id, size, cached, streamType);
+    if (NO_ERROR == rc) {
+        mHits++;
+    } else {
+        mMisses++;
+    }
+    pthread_mutex_unlock(&mLock);
+
     if (NAME_NOT_FOUND == rc ) {
         CDBG_HIGH("%s : Buffer not found!", __func__);
         rc = QCameraMemory::allocOneBuffer(memInfo, heap_id, size, cached,
                  secure_mode);
+        if (rc < 0) {
+            EvictList evicted;
+
+            pthread_mutex_lock(&mLock);
+            evictLocked(CAM_STREAM_TYPE_MAX, 0, evicted);
+            pthread_mutex_unlock(&mLock);
+
+            if (!evicted.isEmpty()) {
+                ALOGE("%s : Allocation failed, retry after dropping %zu cached buffers",
+                        __func__, evicted.size());
+                deallocEvicted(evicted);
+                rc = QCameraMemory::allocOneBuffer(memInfo, heap_id, size,
+                        cached, secure_mode);
+            }
+        }
+    }
+
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : dump
+ *
+ * DESCRIPTION: Composes a string based on memory pool statistics
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : Formatted string
+ *==========================================================================*/
+String8 QCameraMemoryPool::dump()
+{
+    String8 str("\n");
+    char s[128];
+    size_t totalBytes = 0;
+
+    pthread_mutex_lock(&mLock);
+
+    snprintf(s, 128, "Pool Hits: %u Misses: %u Evictions: %u\n",
+            mHits, mMisses, mEvictions);
+    str += s;
+
+    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++) {
+        totalBytes += mRetainedBytes[i];
+        if (mRetainedCnt[i] == 0) {
+            continue;
+        }
+        snprintf(s, 128, "Stream type %d: %zu buffers, %zu bytes retained\n",
+                i, mRetainedCnt[i], mRetainedBytes[i]);
+        str += s;
     }
 
+    snprintf(s, 128, "Total bytes retained: %zu\n", totalBytes);
+    str += s;
+
     pthread_mutex_unlock(&mLock);
 
-    return rc;
+    return str;
 }
 
 /*===========================================================================
@@ -33,6 +33,8 @@
 #include <hardware/camera.h>
 #include <utils/Mutex.h>
 #include <utils/List.h>
+#include <utils/Vector.h>
+#include <utils/String8.h>
 #include <qdMetaData.h>
 
 extern "C" {
@@ -43,6 +45,13 @@ extern "C" {
 
 namespace qcamera {
 
+// Memory pool buckets buffers by power of two size class, starting at 4KB
+#define QCAMERA_MEM_POOL_MIN_CLASS_SHIFT    12
+#define QCAMERA_MEM_POOL_SIZE_CLASSES       16
+// Cached buffer may be at most this many classes bigger than requested
+#define QCAMERA_MEM_POOL_MAX_FIT_CLASSES    2
+#define QCAMERA_MEM_POOL_NO_LIMIT           ((size_t)-1)
+
 class QCameraMemoryPool;
 
 // Base class for all memory types. Abstract.
@@ -135,14 +144,35 @@ public:
     void releaseBuffer(struct QCameraMemory::QCameraMemInfo &memInfo,
             cam_stream_type_t streamType);
     void clear();
+    void trim(size_t bytes);
+    void setRetentionLimit(cam_stream_type_t streamType, size_t bytes);
+    android::String8 dump();
 
 protected:
 
+    struct QCameraPoolEntry {
+        struct QCameraMemory::QCameraMemInfo memInfo;
+        uint32_t seq;               // release order, oldest is evicted first
+    };
+    typedef android::Vector<struct QCameraMemory::QCameraMemInfo> EvictList;
+
     int findBufferLocked(struct QCameraMemory::QCameraMemInfo &memInfo,
             unsigned int heap_id, size_t size, bool cached,
             cam_stream_type_t streamType);
-
-    android::List<QCameraMemory::QCameraMemInfo> mPools[CAM_STREAM_TYPE_MAX];
+    void evictLocked(int streamType, size_t bytes, EvictList &evicted);
+    static void deallocEvicted(EvictList &evicted);
+    static size_t getSizeClass(size_t size);
+
+    // per stream type buckets, each sorted by ascending buffer size
+    android::Vector<QCameraPoolEntry>
+            mPools[CAM_STREAM_TYPE_MAX][QCAMERA_MEM_POOL_SIZE_CLASSES];
+    size_t mRetainedBytes[CAM_STREAM_TYPE_MAX];
+    size_t mRetainedCnt[CAM_STREAM_TYPE_MAX];
+    size_t mRetentionLimit[CAM_STREAM_TYPE_MAX];
+    uint32_t mSeq;
+    uint32_t mHits;
+    uint32_t mMisses;
+    uint32_t mEvictions;
     pthread_mutex_t mLock;
 };
 
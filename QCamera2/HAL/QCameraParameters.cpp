@@ -37,6 +37,7 @@
 #include <stdlib.h>
 #include <gralloc_priv.h>
 #include <sys/sysinfo.h>
+#include <pthread.h>
 #include "QCamera2HWI.h"
 #include "QCameraParameters.h"
 
@@ -746,6 +747,102 @@ const QCameraParameters::QCameraMap<int>
     { VIDEO_ROTATION_270, 270 }
 };
 
+const QCameraParameters::param_setter_entry_t
+        QCameraParameters::PARAM_SETTERS_TBL[] = {
+    { &QCameraParameters::setPreviewSize,         { KEY_PREVIEW_SIZE } },
+    { &QCameraParameters::setVideoSize,           { KEY_VIDEO_SIZE, KEY_PREVIEW_SIZE } },
+    { &QCameraParameters::setPictureSize,         { NULL } },
+    { &QCameraParameters::setPreviewFormat,       { KEY_PREVIEW_FORMAT } },
+    { &QCameraParameters::setPictureFormat,       { KEY_PICTURE_FORMAT } },
+    { &QCameraParameters::setJpegQuality,         { KEY_JPEG_QUALITY,
+                                                    KEY_JPEG_THUMBNAIL_QUALITY } },
+    { &QCameraParameters::setOrientation,         { KEY_QC_ORIENTATION } },
+    { &QCameraParameters::setRotation,            { KEY_ROTATION } },
+    { &QCameraParameters::setVideoRotation,       { KEY_QC_VIDEO_ROTATION } },
+    { &QCameraParameters::setNoDisplayMode,       { NULL } },
+    { &QCameraParameters::setZslMode,             { NULL } },
+    { &QCameraParameters::setZslAttributes,       { NULL } },
+    { &QCameraParameters::setCameraMode,          { KEY_QC_CAMERA_MODE } },
+    { &QCameraParameters::setSceneSelectionMode,  { KEY_QC_SCENE_SELECTION } },
+    { &QCameraParameters::setRecordingHint,       { KEY_RECORDING_HINT } },
+    { &QCameraParameters::setRdiMode,             { NULL } },
+    { &QCameraParameters::setSecureMode,          { NULL } },
+    { &QCameraParameters::setPreviewFrameRate,    { KEY_PREVIEW_FRAME_RATE } },
+    { &QCameraParameters::setPreviewFpsRange,     { NULL } },
+    { &QCameraParameters::setAutoExposure,        { KEY_QC_AUTO_EXPOSURE } },
+    { &QCameraParameters::setEffect,              { NULL } },
+    { &QCameraParameters::setBrightness,          { KEY_QC_BRIGHTNESS } },
+    { &QCameraParameters::setZoom,                { NULL } },
+    { &QCameraParameters::setSharpness,           { KEY_QC_SHARPNESS } },
+    { &QCameraParameters::setSaturation,          { KEY_QC_SATURATION } },
+    { &QCameraParameters::setContrast,            { KEY_QC_CONTRAST } },
+    { &QCameraParameters::setFocusMode,           { KEY_FOCUS_MODE } },
+    { &QCameraParameters::setISOValue,            { KEY_QC_ISO_MODE } },
+    { &QCameraParameters::setContinuousISO,       { KEY_QC_ISO_MODE,
+                                                    KEY_QC_CONTINUOUS_ISO } },
+    { &QCameraParameters::setExposureTime,        { KEY_QC_EXPOSURE_TIME } },
+    { &QCameraParameters::setSkinToneEnhancement, { KEY_QC_SCE_FACTOR } },
+    { &QCameraParameters::setFlash,               { KEY_FLASH_MODE } },
+    { &QCameraParameters::setAecLock,             { KEY_AUTO_EXPOSURE_LOCK } },
+    { &QCameraParameters::setAwbLock,             { KEY_AUTO_WHITEBALANCE_LOCK } },
+    { &QCameraParameters::setLensShadeValue,      { KEY_QC_LENSSHADE } },
+    { &QCameraParameters::setMCEValue,            { KEY_QC_MEMORY_COLOR_ENHANCEMENT } },
+    { &QCameraParameters::setDISValue,            { KEY_QC_DIS } },
+    { &QCameraParameters::setAntibanding,         { KEY_ANTIBANDING } },
+    { &QCameraParameters::setExposureCompensation,{ KEY_EXPOSURE_COMPENSATION } },
+    { &QCameraParameters::setWhiteBalance,        { KEY_WHITE_BALANCE } },
+    { &QCameraParameters::setHDRMode,             { KEY_QC_HDR_MODE } },
+    { &QCameraParameters::setHDRNeed1x,           { KEY_QC_HDR_NEED_1X } },
+    { &QCameraParameters::setManualWhiteBalance,  { KEY_WHITE_BALANCE,
+                                                    KEY_QC_MANUAL_WB_TYPE,
+                                                    KEY_QC_MANUAL_WB_VALUE } },
+    { &QCameraParameters::setSceneMode,           { KEY_SCENE_MODE } },
+    { &QCameraParameters::setFocusAreas,          { NULL } },
+    { &QCameraParameters::setFocusPosition,       { KEY_FOCUS_MODE,
+                                                    KEY_QC_MANUAL_FOCUS_POS_TYPE,
+                                                    KEY_QC_MANUAL_FOCUS_POSITION } },
+    { &QCameraParameters::setMeteringAreas,       { NULL } },
+    { &QCameraParameters::setSelectableZoneAf,    { KEY_QC_SELECTABLE_ZONE_AF } },
+    { &QCameraParameters::setRedeyeReduction,     { KEY_QC_REDEYE_REDUCTION } },
+    { &QCameraParameters::setAEBracket,           { NULL } },
+    { &QCameraParameters::setAutoHDR,             { NULL } },
+    { &QCameraParameters::setGpsLocation,         { KEY_GPS_PROCESSING_METHOD,
+                                                    KEY_GPS_LATITUDE,
+                                                    KEY_QC_GPS_LATITUDE_REF,
+                                                    KEY_GPS_LONGITUDE,
+                                                    KEY_QC_GPS_LONGITUDE_REF,
+                                                    KEY_QC_GPS_ALTITUDE_REF,
+                                                    KEY_GPS_ALTITUDE,
+                                                    KEY_QC_GPS_STATUS,
+                                                    KEY_GPS_TIMESTAMP } },
+    { &QCameraParameters::setWaveletDenoise,      { KEY_PICTURE_FORMAT, KEY_QC_DENOISE } },
+    { &QCameraParameters::setFaceRecognition,     { KEY_QC_FACE_RECOGNITION,
+                                                    KEY_QC_MAX_NUM_REQUESTED_FACES } },
+    { &QCameraParameters::setFlip,                { KEY_QC_PREVIEW_FLIP,
+                                                    KEY_QC_VIDEO_FLIP,
+                                                    KEY_QC_SNAPSHOT_PICTURE_FLIP } },
+    { &QCameraParameters::setVideoHDR,            { KEY_QC_VIDEO_HDR } },
+    { &QCameraParameters::setVtEnable,            { KEY_QC_VT_ENABLE } },
+    { &QCameraParameters::setAFBracket,           { KEY_QC_AF_BRACKET } },
+    { &QCameraParameters::setReFocus,             { KEY_QC_RE_FOCUS } },
+    { &QCameraParameters::setChromaFlash,         { KEY_QC_CHROMA_FLASH } },
+    { &QCameraParameters::setTruePortrait,        { KEY_QC_TRUE_PORTRAIT } },
+    { &QCameraParameters::setOptiZoom,            { KEY_QC_OPTI_ZOOM } },
+    { &QCameraParameters::setBurstNum,            { NULL } },
+    { &QCameraParameters::setBurstLEDOnPeriod,    { NULL } },
+    { &QCameraParameters::setRetroActiveBurstNum, { NULL } },
+    { &QCameraParameters::setSnapshotFDReq,       { NULL } },
+    { &QCameraParameters::setTintlessValue,       { NULL } },
+    { &QCameraParameters::setCDSMode,             { NULL } },
+    { &QCameraParameters::setTemporalDenoise,     { NULL } },
+    // update live snapshot size after all other parameters are set
+    { &QCameraParameters::setLiveSnapshotSize,    { NULL } },
+    { &QCameraParameters::setJpegThumbnailSize,   { NULL } },
+    { &QCameraParameters::setMobicat,             { NULL } },
+    { &QCameraParameters::setSeeMore,             { KEY_QC_SEE_MORE } },
+    { &QCameraParameters::setStillMore,           { KEY_QC_STILL_MORE } }
+};
+
 #define DEFAULT_CAMERA_AREA "(0, 0, 0, 0, 0)"
 #define DATA_PTR(MEM_OBJ,INDEX) MEM_OBJ->getPtr( INDEX )
 #define TOTAL_RAM_SIZE_512MB 536870912
@@ -856,6 +953,9 @@ QCameraParameters::QCameraParameters()
     mCurPPCount = 0;
     mBufBatchCnt = 0;
     mRotation = 0;
+    m_bFullParamUpdate = true;
+    mLastUpdateType = PARAM_UPDATE_FULL;
+    memset(mUpdateStats, 0, sizeof(mUpdateStats));
 }
 
 /*===========================================================================
@@ -939,6 +1039,9 @@ QCameraParameters::QCameraParameters(const String8 &params)
     mParmZoomLevel = 0;
     mCurPPCount = 0;
     mRotation = 0;
+    m_bFullParamUpdate = true;
+    mLastUpdateType = PARAM_UPDATE_FULL;
+    memset(mUpdateStats, 0, sizeof(mUpdateStats));
 }
 
 /*===========================================================================
@@ -983,6 +1086,163 @@ String8 QCameraParameters::createSizesString(const cam_dimension_t *sizes, size_
     return str;
 }
 
+/* Maps shorter than this are scanned linearly, longer ones go through a
+ * sorted index that is built on first lookup and kept for process life */
+#define QCAMERA_MAP_INDEX_MIN_LEN   8
+#define QCAMERA_MAP_INDEX_MAX_LEN   128
+#define QCAMERA_MAP_INDEX_SLOTS     64  // power of 2, > number of maps
+
+typedef struct {
+    const void *map;                            // published last
+    size_t len;
+    uint8_t by_name[QCAMERA_MAP_INDEX_MAX_LEN]; // entry ids sorted by desc
+    uint8_t by_val[QCAMERA_MAP_INDEX_MAX_LEN];  // entry ids sorted by val
+} qcamera_map_index_t;
+
+static qcamera_map_index_t g_mapIndex[QCAMERA_MAP_INDEX_SLOTS];
+static pthread_mutex_t g_mapIndexLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*===========================================================================
+ * FUNCTION   : findMapIndex
+ *
+ * DESCRIPTION: find the index slot of a map in the open addressed table
+ *
+ * PARAMETERS :
+ *   @map     : map the index is built for
+ *   @len     : size of the map
+ *   @empty   : [output] first empty slot on the probe path if not found
+ *
+ * RETURN     : published index of the map, NULL if not built yet
+ *==========================================================================*/
+static qcamera_map_index_t *findMapIndex(const void *map, size_t len,
+        qcamera_map_index_t **empty)
+{
+    size_t slot = ((uintptr_t)map >> 3) & (QCAMERA_MAP_INDEX_SLOTS - 1);
+
+    if (empty != NULL) {
+        *empty = NULL;
+    }
+    for (size_t n = 0; n < QCAMERA_MAP_INDEX_SLOTS; n++) {
+        qcamera_map_index_t *idx = &g_mapIndex[slot];
+        const void *cur = __atomic_load_n(&idx->map, __ATOMIC_ACQUIRE);
+        if (cur == NULL) {
+            if (empty != NULL) {
+                *empty = idx;
+            }
+            break;
+        }
+        if (cur == map && idx->len == len) {
+            return idx;
+        }
+        slot = (slot + 1) & (QCAMERA_MAP_INDEX_SLOTS - 1);
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : compareMapDesc
+ *
+ * DESCRIPTION: order two map names, NULL sorts before any name
+ *
+ * PARAMETERS :
+ *   @a       : first name
+ *   @b       : second name
+ *
+ * RETURN     : <0, 0 or >0 as strcmp
+ *==========================================================================*/
+static inline int compareMapDesc(const char *a, const char *b)
+{
+    if (a == NULL || b == NULL) {
+        return (a == b) ? 0 : ((a == NULL) ? -1 : 1);
+    }
+    return strcmp(a, b);
+}
+
+/*===========================================================================
+ * FUNCTION   : getMapIndex
+ *
+ * DESCRIPTION: get the sorted index of a map, build it on first use. Sorting
+ *              is stable so the first entry of equal names/values in the
+ *              map is still the one found, as with a linear scan.
+ *
+ * PARAMETERS :
+ *   @arr     : map contains <name, value>
+ *   @len     : size of the map
+ *
+ * RETURN     : index of the map
+ *              NULL if the map should be scanned linearly
+ *==========================================================================*/
+template <class mapType> const qcamera_map_index_t *getMapIndex(
+        const mapType *arr, size_t len)
+{
+    if (len < QCAMERA_MAP_INDEX_MIN_LEN || len > QCAMERA_MAP_INDEX_MAX_LEN) {
+        return NULL;
+    }
+
+    qcamera_map_index_t *idx = findMapIndex(arr, len, NULL);
+    if (idx != NULL) {
+        return idx;
+    }
+
+    pthread_mutex_lock(&g_mapIndexLock);
+    qcamera_map_index_t *slot = NULL;
+    idx = findMapIndex(arr, len, &slot);
+    if (idx == NULL && slot != NULL) {
+        // insertion sort keeps equal entries in map order
+        for (size_t i = 0; i < len; i++) {
+            size_t j = i;
+            while (j > 0 && compareMapDesc(arr[slot->by_name[j - 1]].desc,
+                    arr[i].desc) > 0) {
+                slot->by_name[j] = slot->by_name[j - 1];
+                j--;
+            }
+            slot->by_name[j] = (uint8_t)i;
+
+            j = i;
+            while (j > 0 && (int)arr[slot->by_val[j - 1]].val > (int)arr[i].val) {
+                slot->by_val[j] = slot->by_val[j - 1];
+                j--;
+            }
+            slot->by_val[j] = (uint8_t)i;
+        }
+        slot->len = len;
+        __atomic_store_n(&slot->map, (const void *)arr, __ATOMIC_RELEASE);
+        idx = slot;
+    } else if (idx == NULL) {
+        ALOGE("%s: map index table is full", __func__);
+    }
+    pthread_mutex_unlock(&g_mapIndexLock);
+    return idx;
+}
+
+/*===========================================================================
+ * FUNCTION   : lowerBoundByVal
+ *
+ * DESCRIPTION: find the position of the first entry with a value not less
+ *              than the given one in the value sorted index
+ *
+ * PARAMETERS :
+ *   @arr     : map contains <name, value>
+ *   @idx     : sorted index of the map
+ *   @value   : value to be looked up
+ *
+ * RETURN     : position in idx->by_val, idx->len if all values are less
+ *==========================================================================*/
+template <class mapType> size_t lowerBoundByVal(const mapType *arr,
+        const qcamera_map_index_t *idx, int value)
+{
+    size_t lo = 0, hi = idx->len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((int)arr[idx->by_val[mid]].val < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
 /*===========================================================================
  * FUNCTION   : createValuesString
  *
@@ -1002,8 +1262,24 @@ template <typename valuesType, class mapType> String8 createValuesString(
 {
     String8 str;
     int count = 0;
+    const qcamera_map_index_t *idx = getMapIndex(map, map_len);
 
     for (size_t i = 0; i < len; i++ ) {
+        if (idx != NULL) {
+            int value = (int)values[i];
+            for (size_t k = lowerBoundByVal(map, idx, value);
+                    k < idx->len && (int)map[idx->by_val[k]].val == value; k++) {
+                if (NULL != map[idx->by_val[k]].desc) {
+                    if (count > 0) {
+                        str.append(",");
+                    }
+                    str.append(map[idx->by_val[k]].desc);
+                    count++;
+                    break; //loop k
+                }
+            }
+            continue;
+        }
         for (size_t j = 0; j < map_len; j ++)
             if (map[j].val == values[i]) {
                 if (NULL != map[j].desc) {
@@ -1253,6 +1529,21 @@ template <class mapType> int lookupAttr(const mapType *arr,
         size_t len, const char *name)
 {
     if (name) {
+        const qcamera_map_index_t *idx = getMapIndex(arr, len);
+        if (idx != NULL) {
+            size_t lo = 0, hi = idx->len;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (compareMapDesc(arr[idx->by_name[mid]].desc, name) < 0) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            if (lo < idx->len && !strcmp(arr[idx->by_name[lo]].desc, name))
+                return arr[idx->by_name[lo]].val;
+            return NAME_NOT_FOUND;
+        }
         for (size_t i = 0; i < len; i++) {
             if (!strcmp(arr[i].desc, name))
                 return arr[i].val;
@@ -1276,6 +1567,14 @@ template <class mapType> int lookupAttr(const mapType *arr,
 template <class mapType> const char *lookupNameByValue(const mapType *arr,
         size_t len, int value)
 {
+    const qcamera_map_index_t *idx = getMapIndex(arr, len);
+    if (idx != NULL) {
+        size_t k = lowerBoundByVal(arr, idx, value);
+        if (k < idx->len && (int)arr[idx->by_val[k]].val == value) {
+            return arr[idx->by_val[k]].desc;
+        }
+        return NULL;
+    }
     for (size_t i = 0; i < len; i++) {
         if (arr[i].val == value) {
             return arr[i].desc;
@@ -4461,7 +4760,9 @@ int32_t QCameraParameters::setMobicat(const QCameraParameters& )
 /*===========================================================================
  * FUNCTION   : updateParameters
  *
- * DESCRIPTION: update parameters from user setting
+ * DESCRIPTION: update parameters from user setting. Only setters whose keys
+ *              changed against current setting are applied, so that only
+ *              their entries go into the batch.
  *
  * PARAMETERS :
  *   @params  : user setting parameters
@@ -4476,6 +4777,10 @@ int32_t QCameraParameters::updateParameters(QCameraParameters& params,
 {
     int32_t final_rc = NO_ERROR;
     int32_t rc;
+    size_t skipped = 0;
+    nsecs_t start = systemTime(CLOCK_MONOTONIC);
+    param_update_type_t type = m_bFullParamUpdate ?
+            PARAM_UPDATE_FULL : PARAM_UPDATE_CHANGED_KEYS;
     m_bNeedRestart = false;
 
     if(initBatchUpdate(m_pParamBuf) < 0 ) {
@@ -4484,87 +4789,39 @@ int32_t QCameraParameters::updateParameters(QCameraParameters& params,
         goto UPDATE_PARAM_DONE;
     }
 
-    if ((rc = setPreviewSize(params)))                  final_rc = rc;
-    if ((rc = setVideoSize(params)))                    final_rc = rc;
-    if ((rc = setPictureSize(params)))                  final_rc = rc;
-    if ((rc = setPreviewFormat(params)))                final_rc = rc;
-    if ((rc = setPictureFormat(params)))                final_rc = rc;
-    if ((rc = setJpegQuality(params)))                  final_rc = rc;
-    if ((rc = setOrientation(params)))                  final_rc = rc;
-    if ((rc = setRotation(params)))                     final_rc = rc;
-    if ((rc = setVideoRotation(params)))                final_rc = rc;
-    if ((rc = setNoDisplayMode(params)))                final_rc = rc;
-    if ((rc = setZslMode(params)))                      final_rc = rc;
-    if ((rc = setZslAttributes(params)))                final_rc = rc;
-    if ((rc = setCameraMode(params)))                   final_rc = rc;
-    if ((rc = setSceneSelectionMode(params)))           final_rc = rc;
-    if ((rc = setRecordingHint(params)))                final_rc = rc;
-    if ((rc = setRdiMode(params)))                      final_rc = rc;
-    if ((rc = setSecureMode(params)))                   final_rc = rc;
-    if ((rc = setPreviewFrameRate(params)))             final_rc = rc;
-    if ((rc = setPreviewFpsRange(params)))              final_rc = rc;
-    if ((rc = setAutoExposure(params)))                 final_rc = rc;
-    if ((rc = setEffect(params)))                       final_rc = rc;
-    if ((rc = setBrightness(params)))                   final_rc = rc;
-    if ((rc = setZoom(params)))                         final_rc = rc;
-    if ((rc = setSharpness(params)))                    final_rc = rc;
-    if ((rc = setSaturation(params)))                   final_rc = rc;
-    if ((rc = setContrast(params)))                     final_rc = rc;
-    if ((rc = setFocusMode(params)))                    final_rc = rc;
-    if ((rc = setISOValue(params)))                     final_rc = rc;
-    if ((rc = setContinuousISO(params)))                final_rc = rc;
-    if ((rc = setExposureTime(params)))                 final_rc = rc;
-    if ((rc = setSkinToneEnhancement(params)))          final_rc = rc;
-    if ((rc = setFlash(params)))                        final_rc = rc;
-    if ((rc = setAecLock(params)))                      final_rc = rc;
-    if ((rc = setAwbLock(params)))                      final_rc = rc;
-    if ((rc = setLensShadeValue(params)))               final_rc = rc;
-    if ((rc = setMCEValue(params)))                     final_rc = rc;
-    if ((rc = setDISValue(params)))                     final_rc = rc;
-    if ((rc = setAntibanding(params)))                  final_rc = rc;
-    if ((rc = setExposureCompensation(params)))         final_rc = rc;
-    if ((rc = setWhiteBalance(params)))                 final_rc = rc;
-    if ((rc = setHDRMode(params)))                      final_rc = rc;
-    if ((rc = setHDRNeed1x(params)))                    final_rc = rc;
-    if ((rc = setManualWhiteBalance(params)))           final_rc = rc;
-    if ((rc = setSceneMode(params)))                    final_rc = rc;
-    if ((rc = setFocusAreas(params)))                   final_rc = rc;
-    if ((rc = setFocusPosition(params)))                final_rc = rc;
-    if ((rc = setMeteringAreas(params)))                final_rc = rc;
-    if ((rc = setSelectableZoneAf(params)))             final_rc = rc;
-    if ((rc = setRedeyeReduction(params)))              final_rc = rc;
-    if ((rc = setAEBracket(params)))                    final_rc = rc;
-    if ((rc = setAutoHDR(params)))                      final_rc = rc;
-    if ((rc = setGpsLocation(params)))                  final_rc = rc;
-    if ((rc = setWaveletDenoise(params)))               final_rc = rc;
-    if ((rc = setFaceRecognition(params)))              final_rc = rc;
-    if ((rc = setFlip(params)))                         final_rc = rc;
-    if ((rc = setVideoHDR(params)))                     final_rc = rc;
-    if ((rc = setVtEnable(params)))                     final_rc = rc;
-    if ((rc = setAFBracket(params)))                    final_rc = rc;
-    if ((rc = setReFocus(params)))                      final_rc = rc;
-    if ((rc = setChromaFlash(params)))                  final_rc = rc;
-    if ((rc = setTruePortrait(params)))                 final_rc = rc;
-    if ((rc = setOptiZoom(params)))                     final_rc = rc;
-    if ((rc = setBurstNum(params)))                     final_rc = rc;
-    if ((rc = setBurstLEDOnPeriod(params)))             final_rc = rc;
-    if ((rc = setRetroActiveBurstNum(params)))          final_rc = rc;
-    if ((rc = setSnapshotFDReq(params)))                final_rc = rc;
-    if ((rc = setTintlessValue(params)))                final_rc = rc;
-    if ((rc = setCDSMode(params)))                      final_rc = rc;
-    if ((rc = setTemporalDenoise(params)))              final_rc = rc;
+    for (size_t i = 0; i < PARAM_MAP_SIZE(PARAM_SETTERS_TBL); i++) {
+        const param_setter_entry_t &entry = PARAM_SETTERS_TBL[i];
+        if (!m_bFullParamUpdate && !isParamChanged(params, entry.keys)) {
+            skipped++;
+            continue;
+        }
+        if ((rc = (this->*entry.setter)(params)))       final_rc = rc;
+    }
 
-    // update live snapshot size after all other parameters are set
-    if ((rc = setLiveSnapshotSize(params)))             final_rc = rc;
-    if ((rc = setJpegThumbnailSize(params)))            final_rc = rc;
     if ((rc = setStatsDebugMask()))                     final_rc = rc;
     if ((rc = setPAAF()))                               final_rc = rc;
-    if ((rc = setMobicat(params)))                      final_rc = rc;
-    if ((rc = setSeeMore(params)))                      final_rc = rc;
-    if ((rc = setStillMore(params)))                    final_rc = rc;
 
     if ((rc = updateFlash(false)))                      final_rc = rc;
 
+    // batch is not committed on failure while some setters already updated
+    // the local copy, so comparing against it next time is not reliable
+    m_bFullParamUpdate = (final_rc != NO_ERROR);
+
+    {
+        param_update_stats_t &stats = mUpdateStats[type];
+        nsecs_t elapsed = systemTime(CLOCK_MONOTONIC) - start;
+        stats.count++;
+        stats.setters += PARAM_MAP_SIZE(PARAM_SETTERS_TBL) - skipped;
+        stats.update_total += elapsed;
+        if (elapsed > stats.update_max) {
+            stats.update_max = elapsed;
+        }
+        mLastUpdateType = type;
+        CDBG("%s: skipped %zu of %zu setters, %lld us", __func__,
+                skipped, PARAM_MAP_SIZE(PARAM_SETTERS_TBL),
+                (long long)(elapsed / 1000));
+    }
+
 UPDATE_PARAM_DONE:
     needRestart = m_bNeedRestart;
     return final_rc;
@@ -4583,7 +4840,53 @@ UPDATE_PARAM_DONE:
  *==========================================================================*/
 int32_t QCameraParameters::commitParameters()
 {
-    return commitSetBatch();
+    param_update_stats_t &stats = mUpdateStats[mLastUpdateType];
+    nsecs_t start = systemTime(CLOCK_MONOTONIC);
+    int32_t rc = commitSetBatch();
+    nsecs_t elapsed = systemTime(CLOCK_MONOTONIC) - start;
+
+    stats.commits++;
+    stats.commit_total += elapsed;
+    if (elapsed > stats.commit_max) {
+        stats.commit_max = elapsed;
+    }
+    if (rc != NO_ERROR) {
+        m_bFullParamUpdate = true;
+    }
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : isParamChanged
+ *
+ * DESCRIPTION: check if any of the given keys in user setting differs from
+ *              current setting
+ *
+ * PARAMETERS :
+ *   @params  : user setting parameters
+ *   @keys    : NULL terminated list of keys, empty list means always changed
+ *
+ * RETURN     : true if setting for any key changed, false otherwise
+ *==========================================================================*/
+bool QCameraParameters::isParamChanged(const QCameraParameters& params,
+        const char * const *keys)
+{
+    if (keys[0] == NULL) {
+        return true;
+    }
+
+    for (size_t i = 0; (i < QCAMERA_PARAM_SETTER_MAX_KEYS) && (keys[i] != NULL); i++) {
+        const char *str = params.get(keys[i]);
+        const char *prev_str = get(keys[i]);
+        if (str == NULL || prev_str == NULL) {
+            if (str != prev_str) {
+                return true;
+            }
+        } else if (strcmp(str, prev_str) != 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 /*===========================================================================
@@ -11968,6 +12271,24 @@ String8 QCameraParameters::dump()
         getBurstCountForAdvancedCapture());
     str += s;
 
+    for (int i = 0; i < PARAM_UPDATE_MAX; i++) {
+        const param_update_stats_t &stats = mUpdateStats[i];
+        snprintf(s, 128, "updateParameters %s: %u calls, avg %llu setters, "
+                "avg %lld us, max %lld us\n",
+                (i == PARAM_UPDATE_FULL) ? "full" : "changed keys",
+                stats.count,
+                (unsigned long long)(stats.count ? stats.setters / stats.count : 0),
+                (long long)(stats.count ? stats.update_total / stats.count / 1000 : 0),
+                (long long)(stats.update_max / 1000));
+        str += s;
+        snprintf(s, 128, "commitParameters %s: %u calls, avg %lld us, max %lld us\n",
+                (i == PARAM_UPDATE_FULL) ? "full" : "changed keys",
+                stats.commits,
+                (long long)(stats.commits ? stats.commit_total / stats.commits / 1000 : 0),
+                (long long)(stats.commit_max / 1000));
+        str += s;
+    }
+
     return str;
 }
 
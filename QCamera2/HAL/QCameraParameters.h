@@ -24,6 +24,7 @@
 #include <hardware/camera.h>
 #include <stdlib.h>
 #include <utils/Errors.h>
+#include <utils/Timers.h>
 #include "cam_intf.h"
 #include "cam_types.h"
 #include "QCameraMem.h"
@@ -46,6 +47,9 @@ static const char ExifUndefinedPrefix[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 
 #define CAMERA_MIN_BATCH_COUNT           1
 
+// max number of parameter keys a single user setting setter depends on
+#define QCAMERA_PARAM_SETTER_MAX_KEYS    10
+
 class QCameraAdjustFPS
 {
 public:
@@ -967,6 +971,35 @@ private:
     static const QCameraMap<int> SEE_MORE_MODES_MAP[];
     static const QCameraMap<int> STILL_MORE_MODES_MAP[];
 
+    // Setters applied by updateParameters, in order. Each one only runs when
+    // one of the keys it consumes differs from the current setting; entries
+    // without keys depend on state beyond the keys and always run.
+    typedef int32_t (QCameraParameters::*param_setter_t)(const QCameraParameters&);
+    typedef struct {
+        param_setter_t setter;
+        const char *keys[QCAMERA_PARAM_SETTER_MAX_KEYS];
+    } param_setter_entry_t;
+    static const param_setter_entry_t PARAM_SETTERS_TBL[];
+    bool isParamChanged(const QCameraParameters& params,
+            const char * const *keys);
+
+    // latency of updateParameters and of the commit that follows it,
+    // for changed-key passes and for full passes
+    typedef enum {
+        PARAM_UPDATE_CHANGED_KEYS,
+        PARAM_UPDATE_FULL,
+        PARAM_UPDATE_MAX
+    } param_update_type_t;
+    typedef struct {
+        uint32_t count;
+        uint64_t setters;           // setters run, summed over count
+        nsecs_t update_total;
+        nsecs_t update_max;
+        uint32_t commits;
+        nsecs_t commit_total;
+        nsecs_t commit_max;
+    } param_update_stats_t;
+
     cam_capability_t *m_pCapability;
     mm_camera_vtbl_t *m_pCamOpsTbl;
     QCameraHeapMemory *m_pParamHeap;
@@ -1057,6 +1090,9 @@ private:
     int8_t mBufBatchCnt;
 
     uint32_t mRotation;
+    bool m_bFullParamUpdate;        // run all setters on next updateParameters
+    param_update_type_t mLastUpdateType;
+    param_update_stats_t mUpdateStats[PARAM_UPDATE_MAX];
 };
 
 }; // namespace qcamera
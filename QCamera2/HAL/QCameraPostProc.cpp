@@ -1907,6 +1907,14 @@ int32_t QCameraPostProcessor::encodeData(qcamera_jpeg_data_t *jpeg_job_data,
         jpg_job.encode_job.dst_index = -1;
     }
 
+    // Burst frames yield to a pending single shot in the jpeg job manager
+    if (m_parent->isLongshotEnabled() ||
+            (m_parent->numOfSnapshotsExpected() > 1)) {
+        jpg_job.encode_job.priority = MM_JPEG_JOB_PRIO_BURST;
+    } else {
+        jpg_job.encode_job.priority = MM_JPEG_JOB_PRIO_SINGLE_SHOT;
+    }
+
     cam_dimension_t src_dim;
     memset(&src_dim, 0, sizeof(cam_dimension_t));
     main_stream->getFrameDimension(src_dim);
@@ -2954,7 +2962,8 @@ int QCameraPostProcessor::getJpegMemory(omx_jpeg_ouput_buf_t *out_buf)
  * RETURN     : None
  *==========================================================================*/
 QCameraExif::QCameraExif()
-    : m_nNumEntries(0)
+    : m_nNumEntries(0),
+      m_nArenaUsed(0)
 {
     memset(m_Entries, 0, sizeof(m_Entries));
 }
@@ -2962,7 +2971,8 @@ QCameraExif::QCameraExif()
 /*===========================================================================
  * FUNCTION   : ~QCameraExif
  *
- * DESCRIPTION: deconstructor of QCameraExif. Will release internal memory ptr.
+ * DESCRIPTION: deconstructor of QCameraExif. Tag values live in the
+ *              object arena, so there is nothing to release per tag.
  *
  * PARAMETERS : None
  *
@@ -2970,86 +2980,15 @@ QCameraExif::QCameraExif()
  *==========================================================================*/
 QCameraExif::~QCameraExif()
 {
-    for (uint32_t i = 0; i < m_nNumEntries; i++) {
-        switch (m_Entries[i].tag_entry.type) {
-        case EXIF_BYTE:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._bytes != NULL) {
-                    free(m_Entries[i].tag_entry.data._bytes);
-                    m_Entries[i].tag_entry.data._bytes = NULL;
-                }
-            }
-            break;
-        case EXIF_ASCII:
-            {
-                if (m_Entries[i].tag_entry.data._ascii != NULL) {
-                    free(m_Entries[i].tag_entry.data._ascii);
-                    m_Entries[i].tag_entry.data._ascii = NULL;
-                }
-            }
-            break;
-        case EXIF_SHORT:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._shorts != NULL) {
-                    free(m_Entries[i].tag_entry.data._shorts);
-                    m_Entries[i].tag_entry.data._shorts = NULL;
-                }
-            }
-            break;
-        case EXIF_LONG:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._longs != NULL) {
-                    free(m_Entries[i].tag_entry.data._longs);
-                    m_Entries[i].tag_entry.data._longs = NULL;
-                }
-            }
-            break;
-        case EXIF_RATIONAL:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._rats != NULL) {
-                    free(m_Entries[i].tag_entry.data._rats);
-                    m_Entries[i].tag_entry.data._rats = NULL;
-                }
-            }
-            break;
-        case EXIF_UNDEFINED:
-            {
-                if (m_Entries[i].tag_entry.data._undefined != NULL) {
-                    free(m_Entries[i].tag_entry.data._undefined);
-                    m_Entries[i].tag_entry.data._undefined = NULL;
-                }
-            }
-            break;
-        case EXIF_SLONG:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._slongs != NULL) {
-                    free(m_Entries[i].tag_entry.data._slongs);
-                    m_Entries[i].tag_entry.data._slongs = NULL;
-                }
-            }
-            break;
-        case EXIF_SRATIONAL:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._srats != NULL) {
-                    free(m_Entries[i].tag_entry.data._srats);
-                    m_Entries[i].tag_entry.data._srats = NULL;
-                }
-            }
-            break;
-        }
-    }
 }
 
 /*===========================================================================
  * FUNCTION   : addEntry
  *
- * DESCRIPTION: function to add an entry to exif data
+ * DESCRIPTION: function to add an entry to exif data. Strings and arrays
+ *              are copied into the object arena. Entries are kept in the
+ *              order they are written into APP1 and a repeated tag
+ *              replaces the earlier value.
  *
  * PARAMETERS :
  *   @tagid   : exif tag ID
@@ -3066,143 +3005,103 @@ int32_t QCameraExif::addEntry(exif_tag_id_t tagid,
                               uint32_t count,
                               void *data)
 {
-    int32_t rc = NO_ERROR;
-    if(m_nNumEntries >= MAX_EXIF_TABLE_ENTRIES) {
+    uint32_t order = mm_jpeg_exif_tag_order(tagid);
+    uint32_t i = m_nNumEntries;
+    uint32_t size = count;
+    exif_tag_entry_t entry;
+
+    // tags mostly arrive in order, search from the back
+    while ((i > 0) && (mm_jpeg_exif_tag_order(m_Entries[i - 1].tag_id) > order)) {
+        i--;
+    }
+    bool replace = (i > 0) && (m_Entries[i - 1].tag_id == tagid);
+    if (!replace && (m_nNumEntries >= MAX_EXIF_TABLE_ENTRIES)) {
         ALOGE("%s: Number of entries exceeded limit", __func__);
         return NO_MEMORY;
     }
 
-    m_Entries[m_nNumEntries].tag_id = tagid;
-    m_Entries[m_nNumEntries].tag_entry.type = type;
-    m_Entries[m_nNumEntries].tag_entry.count = count;
-    m_Entries[m_nNumEntries].tag_entry.copy = 1;
     switch (type) {
-    case EXIF_BYTE:
-        {
-            if (count > 1) {
-                uint8_t *values = (uint8_t *)malloc(count);
-                if (values == NULL) {
-                    ALOGE("%s: No memory for byte array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count);
-                    m_Entries[m_nNumEntries].tag_entry.data._bytes = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._byte = *(uint8_t *)data;
-            }
-        }
-        break;
-    case EXIF_ASCII:
-        {
-            char *str = NULL;
-            str = (char *)malloc(count + 1);
-            if (str == NULL) {
-                ALOGE("%s: No memory for ascii string", __func__);
-                rc = NO_MEMORY;
-            } else {
-                memset(str, 0, count + 1);
-                memcpy(str, data, count);
-                m_Entries[m_nNumEntries].tag_entry.data._ascii = str;
-            }
-        }
-        break;
     case EXIF_SHORT:
-        {
-            if (count > 1) {
-                uint16_t *values = (uint16_t *)malloc(count * sizeof(uint16_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for short array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(uint16_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._shorts = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._short = *(uint16_t *)data;
-            }
-        }
+        size = count * (uint32_t)sizeof(uint16_t);
         break;
     case EXIF_LONG:
-        {
-            if (count > 1) {
-                uint32_t *values = (uint32_t *)malloc(count * sizeof(uint32_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for long array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(uint32_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._longs = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._long = *(uint32_t *)data;
-            }
-        }
+    case EXIF_SLONG:
+        size = count * (uint32_t)sizeof(uint32_t);
         break;
     case EXIF_RATIONAL:
-        {
-            if (count > 1) {
-                rat_t *values = (rat_t *)malloc(count * sizeof(rat_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for rational array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(rat_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._rats = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._rat = *(rat_t *)data;
-            }
-        }
-        break;
-    case EXIF_UNDEFINED:
-        {
-            uint8_t *values = (uint8_t *)malloc(count);
-            if (values == NULL) {
-                ALOGE("%s: No memory for undefined array", __func__);
-                rc = NO_MEMORY;
-            } else {
-                memcpy(values, data, count);
-                m_Entries[m_nNumEntries].tag_entry.data._undefined = values;
-            }
-        }
+    case EXIF_SRATIONAL:
+        size = count * (uint32_t)sizeof(rat_t);
         break;
-    case EXIF_SLONG:
-        {
-            if (count > 1) {
-                int32_t *values = (int32_t *)malloc(count * sizeof(int32_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for signed long array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(int32_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._slongs = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._slong = *(int32_t *)data;
-            }
-        }
+    default:
         break;
-    case EXIF_SRATIONAL:
-        {
-            if (count > 1) {
-                srat_t *values = (srat_t *)malloc(count * sizeof(srat_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for signed rational array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(srat_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._srats = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._srat = *(srat_t *)data;
-            }
+    }
+
+    memset(&entry, 0, sizeof(entry));
+    entry.type = type;
+    entry.count = count;
+    entry.copy = 1;
+    if ((count > 1) || (type == EXIF_ASCII) || (type == EXIF_UNDEFINED)) {
+        // keep strings terminated and every chunk aligned for rationals
+        uint32_t aligned = (size + 1 + 7) & ~7U;
+        if (aligned > sizeof(m_Arena) - m_nArenaUsed) {
+            ALOGE("%s: No arena space for tag 0x%x (%u bytes)",
+                    __func__, tagid, size);
+            return NO_MEMORY;
         }
-        break;
+        uint8_t *values = (uint8_t *)m_Arena + m_nArenaUsed;
+        m_nArenaUsed += aligned;
+        memcpy(values, data, size);
+        values[size] = 0;
+        // all pointer members of the union share its first word
+        entry.data._bytes = values;
+    } else {
+        // so do the single values
+        memcpy(&entry.data, data, size);
     }
 
-    // Increase number of entries
-    m_nNumEntries++;
+    if (replace) {
+        i--;
+    } else {
+        memmove(&m_Entries[i + 1], &m_Entries[i],
+                (m_nNumEntries - i) * sizeof(m_Entries[0]));
+        m_nNumEntries++;
+    }
+    m_Entries[i].tag_id = tagid;
+    m_Entries[i].tag_entry = entry;
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : addEntries
+ *
+ * DESCRIPTION: copy all entries of a template, used for the tags that
+ *              stay the same for the whole camera session
+ *
+ * PARAMETERS :
+ *   @src     : template to copy from
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraExif::addEntries(const QCameraExif &src)
+{
+    int32_t rc = NO_ERROR;
+
+    for (uint32_t i = 0; i < src.m_nNumEntries; i++) {
+        const QEXIF_INFO_DATA &e = src.m_Entries[i];
+        const void *data = e.tag_entry.data._bytes;
+        if ((e.tag_entry.count <= 1) &&
+                (e.tag_entry.type != EXIF_ASCII) &&
+                (e.tag_entry.type != EXIF_UNDEFINED)) {
+            data = &e.tag_entry.data;
+        }
+        int32_t ret = addEntry(e.tag_id, e.tag_entry.type,
+                e.tag_entry.count, (void *)data);
+        if (ret != NO_ERROR) {
+            rc = ret;
+        }
+    }
     return rc;
 }
 
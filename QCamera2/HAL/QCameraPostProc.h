@@ -95,7 +95,8 @@ typedef struct {
     qcamera_release_data_t   release_data; // any data needs to be release after notify
 } qcamera_data_argm_t;
 
-#define MAX_EXIF_TABLE_ENTRIES 17
+#define MAX_EXIF_TABLE_ENTRIES 24
+#define EXIF_ARENA_SIZE 1024
 class QCameraExif
 {
 public:
@@ -106,12 +107,15 @@ public:
                      exif_tag_type_t type,
                      uint32_t count,
                      void *data);
+    int32_t addEntries(const QCameraExif &src);
     uint32_t getNumOfEntries() {return m_nNumEntries;};
     QEXIF_INFO_DATA *getEntries() {return m_Entries;};
 
 private:
-    QEXIF_INFO_DATA m_Entries[MAX_EXIF_TABLE_ENTRIES];  // exif tags for JPEG encoder
+    QEXIF_INFO_DATA m_Entries[MAX_EXIF_TABLE_ENTRIES];  // exif tags for JPEG encoder, in APP1 order
     uint32_t  m_nNumEntries;                            // number of valid entries
+    uint64_t  m_Arena[EXIF_ARENA_SIZE / sizeof(uint64_t)]; // storage for strings and arrays
+    uint32_t  m_nArenaUsed;                             // bytes taken from m_Arena
 };
 
 class QCameraPostProcessor
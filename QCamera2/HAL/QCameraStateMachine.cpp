@@ -62,13 +62,9 @@ void *QCameraStateMachine::smEvtProcRoutine(void *data)
             }
         } while (ret != 0);
 
-        // we got notified about new cmd avail in cmd queue
-        // first check API cmd queue
-        qcamera_sm_cmd_t *node = (qcamera_sm_cmd_t *)pme->api_queue.dequeue();
-        if (node == NULL) {
-            // no API cmd, then check evt cmd queue
-            node = (qcamera_sm_cmd_t *)pme->evt_queue.dequeue();
-        }
+        // we got notified about new cmd avail in cmd queue,
+        // take it from the highest priority lane that has one
+        qcamera_sm_cmd_t *node = pme->dequeueCmd();
         if (node != NULL) {
             switch (node->cmd) {
             case QCAMERA_SM_CMD_TYPE_API:
@@ -80,16 +76,27 @@ void *QCameraStateMachine::smEvtProcRoutine(void *data)
                 pme->stateMachine(node->evt, node->evt_payload);
 
                 // EVT is async call, so payload need to be free after use
-                free(node->evt_payload);
+                pme->releaseEvtPayload(node->evt_payload);
                 node->evt_payload = NULL;
                 break;
+            case QCAMERA_SM_CMD_TYPE_EVT_LATEST:
+                // pick up the newest payload posted for this evt type
+                node->evt_payload = __atomic_exchange_n(
+                        &pme->m_latestEvt[node->internal_evt], NULL,
+                        __ATOMIC_ACQ_REL);
+                if (NULL != node->evt_payload) {
+                    pme->stateMachine(node->evt, node->evt_payload);
+                    pme->releaseEvtPayload(node->evt_payload);
+                    node->evt_payload = NULL;
+                }
+                break;
             case QCAMERA_SM_CMD_TYPE_EXIT:
                 running = 0;
                 break;
             default:
                 break;
             }
-            free(node);
+            pme->releaseCmd(node);
             node = NULL;
         }
     } while (running);
@@ -108,9 +115,13 @@ void *QCameraStateMachine::smEvtProcRoutine(void *data)
  * RETURN     : none
  *==========================================================================*/
 QCameraStateMachine::QCameraStateMachine(QCamera2HardwareInterface *ctrl) :
-    api_queue(),
-    evt_queue()
+    m_cmdPool(sizeof(qcamera_sm_cmd_t), QCAMERA_SM_CMD_POOL_SIZE),
+    m_evtPayloadPool(sizeof(qcamera_sm_internal_evt_payload_t),
+            QCAMERA_SM_EVT_PAYLOAD_POOL_SIZE),
+    m_coalescedEvtCnt(0)
 {
+    memset(m_latestEvt, 0, sizeof(m_latestEvt));
+    memset(m_laneStats, 0, sizeof(m_laneStats));
     m_parent = ctrl;
     m_state = QCAMERA_SM_STATE_PREVIEW_STOPPED;
     cmd_pid = 0;
@@ -135,6 +146,20 @@ QCameraStateMachine::QCameraStateMachine(QCamera2HardwareInterface *ctrl) :
  *==========================================================================*/
 QCameraStateMachine::~QCameraStateMachine()
 {
+    if (0 == cmd_pid) {
+        // cmd thread is gone, reclaim whatever it left in the queues
+        qcamera_sm_cmd_t *node = NULL;
+        while (NULL != (node = dequeueCmd())) {
+            if (QCAMERA_SM_CMD_TYPE_EVT == node->cmd) {
+                releaseEvtPayload(node->evt_payload);
+            }
+            releaseCmd(node);
+        }
+        for (int i = 0; i < QCAMERA_INTERNAL_EVT_MAX; i++) {
+            releaseEvtPayload(m_latestEvt[i]);
+            m_latestEvt[i] = NULL;
+        }
+    }
     cam_sem_destroy(&cmd_sem);
 }
 
@@ -150,16 +175,12 @@ QCameraStateMachine::~QCameraStateMachine()
 void QCameraStateMachine::releaseThread()
 {
     if (cmd_pid != 0) {
-        qcamera_sm_cmd_t *node =
-            (qcamera_sm_cmd_t *)malloc(sizeof(qcamera_sm_cmd_t));
+        qcamera_sm_cmd_t *node = allocCmd();
         if (NULL != node) {
-            memset(node, 0, sizeof(qcamera_sm_cmd_t));
             node->cmd = QCAMERA_SM_CMD_TYPE_EXIT;
 
-            if (api_queue.enqueue((void *)node)) {
-                cam_sem_post(&cmd_sem);
-            } else {
-                free(node);
+            if (!enqueueCmd(QCAMERA_SM_LANE_API, node)) {
+                releaseCmd(node);
                 node = NULL;
             }
 
@@ -213,22 +234,19 @@ int32_t QCameraStateMachine::applyDelayedMsgs()
 int32_t QCameraStateMachine::procAPI(qcamera_sm_evt_enum_t evt,
                                      void *api_payload)
 {
-    qcamera_sm_cmd_t *node =
-        (qcamera_sm_cmd_t *)malloc(sizeof(qcamera_sm_cmd_t));
+    qcamera_sm_cmd_t *node = allocCmd();
     if (NULL == node) {
         ALOGE("%s: No memory for qcamera_sm_cmd_t", __func__);
         return NO_MEMORY;
     }
 
-    memset(node, 0, sizeof(qcamera_sm_cmd_t));
     node->cmd = QCAMERA_SM_CMD_TYPE_API;
     node->evt = evt;
     node->evt_payload = api_payload;
-    if (api_queue.enqueue((void *)node)) {
-        cam_sem_post(&cmd_sem);
+    if (enqueueCmd(QCAMERA_SM_LANE_API, node)) {
         return NO_ERROR;
     } else {
-        free(node);
+        releaseCmd(node);
         return UNKNOWN_ERROR;
     }
 }
@@ -250,26 +268,282 @@ int32_t QCameraStateMachine::procAPI(qcamera_sm_evt_enum_t evt,
 int32_t QCameraStateMachine::procEvt(qcamera_sm_evt_enum_t evt,
                                      void *evt_payload)
 {
-    qcamera_sm_cmd_t *node =
-        (qcamera_sm_cmd_t *)malloc(sizeof(qcamera_sm_cmd_t));
+    if ((QCAMERA_SM_EVT_EVT_INTERNAL == evt) && (NULL != evt_payload) &&
+            isCoalescedEvt(((qcamera_sm_internal_evt_payload_t *)evt_payload)->evt_type)) {
+        return procCoalescedEvt((qcamera_sm_internal_evt_payload_t *)evt_payload);
+    }
+
+    qcamera_sm_cmd_t *node = allocCmd();
     if (NULL == node) {
         ALOGE("%s: No memory for qcamera_sm_cmd_t", __func__);
         return NO_MEMORY;
     }
 
-    memset(node, 0, sizeof(qcamera_sm_cmd_t));
     node->cmd = QCAMERA_SM_CMD_TYPE_EVT;
     node->evt = evt;
     node->evt_payload = evt_payload;
-    if (evt_queue.enqueue((void *)node)) {
-        cam_sem_post(&cmd_sem);
+    if (enqueueCmd(getEvtLane(evt, evt_payload), node)) {
         return NO_ERROR;
     } else {
-        free(node);
+        releaseCmd(node);
         return UNKNOWN_ERROR;
     }
 }
 
+/*===========================================================================
+ * FUNCTION   : procCoalescedEvt
+ *
+ * DESCRIPTION: queue an internal event whose older, not yet dispatched
+ *              instances are superseded by it. Only one cmd node per evt
+ *              type is queued at a time; the payload is parked in
+ *              m_latestEvt and picked up by the cmd thread at dispatch.
+ *
+ * PARAMETERS :
+ *   @payload : internal event payload, owned by statemachine on return
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraStateMachine::procCoalescedEvt(
+        qcamera_sm_internal_evt_payload_t *payload)
+{
+    qcamera_internal_evt_type_t type = payload->evt_type;
+    qcamera_sm_internal_evt_payload_t *old = __atomic_exchange_n(
+            &m_latestEvt[type], payload, __ATOMIC_ACQ_REL);
+    if (NULL != old) {
+        // a cmd node for this type is still queued and will pick up
+        // the new payload, drop the superseded one
+        releaseEvtPayload(old);
+        __atomic_fetch_add(&m_coalescedEvtCnt, 1, __ATOMIC_RELAXED);
+        return NO_ERROR;
+    }
+
+    qcamera_sm_cmd_t *node = allocCmd();
+    if (NULL != node) {
+        node->cmd = QCAMERA_SM_CMD_TYPE_EVT_LATEST;
+        node->evt = QCAMERA_SM_EVT_EVT_INTERNAL;
+        node->internal_evt = type;
+        if (enqueueCmd(QCAMERA_SM_LANE_STATUS, node)) {
+            return NO_ERROR;
+        }
+        releaseCmd(node);
+    }
+
+    // no node will pick up the parked payload, reclaim it. A racing
+    // producer may have already replaced it, so the caller's payload
+    // cannot be handed back and the event is dropped here instead.
+    ALOGE("%s: failed to queue internal evt %d, dropped", __func__, type);
+    releaseEvtPayload(__atomic_exchange_n(&m_latestEvt[type], NULL,
+            __ATOMIC_ACQ_REL));
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : enqueueCmd
+ *
+ * DESCRIPTION: queue a cmd node on a priority lane and wake up cmd thread
+ *
+ * PARAMETERS :
+ *   @lane    : priority lane
+ *   @node    : cmd node
+ *
+ * RETURN     : true if queued, false if lane is full
+ *==========================================================================*/
+bool QCameraStateMachine::enqueueCmd(qcamera_sm_lane_t lane,
+                                     qcamera_sm_cmd_t *node)
+{
+    qcamera_sm_lane_stats_t *stats = &m_laneStats[lane];
+
+    node->enqueue_time = systemTime();
+    uint32_t depth = __atomic_add_fetch(&stats->depth, 1, __ATOMIC_RELAXED);
+    if (!m_cmdQueue[lane].enqueue((void *)node)) {
+        __atomic_fetch_sub(&stats->depth, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    uint32_t maxDepth = __atomic_load_n(&stats->max_depth, __ATOMIC_RELAXED);
+    while ((depth > maxDepth) &&
+            !__atomic_compare_exchange_n(&stats->max_depth, &maxDepth, depth,
+                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    cam_sem_post(&cmd_sem);
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : dequeueCmd
+ *
+ * DESCRIPTION: take the next cmd node from the highest priority lane that
+ *              is not empty and account its dispatch latency. Called from
+ *              cmd thread only.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : cmd node, NULL if all lanes are empty
+ *==========================================================================*/
+QCameraStateMachine::qcamera_sm_cmd_t *QCameraStateMachine::dequeueCmd()
+{
+    for (int lane = 0; lane < QCAMERA_SM_LANE_MAX; lane++) {
+        qcamera_sm_cmd_t *node = (qcamera_sm_cmd_t *)m_cmdQueue[lane].dequeue();
+        if (NULL == node) {
+            continue;
+        }
+
+        qcamera_sm_lane_stats_t *stats = &m_laneStats[lane];
+        nsecs_t latency = systemTime() - node->enqueue_time;
+        __atomic_fetch_sub(&stats->depth, 1, __ATOMIC_RELAXED);
+        stats->dispatched++;
+        stats->total_latency += latency;
+        if (latency > stats->max_latency) {
+            stats->max_latency = latency;
+        }
+        return node;
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : getEvtLane
+ *
+ * DESCRIPTION: pick the priority lane of an incoming event. Per-frame
+ *              status updates go behind everything that can move the
+ *              statemachine, so a burst of them cannot hold up API calls
+ *              or capture events.
+ *
+ * PARAMETERS :
+ *   @evt          : event to be processed
+ *   @evt_payload  : event payload
+ *
+ * RETURN     : priority lane
+ *==========================================================================*/
+QCameraStateMachine::qcamera_sm_lane_t QCameraStateMachine::getEvtLane(
+        qcamera_sm_evt_enum_t evt, void *evt_payload)
+{
+    if ((QCAMERA_SM_EVT_EVT_INTERNAL == evt) && (NULL != evt_payload) &&
+            isStatusEvt(((qcamera_sm_internal_evt_payload_t *)evt_payload)->evt_type)) {
+        return QCAMERA_SM_LANE_STATUS;
+    }
+    return QCAMERA_SM_LANE_EVT;
+}
+
+/*===========================================================================
+ * FUNCTION   : isStatusEvt
+ *
+ * DESCRIPTION: check whether an internal event only reports per-frame
+ *              status and does not drive statemachine transitions
+ *
+ * PARAMETERS :
+ *   @type    : internal event type
+ *
+ * RETURN     : true for status events
+ *==========================================================================*/
+bool QCameraStateMachine::isStatusEvt(qcamera_internal_evt_type_t type)
+{
+    return (QCAMERA_INTERNAL_EVT_FACE_DETECT_RESULT == type) ||
+            isCoalescedEvt(type);
+}
+
+/*===========================================================================
+ * FUNCTION   : isCoalescedEvt
+ *
+ * DESCRIPTION: check whether an internal event only carries the latest
+ *              state, so that a queued older instance can be replaced by a
+ *              newer one without losing information
+ *
+ * PARAMETERS :
+ *   @type    : internal event type
+ *
+ * RETURN     : true if older instances may be dropped
+ *==========================================================================*/
+bool QCameraStateMachine::isCoalescedEvt(qcamera_internal_evt_type_t type)
+{
+    switch (type) {
+    case QCAMERA_INTERNAL_EVT_HISTOGRAM_STATS:
+    case QCAMERA_INTERNAL_EVT_CROP_INFO:
+    case QCAMERA_INTERNAL_EVT_ASD_UPDATE:
+    case QCAMERA_INTERNAL_EVT_AWB_UPDATE:
+    case QCAMERA_INTERNAL_EVT_AE_UPDATE:
+    case QCAMERA_INTERNAL_EVT_FOCUS_POS_UPDATE:
+    case QCAMERA_INTERNAL_EVT_HDR_UPDATE:
+        return true;
+    default:
+        // focus, prepare snapshot and face detection (shared by preview
+        // and snapshot results) must be delivered one by one
+        return false;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : allocEvtPayload
+ *
+ * DESCRIPTION: get a zeroed internal event payload. Must be passed to
+ *              procEvt or released with releaseEvtPayload.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : ptr to payload, NULL if out of memory
+ *==========================================================================*/
+qcamera_sm_internal_evt_payload_t *QCameraStateMachine::allocEvtPayload()
+{
+    qcamera_sm_internal_evt_payload_t *payload =
+            (qcamera_sm_internal_evt_payload_t *)m_evtPayloadPool.alloc();
+    if (NULL != payload) {
+        memset(payload, 0, sizeof(qcamera_sm_internal_evt_payload_t));
+    }
+    return payload;
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseEvtPayload
+ *
+ * DESCRIPTION: release an event payload. Accepts payloads from
+ *              allocEvtPayload as well as malloc'ed ones.
+ *
+ * PARAMETERS :
+ *   @evt_payload : payload to be released, may be NULL
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraStateMachine::releaseEvtPayload(void *evt_payload)
+{
+    m_evtPayloadPool.release(evt_payload);
+}
+
+/*===========================================================================
+ * FUNCTION   : allocCmd
+ *
+ * DESCRIPTION: get a zeroed cmd node
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : ptr to cmd node, NULL if out of memory
+ *==========================================================================*/
+QCameraStateMachine::qcamera_sm_cmd_t *QCameraStateMachine::allocCmd()
+{
+    qcamera_sm_cmd_t *node = (qcamera_sm_cmd_t *)m_cmdPool.alloc();
+    if (NULL != node) {
+        memset(node, 0, sizeof(qcamera_sm_cmd_t));
+    }
+    return node;
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseCmd
+ *
+ * DESCRIPTION: release a cmd node from allocCmd
+ *
+ * PARAMETERS :
+ *   @node    : cmd node to be released
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraStateMachine::releaseCmd(qcamera_sm_cmd_t *node)
+{
+    m_cmdPool.release(node);
+}
+
 /*===========================================================================
  * FUNCTION   : stateMachine
  *
@@ -3318,6 +3592,33 @@ String8 QCameraStateMachine::dump()
     }
     str += s;
 
+    snprintf(s, 128, "Cmd pool: %u/%u in use, %u overflow\n",
+            m_cmdPool.getInUseCnt(), m_cmdPool.getCapacity(),
+            m_cmdPool.getOverflowCnt());
+    str += s;
+
+    snprintf(s, 128, "Evt payload pool: %u/%u in use, %u overflow, %u coalesced\n",
+            m_evtPayloadPool.getInUseCnt(), m_evtPayloadPool.getCapacity(),
+            m_evtPayloadPool.getOverflowCnt(),
+            __atomic_load_n(&m_coalescedEvtCnt, __ATOMIC_RELAXED));
+    str += s;
+
+    static const char *laneNames[QCAMERA_SM_LANE_MAX] = {"api", "evt", "status"};
+    for (int lane = 0; lane < QCAMERA_SM_LANE_MAX; lane++) {
+        qcamera_sm_lane_stats_t *stats = &m_laneStats[lane];
+        uint32_t dispatched = stats->dispatched;
+        snprintf(s, 128, "Lane %s: depth %u max %u, dispatched %u, "
+                "latency avg %lld us max %lld us\n",
+                laneNames[lane],
+                __atomic_load_n(&stats->depth, __ATOMIC_RELAXED),
+                __atomic_load_n(&stats->max_depth, __ATOMIC_RELAXED),
+                dispatched,
+                (long long)(dispatched ?
+                        stats->total_latency / dispatched / 1000 : 0),
+                (long long)(stats->max_latency / 1000));
+        str += s;
+    }
+
     return str;
 }
 
@@ -31,6 +31,7 @@
 #define __QCAMERA_STATEMACHINE_H__
 
 #include <pthread.h>
+#include <utils/Timers.h>
 
 #include <cam_semaphore.h>
 extern "C" {
@@ -38,12 +39,18 @@ extern "C" {
 }
 
 #include "QCameraQueue.h"
+#include "QCameraSlabPool.h"
 #include "QCameraChannel.h"
 
 namespace qcamera {
 
 class QCamera2HardwareInterface;
 
+// number of preallocated statemachine cmd nodes
+#define QCAMERA_SM_CMD_POOL_SIZE         64
+// number of preallocated internal event payloads
+#define QCAMERA_SM_EVT_PAYLOAD_POOL_SIZE 16
+
 typedef enum {
     /*******BEGIN OF: API EVT*********/
     QCAMERA_SM_EVT_SET_PREVIEW_WINDOW = 1,   // set preview window
@@ -178,6 +185,8 @@ public:
     virtual ~QCameraStateMachine();
     int32_t procAPI(qcamera_sm_evt_enum_t evt, void *api_payload);
     int32_t procEvt(qcamera_sm_evt_enum_t evt, void *evt_payload);
+    qcamera_sm_internal_evt_payload_t *allocEvtPayload();
+    void releaseEvtPayload(void *evt_payload);
 
     bool isPreviewRunning(); // check if preview is running
     bool isPreviewReady(); // check if preview is ready
@@ -205,6 +214,7 @@ private:
     {
         QCAMERA_SM_CMD_TYPE_API,                   // cmd from API
         QCAMERA_SM_CMD_TYPE_EVT,                   // cmd from mm-camera-interface/mm-jpeg-interface event
+        QCAMERA_SM_CMD_TYPE_EVT_LATEST,            // latest payload of a coalesced internal event
         QCAMERA_SM_CMD_TYPE_EXIT,                  // cmd for exiting statemachine cmdThread
         QCAMERA_SM_CMD_TYPE_MAX
     } qcamera_sm_cmd_type_t;
@@ -213,8 +223,27 @@ private:
         qcamera_sm_cmd_type_t cmd;                  // cmd type (where it comes from)
         qcamera_sm_evt_enum_t evt;                  // event type
         void *evt_payload;                          // ptr to payload
+        qcamera_internal_evt_type_t internal_evt;   // internal evt type for EVT_LATEST
+        nsecs_t enqueue_time;                       // time the cmd was queued
     } qcamera_sm_cmd_t;
 
+    // cmd queues, drained in order of priority
+    typedef enum {
+        QCAMERA_SM_LANE_API,                       // API calls from framework
+        QCAMERA_SM_LANE_EVT,                       // mm-camera/mm-jpeg events and
+                                                   // internal events driving state
+        QCAMERA_SM_LANE_STATUS,                    // per-frame status updates
+        QCAMERA_SM_LANE_MAX
+    } qcamera_sm_lane_t;
+
+    typedef struct {
+        uint32_t depth;                             // cmds currently queued
+        uint32_t max_depth;                         // high watermark of depth
+        uint32_t dispatched;                        // cmds dispatched
+        nsecs_t total_latency;                      // sum of queue-to-dispatch time
+        nsecs_t max_latency;                        // worst queue-to-dispatch time
+    } qcamera_sm_lane_stats_t;
+
     int32_t stateMachine(qcamera_sm_evt_enum_t evt, void *payload);
     int32_t procEvtPreviewStoppedState(qcamera_sm_evt_enum_t evt, void *payload);
     int32_t procEvtPreviewReadyState(qcamera_sm_evt_enum_t evt, void *payload);
@@ -230,14 +259,29 @@ private:
 
     int32_t applyDelayedMsgs();
 
+    qcamera_sm_cmd_t *allocCmd();
+    void releaseCmd(qcamera_sm_cmd_t *node);
+    bool enqueueCmd(qcamera_sm_lane_t lane, qcamera_sm_cmd_t *node);
+    qcamera_sm_cmd_t *dequeueCmd();
+    static qcamera_sm_lane_t getEvtLane(qcamera_sm_evt_enum_t evt, void *evt_payload);
+    static bool isStatusEvt(qcamera_internal_evt_type_t type);
+    static bool isCoalescedEvt(qcamera_internal_evt_type_t type);
+    int32_t procCoalescedEvt(qcamera_sm_internal_evt_payload_t *payload);
+
     QCamera2HardwareInterface *m_parent;  // ptr to HWI
     qcamera_state_enum_t m_state;         // statemachine state
-    QCameraQueue api_queue;               // cmd queue for APIs
-    QCameraQueue evt_queue;               // cmd queue for evt from mm-camera-intf/mm-jpeg-intf
+    QCameraQueue m_cmdQueue[QCAMERA_SM_LANE_MAX]; // cmd queue per priority lane
+    qcamera_sm_lane_stats_t m_laneStats[QCAMERA_SM_LANE_MAX];
     pthread_t cmd_pid;                    // cmd thread ID
     cam_semaphore_t cmd_sem;              // semaphore for cmd thread
     bool m_bDelayPreviewMsgs;             // Delay preview callback enable during ZSL snapshot
     int32_t m_DelayedMsgs;
+
+    QCameraSlabPool m_cmdPool;            // pool of qcamera_sm_cmd_t nodes
+    QCameraSlabPool m_evtPayloadPool;     // pool of internal evt payloads
+    // newest not yet dispatched payload of each coalesced internal evt type
+    qcamera_sm_internal_evt_payload_t *m_latestEvt[QCAMERA_INTERNAL_EVT_MAX];
+    uint32_t m_coalescedEvtCnt;           // internal evts superseded before dispatch
 };
 
 }; // namespace qcamera
@@ -1559,7 +1559,10 @@ QCamera3PicChannel::QCamera3PicChannel(uint32_t cam_handle,
                         mInputBufferConfig(false),
                         mYuvMemory(NULL),
                         m_pMetaChannel(metadataChannel),
-                        mMetaFrame(NULL)
+                        mMetaFrame(NULL),
+                        mPreallocYuvMemory(NULL),
+                        mPreallocReprocMemory(NULL),
+                        mOfflineMetaPreallocated(false)
 {
     QCamera3HardwareInterface* hal_obj = (QCamera3HardwareInterface*)mUserData;
     m_max_pic_dim = hal_obj->calcMaxJpegDim();
@@ -1616,6 +1619,18 @@ QCamera3PicChannel::~QCamera3PicChannel()
    if (0 < mOfflineMemory.getCnt()) {
        mOfflineMemory.unregisterBuffers();
    }
+
+   Mutex::Autolock lock(mPreallocLock);
+   if (mPreallocYuvMemory) {
+       mPreallocYuvMemory->deallocate();
+       delete mPreallocYuvMemory;
+       mPreallocYuvMemory = NULL;
+   }
+   if (mPreallocReprocMemory) {
+       mPreallocReprocMemory->deallocate();
+       delete mPreallocReprocMemory;
+       mPreallocReprocMemory = NULL;
+   }
 }
 
 int32_t QCamera3PicChannel::initialize(cam_is_type_t isType)
@@ -1759,7 +1774,15 @@ int32_t QCamera3PicChannel::request(buffer_handle_t *buffer,
             rc = NOT_ENOUGH_DATA;
         }
     } else {
-        if (0 < mOfflineMetaMemory.getCnt()) {
+        // Reuse the pre-allocated metadata buffer for the first reprocess only,
+        // later requests keep the original fresh-allocation behavior
+        bool metaPreallocated;
+        {
+            Mutex::Autolock lock(mPreallocLock);
+            metaPreallocated = mOfflineMetaPreallocated;
+            mOfflineMetaPreallocated = false;
+        }
+        if (!metaPreallocated && (0 < mOfflineMetaMemory.getCnt())) {
             mOfflineMetaMemory.deallocate();
         }
         if (0 < mOfflineMemory.getCnt()) {
@@ -1809,11 +1832,13 @@ int32_t QCamera3PicChannel::request(buffer_handle_t *buffer,
             return rc;
         }
 
-        rc = mOfflineMetaMemory.allocate(1, sizeof(metadata_buffer_t), false);
-        if (NO_ERROR != rc) {
-            ALOGE("%s: Couldn't allocate offline metadata buffer!", __func__);
-            free(src_frame);
-            return rc;
+        if (0 == mOfflineMetaMemory.getCnt()) {
+            rc = mOfflineMetaMemory.allocate(1, sizeof(metadata_buffer_t), false);
+            if (NO_ERROR != rc) {
+                ALOGE("%s: Couldn't allocate offline metadata buffer!", __func__);
+                free(src_frame);
+                return rc;
+            }
         }
         mm_camera_buf_def_t meta_buf;
         cam_frame_len_offset_t offset = meta_planes.plane_info;
@@ -1822,7 +1847,7 @@ int32_t QCamera3PicChannel::request(buffer_handle_t *buffer,
             free(src_frame);
             return rc;
         }
-        memcpy(meta_buf.buffer, metadata, sizeof(metadata_buffer_t));
+        copy_metadata_buffer((metadata_buffer_t *)meta_buf.buffer, metadata);
         src_frame->metadata_buffer = meta_buf;
         src_frame->reproc_config = reproc_cfg;
 
@@ -2018,6 +2043,12 @@ QCamera3Memory* QCamera3PicChannel::getStreamBufs(uint32_t len)
 {
     int rc = 0;
 
+    mYuvMemory = takePreallocatedBufs(mPreallocYuvMemory,
+            mCamera3Stream->max_buffers, len);
+    if (mYuvMemory) {
+        return mYuvMemory;
+    }
+
     mYuvMemory = new QCamera3HeapMemory();
     if (!mYuvMemory) {
         ALOGE("%s: unable to create metadata memory", __func__);
@@ -2049,6 +2080,152 @@ int32_t QCamera3PicChannel::queueReprocMetadata(mm_camera_super_buf_t *metadata)
     return m_postprocessor.processPPMetadata(metadata);
 }
 
+/*===========================================================================
+ * FUNCTION   : estimateFrameLen
+ *
+ * DESCRIPTION: estimate the frame length the snapshot or reprocess stream
+ *              will request. The exact length is only known once the stream
+ *              is configured, so use the same offset calculation with the
+ *              widened reprocess padding and both orientations.
+ *
+ * PARAMETERS :
+ *   @width   : frame width
+ *   @height  : frame height
+ *
+ * RETURN     : estimated frame length, 0 on failure
+ *==========================================================================*/
+size_t QCamera3PicChannel::estimateFrameLen(uint32_t width, uint32_t height)
+{
+    cam_padding_info_t padding = *mPaddingInfo;
+    cam_dimension_t dim;
+    cam_stream_buf_plane_info_t planes;
+    size_t len = 0;
+
+    padding.width_padding = MAX(padding.width_padding, padding.height_padding);
+    padding.height_padding = padding.width_padding;
+
+    for (int i = 0; i < 2; i++) {
+        dim.width = (int32_t)(i ? height : width);
+        dim.height = (int32_t)(i ? width : height);
+        memset(&planes, 0, sizeof(planes));
+        if (mm_stream_calc_offset_snapshot(mStreamFormat, &dim, &padding,
+                &planes) == 0) {
+            len = MAX(len, (size_t)planes.plane_info.frame_len);
+        }
+    }
+    return len;
+}
+
+/*===========================================================================
+ * FUNCTION   : preallocateBuffers
+ *
+ * DESCRIPTION: allocate the snapshot YUV buffers, and optionally the
+ *              reprocess output and offline metadata buffers, ahead of the
+ *              first capture request. Called from a worker thread right
+ *              after stream configuration.
+ *
+ * PARAMETERS :
+ *   @reprocess : true if an input stream is configured
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCamera3PicChannel::preallocateBuffers(bool reprocess)
+{
+    int32_t rc = NO_ERROR;
+    Mutex::Autolock lock(mPreallocLock);
+
+    size_t yuvLen = estimateFrameLen(mYuvWidth, mYuvHeight);
+    if ((NULL == mPreallocYuvMemory) && (0 < yuvLen)) {
+        mPreallocYuvMemory = new QCamera3HeapMemory();
+        rc = mPreallocYuvMemory->allocate(mCamera3Stream->max_buffers,
+                yuvLen, false);
+        if (rc < 0) {
+            ALOGE("%s: unable to pre-allocate YUV memory", __func__);
+            delete mPreallocYuvMemory;
+            mPreallocYuvMemory = NULL;
+            return rc;
+        }
+    }
+
+    if (!reprocess) {
+        return rc;
+    }
+
+    size_t reprocLen = estimateFrameLen(mCamera3Stream->width,
+            mCamera3Stream->height);
+    if ((NULL == mPreallocReprocMemory) && (0 < reprocLen)) {
+        mPreallocReprocMemory = new QCamera3HeapMemory();
+        rc = mPreallocReprocMemory->allocate(mNumBuffers, reprocLen, true);
+        if (rc < 0) {
+            ALOGE("%s: unable to pre-allocate reprocess memory", __func__);
+            delete mPreallocReprocMemory;
+            mPreallocReprocMemory = NULL;
+            return rc;
+        }
+    }
+
+    if (0 == mOfflineMetaMemory.getCnt()) {
+        rc = mOfflineMetaMemory.allocate(1, sizeof(metadata_buffer_t), false);
+        if (rc < 0) {
+            ALOGE("%s: unable to pre-allocate offline metadata", __func__);
+            return rc;
+        }
+        mOfflineMetaPreallocated = true;
+    }
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : takePreallocatedBufs
+ *
+ * DESCRIPTION: hand over pre-allocated buffers if they fit the request.
+ *              Buffers which turn out too small are released so the caller
+ *              falls back to a regular allocation.
+ *
+ * PARAMETERS :
+ *   @mem     : pre-allocated memory slot, cleared on return
+ *   @count   : number of buffers needed
+ *   @len     : length of each buffer
+ *
+ * RETURN     : heap memory, or NULL if nothing usable was pre-allocated
+ *==========================================================================*/
+QCamera3HeapMemory *QCamera3PicChannel::takePreallocatedBufs(
+        QCamera3HeapMemory *&mem, uint32_t count, uint32_t len)
+{
+    Mutex::Autolock lock(mPreallocLock);
+    QCamera3HeapMemory *bufs = mem;
+    mem = NULL;
+
+    if (bufs && ((bufs->getCnt() != count) ||
+            (bufs->getSize(0) < (ssize_t)len))) {
+        CDBG_HIGH("%s: pre-allocated %u x %zd does not fit %u x %u", __func__,
+                bufs->getCnt(), bufs->getSize(0), count, len);
+        bufs->deallocate();
+        delete bufs;
+        bufs = NULL;
+    }
+    return bufs;
+}
+
+/*===========================================================================
+ * FUNCTION   : getPreallocatedReprocBufs
+ *
+ * DESCRIPTION: hand over pre-allocated reprocess output buffers
+ *
+ * PARAMETERS :
+ *   @count   : number of buffers needed
+ *   @len     : length of each buffer
+ *
+ * RETURN     : heap memory, or NULL if nothing usable was pre-allocated
+ *==========================================================================*/
+QCamera3HeapMemory *QCamera3PicChannel::getPreallocatedReprocBufs(
+        uint32_t count, uint32_t len)
+{
+    return takePreallocatedBufs(mPreallocReprocMemory, count, len);
+}
+
 int32_t QCamera3PicChannel::queueJpegSetting(uint32_t index, metadata_buffer_t *metadata)
 {
     jpeg_settings_t *settings =
@@ -2100,6 +2277,23 @@ int32_t QCamera3PicChannel::queueJpegSetting(uint32_t index, metadata_buffer_t *
                 sizeof(settings->gps_processing_method)+1);
     }
 
+    // A blob on a preview or recording request yields to still captures
+    // in the jpeg job manager, a video snapshot to single shots
+    settings->jpeg_priority = MM_JPEG_JOB_PRIO_SINGLE_SHOT;
+    IF_META_AVAILABLE(uint32_t, intent, CAM_INTF_META_CAPTURE_INTENT, metadata) {
+        switch (*intent) {
+        case ANDROID_CONTROL_CAPTURE_INTENT_PREVIEW:
+        case ANDROID_CONTROL_CAPTURE_INTENT_VIDEO_RECORD:
+            settings->jpeg_priority = MM_JPEG_JOB_PRIO_PREVIEW_THUMB;
+            break;
+        case ANDROID_CONTROL_CAPTURE_INTENT_VIDEO_SNAPSHOT:
+            settings->jpeg_priority = MM_JPEG_JOB_PRIO_BURST;
+            break;
+        default:
+            break;
+        }
+    }
+
     return m_postprocessor.processJpegSettingData(settings);
 }
 
@@ -2805,6 +2999,14 @@ QCamera3Memory* QCamera3ReprocessChannel::getStreamBufs(uint32_t len)
 {
    int rc = 0;
 
+    if (picChHandle) {
+        mMemory = ((QCamera3PicChannel *)picChHandle)->getPreallocatedReprocBufs(
+                mNumBuffers, len);
+        if (mMemory) {
+            return mMemory;
+        }
+    }
+
     mMemory = new QCamera3HeapMemory();
     if (!mMemory) {
         ALOGE("%s: unable to create reproc memory", __func__);
@@ -313,9 +313,14 @@ public:
             void *userdata);
     virtual int32_t registerBuffer(buffer_handle_t *buffer, cam_is_type_t isType);
     int32_t queueReprocMetadata(mm_camera_super_buf_t *metadata);
+    int32_t preallocateBuffers(bool reprocess);
+    QCamera3HeapMemory *getPreallocatedReprocBufs(uint32_t count, uint32_t len);
 
 private:
     int32_t queueJpegSetting(uint32_t out_buf_index, metadata_buffer_t *metadata);
+    size_t estimateFrameLen(uint32_t width, uint32_t height);
+    QCamera3HeapMemory *takePreallocatedBufs(QCamera3HeapMemory *&mem,
+            uint32_t count, uint32_t len);
 
 public:
     QCamera3PostProcessor m_postprocessor; // post processor
@@ -341,6 +346,12 @@ private:
     QCamera3GrallocMemory mOfflineMemory;
     QCamera3HeapMemory mOfflineMetaMemory;
 
+    // Buffers allocated ahead of stream start by preallocateBuffers()
+    Mutex mPreallocLock;
+    QCamera3HeapMemory *mPreallocYuvMemory;
+    QCamera3HeapMemory *mPreallocReprocMemory;
+    bool mOfflineMetaPreallocated;
+
     // Keep a list of free buffers
     Mutex mFreeBuffersLock;
     List<uint32_t> mFreeBufferList;
@@ -0,0 +1,312 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef __QCAMERA3FRAMETABLE_H__
+#define __QCAMERA3FRAMETABLE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <utils/Log.h>
+#include "QCamera3HALHeader.h"
+
+namespace qcamera {
+
+/* Initial and max number of ring slots, must be powers of 2 */
+#define FRAME_TABLE_INIT_SLOTS 32
+#define FRAME_TABLE_MAX_SLOTS 4096
+
+/*===========================================================================
+ * CLASS      : QCamera3FrameTable
+ *
+ * DESCRIPTION: ring table of items keyed by frame number. An item is stored
+ *              in slot (frame_number & (slots - 1)); the ring doubles when
+ *              the pending frame number span would not fit, up to
+ *              FRAME_TABLE_MAX_SLOTS. Past that the oldest items are moved
+ *              to an overflow list kept in frame number order, so a frame
+ *              stuck in the pipeline can not grow the ring without bound.
+ *              Lookup, insertion and removal are O(1) within the ring and
+ *              O(overflow) for overflowed items. next() and erasing the
+ *              oldest or newest item step over empty slots, so they are
+ *              O(gap to the neighbouring item); a walk from first() is
+ *              O(span), at most FRAME_TABLE_MAX_SLOTS plus the overflow.
+ *              Iteration goes from the oldest to the newest frame number.
+ *              Item pointers are valid until the next add() or erase().
+ *==========================================================================*/
+template <typename T>
+class QCamera3FrameTable {
+public:
+    QCamera3FrameTable() :
+        mSlots(new Slot[FRAME_TABLE_INIT_SLOTS]),
+        mNumSlots(FRAME_TABLE_INIT_SLOTS),
+        mCount(0),
+        mOldest(0),
+        mNewest(0),
+        mOverflow(NULL),
+        mOverflowCount(0),
+        mOverflowCap(0) {}
+    ~QCamera3FrameTable() { delete [] mSlots; delete [] mOverflow; }
+
+    size_t size() const { return mCount + mOverflowCount; }
+    bool isEmpty() const { return (0 == size()); }
+    size_t overflowSize() const { return mOverflowCount; }
+
+    /* Insert an item, returns NULL if the frame number is already present */
+    T *add(uint32_t frameNumber, const T &item)
+    {
+        if (findOverflow(frameNumber) >= 0) {
+            return NULL;
+        }
+        if (mOverflowCount &&
+                FRAME_NUM_LT(frameNumber, mOverflow[mOverflowCount - 1].frameNumber)) {
+            /* older than an item already overflowed, keep it there too */
+            return insertOverflow(frameNumber, item);
+        }
+
+        uint32_t oldest = frameNumber, newest = frameNumber;
+        if (mCount) {
+            oldest = FRAME_NUM_LT(mOldest, frameNumber) ? mOldest : frameNumber;
+            newest = FRAME_NUM_LT(frameNumber, mNewest) ? mNewest : frameNumber;
+        }
+        while ((size_t)(newest - oldest) >= mNumSlots) {
+            if (mNumSlots < FRAME_TABLE_MAX_SLOTS) {
+                grow();
+            } else if (oldest == frameNumber) {
+                /* the new item is the one out of range */
+                return insertOverflow(frameNumber, item);
+            } else {
+                ALOGW("%s: frame %u pending for over %u frames, moved to overflow",
+                        __func__, mOldest, (uint32_t)FRAME_TABLE_MAX_SLOTS);
+                overflowOldest();
+                oldest = mCount ?
+                        (FRAME_NUM_LT(mOldest, frameNumber) ? mOldest : frameNumber) :
+                        frameNumber;
+                newest = mCount ?
+                        (FRAME_NUM_LT(frameNumber, mNewest) ? mNewest : frameNumber) :
+                        frameNumber;
+            }
+        }
+
+        Slot &slot = mSlots[frameNumber & (mNumSlots - 1)];
+        if (slot.valid) {
+            return NULL;
+        }
+        slot.valid = true;
+        slot.frameNumber = frameNumber;
+        slot.item = item;
+        mOldest = oldest;
+        mNewest = newest;
+        mCount++;
+        return &slot.item;
+    }
+
+    T *find(uint32_t frameNumber)
+    {
+        T *item = findRing(frameNumber);
+        if (item || !mOverflowCount) {
+            return item;
+        }
+        ssize_t pos = findOverflow(frameNumber);
+        return (pos >= 0) ? &mOverflow[pos].item : NULL;
+    }
+
+    /* Oldest item, NULL if the table is empty */
+    T *first()
+    {
+        if (mOverflowCount) {
+            return &mOverflow[0].item;
+        }
+        return findRing(mOldest);
+    }
+
+    /* First item with a frame number newer than frameNumber */
+    T *next(uint32_t frameNumber)
+    {
+        for (size_t i = 0; i < mOverflowCount; i++) {
+            if (FRAME_NUM_LT(frameNumber, mOverflow[i].frameNumber)) {
+                return &mOverflow[i].item;
+            }
+        }
+        if (!mCount) {
+            return NULL;
+        }
+        uint32_t f = FRAME_NUM_LT(frameNumber, mOldest) ? mOldest : frameNumber + 1;
+        for (; FRAME_NUM_LE(f, mNewest); f++) {
+            T *item = findRing(f);
+            if (item) {
+                return item;
+            }
+        }
+        return NULL;
+    }
+
+    void erase(uint32_t frameNumber)
+    {
+        if (!findRing(frameNumber)) {
+            eraseOverflow(frameNumber);
+            return;
+        }
+        Slot &slot = mSlots[frameNumber & (mNumSlots - 1)];
+        slot.valid = false;
+        slot.item = T();
+        mCount--;
+        if (!mCount) {
+            return;
+        }
+        if (frameNumber == mOldest) {
+            while (!findRing(++mOldest));
+        } else if (frameNumber == mNewest) {
+            while (!findRing(--mNewest));
+        }
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < mNumSlots; i++) {
+            if (mSlots[i].valid) {
+                mSlots[i].valid = false;
+                mSlots[i].item = T();
+            }
+        }
+        for (size_t i = 0; i < mOverflowCount; i++) {
+            mOverflow[i].valid = false;
+            mOverflow[i].item = T();
+        }
+        mCount = 0;
+        mOverflowCount = 0;
+    }
+
+private:
+    struct Slot {
+        Slot() : valid(false), frameNumber(0) {}
+        bool valid;
+        uint32_t frameNumber;
+        T item;
+    };
+
+    T *findRing(uint32_t frameNumber)
+    {
+        if (!mCount || FRAME_NUM_LT(frameNumber, mOldest) ||
+                FRAME_NUM_LT(mNewest, frameNumber)) {
+            return NULL;
+        }
+        Slot &slot = mSlots[frameNumber & (mNumSlots - 1)];
+        return (slot.valid && (slot.frameNumber == frameNumber)) ?
+                &slot.item : NULL;
+    }
+
+    void grow()
+    {
+        size_t numSlots = mNumSlots * 2;
+        Slot *slots = new Slot[numSlots];
+        for (size_t i = 0; i < mNumSlots; i++) {
+            if (mSlots[i].valid) {
+                slots[mSlots[i].frameNumber & (numSlots - 1)] = mSlots[i];
+            }
+        }
+        delete [] mSlots;
+        mSlots = slots;
+        mNumSlots = numSlots;
+    }
+
+    /* Move the oldest ring item to the end of the overflow list */
+    void overflowOldest()
+    {
+        Slot &slot = mSlots[mOldest & (mNumSlots - 1)];
+        insertOverflow(slot.frameNumber, slot.item);
+        erase(slot.frameNumber);
+    }
+
+    ssize_t findOverflow(uint32_t frameNumber) const
+    {
+        for (size_t i = 0; i < mOverflowCount; i++) {
+            if (mOverflow[i].frameNumber == frameNumber) {
+                return (ssize_t)i;
+            }
+        }
+        return -1;
+    }
+
+    /* Insert in frame number order, the list is short and appended to */
+    T *insertOverflow(uint32_t frameNumber, const T &item)
+    {
+        if (mOverflowCount == mOverflowCap) {
+            size_t cap = mOverflowCap ? mOverflowCap * 2 : 4;
+            Slot *overflow = new Slot[cap];
+            for (size_t i = 0; i < mOverflowCount; i++) {
+                overflow[i] = mOverflow[i];
+            }
+            delete [] mOverflow;
+            mOverflow = overflow;
+            mOverflowCap = cap;
+        }
+        size_t pos = mOverflowCount;
+        while ((pos > 0) &&
+                FRAME_NUM_LT(frameNumber, mOverflow[pos - 1].frameNumber)) {
+            mOverflow[pos] = mOverflow[pos - 1];
+            pos--;
+        }
+        mOverflow[pos].valid = true;
+        mOverflow[pos].frameNumber = frameNumber;
+        mOverflow[pos].item = item;
+        mOverflowCount++;
+        return &mOverflow[pos].item;
+    }
+
+    void eraseOverflow(uint32_t frameNumber)
+    {
+        ssize_t pos = findOverflow(frameNumber);
+        if (pos < 0) {
+            return;
+        }
+        for (size_t i = (size_t)pos; i + 1 < mOverflowCount; i++) {
+            mOverflow[i] = mOverflow[i + 1];
+        }
+        mOverflowCount--;
+        mOverflow[mOverflowCount].valid = false;
+        mOverflow[mOverflowCount].item = T();
+    }
+
+    /* not copyable */
+    QCamera3FrameTable(const QCamera3FrameTable &);
+    QCamera3FrameTable &operator=(const QCamera3FrameTable &);
+
+    Slot *mSlots;
+    size_t mNumSlots;
+    size_t mCount;
+    uint32_t mOldest;
+    uint32_t mNewest;
+    Slot *mOverflow;            // items older than the ring can span
+    size_t mOverflowCount;
+    size_t mOverflowCap;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA3FRAMETABLE_H__ */
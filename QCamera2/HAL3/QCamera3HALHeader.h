@@ -41,6 +41,12 @@ namespace qcamera {
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+/* Frame number comparison with serial number arithmetic, correct across
+ * uint32_t rollover as long as compared frames are less than 2^31 apart */
+#define FRAME_NUM_DIFF(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)))
+#define FRAME_NUM_LT(a, b) (FRAME_NUM_DIFF(a, b) < 0)
+#define FRAME_NUM_LE(a, b) (FRAME_NUM_DIFF(a, b) <= 0)
+
 class QCamera3Channel;
 
     typedef enum {
@@ -59,6 +65,7 @@ class QCamera3Channel;
         uint8_t gps_coordinates_valid;
         double gps_coordinates[3];
         char gps_processing_method[GPS_PROCESSING_METHOD_SIZE];
+        mm_jpeg_job_prio_t jpeg_priority;
     } jpeg_settings_t;
 
     typedef struct {
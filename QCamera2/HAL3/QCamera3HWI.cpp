@@ -49,6 +49,7 @@
 #include "QCamera3Channel.h"
 #include "QCamera3PostProc.h"
 #include "QCamera3VendorTags.h"
+#include "QCameraDebugConfig.h"
 
 using namespace android;
 
@@ -72,6 +73,15 @@ namespace qcamera {
 #define MAX_STALLING_STREAMS   1
 #define MAX_PROCESSED_STREAMS  3
 
+/* Result metadata buffers kept for reuse across frames */
+#define MAX_RESULT_METADATA_POOL        2
+/* Room for tags emitted but not advertised as result keys (vendor, jpeg) */
+#define RESULT_METADATA_EXTRA_ENTRIES   32
+#define RESULT_METADATA_EXTRA_DATA      1024
+
+/* Smoothing of the request latency and result interval averages */
+#define INFLIGHT_EWMA_WEIGHT 8
+
 #define METADATA_MAP_SIZE(MAP) (sizeof(MAP)/sizeof(MAP[0]))
 
 #define CAM_QCOM_FEATURE_PP_SUPERSET_HAL3   ( CAM_QCOM_FEATURE_DENOISE2D |\
@@ -307,6 +317,9 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
       m_bIs4KVideo(false),
       m_bEisSupportedSize(false),
       m_bEisEnable(false),
+      mMetadataCount(0),
+      mSentParameters(NULL),
+      mSentParamsValid(false),
       mMinProcessedFrameDuration(0),
       mMinJpegFrameDuration(0),
       mMinRawFrameDuration(0),
@@ -314,7 +327,15 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
       mMetaFrameCount(0U),
       mUpdateDebugLevel(false),
       mCallbacks(callbacks),
-      mCaptureIntent(0)
+      mCaptureIntent(0),
+      mPreallocActive(false),
+      mPreallocReprocess(false),
+      mConfigDoneTime(0),
+      mFirstShotPending(false),
+      mFirstShotFrameNumber(0),
+      mFirstShotRequestTime(0),
+      mResultMetaEntryCap(0),
+      mResultMetaDataCap(0)
 {
     getLogLevel();
     mCameraDevice.common.tag = HARDWARE_DEVICE_TAG;
@@ -328,8 +349,21 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
     gCamCapability[cameraId]->min_num_pp_bufs = 3;
 
     pthread_cond_init(&mRequestCond, NULL);
+    memset(&mMetaLockStats, 0, sizeof(mMetaLockStats));
+    memset(&mBufferLockStats, 0, sizeof(mBufferLockStats));
+    memset(&mSettingsCacheStats, 0, sizeof(mSettingsCacheStats));
     mPendingRequest = 0;
     mCurrentRequestId = -1;
+    mInflightCeiling = MAX_INFLIGHT_REQUESTS;
+    mInflightFloor = MIN_INFLIGHT_REQUESTS;
+    mInflightWindow = MIN_INFLIGHT_REQUESTS;
+    mResultLatency = 0;
+    mResultInterval = 0;
+    mLastResultTime = 0;
+    memset(mRequestBlockHist, 0, sizeof(mRequestBlockHist));
+    mFlushCount = 0;
+    memset(&mLastFlushTiming, 0, sizeof(mLastFlushTiming));
+    memset(&mMaxFlushTiming, 0, sizeof(mMaxFlushTiming));
     pthread_mutex_init(&mMutex, NULL);
 
     for (size_t i = 0; i < CAMERA3_TEMPLATE_COUNT; i++)
@@ -360,6 +394,8 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
 QCamera3HardwareInterface::~QCamera3HardwareInterface()
 {
     CDBG("%s: E", __func__);
+    waitForBufferPreallocation();
+
     /* We need to stop all streams before deleting any stream */
 
 
@@ -431,9 +467,10 @@ QCamera3HardwareInterface::~QCamera3HardwareInterface()
     if (mCameraOpened)
         closeCamera();
 
-    mPendingBuffersMap.mPendingBufferList.clear();
-    mPendingRequestsList.clear();
-    mPendingReprocessResultList.clear();
+    mPendingBuffersMap.mPendingBuffers.clear();
+    mPendingRequests.clear();
+    mPendingReprocessResults.clear();
+    clearResultMetadataPool();
 
     for (size_t i = 0; i < CAMERA3_TEMPLATE_COUNT; i++)
         if (mDefaultMetadata[i])
@@ -559,6 +596,7 @@ int QCamera3HardwareInterface::openCamera()
     }
 
     mCameraOpened = true;
+    QCameraDebugConfig::start();
 
     rc = mCameraHandle->ops->register_event_notify(mCameraHandle->camera_handle,
             camEvtHandle, (void *)this);
@@ -591,6 +629,7 @@ int QCamera3HardwareInterface::closeCamera()
     rc = mCameraHandle->ops->close_camera(mCameraHandle->camera_handle);
     mCameraHandle = NULL;
     mCameraOpened = false;
+    QCameraDebugConfig::stop();
 
 #ifdef HAS_MULTIMEDIA_HINTS
     if (rc == NO_ERROR) {
@@ -883,6 +922,10 @@ int QCamera3HardwareInterface::configureStreams(
         return BAD_VALUE;
     }
 
+    // The pre-allocation thread of the previous configuration still
+    // references its picture channel
+    waitForBufferPreallocation();
+
     /* first invalidate all the steams in the mStreamList
      * if they appear again, they will be validated */
     for (List<stream_info_t*>::iterator it = mStreamInfo.begin();
@@ -1443,21 +1486,277 @@ int QCamera3HardwareInterface::configureStreams(
     mStreamConfigInfo.buffer_info.max_buffers = MAX_INFLIGHT_REQUESTS;
 
     /* Initialize mPendingRequestInfo and mPendnigBuffersMap */
-    mPendingRequestsList.clear();
-    mPendingFrameDropList.clear();
-    // Initialize/Reset the pending buffers list
+    mPendingRequests.clear();
+    // Initialize/Reset the pending buffers map
     mPendingBuffersMap.num_buffers = 0;
-    mPendingBuffersMap.mPendingBufferList.clear();
-    mPendingReprocessResultList.clear();
+    mPendingBuffersMap.mPendingBuffers.clear();
+    mPendingReprocessResults.clear();
 
     mFirstRequest = true;
     //Get min frame duration for this streams configuration
     deriveMinFrameDuration();
+    initResultMetadataPool();
+    invalidateSettingsCache();
+    initInflightWindow();
+
+    startBufferPreallocation();
 
     pthread_mutex_unlock(&mMutex);
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : startBufferPreallocation
+ *
+ * DESCRIPTION: kick off allocation of the snapshot (and reprocess) buffers
+ *              on a worker thread so the first capture request does not
+ *              pay for it. Joined in processCaptureRequest before the
+ *              channels are started.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::startBufferPreallocation()
+{
+    mConfigDoneTime = systemTime(CLOCK_MONOTONIC);
+    mFirstShotPending = true;
+    mFirstShotRequestTime = 0;
+    if (NULL == mPictureChannel || mPreallocActive) {
+        return;
+    }
+
+    mPreallocReprocess = (NULL != mInputStream);
+    if (pthread_create(&mPreallocTid, NULL, bufferPreallocRoutine, this) != 0) {
+        ALOGE("%s: Failed to start buffer pre-allocation", __func__);
+        return;
+    }
+    mPreallocActive = true;
+}
+
+/*===========================================================================
+ * FUNCTION   : waitForBufferPreallocation
+ *
+ * DESCRIPTION: join the buffer pre-allocation thread if one is running
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::waitForBufferPreallocation()
+{
+    if (!mPreallocActive) {
+        return;
+    }
+
+    nsecs_t start = systemTime(CLOCK_MONOTONIC);
+    pthread_join(mPreallocTid, NULL);
+    mPreallocActive = false;
+    CDBG_HIGH("%s: waited %lld us for buffer pre-allocation", __func__,
+            (long long)((systemTime(CLOCK_MONOTONIC) - start) / NSEC_PER_USEC));
+}
+
+/*===========================================================================
+ * FUNCTION   : bufferPreallocRoutine
+ *
+ * DESCRIPTION: worker routine allocating the picture channel buffers
+ *
+ * PARAMETERS :
+ *   @data    : ptr to QCamera3HardwareInterface
+ *
+ * RETURN     : NULL
+ *==========================================================================*/
+void *QCamera3HardwareInterface::bufferPreallocRoutine(void *data)
+{
+    QCamera3HardwareInterface *hw = (QCamera3HardwareInterface *)data;
+    nsecs_t start = systemTime(CLOCK_MONOTONIC);
+
+    CDBG_HIGH("[KPI Perf] %s: E PROFILE_PREALLOC_SNAPSHOT_BUFS", __func__);
+    int32_t rc = hw->mPictureChannel->preallocateBuffers(hw->mPreallocReprocess);
+    CDBG_HIGH("[KPI Perf] %s: X PROFILE_PREALLOC_SNAPSHOT_BUFS rc %d, %lld us",
+            __func__, rc,
+            (long long)((systemTime(CLOCK_MONOTONIC) - start) / NSEC_PER_USEC));
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : initResultMetadataPool
+ *
+ * DESCRIPTION: size the result metadata buffers from the advertised result
+ *              keys so a per-frame translation fits without regrowing, and
+ *              pre-allocate the pool.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::initResultMetadataPool()
+{
+    const cam_capability_t *caps = gCamCapability[mCameraId];
+    size_t entries = RESULT_METADATA_EXTRA_ENTRIES;
+    size_t data = RESULT_METADATA_EXTRA_DATA;
+    camera_metadata_ro_entry_t keys;
+
+    clearResultMetadataPool();
+
+    memset(&keys, 0, sizeof(keys));
+    if (NULL != gStaticMetadata[mCameraId]) {
+        find_camera_metadata_ro_entry(gStaticMetadata[mCameraId],
+                ANDROID_REQUEST_AVAILABLE_RESULT_KEYS, &keys);
+    }
+    for (size_t i = 0; i < keys.count; i++) {
+        uint32_t tag = (uint32_t)keys.data.i32[i];
+        int type = get_camera_metadata_tag_type(tag);
+        size_t count;
+
+        if (type < 0) {
+            continue;
+        }
+        switch (tag) {
+        case ANDROID_TONEMAP_CURVE_RED:
+        case ANDROID_TONEMAP_CURVE_GREEN:
+        case ANDROID_TONEMAP_CURVE_BLUE:
+        case ANDROID_SENSOR_PROFILE_TONE_CURVE:
+            count = 2 * (size_t)caps->max_tone_map_curve_points;
+            break;
+        case ANDROID_STATISTICS_SHARPNESS_MAP:
+            count = CAM_MAX_MAP_WIDTH * CAM_MAX_MAP_HEIGHT * 3;
+            break;
+        case ANDROID_STATISTICS_FACE_RECTANGLES:
+            count = 4 * (size_t)caps->max_num_roi;
+            break;
+        case ANDROID_STATISTICS_FACE_LANDMARKS:
+            count = 6 * (size_t)caps->max_num_roi;
+            break;
+        case ANDROID_STATISTICS_FACE_IDS:
+        case ANDROID_STATISTICS_FACE_SCORES:
+            count = (size_t)caps->max_num_roi;
+            break;
+        case ANDROID_CONTROL_AE_REGIONS:
+        case ANDROID_CONTROL_AF_REGIONS:
+        case ANDROID_CONTROL_AWB_REGIONS:
+            count = MAX_ROI;
+            break;
+        case ANDROID_COLOR_CORRECTION_TRANSFORM:
+        case ANDROID_STATISTICS_PREDICTED_COLOR_TRANSFORM:
+            count = 9;
+            break;
+        case ANDROID_JPEG_GPS_PROCESSING_METHOD:
+            count = GPS_PROCESSING_METHOD_SIZE;
+            break;
+        default:
+            count = 4;
+            break;
+        }
+        entries++;
+        data += calculate_camera_metadata_entry_data_size((uint8_t)type, count);
+    }
+
+    /* Emitted but not advertised: shading map and reprocess private data */
+    data += calculate_camera_metadata_entry_data_size(TYPE_FLOAT,
+            4 * (size_t)caps->lens_shading_map_size.width *
+            (size_t)caps->lens_shading_map_size.height);
+    data += calculate_camera_metadata_entry_data_size(TYPE_INT32,
+            MAX_METADATA_PRIVATE_PAYLOAD_SIZE_IN_BYTES / sizeof(int32_t));
+
+    mResultMetaEntryCap = entries;
+    mResultMetaDataCap = data;
+    for (size_t i = 0; i < MAX_RESULT_METADATA_POOL; i++) {
+        camera_metadata_t *meta = allocate_camera_metadata(entries, data);
+        if (NULL == meta) {
+            ALOGE("%s: Failed to allocate result metadata", __func__);
+            break;
+        }
+        mResultMetadataPool.add(meta);
+    }
+    CDBG_HIGH("%s: %zu result metadata buffers, %zu entries, %zu data bytes",
+            __func__, mResultMetadataPool.size(), entries, data);
+}
+
+/*===========================================================================
+ * FUNCTION   : clearResultMetadataPool
+ *
+ * DESCRIPTION: free all pooled result metadata buffers
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::clearResultMetadataPool()
+{
+    for (size_t i = 0; i < mResultMetadataPool.size(); i++) {
+        free_camera_metadata(mResultMetadataPool.editItemAt(i));
+    }
+    mResultMetadataPool.clear();
+}
+
+/*===========================================================================
+ * FUNCTION   : acquireResultMetadata
+ *
+ * DESCRIPTION: take an empty result metadata buffer from the pool, or
+ *              allocate one at the pool capacity if the pool is drained.
+ *              Must be called with mMutex held.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : camera_metadata_t* to be handed to CameraMetadata; NULL is
+ *              tolerated by CameraMetadata which then allocates on demand
+ *==========================================================================*/
+camera_metadata_t *QCamera3HardwareInterface::acquireResultMetadata()
+{
+    if (mResultMetadataPool.isEmpty()) {
+        if (0 == mResultMetaEntryCap) {
+            return NULL;
+        }
+        return allocate_camera_metadata(mResultMetaEntryCap, mResultMetaDataCap);
+    }
+
+    size_t last = mResultMetadataPool.size() - 1;
+    camera_metadata_t *meta = mResultMetadataPool.editItemAt(last);
+    mResultMetadataPool.removeAt(last);
+
+    /* Drop the previous frame's entries, keeping the allocation */
+    return place_camera_metadata(meta, get_camera_metadata_size(meta),
+            get_camera_metadata_entry_capacity(meta),
+            get_camera_metadata_data_capacity(meta));
+}
+
+/*===========================================================================
+ * FUNCTION   : recycleResultMetadata
+ *
+ * DESCRIPTION: return a result buffer once process_capture_result is done
+ *              with it. A buffer that had to grow raises the pool capacity;
+ *              undersized or surplus buffers are freed. Must be called with
+ *              mMutex held.
+ *
+ * PARAMETERS :
+ *   @meta    : result metadata released by CameraMetadata
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::recycleResultMetadata(camera_metadata_t *meta)
+{
+    if (NULL == meta) {
+        return;
+    }
+
+    size_t entries = get_camera_metadata_entry_capacity(meta);
+    size_t data = get_camera_metadata_data_capacity(meta);
+    if (entries > mResultMetaEntryCap || data > mResultMetaDataCap) {
+        CDBG("%s: result metadata grew to %zu entries, %zu data bytes",
+                __func__, entries, data);
+        mResultMetaEntryCap = MAX(entries, mResultMetaEntryCap);
+        mResultMetaDataCap = MAX(data, mResultMetaDataCap);
+    }
+
+    if (entries < mResultMetaEntryCap || data < mResultMetaDataCap ||
+            mResultMetadataPool.size() >= MAX_RESULT_METADATA_POOL) {
+        free_camera_metadata(meta);
+        return;
+    }
+    mResultMetadataPool.add(meta);
+}
+
 /*===========================================================================
  * FUNCTION   : validateCaptureRequest
  *
@@ -1692,42 +1991,123 @@ int64_t QCamera3HardwareInterface::getMinFrameDuration(const camera3_capture_req
  *==========================================================================*/
 int32_t QCamera3HardwareInterface::handlePendingReprocResults(uint32_t frame_number)
 {
-    for (List<PendingReprocessResult>::iterator j = mPendingReprocessResultList.begin();
-            j != mPendingReprocessResultList.end(); j++) {
-        if (j->frame_number == frame_number) {
-            mCallbackOps->notify(mCallbackOps, &j->notify_msg);
-
-            CDBG("%s: Delayed reprocess notify %d", __func__,
-                    frame_number);
-
-            for (List<PendingRequestInfo>::iterator k = mPendingRequestsList.begin();
-                k != mPendingRequestsList.end(); k++) {
-
-                if (k->frame_number == j->frame_number) {
-                    CDBG("%s: Found reprocess frame number %d in pending reprocess List "
-                            "Take it out!!", __func__,
-                            k->frame_number);
-
-                    camera3_capture_result result;
-                    memset(&result, 0, sizeof(camera3_capture_result));
-                    result.frame_number = frame_number;
-                    result.num_output_buffers = 1;
-                    result.output_buffers =  &j->buffer;
-                    result.input_buffer = k->input_buffer;
-                    result.result = k->settings;
-                    result.partial_result = PARTIAL_RESULT_COUNT;
-                    mCallbackOps->process_capture_result(mCallbackOps, &result);
-
-                    mPendingRequestsList.erase(k);
-                    mPendingRequest--;
-                    break;
-                }
+    PendingReprocessResult *j = mPendingReprocessResults.find(frame_number);
+    if (NULL == j) {
+        return NO_ERROR;
+    }
+
+    mCallbackOps->notify(mCallbackOps, &j->notify_msg);
+
+    CDBG("%s: Delayed reprocess notify %d", __func__,
+            frame_number);
+
+    PendingRequestInfo *k = mPendingRequests.find(frame_number);
+    if (NULL != k) {
+        CDBG("%s: Found reprocess frame number %d in pending reprocess List "
+                "Take it out!!", __func__,
+                k->frame_number);
+
+        camera3_capture_result result;
+        memset(&result, 0, sizeof(camera3_capture_result));
+        result.frame_number = frame_number;
+        result.num_output_buffers = 1;
+        result.output_buffers =  &j->buffer;
+        result.input_buffer = k->input_buffer;
+        result.result = k->settings;
+        result.partial_result = PARTIAL_RESULT_COUNT;
+        mCallbackOps->process_capture_result(mCallbackOps, &result);
+
+        mPendingRequests.erase(frame_number);
+        mPendingRequest--;
+    }
+    mPendingReprocessResults.erase(frame_number);
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : removePendingBuffer
+ *
+ * DESCRIPTION: take a buffer out of the pending buffers map
+ *
+ * PARAMETERS :
+ *   @frame_number : frame number of the buffer
+ *   @buffer       : buffer handle
+ *
+ * RETURN     : true if metadata reported the buffer as dropped
+ *==========================================================================*/
+bool QCamera3HardwareInterface::removePendingBuffer(uint32_t frame_number,
+        buffer_handle_t *buffer)
+{
+    Vector<PendingBufferInfo> *pending =
+            mPendingBuffersMap.mPendingBuffers.find(frame_number);
+    if (NULL == pending) {
+        return false;
+    }
+
+    for (size_t k = 0; k < pending->size(); k++) {
+        if (pending->itemAt(k).buffer == buffer) {
+            bool dropped = pending->itemAt(k).dropped;
+            CDBG("%s: Found buffer %p in pending buffer map for frame %u, "
+                    "Take it out!!", __func__, buffer, frame_number);
+            pending->removeAt(k);
+            mPendingBuffersMap.num_buffers--;
+            if (pending->isEmpty()) {
+                mPendingBuffersMap.mPendingBuffers.erase(frame_number);
             }
-            mPendingReprocessResultList.erase(j);
-            break;
+            return dropped;
         }
     }
-    return NO_ERROR;
+    return false;
+}
+
+/*===========================================================================
+ * FUNCTION   : markPendingBufferDropped
+ *
+ * DESCRIPTION: flag the pending buffer of a stream as dropped so it is
+ *              returned with CAMERA3_BUFFER_STATUS_ERROR
+ *
+ * PARAMETERS :
+ *   @frame_number : frame number of the buffer
+ *   @stream       : stream of the buffer
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::markPendingBufferDropped(uint32_t frame_number,
+        camera3_stream_t *stream)
+{
+    Vector<PendingBufferInfo> *pending =
+            mPendingBuffersMap.mPendingBuffers.find(frame_number);
+    if (NULL == pending) {
+        return;
+    }
+
+    for (size_t k = 0; k < pending->size(); k++) {
+        if (pending->itemAt(k).stream == stream) {
+            pending->editItemAt(k).dropped = true;
+        }
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : updateLockHoldStats
+ *
+ * DESCRIPTION: account one mMutex hold period
+ *
+ * PARAMETERS :
+ *   @stats    : statistics to update
+ *   @lockTime : time the mutex was acquired
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::updateLockHoldStats(LockHoldStats &stats,
+        nsecs_t lockTime)
+{
+    nsecs_t held = systemTime(CLOCK_MONOTONIC) - lockTime;
+    stats.count++;
+    stats.total += held;
+    if (held > stats.max) {
+        stats.max = held;
+    }
 }
 
 /*===========================================================================
@@ -1783,40 +2163,35 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
 
         //Recieved an urgent Frame Number, handle it
         //using partial results
-        for (List<PendingRequestInfo>::iterator i =
-            mPendingRequestsList.begin(); i != mPendingRequestsList.end(); i++) {
-            CDBG("%s: Iterator Frame = %d urgent frame = %d",
-                __func__, i->frame_number, urgent_frame_number);
-
-            if (i->frame_number < urgent_frame_number &&
-                i->partial_result_cnt == 0) {
+        for (PendingRequestInfo *i = mPendingRequests.first();
+                i != NULL && FRAME_NUM_LT(i->frame_number, urgent_frame_number);
+                i = mPendingRequests.next(i->frame_number)) {
+            if (i->partial_result_cnt == 0) {
                 ALOGE("%s: Error: HAL missed urgent metadata for frame number %d",
                     __func__, i->frame_number);
             }
+        }
 
-            if (i->frame_number == urgent_frame_number &&
-                     i->bUrgentReceived == 0) {
-
-                camera3_capture_result_t result;
-                memset(&result, 0, sizeof(camera3_capture_result_t));
+        PendingRequestInfo *i = mPendingRequests.find(urgent_frame_number);
+        if (i != NULL && i->bUrgentReceived == 0) {
+            camera3_capture_result_t result;
+            memset(&result, 0, sizeof(camera3_capture_result_t));
 
-                i->partial_result_cnt++;
-                i->bUrgentReceived = 1;
-                // Extract 3A metadata
-                result.result =
-                    translateCbUrgentMetadataToResultMetadata(metadata);
-                // Populate metadata result
-                result.frame_number = urgent_frame_number;
-                result.num_output_buffers = 0;
-                result.output_buffers = NULL;
-                result.partial_result = i->partial_result_cnt;
+            i->partial_result_cnt++;
+            i->bUrgentReceived = 1;
+            // Extract 3A metadata
+            result.result =
+                translateCbUrgentMetadataToResultMetadata(metadata);
+            // Populate metadata result
+            result.frame_number = urgent_frame_number;
+            result.num_output_buffers = 0;
+            result.output_buffers = NULL;
+            result.partial_result = i->partial_result_cnt;
 
-                mCallbackOps->process_capture_result(mCallbackOps, &result);
-                CDBG("%s: urgent frame_number = %u, capture_time = %lld",
-                     __func__, result.frame_number, capture_time);
-                free_camera_metadata((camera_metadata_t *)result.result);
-                break;
-            }
+            mCallbackOps->process_capture_result(mCallbackOps, &result);
+            CDBG("%s: urgent frame_number = %u, capture_time = %lld",
+                 __func__, result.frame_number, capture_time);
+            recycleResultMetadata((camera_metadata_t *)result.result);
         }
     }
 
@@ -1830,8 +2205,8 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             frame_number, capture_time);
 
     // Go through the pending requests info and send shutter/results to frameworks
-    for (List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-        i != mPendingRequestsList.end() && i->frame_number <= frame_number;) {
+    for (PendingRequestInfo *i = mPendingRequests.first();
+        i != NULL && FRAME_NUM_LE(i->frame_number, frame_number);) {
         camera3_capture_result_t result;
         memset(&result, 0, sizeof(camera3_capture_result_t));
 
@@ -1864,11 +2239,8 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
                        mCallbackOps->notify(mCallbackOps, &notify_msg);
                        CDBG("%s: End of reporting error frame#=%u, streamID=%u",
                               __func__, i->frame_number, streamID);
-                       PendingFrameDropInfo PendingFrameDrop;
-                       PendingFrameDrop.frame_number=i->frame_number;
-                       PendingFrameDrop.stream_ID = streamID;
-                       // Add the Frame drop info to mPendingFrameDropList
-                       mPendingFrameDropList.push_back(PendingFrameDrop);
+                       // Buffer is returned with error status once it arrives
+                       markPendingBufferDropped(i->frame_number, j->stream);
                    }
                 }
             }
@@ -1876,7 +2248,7 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
 
         // Send empty metadata with already filled buffers for dropped metadata
         // and send valid metadata with already filled buffers for current metadata
-        if (i->frame_number < frame_number) {
+        if (FRAME_NUM_LT(i->frame_number, frame_number)) {
             /* Clear notify_msg structure */
             camera3_notify_msg_t notify_msg;
             memset(&notify_msg, 0, sizeof(camera3_notify_msg_t));
@@ -1890,7 +2262,7 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             CDBG("%s: Support notification !!!! notify frame_number = %u, capture_time = %llu",
                     __func__, i->frame_number, notify_msg.message.shutter.timestamp);
 
-            CameraMetadata dummyMetadata;
+            CameraMetadata dummyMetadata(acquireResultMetadata());
             dummyMetadata.update(ANDROID_SENSOR_TIMESTAMP,
                     &i->timestamp, 1);
             dummyMetadata.update(ANDROID_REQUEST_ID,
@@ -1908,18 +2280,18 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             mCallbackOps->notify(mCallbackOps, &notify_msg);
 
             i->timestamp = capture_time;
+            updateInflightWindow(i->request_time, systemTime(CLOCK_MONOTONIC));
 
             result.result = translateFromHalMetadata(metadata,
-                    i->timestamp, i->request_id, i->jpegMetadata, i->pipeline_depth,
+                    i->timestamp, i->request_id, i->jpegMetadata,
+                    (uint8_t)(mMetadataCount - i->pipeline_start),
                     i->capture_intent);
 
             if (i->blob_request) {
                 {
                     //Dump tuning metadata if enabled and available
-                    char prop[PROPERTY_VALUE_MAX];
-                    memset(prop, 0, sizeof(prop));
-                    property_get("persist.camera.dumpmetadata", prop, "0");
-                    int32_t enabled = atoi(prop);
+                    bool enabled = QCameraDebugConfig::isEnabled(
+                            QCAMERA_DBG_DUMP_METADATA);
                     if (enabled && metadata->is_tuning_params_valid) {
                         dumpMetadataToFile(metadata->tuning_params,
                                mMetaFrameCount,
@@ -1960,30 +2332,10 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             for (List<RequestedBufferInfo>::iterator j = i->buffers.begin();
                     j != i->buffers.end(); j++) {
                 if (j->buffer) {
-                    for (List<PendingFrameDropInfo>::iterator m = mPendingFrameDropList.begin();
-                            m != mPendingFrameDropList.end(); m++) {
-                        QCamera3Channel *channel = (QCamera3Channel *)j->buffer->stream->priv;
-                        uint32_t streamID = channel->getStreamID(channel->getStreamTypeMask());
-                        if((m->stream_ID == streamID) && (m->frame_number==frame_number)) {
-                            j->buffer->status=CAMERA3_BUFFER_STATUS_ERROR;
-                            CDBG("%s: Stream STATUS_ERROR frame_number=%u, streamID=%u",
-                                  __func__, frame_number, streamID);
-                            m = mPendingFrameDropList.erase(m);
-                            break;
-                        }
-                    }
-
-                    for (List<PendingBufferInfo>::iterator k =
-                      mPendingBuffersMap.mPendingBufferList.begin();
-                      k != mPendingBuffersMap.mPendingBufferList.end(); k++) {
-                      if (k->buffer == j->buffer->buffer) {
-                        CDBG("%s: Found buffer %p in pending buffer List "
-                              "for frame %u, Take it out!!", __func__,
-                               k->buffer, k->frame_number);
-                        mPendingBuffersMap.num_buffers--;
-                        k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                        break;
-                      }
+                    if (removePendingBuffer(i->frame_number, j->buffer->buffer)) {
+                        j->buffer->status=CAMERA3_BUFFER_STATUS_ERROR;
+                        CDBG("%s: Stream STATUS_ERROR frame_number=%u, stream=%p",
+                              __func__, i->frame_number, j->stream);
                     }
 
                     result_buffers[result_buffers_idx++] = *(j->buffer);
@@ -1995,27 +2347,27 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             mCallbackOps->process_capture_result(mCallbackOps, &result);
             CDBG("%s: meta frame_number = %u, capture_time = %lld",
                     __func__, result.frame_number, i->timestamp);
-            free_camera_metadata((camera_metadata_t *)result.result);
+            recycleResultMetadata((camera_metadata_t *)result.result);
             delete[] result_buffers;
         } else {
             mCallbackOps->process_capture_result(mCallbackOps, &result);
             CDBG("%s: meta frame_number = %u, capture_time = %lld",
                         __func__, result.frame_number, i->timestamp);
-            free_camera_metadata((camera_metadata_t *)result.result);
+            recycleResultMetadata((camera_metadata_t *)result.result);
         }
-        // erase the element from the list
-        i = mPendingRequestsList.erase(i);
+        // erase the element from the table
+        uint32_t done_frame_number = i->frame_number;
+        mPendingRequests.erase(done_frame_number);
 
-        if (!mPendingReprocessResultList.empty()) {
+        if (!mPendingReprocessResults.isEmpty()) {
             handlePendingReprocResults(frame_number + 1);
         }
+        i = mPendingRequests.next(done_frame_number);
     }
 
 done_metadata:
-    for (List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-        i != mPendingRequestsList.end() ;i++) {
-        i->pipeline_depth++;
-    }
+    // Every pending request moves one step down the pipeline
+    mMetadataCount++;
     unblockRequestIfNecessary();
 
 }
@@ -2035,21 +2387,25 @@ void QCamera3HardwareInterface::handleBufferWithLock(
     camera3_stream_buffer_t *buffer, uint32_t frame_number)
 {
     ATRACE_CALL();
+    if (mFirstShotRequestTime && (frame_number == mFirstShotFrameNumber) &&
+            (buffer->stream->format == HAL_PIXEL_FORMAT_BLOB)) {
+        CDBG_HIGH("[KPI Perf] %s: X PROFILE_FIRST_SHOT frame %u, latency %lld us",
+                __func__, frame_number,
+                (long long)((systemTime(CLOCK_MONOTONIC) - mFirstShotRequestTime) /
+                NSEC_PER_USEC));
+        mFirstShotRequestTime = 0;
+    }
+
     // If the frame number doesn't exist in the pending request list,
     // directly send the buffer to the frameworks, and update pending buffers map
     // Otherwise, book-keep the buffer.
-    List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-    while (i != mPendingRequestsList.end() && i->frame_number != frame_number){
-        i++;
-    }
-    if (i == mPendingRequestsList.end()) {
+    PendingRequestInfo *i = mPendingRequests.find(frame_number);
+    if (i == NULL) {
         // Verify all pending requests frame_numbers are greater
-        for (List<PendingRequestInfo>::iterator j = mPendingRequestsList.begin();
-                j != mPendingRequestsList.end(); j++) {
-            if (j->frame_number < frame_number) {
-                ALOGE("%s: Error: pending frame number %d is smaller than %d",
-                        __func__, j->frame_number, frame_number);
-            }
+        PendingRequestInfo *oldest = mPendingRequests.first();
+        if (oldest != NULL && FRAME_NUM_LT(oldest->frame_number, frame_number)) {
+            ALOGE("%s: Error: pending frame number %d is smaller than %d",
+                    __func__, oldest->frame_number, frame_number);
         }
         camera3_capture_result_t result;
         memset(&result, 0, sizeof(camera3_capture_result_t));
@@ -2057,34 +2413,14 @@ void QCamera3HardwareInterface::handleBufferWithLock(
         result.frame_number = frame_number;
         result.num_output_buffers = 1;
         result.partial_result = 0;
-        for (List<PendingFrameDropInfo>::iterator m = mPendingFrameDropList.begin();
-                m != mPendingFrameDropList.end(); m++) {
-            QCamera3Channel *channel = (QCamera3Channel *)buffer->stream->priv;
-            uint32_t streamID = channel->getStreamID(channel->getStreamTypeMask());
-            if((m->stream_ID == streamID) && (m->frame_number==frame_number) ) {
-                buffer->status=CAMERA3_BUFFER_STATUS_ERROR;
-                CDBG("%s: Stream STATUS_ERROR frame_number=%d, streamID=%d",
-                        __func__, frame_number, streamID);
-                m = mPendingFrameDropList.erase(m);
-                break;
-            }
+        if (removePendingBuffer(frame_number, buffer->buffer)) {
+            buffer->status=CAMERA3_BUFFER_STATUS_ERROR;
+            CDBG("%s: Stream STATUS_ERROR frame_number=%d, stream=%p",
+                    __func__, frame_number, buffer->stream);
         }
         result.output_buffers = buffer;
         CDBG("%s: result frame_number = %d, buffer = %p",
                 __func__, frame_number, buffer->buffer);
-
-        for (List<PendingBufferInfo>::iterator k =
-                mPendingBuffersMap.mPendingBufferList.begin();
-                k != mPendingBuffersMap.mPendingBufferList.end(); k++ ) {
-            if (k->buffer == buffer->buffer) {
-                CDBG("%s: Found Frame buffer, take it out from list",
-                        __func__);
-
-                mPendingBuffersMap.num_buffers--;
-                k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                break;
-            }
-        }
         CDBG("%s: mPendingBuffersMap.num_buffers = %d",
             __func__, mPendingBuffersMap.num_buffers);
 
@@ -2117,29 +2453,14 @@ void QCamera3HardwareInterface::handleBufferWithLock(
                 ALOGE("%s: input buffer fence wait failed %d", __func__, rc);
             }
 
-            for (List<PendingBufferInfo>::iterator k =
-                    mPendingBuffersMap.mPendingBufferList.begin();
-                    k != mPendingBuffersMap.mPendingBufferList.end(); k++ ) {
-                if (k->buffer == buffer->buffer) {
-                    CDBG("%s: Found Frame buffer, take it out from list",
-                            __func__);
-
-                    mPendingBuffersMap.num_buffers--;
-                    k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                    break;
-                }
-            }
+            removePendingBuffer(frame_number, buffer->buffer);
             CDBG("%s: mPendingBuffersMap.num_buffers = %d",
                 __func__, mPendingBuffersMap.num_buffers);
 
-            bool notifyNow = true;
-            for (List<PendingRequestInfo>::iterator j = mPendingRequestsList.begin();
-                    j != mPendingRequestsList.end(); j++) {
-                if (j->frame_number < frame_number) {
-                    notifyNow = false;
-                    break;
-                }
-            }
+            // Results go out in order, wait for any older pending request
+            PendingRequestInfo *oldest = mPendingRequests.first();
+            bool notifyNow = !(oldest != NULL &&
+                    FRAME_NUM_LT(oldest->frame_number, frame_number));
 
             if (notifyNow) {
                 camera3_capture_result result;
@@ -2154,7 +2475,7 @@ void QCamera3HardwareInterface::handleBufferWithLock(
                 mCallbackOps->notify(mCallbackOps, &notify_msg);
                 mCallbackOps->process_capture_result(mCallbackOps, &result);
                 CDBG("%s: Notify reprocess now %d!", __func__, frame_number);
-                i = mPendingRequestsList.erase(i);
+                mPendingRequests.erase(frame_number);
                 mPendingRequest--;
             } else {
                 // Cache reprocess result for later
@@ -2163,7 +2484,7 @@ void QCamera3HardwareInterface::handleBufferWithLock(
                 pendingResult.notify_msg = notify_msg;
                 pendingResult.buffer = *buffer;
                 pendingResult.frame_number = frame_number;
-                mPendingReprocessResultList.push_back(pendingResult);
+                mPendingReprocessResults.add(frame_number, pendingResult);
                 CDBG("%s: Cache reprocess result %d!", __func__, frame_number);
             }
         } else {
@@ -2202,6 +2523,115 @@ void QCamera3HardwareInterface::unblockRequestIfNecessary()
    pthread_cond_signal(&mRequestCond);
 }
 
+/*===========================================================================
+ * FUNCTION   : initInflightWindow
+ *
+ * DESCRIPTION: derive the in-flight request window bounds for the current
+ *              stream configuration. The ceiling is the smallest buffer
+ *              count of the processed output streams, capped by what the
+ *              backend was configured for; the window starts at the floor
+ *              and adapts to the measured result latency.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::initInflightWindow()
+{
+    uint32_t ceiling = mStreamConfigInfo.buffer_info.max_buffers;
+
+    for (List<stream_info_t *>::iterator it = mStreamInfo.begin();
+            it != mStreamInfo.end(); it++) {
+        camera3_stream_t *stream = (*it)->stream;
+        /* Blob and input buffers are paced by their own channels */
+        if ((stream->stream_type == CAMERA3_STREAM_INPUT) ||
+                (stream->format == HAL_PIXEL_FORMAT_BLOB) ||
+                (0 == stream->max_buffers)) {
+            continue;
+        }
+        ceiling = MIN(ceiling, stream->max_buffers);
+    }
+
+    mInflightCeiling = MAX(ceiling, 1U);
+    mInflightFloor = MIN((uint32_t)MIN_INFLIGHT_REQUESTS, mInflightCeiling);
+    mInflightWindow = mInflightFloor;
+    mResultLatency = 0;
+    mResultInterval = 0;
+    mLastResultTime = 0;
+    memset(mRequestBlockHist, 0, sizeof(mRequestBlockHist));
+    CDBG_HIGH("%s: in-flight window %u, ceiling %u", __func__,
+            mInflightWindow, mInflightCeiling);
+}
+
+/*===========================================================================
+ * FUNCTION   : updateInflightWindow
+ *
+ * DESCRIPTION: fold one request to result latency into the running averages
+ *              and resize the window to cover it: enough requests to keep
+ *              the pipeline busy for one latency at the measured result rate,
+ *              plus one being queued. Must be called with mMutex held.
+ *
+ * PARAMETERS :
+ *   @requestTime : time the request was queued
+ *   @resultTime  : time its result metadata arrived
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::updateInflightWindow(nsecs_t requestTime,
+        nsecs_t resultTime)
+{
+    nsecs_t latency = resultTime - requestTime;
+
+    if (0 != mLastResultTime) {
+        nsecs_t interval = resultTime - mLastResultTime;
+        mResultInterval = (0 == mResultInterval) ? interval :
+                mResultInterval + (interval - mResultInterval) / INFLIGHT_EWMA_WEIGHT;
+    }
+    mLastResultTime = resultTime;
+    mResultLatency = (0 == mResultLatency) ? latency :
+            mResultLatency + (latency - mResultLatency) / INFLIGHT_EWMA_WEIGHT;
+
+    if (mResultInterval <= 0) {
+        return;
+    }
+
+    nsecs_t depth = (mResultLatency + mResultInterval - 1) / mResultInterval + 1;
+    uint32_t window = (uint32_t)MIN((nsecs_t)mInflightCeiling,
+            MAX((nsecs_t)mInflightFloor, depth));
+    if (window != mInflightWindow) {
+        CDBG("%s: in-flight window %u -> %u, latency %lld us, interval %lld us",
+                __func__, mInflightWindow, window,
+                (long long)(mResultLatency / NSEC_PER_USEC),
+                (long long)(mResultInterval / NSEC_PER_USEC));
+        mInflightWindow = window;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : recordRequestBlockTime
+ *
+ * DESCRIPTION: account the time process_capture_request blocked on the
+ *              in-flight window. Bucket 0 counts requests that did not
+ *              block; bucket n > 0 counts blocking below 2^(n-1) ms, the
+ *              last bucket everything longer.
+ *
+ * PARAMETERS :
+ *   @blockTime : time spent waiting on mRequestCond
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::recordRequestBlockTime(nsecs_t blockTime)
+{
+    size_t idx = 1;
+    nsecs_t limit = NSEC_PER_MSEC;
+
+    while ((idx < REQUEST_BLOCK_HIST_SIZE - 1) && (blockTime >= limit)) {
+        limit <<= 1;
+        idx++;
+    }
+    mRequestBlockHist[idx]++;
+}
+
 /*===========================================================================
  * FUNCTION   : processCaptureRequest
  *
@@ -2384,6 +2814,9 @@ int QCamera3HardwareInterface::processCaptureRequest(
             }
         }
 
+        // Snapshot buffers are picked up by the picture channel on start
+        waitForBufferPreallocation();
+
         //Then start them.
         CDBG_HIGH("%s: Start META Channel", __func__);
         rc = mMetadataChannel->start();
@@ -2544,10 +2977,20 @@ int QCamera3HardwareInterface::processCaptureRequest(
 
     pendingRequest.input_buffer = request->input_buffer;
     pendingRequest.settings = request->settings;
-    pendingRequest.pipeline_depth = 0;
+    pendingRequest.pipeline_start = mMetadataCount;
+    pendingRequest.request_time = systemTime(CLOCK_MONOTONIC);
     pendingRequest.partial_result_cnt = 0;
     extractJpegMetadata(pendingRequest.jpegMetadata, request);
 
+    if (blob_request && mFirstShotPending) {
+        mFirstShotPending = false;
+        mFirstShotFrameNumber = frameNumber;
+        mFirstShotRequestTime = systemTime(CLOCK_MONOTONIC);
+        CDBG_HIGH("[KPI Perf] %s: E PROFILE_FIRST_SHOT frame %u, %lld us after configure",
+                __func__, frameNumber,
+                (long long)((mFirstShotRequestTime - mConfigDoneTime) / NSEC_PER_USEC));
+    }
+
     //extract capture intent
     if (meta.exists(ANDROID_CONTROL_CAPTURE_INTENT)) {
         mCaptureIntent =
@@ -2555,6 +2998,7 @@ int QCamera3HardwareInterface::processCaptureRequest(
     }
     pendingRequest.capture_intent = mCaptureIntent;
 
+    Vector<PendingBufferInfo> pendingBuffers;
     for (size_t i = 0; i < request->num_output_buffers; i++) {
         RequestedBufferInfo requestedBuf;
         requestedBuf.stream = request->output_buffers[i].stream;
@@ -2566,7 +3010,8 @@ int QCamera3HardwareInterface::processCaptureRequest(
         bufferInfo.frame_number = frameNumber;
         bufferInfo.buffer = request->output_buffers[i].buffer;
         bufferInfo.stream = request->output_buffers[i].stream;
-        mPendingBuffersMap.mPendingBufferList.push_back(bufferInfo);
+        bufferInfo.dropped = false;
+        pendingBuffers.add(bufferInfo);
         mPendingBuffersMap.num_buffers++;
         QCamera3Channel *channel = (QCamera3Channel *)bufferInfo.stream->priv;
         CDBG("%s: frame = %d, buffer = %p, streamTypeMask = %d, stream format = %d",
@@ -2576,9 +3021,20 @@ int QCamera3HardwareInterface::processCaptureRequest(
     CDBG("%s: mPendingBuffersMap.num_buffers = %d",
           __func__, mPendingBuffersMap.num_buffers);
 
-    mPendingRequestsList.push_back(pendingRequest);
-
+    if (!pendingBuffers.isEmpty() &&
+            (NULL == mPendingBuffersMap.mPendingBuffers.add(frameNumber,
+                    pendingBuffers))) {
+        ALOGE("%s: Error: frame number %d already has pending buffers",
+                __func__, frameNumber);
+    }
+    if (NULL == mPendingRequests.add(frameNumber, pendingRequest)) {
+        ALOGE("%s: Error: frame number %d is already pending",
+                __func__, frameNumber);
+    }
+
     if(mFlush) {
+        /* parameters of this request never reach the backend */
+        invalidateSettingsCache();
         pthread_mutex_unlock(&mMutex);
         return NO_ERROR;
     }
@@ -2644,10 +3100,23 @@ int QCamera3HardwareInterface::processCaptureRequest(
 
     if(request->input_buffer == NULL) {
         /*set the parameters to backend*/
-        mCameraHandle->ops->set_parms(mCameraHandle->camera_handle, mParameters);
+        if (mCameraHandle->ops->set_parms(mCameraHandle->camera_handle,
+                mParameters) < 0) {
+            ALOGE("%s: set_parms failed for frame %u", __func__, frameNumber);
+            invalidateSettingsCache();
+        }
     }
 
     mFirstRequest = false;
+
+    mPendingRequest++;
+    if (mPendingRequest < (int)mInflightWindow) {
+        /* Window has room, no need to wait */
+        mRequestBlockHist[0]++;
+        pthread_mutex_unlock(&mMutex);
+        return NO_ERROR;
+    }
+
     // Added a timed condition wait
     struct timespec ts;
     uint8_t isValidTimeout = 1;
@@ -2661,9 +3130,8 @@ int QCamera3HardwareInterface::processCaptureRequest(
       ts.tv_sec += 5;
     }
     //Block on conditional variable
-
-    mPendingRequest++;
-    while (mPendingRequest >= MIN_INFLIGHT_REQUESTS) {
+    nsecs_t blockStart = systemTime(CLOCK_MONOTONIC);
+    while (mPendingRequest >= (int)mInflightWindow) {
         if (!isValidTimeout) {
             CDBG("%s: Blocking on conditional wait", __func__);
             pthread_cond_wait(&mRequestCond, &mMutex);
@@ -2680,10 +3148,11 @@ int QCamera3HardwareInterface::processCaptureRequest(
         CDBG("%s: Unblocked", __func__);
         if (mWokenUpByDaemon) {
             mWokenUpByDaemon = false;
-            if (mPendingRequest < MAX_INFLIGHT_REQUESTS)
+            if (mPendingRequest < (int)mInflightCeiling)
                 break;
         }
     }
+    recordRequestBlockTime(systemTime(CLOCK_MONOTONIC) - blockStart);
     pthread_mutex_unlock(&mMutex);
 
     return rc;
@@ -2705,12 +3174,12 @@ void QCamera3HardwareInterface::dump(int fd)
     dprintf(fd, "\n Camera HAL3 information Begin \n");
 
     dprintf(fd, "\nNumber of pending requests: %zu \n",
-        mPendingRequestsList.size());
+        mPendingRequests.size());
     dprintf(fd, "-------+-------------------+-------------+----------+---------------------\n");
     dprintf(fd, " Frame | Number of Buffers |   Req Id:   | Blob Req | Input buffer present\n");
     dprintf(fd, "-------+-------------------+-------------+----------+---------------------\n");
-    for(List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-        i != mPendingRequestsList.end(); i++) {
+    for (PendingRequestInfo *i = mPendingRequests.first(); i != NULL;
+        i = mPendingRequests.next(i->frame_number)) {
         dprintf(fd, " %5d | %17d | %11d | %8d | %p \n",
         i->frame_number, i->num_buffers, i->request_id, i->blob_request,
         i->input_buffer);
@@ -2720,31 +3189,77 @@ void QCamera3HardwareInterface::dump(int fd)
     dprintf(fd, "-------+------------------\n");
     dprintf(fd, " Frame | Stream type mask \n");
     dprintf(fd, "-------+------------------\n");
-    for(List<PendingBufferInfo>::iterator i =
-        mPendingBuffersMap.mPendingBufferList.begin();
-        i != mPendingBuffersMap.mPendingBufferList.end(); i++) {
-        QCamera3Channel *channel = (QCamera3Channel *)(i->stream->priv);
-        dprintf(fd, " %5d | %11d \n",
-                i->frame_number, channel->getStreamTypeMask());
+    for (Vector<PendingBufferInfo> *pending =
+        mPendingBuffersMap.mPendingBuffers.first(); pending != NULL;
+        pending = mPendingBuffersMap.mPendingBuffers.next(
+                pending->itemAt(0).frame_number)) {
+        for (size_t k = 0; k < pending->size(); k++) {
+            const PendingBufferInfo &info = pending->itemAt(k);
+            QCamera3Channel *channel = (QCamera3Channel *)(info.stream->priv);
+            dprintf(fd, " %5d | %11d %s\n",
+                    info.frame_number, channel->getStreamTypeMask(),
+                    info.dropped ? "(dropped)" : "");
+        }
     }
     dprintf(fd, "-------+------------------\n");
 
-    dprintf(fd, "\nPending frame drop list: %zu\n",
-        mPendingFrameDropList.size());
-    dprintf(fd, "-------+-----------\n");
-    dprintf(fd, " Frame | Stream ID \n");
-    dprintf(fd, "-------+-----------\n");
-    for(List<PendingFrameDropInfo>::iterator i = mPendingFrameDropList.begin();
-        i != mPendingFrameDropList.end(); i++) {
-        dprintf(fd, " %5d | %9d \n",
-            i->frame_number, i->stream_ID);
-    }
-    dprintf(fd, "-------+-----------\n");
+    dprintf(fd, "\nmMutex hold time on result path (us)\n");
+    dprintf(fd, "----------+----------+----------+----------\n");
+    dprintf(fd, " Result   |    Count |      Avg |      Max \n");
+    dprintf(fd, "----------+----------+----------+----------\n");
+    dprintf(fd, " Metadata | %8u | %8lld | %8lld \n", mMetaLockStats.count,
+            (long long)(mMetaLockStats.count ?
+            mMetaLockStats.total / mMetaLockStats.count / NSEC_PER_USEC : 0),
+            (long long)(mMetaLockStats.max / NSEC_PER_USEC));
+    dprintf(fd, " Buffer   | %8u | %8lld | %8lld \n", mBufferLockStats.count,
+            (long long)(mBufferLockStats.count ?
+            mBufferLockStats.total / mBufferLockStats.count / NSEC_PER_USEC : 0),
+            (long long)(mBufferLockStats.max / NSEC_PER_USEC));
+    dprintf(fd, "----------+----------+----------+----------\n");
+
+    dprintf(fd, "\nRequest settings: %u with settings, %u unchanged, "
+            "%u entries sent, %u entries skipped\n",
+            mSettingsCacheStats.requests, mSettingsCacheStats.unchanged,
+            mSettingsCacheStats.sent, mSettingsCacheStats.skipped);
+
+    dprintf(fd, "\nIn-flight window: %u (floor %u, ceiling %u), "
+            "result latency %lld us, result interval %lld us\n",
+            mInflightWindow, mInflightFloor, mInflightCeiling,
+            (long long)(mResultLatency / NSEC_PER_USEC),
+            (long long)(mResultInterval / NSEC_PER_USEC));
+    dprintf(fd, "----------+----------\n");
+    dprintf(fd, " Blocked  | Requests \n");
+    dprintf(fd, "----------+----------\n");
+    dprintf(fd, " no       | %8u \n", mRequestBlockHist[0]);
+    for (size_t k = 1; k < REQUEST_BLOCK_HIST_SIZE - 1; k++) {
+        dprintf(fd, " <%5u ms | %8u \n", 1U << (k - 1), mRequestBlockHist[k]);
+    }
+    dprintf(fd, " >=%4u ms | %8u \n", 1U << (REQUEST_BLOCK_HIST_SIZE - 2),
+            mRequestBlockHist[REQUEST_BLOCK_HIST_SIZE - 1]);
+    dprintf(fd, "----------+----------\n");
+
+    dprintf(fd, "\nFlush: %u calls, phase durations (us)\n", mFlushCount);
+    dprintf(fd, "------+----------+----------+----------+----------\n");
+    dprintf(fd, "      |     Stop |    Drain |  Restart |    Total \n");
+    dprintf(fd, "------+----------+----------+----------+----------\n");
+    dprintf(fd, " Last | %8lld | %8lld | %8lld | %8lld \n",
+            (long long)(mLastFlushTiming.stop / NSEC_PER_USEC),
+            (long long)(mLastFlushTiming.drain / NSEC_PER_USEC),
+            (long long)(mLastFlushTiming.restart / NSEC_PER_USEC),
+            (long long)(mLastFlushTiming.total / NSEC_PER_USEC));
+    dprintf(fd, " Max  | %8lld | %8lld | %8lld | %8lld \n",
+            (long long)(mMaxFlushTiming.stop / NSEC_PER_USEC),
+            (long long)(mMaxFlushTiming.drain / NSEC_PER_USEC),
+            (long long)(mMaxFlushTiming.restart / NSEC_PER_USEC),
+            (long long)(mMaxFlushTiming.total / NSEC_PER_USEC));
+    dprintf(fd, "------+----------+----------+----------+----------\n");
 
     dprintf(fd, "\n Camera HAL3 information End \n");
 
-    /* use dumpsys media.camera as trigger to send update debug level event */
+    /* use dumpsys media.camera as trigger to send update debug level event
+     * and to re-read the debug properties */
     mUpdateDebugLevel = true;
+    QCameraDebugConfig::refresh();
     pthread_mutex_unlock(&mMutex);
     return;
 }
@@ -2752,49 +3267,33 @@ void QCamera3HardwareInterface::dump(int fd)
 /*===========================================================================
  * FUNCTION   : flush
  *
- * DESCRIPTION:
- *
- * PARAMETERS :
+ * DESCRIPTION: stop all channels, return every pending buffer and request
+ *              with an error and restart the channels. The duration of
+ *              each phase is logged and kept for dump().
  *
+ * PARAMETERS : none
  *
- * RETURN     :
+ * RETURN     : 0 on success
+ *              Error code on failure
  *==========================================================================*/
 int QCamera3HardwareInterface::flush()
 {
     ATRACE_CALL();
-    unsigned int frameNum = 0;
-    camera3_capture_result_t result;
-    camera3_stream_buffer_t *pStream_Buf = NULL;
-    FlushMap flushMap;
+    FlushTiming timing;
+    nsecs_t start = systemTime(CLOCK_MONOTONIC);
+    nsecs_t phaseStart = start;
+    nsecs_t now;
 
     CDBG("%s: Unblocking Process Capture Request", __func__);
     pthread_mutex_lock(&mMutex);
     mFlush = true;
     pthread_mutex_unlock(&mMutex);
 
-    memset(&result, 0, sizeof(camera3_capture_result_t));
-
     // Stop the Streams/Channels
-    for (List<stream_info_t *>::iterator it = mStreamInfo.begin();
-        it != mStreamInfo.end(); it++) {
-        QCamera3Channel *channel = (QCamera3Channel *)(*it)->stream->priv;
-        channel->stop();
-        (*it)->status = INVALID;
-    }
-
-    if (mSupportChannel) {
-        mSupportChannel->stop();
-    }
-    if (mAnalysisChannel) {
-        mAnalysisChannel->stop();
-    }
-    if (mRawDumpChannel) {
-        mRawDumpChannel->stop();
-    }
-    if (mMetadataChannel) {
-        /* If content of mStreamInfo is not 0, there is metadata stream */
-        mMetadataChannel->stop();
-    }
+    stopAllChannels();
+    now = systemTime(CLOCK_MONOTONIC);
+    timing.stop = now - phaseStart;
+    phaseStart = now;
 
     // Mutex Lock
     pthread_mutex_lock(&mMutex);
@@ -2803,157 +3302,18 @@ int QCamera3HardwareInterface::flush()
     mPendingRequest = 0;
     pthread_cond_signal(&mRequestCond);
 
-    List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-    frameNum = i->frame_number;
-    CDBG("%s: Oldest frame num on  mPendingRequestsList = %d",
-      __func__, frameNum);
-
-    // Go through the pending buffers and group them depending
-    // on frame number
-    for (List<PendingBufferInfo>::iterator k =
-            mPendingBuffersMap.mPendingBufferList.begin();
-            k != mPendingBuffersMap.mPendingBufferList.end();) {
-
-        if (k->frame_number < frameNum) {
-            ssize_t idx = flushMap.indexOfKey(k->frame_number);
-            if (idx == NAME_NOT_FOUND) {
-                Vector<PendingBufferInfo> pending;
-                pending.add(*k);
-                flushMap.add(k->frame_number, pending);
-            } else {
-                Vector<PendingBufferInfo> &pending =
-                        flushMap.editValueFor(k->frame_number);
-                pending.add(*k);
-            }
-
-            mPendingBuffersMap.num_buffers--;
-            k = mPendingBuffersMap.mPendingBufferList.erase(k);
-        } else {
-            k++;
-        }
-    }
-
-    for (size_t iFlush = 0; iFlush < flushMap.size(); iFlush++) {
-        uint32_t frame_number = flushMap.keyAt(iFlush);
-        const Vector<PendingBufferInfo> &pending = flushMap.valueAt(iFlush);
-
-        // Send Error notify to frameworks for each buffer for which
-        // metadata buffer is already sent
-        CDBG("%s: Sending ERROR BUFFER for frame %d number of buffer %d",
-          __func__, frame_number, pending.size());
-
-        pStream_Buf = new camera3_stream_buffer_t[pending.size()];
-        if (NULL == pStream_Buf) {
-            ALOGE("%s: No memory for pending buffers array", __func__);
-            pthread_mutex_unlock(&mMutex);
-            return NO_MEMORY;
-        }
-        memset(pStream_Buf, 0, sizeof(camera3_stream_buffer_t)*pending.size());
-
-        for (size_t j = 0; j < pending.size(); j++) {
-            const PendingBufferInfo &info = pending.itemAt(j);
-            camera3_notify_msg_t notify_msg;
-            memset(&notify_msg, 0, sizeof(camera3_notify_msg_t));
-            notify_msg.type = CAMERA3_MSG_ERROR;
-            notify_msg.message.error.error_code = CAMERA3_MSG_ERROR_BUFFER;
-            notify_msg.message.error.error_stream = info.stream;
-            notify_msg.message.error.frame_number = frame_number;
-            pStream_Buf[j].acquire_fence = -1;
-            pStream_Buf[j].release_fence = -1;
-            pStream_Buf[j].buffer = info.buffer;
-            pStream_Buf[j].status = CAMERA3_BUFFER_STATUS_ERROR;
-            pStream_Buf[j].stream = info.stream;
-            mCallbackOps->notify(mCallbackOps, &notify_msg);
-            CDBG("%s: notify frame_number = %d stream %p", __func__,
-                    frame_number, info.stream);
-        }
-
-        result.result = NULL;
-        result.frame_number = frame_number;
-        result.num_output_buffers = (uint32_t)pending.size();
-        result.output_buffers = pStream_Buf;
-        mCallbackOps->process_capture_result(mCallbackOps, &result);
-
-        delete [] pStream_Buf;
-    }
-
-    CDBG("%s:Sending ERROR REQUEST for all pending requests", __func__);
-
-    flushMap.clear();
-    for (List<PendingBufferInfo>::iterator k =
-            mPendingBuffersMap.mPendingBufferList.begin();
-            k != mPendingBuffersMap.mPendingBufferList.end();) {
-        ssize_t idx = flushMap.indexOfKey(k->frame_number);
-        if (idx == NAME_NOT_FOUND) {
-            Vector<PendingBufferInfo> pending;
-            pending.add(*k);
-            flushMap.add(k->frame_number, pending);
-        } else {
-            Vector<PendingBufferInfo> &pending =
-                    flushMap.editValueFor(k->frame_number);
-            pending.add(*k);
-        }
-
-        mPendingBuffersMap.num_buffers--;
-        k = mPendingBuffersMap.mPendingBufferList.erase(k);
-    }
-
-    // Go through the pending requests info and send error request to framework
-    for (size_t iFlush = 0; iFlush < flushMap.size(); iFlush++) {
-        uint32_t frame_number = flushMap.keyAt(iFlush);
-        const Vector<PendingBufferInfo> &pending = flushMap.valueAt(iFlush);
-        CDBG("%s:Sending ERROR REQUEST for frame %d",
-              __func__, frame_number);
-
-        // Send shutter notify to frameworks
-        camera3_notify_msg_t notify_msg;
-        memset(&notify_msg, 0, sizeof(camera3_notify_msg_t));
-        notify_msg.type = CAMERA3_MSG_ERROR;
-        notify_msg.message.error.error_code = CAMERA3_MSG_ERROR_REQUEST;
-        notify_msg.message.error.error_stream = NULL;
-        notify_msg.message.error.frame_number = frame_number;
-        mCallbackOps->notify(mCallbackOps, &notify_msg);
-
-        pStream_Buf = new camera3_stream_buffer_t[pending.size()];
-        if (NULL == pStream_Buf) {
-            ALOGE("%s: No memory for pending buffers array", __func__);
-            pthread_mutex_unlock(&mMutex);
-            return NO_MEMORY;
-        }
-        memset(pStream_Buf, 0, sizeof(camera3_stream_buffer_t)*pending.size());
-
-        for (size_t j = 0; j < pending.size(); j++) {
-            const PendingBufferInfo &info = pending.itemAt(j);
-            pStream_Buf[j].acquire_fence = -1;
-            pStream_Buf[j].release_fence = -1;
-            pStream_Buf[j].buffer = info.buffer;
-            pStream_Buf[j].status = CAMERA3_BUFFER_STATUS_ERROR;
-            pStream_Buf[j].stream = info.stream;
-        }
-
-        result.num_output_buffers = (uint32_t)pending.size();
-        result.output_buffers = pStream_Buf;
-        result.result = NULL;
-        result.frame_number = frame_number;
-        mCallbackOps->process_capture_result(mCallbackOps, &result);
-        delete [] pStream_Buf;
+    int rc = flushPendingWithLock();
+    if (rc != NO_ERROR) {
+        pthread_mutex_unlock(&mMutex);
+        return rc;
     }
 
-    /* Reset pending buffer list and requests list */
-    mPendingRequestsList.clear();
-    /* Reset pending frame Drop list and requests list */
-    mPendingFrameDropList.clear();
-
-    flushMap.clear();
-    mPendingBuffersMap.num_buffers = 0;
-    mPendingBuffersMap.mPendingBufferList.clear();
-    mPendingReprocessResultList.clear();
-    CDBG("%s: Cleared all the pending buffers ", __func__);
-
     mFlush = false;
+    now = systemTime(CLOCK_MONOTONIC);
+    timing.drain = now - phaseStart;
+    phaseStart = now;
 
     // Start the Streams/Channels
-    int rc = NO_ERROR;
     if (mMetadataChannel) {
         /* If content of mStreamInfo is not 0, there is metadata stream */
         rc = mMetadataChannel->start();
@@ -2993,11 +3353,223 @@ int QCamera3HardwareInterface::flush()
         }
     }
 
+    now = systemTime(CLOCK_MONOTONIC);
+    timing.restart = now - phaseStart;
+    timing.total = now - start;
+    mLastFlushTiming = timing;
+    mMaxFlushTiming.stop = MAX(mMaxFlushTiming.stop, timing.stop);
+    mMaxFlushTiming.drain = MAX(mMaxFlushTiming.drain, timing.drain);
+    mMaxFlushTiming.restart = MAX(mMaxFlushTiming.restart, timing.restart);
+    mMaxFlushTiming.total = MAX(mMaxFlushTiming.total, timing.total);
+    mFlushCount++;
+    CDBG_HIGH("%s: flush took %lld us: stop %lld us, drain %lld us, "
+            "restart %lld us", __func__,
+            (long long)(timing.total / NSEC_PER_USEC),
+            (long long)(timing.stop / NSEC_PER_USEC),
+            (long long)(timing.drain / NSEC_PER_USEC),
+            (long long)(timing.restart / NSEC_PER_USEC));
+
     pthread_mutex_unlock(&mMutex);
 
     return 0;
 }
 
+/*===========================================================================
+ * FUNCTION   : stopAllChannels
+ *
+ * DESCRIPTION: stop all stream, support, analysis and raw dump channels in
+ *              parallel, then the metadata channel. Stopping a channel
+ *              mostly waits on stream-off in the kernel and backend, so
+ *              flush no longer pays that wait once per configured stream.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::stopAllChannels()
+{
+    ChannelStopJob job;
+    pthread_t threads[MAX_FLUSH_STOP_THREADS - 1];
+    size_t numThreads = 0;
+
+    job.next = 0;
+    for (List<stream_info_t *>::iterator it = mStreamInfo.begin();
+        it != mStreamInfo.end(); it++) {
+        QCamera3Channel *channel = (QCamera3Channel *)(*it)->stream->priv;
+        (*it)->status = INVALID;
+        if (channel != NULL) {
+            job.channels.push_back(channel);
+        }
+    }
+    if (mSupportChannel) {
+        job.channels.push_back(mSupportChannel);
+    }
+    if (mAnalysisChannel) {
+        job.channels.push_back(mAnalysisChannel);
+    }
+    if (mRawDumpChannel) {
+        job.channels.push_back(mRawDumpChannel);
+    }
+
+    // the calling thread takes a share of the channels as well
+    size_t wanted = MIN(job.channels.size(), (size_t)MAX_FLUSH_STOP_THREADS);
+    while (numThreads + 1 < wanted) {
+        if (pthread_create(&threads[numThreads], NULL,
+                channelStopRoutine, &job) != 0) {
+            ALOGE("%s: failed to create stop thread, continuing with %zu",
+                    __func__, numThreads + 1);
+            break;
+        }
+        pthread_setname_np(threads[numThreads], "CAM_flushStop");
+        numThreads++;
+    }
+    channelStopRoutine(&job);
+    for (size_t i = 0; i < numThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (mMetadataChannel) {
+        /* If content of mStreamInfo is not 0, there is metadata stream */
+        mMetadataChannel->stop();
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : channelStopRoutine
+ *
+ * DESCRIPTION: stop channels of a ChannelStopJob until none is left
+ *
+ * PARAMETERS :
+ *   @data    : ptr to ChannelStopJob
+ *
+ * RETURN     : NULL
+ *==========================================================================*/
+void *QCamera3HardwareInterface::channelStopRoutine(void *data)
+{
+    ChannelStopJob *job = (ChannelStopJob *)data;
+    uint32_t idx;
+
+    while ((idx = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+            job->channels.size()) {
+        job->channels[idx]->stop();
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : flushPendingWithLock
+ *
+ * DESCRIPTION: send error notifies and error results for all pending
+ *              requests and buffers, then reset the pending bookkeeping.
+ *              Each frame gets one capture result carrying all its buffers.
+ *              Caller must hold mMutex.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : NO_ERROR on success
+ *              NO_MEMORY if the result buffer array cannot be allocated
+ *==========================================================================*/
+int QCamera3HardwareInterface::flushPendingWithLock()
+{
+    unsigned int frameNum = 0;
+    camera3_capture_result_t result;
+    camera3_stream_buffer_t *pStream_Buf = NULL;
+    size_t maxBuffers = 0;
+
+    memset(&result, 0, sizeof(camera3_capture_result_t));
+
+    // Buffers of frames older than the oldest pending request already had
+    // their metadata sent, without pending request all of them did
+    PendingRequestInfo *oldest = mPendingRequests.first();
+    if (oldest != NULL) {
+        frameNum = oldest->frame_number;
+        CDBG("%s: Oldest frame num on mPendingRequests = %d",
+          __func__, frameNum);
+    }
+
+    // One buffer array sized for the largest frame serves all results
+    for (Vector<PendingBufferInfo> *pending =
+            mPendingBuffersMap.mPendingBuffers.first(); pending != NULL;
+            pending = mPendingBuffersMap.mPendingBuffers.next(
+                    pending->itemAt(0).frame_number)) {
+        maxBuffers = MAX(maxBuffers, pending->size());
+    }
+    if (maxBuffers > 0) {
+        pStream_Buf = new camera3_stream_buffer_t[maxBuffers];
+        if (NULL == pStream_Buf) {
+            ALOGE("%s: No memory for pending buffers array", __func__);
+            return NO_MEMORY;
+        }
+    }
+
+    // The pending buffers are grouped by frame number, oldest first
+    for (Vector<PendingBufferInfo> *pending =
+            mPendingBuffersMap.mPendingBuffers.first(); pending != NULL;
+            pending = mPendingBuffersMap.mPendingBuffers.next(
+                    pending->itemAt(0).frame_number)) {
+        uint32_t frame_number = pending->itemAt(0).frame_number;
+        bool metaSent = (oldest == NULL) || FRAME_NUM_LT(frame_number, frameNum);
+
+        if (metaSent) {
+            // Send Error notify to frameworks for each buffer for which
+            // metadata buffer is already sent
+            CDBG("%s: Sending ERROR BUFFER for frame %d number of buffer %d",
+              __func__, frame_number, pending->size());
+        } else {
+            CDBG("%s:Sending ERROR REQUEST for frame %d",
+                  __func__, frame_number);
+
+            camera3_notify_msg_t notify_msg;
+            memset(&notify_msg, 0, sizeof(camera3_notify_msg_t));
+            notify_msg.type = CAMERA3_MSG_ERROR;
+            notify_msg.message.error.error_code = CAMERA3_MSG_ERROR_REQUEST;
+            notify_msg.message.error.error_stream = NULL;
+            notify_msg.message.error.frame_number = frame_number;
+            mCallbackOps->notify(mCallbackOps, &notify_msg);
+        }
+
+        memset(pStream_Buf, 0, sizeof(camera3_stream_buffer_t)*pending->size());
+
+        for (size_t j = 0; j < pending->size(); j++) {
+            const PendingBufferInfo &info = pending->itemAt(j);
+            if (metaSent) {
+                camera3_notify_msg_t notify_msg;
+                memset(&notify_msg, 0, sizeof(camera3_notify_msg_t));
+                notify_msg.type = CAMERA3_MSG_ERROR;
+                notify_msg.message.error.error_code = CAMERA3_MSG_ERROR_BUFFER;
+                notify_msg.message.error.error_stream = info.stream;
+                notify_msg.message.error.frame_number = frame_number;
+                mCallbackOps->notify(mCallbackOps, &notify_msg);
+                CDBG("%s: notify frame_number = %d stream %p", __func__,
+                        frame_number, info.stream);
+            }
+            pStream_Buf[j].acquire_fence = -1;
+            pStream_Buf[j].release_fence = -1;
+            pStream_Buf[j].buffer = info.buffer;
+            pStream_Buf[j].status = CAMERA3_BUFFER_STATUS_ERROR;
+            pStream_Buf[j].stream = info.stream;
+        }
+
+        result.result = NULL;
+        result.frame_number = frame_number;
+        result.num_output_buffers = (uint32_t)pending->size();
+        result.output_buffers = pStream_Buf;
+        mCallbackOps->process_capture_result(mCallbackOps, &result);
+    }
+
+    delete [] pStream_Buf;
+
+    /* Reset pending buffers, requests and reprocess results */
+    mPendingRequests.clear();
+    mPendingBuffersMap.num_buffers = 0;
+    mPendingBuffersMap.mPendingBuffers.clear();
+    mPendingReprocessResults.clear();
+    CDBG("%s: Cleared all the pending buffers ", __func__);
+    invalidateSettingsCache();
+
+    return NO_ERROR;
+}
+
 /*===========================================================================
  * FUNCTION   : captureResultCb
  *
@@ -3015,10 +3587,14 @@ void QCamera3HardwareInterface::captureResultCb(mm_camera_super_buf_t *metadata_
                 camera3_stream_buffer_t *buffer, uint32_t frame_number)
 {
     pthread_mutex_lock(&mMutex);
-    if (metadata_buf)
+    nsecs_t lockTime = systemTime(CLOCK_MONOTONIC);
+    if (metadata_buf) {
         handleMetadataWithLock(metadata_buf);
-    else
+        updateLockHoldStats(mMetaLockStats, lockTime);
+    } else {
         handleBufferWithLock(buffer, frame_number);
+        updateLockHoldStats(mBufferLockStats, lockTime);
+    }
     pthread_mutex_unlock(&mMutex);
     return;
 }
@@ -3131,7 +3707,7 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                                  uint8_t pipeline_depth,
                                  uint8_t capture_intent)
 {
-    CameraMetadata camMetadata;
+    CameraMetadata camMetadata(acquireResultMetadata());
     camera_metadata_t *resultMetadata;
 
     if (jpegMetadata.entryCount())
@@ -3142,398 +3718,697 @@ QCamera3HardwareInterface::translateFromHalMetadata(
     camMetadata.update(ANDROID_REQUEST_PIPELINE_DEPTH, &pipeline_depth, 1);
     camMetadata.update(ANDROID_CONTROL_CAPTURE_INTENT, &capture_intent, 1);
 
-    IF_META_AVAILABLE(uint32_t, frame_number, CAM_INTF_META_FRAME_NUMBER, metadata) {
-        int64_t fwk_frame_number = *frame_number;
-        camMetadata.update(ANDROID_SYNC_FRAME_NUMBER, &fwk_frame_number, 1);
-    }
+    /*EIS is currently not hooked up to the app, so set the mode to OFF*/
+    uint8_t vsMode = ANDROID_CONTROL_VIDEO_STABILIZATION_MODE_OFF;
+    camMetadata.update(ANDROID_CONTROL_VIDEO_STABILIZATION_MODE, &vsMode, 1);
 
-    IF_META_AVAILABLE(cam_fps_range_t, float_range, CAM_INTF_PARM_FPS_RANGE, metadata) {
-        int32_t fps_range[2];
-        fps_range[0] = (int32_t)float_range->min_fps;
-        fps_range[1] = (int32_t)float_range->max_fps;
-        camMetadata.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE,
-                                      fps_range, 2);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_TARGET_FPS_RANGE [%d, %d]",
-            __func__, fps_range[0], fps_range[1]);
-    }
+    // Visit only the entries present in this frame instead of probing
+    // every id the framework result can carry
+    uint32_t valid_ids[CAM_INTF_PARM_MAX];
+    uint32_t num_valid = get_metadata_valid_ids(metadata, valid_ids, CAM_INTF_PARM_MAX);
+    for (uint32_t n = 0; n < num_valid; n++) {
+        switch (valid_ids[n]) {
+        case CAM_INTF_META_FRAME_NUMBER: {
+            uint32_t *frame_number = POINTER_OF_META(CAM_INTF_META_FRAME_NUMBER, metadata);
+            int64_t fwk_frame_number = *frame_number;
+            camMetadata.update(ANDROID_SYNC_FRAME_NUMBER, &fwk_frame_number, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(int32_t, expCompensation, CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata) {
-        camMetadata.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, expCompensation, 1);
-    }
+        case CAM_INTF_PARM_FPS_RANGE: {
+            cam_fps_range_t *float_range = POINTER_OF_META(CAM_INTF_PARM_FPS_RANGE, metadata);
+            int32_t fps_range[2];
+            fps_range[0] = (int32_t)float_range->min_fps;
+            fps_range[1] = (int32_t)float_range->max_fps;
+            camMetadata.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE,
+                                          fps_range, 2);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_TARGET_FPS_RANGE [%d, %d]",
+                __func__, fps_range[0], fps_range[1]);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, sceneMode, CAM_INTF_PARM_BESTSHOT_MODE, metadata) {
-        int val = lookupFwkName(SCENE_MODES_MAP, METADATA_MAP_SIZE(SCENE_MODES_MAP),
-                *sceneMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwkSceneMode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_SCENE_MODE, &fwkSceneMode, 1);
+        case CAM_INTF_PARM_EXPOSURE_COMPENSATION: {
+            int32_t *expCompensation =
+                    POINTER_OF_META(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata);
+            camMetadata.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, expCompensation, 1);
         }
-    }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, ae_lock, CAM_INTF_PARM_AEC_LOCK, metadata) {
-        uint8_t fwk_ae_lock = (uint8_t) *ae_lock;
-        camMetadata.update(ANDROID_CONTROL_AE_LOCK, &fwk_ae_lock, 1);
-    }
+        case CAM_INTF_PARM_AEC_LOCK: {
+            uint32_t *ae_lock = POINTER_OF_META(CAM_INTF_PARM_AEC_LOCK, metadata);
+            uint8_t fwk_ae_lock = (uint8_t) *ae_lock;
+            camMetadata.update(ANDROID_CONTROL_AE_LOCK, &fwk_ae_lock, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, awb_lock, CAM_INTF_PARM_AWB_LOCK, metadata) {
-        uint8_t fwk_awb_lock = (uint8_t) *awb_lock;
-        camMetadata.update(ANDROID_CONTROL_AWB_LOCK, &fwk_awb_lock, 1);
-    }
+        case CAM_INTF_PARM_AWB_LOCK: {
+            uint32_t *awb_lock = POINTER_OF_META(CAM_INTF_PARM_AWB_LOCK, metadata);
+            uint8_t fwk_awb_lock = (uint8_t) *awb_lock;
+            camMetadata.update(ANDROID_CONTROL_AWB_LOCK, &fwk_awb_lock, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_face_detection_data_t, faceDetectionInfo,
-            CAM_INTF_META_FACE_DETECTION, metadata) {
-        uint8_t numFaces = MIN(faceDetectionInfo->num_faces_detected, MAX_ROI);
-        int32_t faceIds[MAX_ROI];
-        uint8_t faceScores[MAX_ROI];
-        int32_t faceRectangles[MAX_ROI * 4];
-        int32_t faceLandmarks[MAX_ROI * 6];
-        size_t j = 0, k = 0;
-        for (size_t i = 0; i < numFaces; i++) {
-            faceIds[i] = faceDetectionInfo->faces[i].face_id;
-            faceScores[i] = (uint8_t)faceDetectionInfo->faces[i].score;
-            convertToRegions(faceDetectionInfo->faces[i].face_boundary,
-                faceRectangles+j, -1);
-            convertLandmarks(faceDetectionInfo->faces[i], faceLandmarks+k);
-            j+= 4;
-            k+= 6;
+        case CAM_INTF_META_FACE_DETECTION: {
+            cam_face_detection_data_t *faceDetectionInfo =
+                    POINTER_OF_META(CAM_INTF_META_FACE_DETECTION, metadata);
+            uint8_t numFaces = MIN(faceDetectionInfo->num_faces_detected, MAX_ROI);
+            int32_t faceIds[MAX_ROI];
+            uint8_t faceScores[MAX_ROI];
+            int32_t faceRectangles[MAX_ROI * 4];
+            int32_t faceLandmarks[MAX_ROI * 6];
+            size_t j = 0, k = 0;
+            for (size_t i = 0; i < numFaces; i++) {
+                faceIds[i] = faceDetectionInfo->faces[i].face_id;
+                faceScores[i] = (uint8_t)faceDetectionInfo->faces[i].score;
+                convertToRegions(faceDetectionInfo->faces[i].face_boundary,
+                    faceRectangles+j, -1);
+                convertLandmarks(faceDetectionInfo->faces[i], faceLandmarks+k);
+                j+= 4;
+                k+= 6;
+            }
+            if (numFaces <= 0) {
+                memset(faceIds, 0, sizeof(int32_t) * MAX_ROI);
+                memset(faceScores, 0, sizeof(uint8_t) * MAX_ROI);
+                memset(faceRectangles, 0, sizeof(int32_t) * MAX_ROI * 4);
+                memset(faceLandmarks, 0, sizeof(int32_t) * MAX_ROI * 6);
+            }
+            camMetadata.update(ANDROID_STATISTICS_FACE_IDS, faceIds, numFaces);
+            camMetadata.update(ANDROID_STATISTICS_FACE_SCORES, faceScores, numFaces);
+            camMetadata.update(ANDROID_STATISTICS_FACE_RECTANGLES, faceRectangles, numFaces * 4U);
+            camMetadata.update(ANDROID_STATISTICS_FACE_LANDMARKS, faceLandmarks, numFaces * 6U);
         }
-        if (numFaces <= 0) {
-            memset(faceIds, 0, sizeof(int32_t) * MAX_ROI);
-            memset(faceScores, 0, sizeof(uint8_t) * MAX_ROI);
-            memset(faceRectangles, 0, sizeof(int32_t) * MAX_ROI * 4);
-            memset(faceLandmarks, 0, sizeof(int32_t) * MAX_ROI * 6);
+        break;
+
+        case CAM_INTF_META_COLOR_CORRECT_MODE: {
+            uint32_t *color_correct_mode =
+                    POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_MODE, metadata);
+            uint8_t fwk_color_correct_mode = (uint8_t) *color_correct_mode;
+            camMetadata.update(ANDROID_COLOR_CORRECTION_MODE, &fwk_color_correct_mode, 1);
         }
-        camMetadata.update(ANDROID_STATISTICS_FACE_IDS, faceIds, numFaces);
-        camMetadata.update(ANDROID_STATISTICS_FACE_SCORES, faceScores, numFaces);
-        camMetadata.update(ANDROID_STATISTICS_FACE_RECTANGLES, faceRectangles, numFaces * 4U);
-        camMetadata.update(ANDROID_STATISTICS_FACE_LANDMARKS, faceLandmarks, numFaces * 6U);
-    }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, color_correct_mode, CAM_INTF_META_COLOR_CORRECT_MODE, metadata) {
-        uint8_t fwk_color_correct_mode = (uint8_t) *color_correct_mode;
-        camMetadata.update(ANDROID_COLOR_CORRECTION_MODE, &fwk_color_correct_mode, 1);
-    }
+        case CAM_INTF_META_EDGE_MODE: {
+            cam_edge_application_t *edgeApplication =
+                    POINTER_OF_META(CAM_INTF_META_EDGE_MODE, metadata);
+            uint8_t edgeStrength = (uint8_t) edgeApplication->sharpness;
+            camMetadata.update(ANDROID_EDGE_MODE, &(edgeApplication->edge_mode), 1);
+            camMetadata.update(ANDROID_EDGE_STRENGTH, &edgeStrength, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_edge_application_t, edgeApplication,
-            CAM_INTF_META_EDGE_MODE, metadata) {
-        uint8_t edgeStrength = (uint8_t) edgeApplication->sharpness;
-        camMetadata.update(ANDROID_EDGE_MODE, &(edgeApplication->edge_mode), 1);
-        camMetadata.update(ANDROID_EDGE_STRENGTH, &edgeStrength, 1);
-    }
+        case CAM_INTF_META_FLASH_POWER: {
+            uint32_t *flashPower = POINTER_OF_META(CAM_INTF_META_FLASH_POWER, metadata);
+            uint8_t fwk_flashPower = (uint8_t) *flashPower;
+            camMetadata.update(ANDROID_FLASH_FIRING_POWER, &fwk_flashPower, 1);
+        }
+        break;
+
+        case CAM_INTF_META_FLASH_FIRING_TIME: {
+            int64_t *flashFiringTime = POINTER_OF_META(CAM_INTF_META_FLASH_FIRING_TIME, metadata);
+            camMetadata.update(ANDROID_FLASH_FIRING_TIME, flashFiringTime, 1);
+        }
+        break;
+
+        case CAM_INTF_META_FLASH_STATE: {
+            int32_t *flashState = POINTER_OF_META(CAM_INTF_META_FLASH_STATE, metadata);
+            if (0 <= *flashState) {
+                uint8_t fwk_flashState = (uint8_t) *flashState;
+                if (!gCamCapability[mCameraId]->flash_available) {
+                    fwk_flashState = ANDROID_FLASH_STATE_UNAVAILABLE;
+                }
+                camMetadata.update(ANDROID_FLASH_STATE, &fwk_flashState, 1);
+            }
+        }
+        break;
+
+        case CAM_INTF_META_FLASH_MODE: {
+            uint32_t *flashMode = POINTER_OF_META(CAM_INTF_META_FLASH_MODE, metadata);
+            int val = lookupFwkName(FLASH_MODES_MAP, METADATA_MAP_SIZE(FLASH_MODES_MAP), *flashMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwk_flashMode = (uint8_t)val;
+                camMetadata.update(ANDROID_FLASH_MODE, &fwk_flashMode, 1);
+            }
+        }
+        break;
+
+        case CAM_INTF_META_HOTPIXEL_MODE: {
+            uint32_t *hotPixelMode = POINTER_OF_META(CAM_INTF_META_HOTPIXEL_MODE, metadata);
+            uint8_t fwk_hotPixelMode = (uint8_t) *hotPixelMode;
+            camMetadata.update(ANDROID_HOT_PIXEL_MODE, &fwk_hotPixelMode, 1);
+        }
+        break;
+
+        case CAM_INTF_META_LENS_APERTURE: {
+            float *lensAperture = POINTER_OF_META(CAM_INTF_META_LENS_APERTURE, metadata);
+            camMetadata.update(ANDROID_LENS_APERTURE , lensAperture, 1);
+        }
+        break;
+
+        case CAM_INTF_META_LENS_FILTERDENSITY: {
+            float *filterDensity = POINTER_OF_META(CAM_INTF_META_LENS_FILTERDENSITY, metadata);
+            camMetadata.update(ANDROID_LENS_FILTER_DENSITY , filterDensity, 1);
+        }
+        break;
+
+        case CAM_INTF_META_LENS_FOCAL_LENGTH: {
+            float *focalLength = POINTER_OF_META(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata);
+            camMetadata.update(ANDROID_LENS_FOCAL_LENGTH, focalLength, 1);
+        }
+        break;
+
+        case CAM_INTF_META_LENS_OPT_STAB_MODE: {
+            uint32_t *opticalStab = POINTER_OF_META(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata);
+            uint8_t fwk_opticalStab = (uint8_t) *opticalStab;
+            camMetadata.update(ANDROID_LENS_OPTICAL_STABILIZATION_MODE, &fwk_opticalStab, 1);
+        }
+        break;
+
+        case CAM_INTF_META_NOISE_REDUCTION_MODE: {
+            uint32_t *noiseRedMode = POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata);
+            uint8_t fwk_noiseRedMode = (uint8_t) *noiseRedMode;
+            camMetadata.update(ANDROID_NOISE_REDUCTION_MODE, &fwk_noiseRedMode, 1);
+        }
+        break;
+
+        case CAM_INTF_META_NOISE_REDUCTION_STRENGTH: {
+            uint32_t *noiseRedStrength =
+                    POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata);
+            uint8_t fwk_noiseRedStrength = (uint8_t) *noiseRedStrength;
+            camMetadata.update(ANDROID_NOISE_REDUCTION_STRENGTH, &fwk_noiseRedStrength, 1);
+        }
+        break;
+
+        case CAM_INTF_META_SCALER_CROP_REGION: {
+            cam_crop_region_t *hScalerCropRegion =
+                    POINTER_OF_META(CAM_INTF_META_SCALER_CROP_REGION, metadata);
+            int32_t scalerCropRegion[4];
+            scalerCropRegion[0] = hScalerCropRegion->left;
+            scalerCropRegion[1] = hScalerCropRegion->top;
+            scalerCropRegion[2] = hScalerCropRegion->width;
+            scalerCropRegion[3] = hScalerCropRegion->height;
+
+            // Adjust crop region from sensor output coordinate system to active
+            // array coordinate system.
+            mCropRegionMapper.toActiveArray(scalerCropRegion[0], scalerCropRegion[1],
+                    scalerCropRegion[2], scalerCropRegion[3]);
+
+            camMetadata.update(ANDROID_SCALER_CROP_REGION, scalerCropRegion, 4);
+        }
+        break;
+
+        case CAM_INTF_META_SENSOR_EXPOSURE_TIME: {
+            int64_t *sensorExpTime = POINTER_OF_META(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata);
+            CDBG("%s: sensorExpTime = %lld", __func__, *sensorExpTime);
+            camMetadata.update(ANDROID_SENSOR_EXPOSURE_TIME , sensorExpTime, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, flashPower, CAM_INTF_META_FLASH_POWER, metadata) {
-        uint8_t fwk_flashPower = (uint8_t) *flashPower;
-        camMetadata.update(ANDROID_FLASH_FIRING_POWER, &fwk_flashPower, 1);
-    }
+        case CAM_INTF_META_SENSOR_FRAME_DURATION: {
+            int64_t *sensorFameDuration =
+                    POINTER_OF_META(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata);
+            CDBG("%s: sensorFameDuration = %lld", __func__, *sensorFameDuration);
+            camMetadata.update(ANDROID_SENSOR_FRAME_DURATION, sensorFameDuration, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(int64_t, flashFiringTime, CAM_INTF_META_FLASH_FIRING_TIME, metadata) {
-        camMetadata.update(ANDROID_FLASH_FIRING_TIME, flashFiringTime, 1);
-    }
+        case CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW: {
+            int64_t *sensorRollingShutterSkew =
+                    POINTER_OF_META(CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW, metadata);
+            CDBG("%s: sensorRollingShutterSkew = %lld", __func__, *sensorRollingShutterSkew);
+            camMetadata.update(ANDROID_SENSOR_ROLLING_SHUTTER_SKEW,
+                    sensorRollingShutterSkew, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(int32_t, flashState, CAM_INTF_META_FLASH_STATE, metadata) {
-        if (0 <= *flashState) {
-            uint8_t fwk_flashState = (uint8_t) *flashState;
-            if (!gCamCapability[mCameraId]->flash_available) {
-                fwk_flashState = ANDROID_FLASH_STATE_UNAVAILABLE;
+        case CAM_INTF_META_SENSOR_SENSITIVITY: {
+            int32_t *sensorSensitivity =
+                    POINTER_OF_META(CAM_INTF_META_SENSOR_SENSITIVITY, metadata);
+            CDBG("%s: sensorSensitivity = %d", __func__, *sensorSensitivity);
+            camMetadata.update(ANDROID_SENSOR_SENSITIVITY, sensorSensitivity, 1);
+
+            //calculate the noise profile based on sensitivity
+            double noise_profile_S = computeNoiseModelEntryS(*sensorSensitivity);
+            double noise_profile_O = computeNoiseModelEntryO(*sensorSensitivity);
+            double noise_profile[2 * gCamCapability[mCameraId]->num_color_channels];
+            for (int i = 0; i < 2 * gCamCapability[mCameraId]->num_color_channels; i += 2) {
+                noise_profile[i]   = noise_profile_S;
+                noise_profile[i+1] = noise_profile_O;
             }
-            camMetadata.update(ANDROID_FLASH_STATE, &fwk_flashState, 1);
+            CDBG("%s: noise model entry (S, O) is (%f, %f)", __func__,
+                    noise_profile_S, noise_profile_O);
+            camMetadata.update(ANDROID_SENSOR_NOISE_PROFILE, noise_profile,
+                    (size_t) (2 * gCamCapability[mCameraId]->num_color_channels));
         }
-    }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, flashMode, CAM_INTF_META_FLASH_MODE, metadata) {
-        int val = lookupFwkName(FLASH_MODES_MAP, METADATA_MAP_SIZE(FLASH_MODES_MAP), *flashMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwk_flashMode = (uint8_t)val;
-            camMetadata.update(ANDROID_FLASH_MODE, &fwk_flashMode, 1);
+        case CAM_INTF_META_SHADING_MODE: {
+            uint32_t *shadingMode = POINTER_OF_META(CAM_INTF_META_SHADING_MODE, metadata);
+            uint8_t fwk_shadingMode = (uint8_t) *shadingMode;
+            camMetadata.update(ANDROID_SHADING_MODE, &fwk_shadingMode, 1);
         }
-    }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, hotPixelMode, CAM_INTF_META_HOTPIXEL_MODE, metadata) {
-        uint8_t fwk_hotPixelMode = (uint8_t) *hotPixelMode;
-        camMetadata.update(ANDROID_HOT_PIXEL_MODE, &fwk_hotPixelMode, 1);
-    }
+        case CAM_INTF_META_STATS_FACEDETECT_MODE: {
+            uint32_t *faceDetectMode =
+                    POINTER_OF_META(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata);
+            int val = lookupFwkName(FACEDETECT_MODES_MAP, METADATA_MAP_SIZE(FACEDETECT_MODES_MAP),
+                    *faceDetectMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwk_faceDetectMode = (uint8_t)val;
+                camMetadata.update(ANDROID_STATISTICS_FACE_DETECT_MODE, &fwk_faceDetectMode, 1);
+            }
+        }
+        break;
 
-    IF_META_AVAILABLE(float, lensAperture, CAM_INTF_META_LENS_APERTURE, metadata) {
-        camMetadata.update(ANDROID_LENS_APERTURE , lensAperture, 1);
-    }
+        case CAM_INTF_META_STATS_HISTOGRAM_MODE: {
+            uint32_t *histogramMode = POINTER_OF_META(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata);
+            uint8_t fwk_histogramMode = (uint8_t) *histogramMode;
+            camMetadata.update(ANDROID_STATISTICS_HISTOGRAM_MODE, &fwk_histogramMode, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(float, filterDensity, CAM_INTF_META_LENS_FILTERDENSITY, metadata) {
-        camMetadata.update(ANDROID_LENS_FILTER_DENSITY , filterDensity, 1);
-    }
+        case CAM_INTF_META_STATS_SHARPNESS_MAP_MODE: {
+            uint32_t *sharpnessMapMode =
+                    POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata);
+            uint8_t fwk_sharpnessMapMode = (uint8_t) *sharpnessMapMode;
+            camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP_MODE, &fwk_sharpnessMapMode, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(float, focalLength, CAM_INTF_META_LENS_FOCAL_LENGTH, metadata) {
-        camMetadata.update(ANDROID_LENS_FOCAL_LENGTH, focalLength, 1);
-    }
+        case CAM_INTF_META_STATS_SHARPNESS_MAP: {
+            cam_sharpness_map_t *sharpnessMap =
+                    POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata);
+            camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP, (int32_t *)sharpnessMap->sharpness,
+                    CAM_MAX_MAP_WIDTH * CAM_MAX_MAP_HEIGHT * 3);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, opticalStab, CAM_INTF_META_LENS_OPT_STAB_MODE, metadata) {
-        uint8_t fwk_opticalStab = (uint8_t) *opticalStab;
-        camMetadata.update(ANDROID_LENS_OPTICAL_STABILIZATION_MODE, &fwk_opticalStab, 1);
-    }
+        case CAM_INTF_META_LENS_SHADING_MAP: {
+            cam_lens_shading_map_t *lensShadingMap =
+                    POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP, metadata);
+            size_t map_height = MIN((size_t)gCamCapability[mCameraId]->lens_shading_map_size.height,
+                    CAM_MAX_SHADING_MAP_HEIGHT);
+            size_t map_width = MIN((size_t)gCamCapability[mCameraId]->lens_shading_map_size.width,
+                    CAM_MAX_SHADING_MAP_WIDTH);
+            camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP,
+                    lensShadingMap->lens_shading, 4U * map_width * map_height);
+        }
+        break;
 
-    /*EIS is currently not hooked up to the app, so set the mode to OFF*/
-    uint8_t vsMode = ANDROID_CONTROL_VIDEO_STABILIZATION_MODE_OFF;
-    camMetadata.update(ANDROID_CONTROL_VIDEO_STABILIZATION_MODE, &vsMode, 1);
+        case CAM_INTF_META_TONEMAP_MODE: {
+            uint32_t *toneMapMode = POINTER_OF_META(CAM_INTF_META_TONEMAP_MODE, metadata);
+            uint8_t fwk_toneMapMode = (uint8_t) *toneMapMode;
+            camMetadata.update(ANDROID_TONEMAP_MODE, &fwk_toneMapMode, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, noiseRedMode, CAM_INTF_META_NOISE_REDUCTION_MODE, metadata) {
-        uint8_t fwk_noiseRedMode = (uint8_t) *noiseRedMode;
-        camMetadata.update(ANDROID_NOISE_REDUCTION_MODE, &fwk_noiseRedMode, 1);
-    }
+        case CAM_INTF_META_TONEMAP_CURVES: {
+            cam_rgb_tonemap_curves *tonemap =
+                    POINTER_OF_META(CAM_INTF_META_TONEMAP_CURVES, metadata);
+            //Populate CAM_INTF_META_TONEMAP_CURVES
+            /* ch0 = G, ch 1 = B, ch 2 = R*/
+            if (tonemap->tonemap_points_cnt > CAM_MAX_TONEMAP_CURVE_SIZE) {
+                ALOGE("%s: Fatal: tonemap_points_cnt %d exceeds max value of %d",
+                        __func__, tonemap->tonemap_points_cnt,
+                        CAM_MAX_TONEMAP_CURVE_SIZE);
+                tonemap->tonemap_points_cnt = CAM_MAX_TONEMAP_CURVE_SIZE;
+            }
 
-    IF_META_AVAILABLE(uint32_t, noiseRedStrength, CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata) {
-        uint8_t fwk_noiseRedStrength = (uint8_t) *noiseRedStrength;
-        camMetadata.update(ANDROID_NOISE_REDUCTION_STRENGTH, &fwk_noiseRedStrength, 1);
-    }
+            camMetadata.update(ANDROID_TONEMAP_CURVE_GREEN,
+                            &tonemap->curves[0].tonemap_points[0][0],
+                            tonemap->tonemap_points_cnt * 2);
 
-    IF_META_AVAILABLE(cam_crop_region_t, hScalerCropRegion,
-            CAM_INTF_META_SCALER_CROP_REGION, metadata) {
-        int32_t scalerCropRegion[4];
-        scalerCropRegion[0] = hScalerCropRegion->left;
-        scalerCropRegion[1] = hScalerCropRegion->top;
-        scalerCropRegion[2] = hScalerCropRegion->width;
-        scalerCropRegion[3] = hScalerCropRegion->height;
+            camMetadata.update(ANDROID_TONEMAP_CURVE_BLUE,
+                            &tonemap->curves[1].tonemap_points[0][0],
+                            tonemap->tonemap_points_cnt * 2);
 
-        // Adjust crop region from sensor output coordinate system to active
-        // array coordinate system.
-        mCropRegionMapper.toActiveArray(scalerCropRegion[0], scalerCropRegion[1],
-                scalerCropRegion[2], scalerCropRegion[3]);
+            camMetadata.update(ANDROID_TONEMAP_CURVE_RED,
+                            &tonemap->curves[2].tonemap_points[0][0],
+                            tonemap->tonemap_points_cnt * 2);
+        }
+        break;
 
-        camMetadata.update(ANDROID_SCALER_CROP_REGION, scalerCropRegion, 4);
-    }
+        case CAM_INTF_META_COLOR_CORRECT_GAINS: {
+            cam_color_correct_gains_t *colorCorrectionGains =
+                    POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata);
+            camMetadata.update(ANDROID_COLOR_CORRECTION_GAINS, colorCorrectionGains->gains,
+                    CC_GAINS_COUNT);
+        }
+        break;
 
-    IF_META_AVAILABLE(int64_t, sensorExpTime, CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata) {
-        CDBG("%s: sensorExpTime = %lld", __func__, *sensorExpTime);
-        camMetadata.update(ANDROID_SENSOR_EXPOSURE_TIME , sensorExpTime, 1);
-    }
+        case CAM_INTF_META_COLOR_CORRECT_TRANSFORM: {
+            cam_color_correct_matrix_t *colorCorrectionMatrix =
+                    POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata);
+            camMetadata.update(ANDROID_COLOR_CORRECTION_TRANSFORM,
+                    (camera_metadata_rational_t *)(void *)colorCorrectionMatrix->transform_matrix,
+                    CC_MATRIX_COLS * CC_MATRIX_ROWS);
+        }
+        break;
 
-    IF_META_AVAILABLE(int64_t, sensorFameDuration,
-            CAM_INTF_META_SENSOR_FRAME_DURATION, metadata) {
-        CDBG("%s: sensorFameDuration = %lld", __func__, *sensorFameDuration);
-        camMetadata.update(ANDROID_SENSOR_FRAME_DURATION, sensorFameDuration, 1);
-    }
+        case CAM_INTF_META_PROFILE_TONE_CURVE: {
+            cam_profile_tone_curve *toneCurve =
+                    POINTER_OF_META(CAM_INTF_META_PROFILE_TONE_CURVE, metadata);
+            if (toneCurve->tonemap_points_cnt > CAM_MAX_TONEMAP_CURVE_SIZE) {
+                ALOGE("%s: Fatal: tonemap_points_cnt %d exceeds max value of %d",
+                        __func__, toneCurve->tonemap_points_cnt,
+                        CAM_MAX_TONEMAP_CURVE_SIZE);
+                toneCurve->tonemap_points_cnt = CAM_MAX_TONEMAP_CURVE_SIZE;
+            }
+            camMetadata.update(ANDROID_SENSOR_PROFILE_TONE_CURVE,
+                    (float*)toneCurve->curve.tonemap_points,
+                    toneCurve->tonemap_points_cnt * 2);
+        }
+        break;
 
-    IF_META_AVAILABLE(int64_t, sensorRollingShutterSkew,
-            CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW, metadata) {
-        CDBG("%s: sensorRollingShutterSkew = %lld", __func__, *sensorRollingShutterSkew);
-        camMetadata.update(ANDROID_SENSOR_ROLLING_SHUTTER_SKEW,
-                sensorRollingShutterSkew, 1);
-    }
+        case CAM_INTF_META_PRED_COLOR_CORRECT_GAINS: {
+            cam_color_correct_gains_t *predColorCorrectionGains =
+                    POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata);
+            camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_GAINS,
+                    predColorCorrectionGains->gains, 4);
+        }
+        break;
 
-    IF_META_AVAILABLE(int32_t, sensorSensitivity, CAM_INTF_META_SENSOR_SENSITIVITY, metadata) {
-        CDBG("%s: sensorSensitivity = %d", __func__, *sensorSensitivity);
-        camMetadata.update(ANDROID_SENSOR_SENSITIVITY, sensorSensitivity, 1);
+        case CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM: {
+            cam_color_correct_matrix_t *predColorCorrectionMatrix =
+                    POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata);
+            camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_TRANSFORM,
+                    (camera_metadata_rational_t *)(void *)predColorCorrectionMatrix->transform_matrix,
+                    CC_MATRIX_ROWS * CC_MATRIX_COLS);
+        }
+        break;
 
-        //calculate the noise profile based on sensitivity
-        double noise_profile_S = computeNoiseModelEntryS(*sensorSensitivity);
-        double noise_profile_O = computeNoiseModelEntryO(*sensorSensitivity);
-        double noise_profile[2 * gCamCapability[mCameraId]->num_color_channels];
-        for (int i = 0; i < 2 * gCamCapability[mCameraId]->num_color_channels; i += 2) {
-            noise_profile[i]   = noise_profile_S;
-            noise_profile[i+1] = noise_profile_O;
+        case CAM_INTF_META_OTP_WB_GRGB: {
+            float *otpWbGrGb = POINTER_OF_META(CAM_INTF_META_OTP_WB_GRGB, metadata);
+            camMetadata.update(ANDROID_SENSOR_GREEN_SPLIT, otpWbGrGb, 1);
         }
-        CDBG("%s: noise model entry (S, O) is (%f, %f)", __func__,
-                noise_profile_S, noise_profile_O);
-        camMetadata.update(ANDROID_SENSOR_NOISE_PROFILE, noise_profile,
-                (size_t) (2 * gCamCapability[mCameraId]->num_color_channels));
-    }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, shadingMode, CAM_INTF_META_SHADING_MODE, metadata) {
-        uint8_t fwk_shadingMode = (uint8_t) *shadingMode;
-        camMetadata.update(ANDROID_SHADING_MODE, &fwk_shadingMode, 1);
-    }
+        case CAM_INTF_META_BLACK_LEVEL_LOCK: {
+            uint32_t *blackLevelLock = POINTER_OF_META(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata);
+            uint8_t fwk_blackLevelLock = (uint8_t) *blackLevelLock;
+            camMetadata.update(ANDROID_BLACK_LEVEL_LOCK, &fwk_blackLevelLock, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, faceDetectMode, CAM_INTF_META_STATS_FACEDETECT_MODE, metadata) {
-        int val = lookupFwkName(FACEDETECT_MODES_MAP, METADATA_MAP_SIZE(FACEDETECT_MODES_MAP),
-                *faceDetectMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwk_faceDetectMode = (uint8_t)val;
-            camMetadata.update(ANDROID_STATISTICS_FACE_DETECT_MODE, &fwk_faceDetectMode, 1);
+        case CAM_INTF_META_SCENE_FLICKER: {
+            uint32_t *sceneFlicker = POINTER_OF_META(CAM_INTF_META_SCENE_FLICKER, metadata);
+            uint8_t fwk_sceneFlicker = (uint8_t) *sceneFlicker;
+            camMetadata.update(ANDROID_STATISTICS_SCENE_FLICKER, &fwk_sceneFlicker, 1);
         }
-    }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, histogramMode, CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata) {
-        uint8_t fwk_histogramMode = (uint8_t) *histogramMode;
-        camMetadata.update(ANDROID_STATISTICS_HISTOGRAM_MODE, &fwk_histogramMode, 1);
-    }
+        case CAM_INTF_PARM_EFFECT: {
+            uint32_t *effectMode = POINTER_OF_META(CAM_INTF_PARM_EFFECT, metadata);
+            int val = lookupFwkName(EFFECT_MODES_MAP, METADATA_MAP_SIZE(EFFECT_MODES_MAP),
+                    *effectMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwk_effectMode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_EFFECT_MODE, &fwk_effectMode, 1);
+            }
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, sharpnessMapMode,
-            CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata) {
-        uint8_t fwk_sharpnessMapMode = (uint8_t) *sharpnessMapMode;
-        camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP_MODE, &fwk_sharpnessMapMode, 1);
-    }
+        case CAM_INTF_META_TEST_PATTERN_DATA: {
+            cam_test_pattern_data_t *testPatternData =
+                    POINTER_OF_META(CAM_INTF_META_TEST_PATTERN_DATA, metadata);
+            int32_t fwk_testPatternMode = lookupFwkName(TEST_PATTERN_MAP,
+                    METADATA_MAP_SIZE(TEST_PATTERN_MAP), testPatternData->mode);
+            if (NAME_NOT_FOUND != fwk_testPatternMode) {
+                camMetadata.update(ANDROID_SENSOR_TEST_PATTERN_MODE, &fwk_testPatternMode, 1);
+            }
+            int32_t fwk_testPatternData[4];
+            fwk_testPatternData[0] = testPatternData->r;
+            fwk_testPatternData[3] = testPatternData->b;
+            switch (gCamCapability[mCameraId]->color_arrangement) {
+            case CAM_FILTER_ARRANGEMENT_RGGB:
+            case CAM_FILTER_ARRANGEMENT_GRBG:
+                fwk_testPatternData[1] = testPatternData->gr;
+                fwk_testPatternData[2] = testPatternData->gb;
+                break;
+            case CAM_FILTER_ARRANGEMENT_GBRG:
+            case CAM_FILTER_ARRANGEMENT_BGGR:
+                fwk_testPatternData[2] = testPatternData->gr;
+                fwk_testPatternData[1] = testPatternData->gb;
+                break;
+            default:
+                ALOGE("%s: color arrangement %d is not supported", __func__,
+                    gCamCapability[mCameraId]->color_arrangement);
+                break;
+            }
+            camMetadata.update(ANDROID_SENSOR_TEST_PATTERN_DATA, fwk_testPatternData, 4);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_sharpness_map_t, sharpnessMap,
-            CAM_INTF_META_STATS_SHARPNESS_MAP, metadata) {
-        camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP, (int32_t *)sharpnessMap->sharpness,
-                CAM_MAX_MAP_WIDTH * CAM_MAX_MAP_HEIGHT * 3);
-    }
+        case CAM_INTF_META_JPEG_GPS_COORDINATES: {
+            double *gps_coords = POINTER_OF_META(CAM_INTF_META_JPEG_GPS_COORDINATES, metadata);
+            camMetadata.update(ANDROID_JPEG_GPS_COORDINATES, gps_coords, 3);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_lens_shading_map_t, lensShadingMap,
-            CAM_INTF_META_LENS_SHADING_MAP, metadata) {
-        size_t map_height = MIN((size_t)gCamCapability[mCameraId]->lens_shading_map_size.height,
-                CAM_MAX_SHADING_MAP_HEIGHT);
-        size_t map_width = MIN((size_t)gCamCapability[mCameraId]->lens_shading_map_size.width,
-                CAM_MAX_SHADING_MAP_WIDTH);
-        camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP,
-                lensShadingMap->lens_shading, 4U * map_width * map_height);
-    }
+        case CAM_INTF_META_JPEG_GPS_PROC_METHODS: {
+            uint8_t *gps_methods = POINTER_OF_META(CAM_INTF_META_JPEG_GPS_PROC_METHODS, metadata);
+            String8 str((const char *)gps_methods);
+            camMetadata.update(ANDROID_JPEG_GPS_PROCESSING_METHOD, str);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, toneMapMode, CAM_INTF_META_TONEMAP_MODE, metadata) {
-        uint8_t fwk_toneMapMode = (uint8_t) *toneMapMode;
-        camMetadata.update(ANDROID_TONEMAP_MODE, &fwk_toneMapMode, 1);
-    }
+        case CAM_INTF_META_JPEG_GPS_TIMESTAMP: {
+            int64_t *gps_timestamp = POINTER_OF_META(CAM_INTF_META_JPEG_GPS_TIMESTAMP, metadata);
+            camMetadata.update(ANDROID_JPEG_GPS_TIMESTAMP, gps_timestamp, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_rgb_tonemap_curves, tonemap, CAM_INTF_META_TONEMAP_CURVES, metadata) {
-        //Populate CAM_INTF_META_TONEMAP_CURVES
-        /* ch0 = G, ch 1 = B, ch 2 = R*/
-        if (tonemap->tonemap_points_cnt > CAM_MAX_TONEMAP_CURVE_SIZE) {
-            ALOGE("%s: Fatal: tonemap_points_cnt %d exceeds max value of %d",
-                    __func__, tonemap->tonemap_points_cnt,
-                    CAM_MAX_TONEMAP_CURVE_SIZE);
-            tonemap->tonemap_points_cnt = CAM_MAX_TONEMAP_CURVE_SIZE;
+        case CAM_INTF_META_JPEG_ORIENTATION: {
+            int32_t *jpeg_orientation = POINTER_OF_META(CAM_INTF_META_JPEG_ORIENTATION, metadata);
+            camMetadata.update(ANDROID_JPEG_ORIENTATION, jpeg_orientation, 1);
         }
+        break;
 
-        camMetadata.update(ANDROID_TONEMAP_CURVE_GREEN,
-                        &tonemap->curves[0].tonemap_points[0][0],
-                        tonemap->tonemap_points_cnt * 2);
+        case CAM_INTF_META_JPEG_QUALITY: {
+            uint32_t *jpeg_quality = POINTER_OF_META(CAM_INTF_META_JPEG_QUALITY, metadata);
+            uint8_t fwk_jpeg_quality = (uint8_t) *jpeg_quality;
+            camMetadata.update(ANDROID_JPEG_QUALITY, &fwk_jpeg_quality, 1);
+        }
+        break;
 
-        camMetadata.update(ANDROID_TONEMAP_CURVE_BLUE,
-                        &tonemap->curves[1].tonemap_points[0][0],
-                        tonemap->tonemap_points_cnt * 2);
+        case CAM_INTF_META_JPEG_THUMB_QUALITY: {
+            uint32_t *thumb_quality = POINTER_OF_META(CAM_INTF_META_JPEG_THUMB_QUALITY, metadata);
+            uint8_t fwk_thumb_quality = (uint8_t) *thumb_quality;
+            camMetadata.update(ANDROID_JPEG_THUMBNAIL_QUALITY, &fwk_thumb_quality, 1);
+        }
+        break;
 
-        camMetadata.update(ANDROID_TONEMAP_CURVE_RED,
-                        &tonemap->curves[2].tonemap_points[0][0],
-                        tonemap->tonemap_points_cnt * 2);
-    }
+        case CAM_INTF_META_JPEG_THUMB_SIZE: {
+            cam_dimension_t *thumb_size = POINTER_OF_META(CAM_INTF_META_JPEG_THUMB_SIZE, metadata);
+            int32_t fwk_thumb_size[2];
+            fwk_thumb_size[0] = thumb_size->width;
+            fwk_thumb_size[1] = thumb_size->height;
+            camMetadata.update(ANDROID_JPEG_THUMBNAIL_SIZE, fwk_thumb_size, 2);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_color_correct_gains_t, colorCorrectionGains,
-            CAM_INTF_META_COLOR_CORRECT_GAINS, metadata) {
-        camMetadata.update(ANDROID_COLOR_CORRECTION_GAINS, colorCorrectionGains->gains,
-                CC_GAINS_COUNT);
-    }
+        case CAM_INTF_META_PRIVATE_DATA: {
+            int32_t *privateData = POINTER_OF_META(CAM_INTF_META_PRIVATE_DATA, metadata);
+            camMetadata.update(QCAMERA3_PRIVATEDATA_REPROCESS,
+                    privateData,
+                    MAX_METADATA_PRIVATE_PAYLOAD_SIZE_IN_BYTES / sizeof(int32_t));
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_color_correct_matrix_t, colorCorrectionMatrix,
-            CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata) {
-        camMetadata.update(ANDROID_COLOR_CORRECTION_TRANSFORM,
-                (camera_metadata_rational_t *)(void *)colorCorrectionMatrix->transform_matrix,
-                CC_MATRIX_COLS * CC_MATRIX_ROWS);
-    }
+        case CAM_INTF_META_NEUTRAL_COL_POINT: {
+            cam_neutral_col_point_t *neuColPoint =
+                    POINTER_OF_META(CAM_INTF_META_NEUTRAL_COL_POINT, metadata);
+            camMetadata.update(ANDROID_SENSOR_NEUTRAL_COLOR_POINT,
+                    (camera_metadata_rational_t *)(void *)neuColPoint->neutral_col_point,
+                    NEUTRAL_COL_POINTS);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_profile_tone_curve, toneCurve,
-            CAM_INTF_META_PROFILE_TONE_CURVE, metadata) {
-        if (toneCurve->tonemap_points_cnt > CAM_MAX_TONEMAP_CURVE_SIZE) {
-            ALOGE("%s: Fatal: tonemap_points_cnt %d exceeds max value of %d",
-                    __func__, toneCurve->tonemap_points_cnt,
-                    CAM_MAX_TONEMAP_CURVE_SIZE);
-            toneCurve->tonemap_points_cnt = CAM_MAX_TONEMAP_CURVE_SIZE;
+        case CAM_INTF_META_LENS_SHADING_MAP_MODE: {
+            uint32_t *shadingMapMode =
+                    POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata);
+            uint8_t fwk_shadingMapMode = (uint8_t) *shadingMapMode;
+            camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP_MODE, &fwk_shadingMapMode, 1);
         }
-        camMetadata.update(ANDROID_SENSOR_PROFILE_TONE_CURVE,
-                (float*)toneCurve->curve.tonemap_points,
-                toneCurve->tonemap_points_cnt * 2);
-    }
+        break;
 
-    IF_META_AVAILABLE(cam_color_correct_gains_t, predColorCorrectionGains,
-            CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata) {
-        camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_GAINS,
-                predColorCorrectionGains->gains, 4);
-    }
+        case CAM_INTF_META_AEC_ROI: {
+            cam_area_t *hAeRegions = POINTER_OF_META(CAM_INTF_META_AEC_ROI, metadata);
+            int32_t aeRegions[MAX_ROI];
+            convertToRegions(hAeRegions->rect, aeRegions, hAeRegions->weight);
+            camMetadata.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, MAX_ROI);
+            CDBG("%s: Metadata : ANDROID_CONTROL_AE_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
+                    __func__, aeRegions[0], aeRegions[1], aeRegions[2], aeRegions[3],
+                    hAeRegions->rect.left, hAeRegions->rect.top, hAeRegions->rect.width,
+                    hAeRegions->rect.height);
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_color_correct_matrix_t, predColorCorrectionMatrix,
-            CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata) {
-        camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_TRANSFORM,
-                (camera_metadata_rational_t *)(void *)predColorCorrectionMatrix->transform_matrix,
-                CC_MATRIX_ROWS * CC_MATRIX_COLS);
-    }
+        case CAM_INTF_META_AF_ROI: {
+            cam_area_t *hAfRegions = POINTER_OF_META(CAM_INTF_META_AF_ROI, metadata);
+            /*af regions*/
+            int32_t afRegions[MAX_ROI];
+            convertToRegions(hAfRegions->rect, afRegions, hAfRegions->weight);
+            camMetadata.update(ANDROID_CONTROL_AF_REGIONS, afRegions, MAX_ROI);
+            CDBG("%s: Metadata : ANDROID_CONTROL_AF_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
+                    __func__, afRegions[0], afRegions[1], afRegions[2], afRegions[3],
+                    hAfRegions->rect.left, hAfRegions->rect.top, hAfRegions->rect.width,
+                    hAfRegions->rect.height);
+        }
+        break;
 
-    IF_META_AVAILABLE(float, otpWbGrGb, CAM_INTF_META_OTP_WB_GRGB, metadata) {
-        camMetadata.update(ANDROID_SENSOR_GREEN_SPLIT, otpWbGrGb, 1);
-    }
+        case CAM_INTF_PARM_ANTIBANDING: {
+            uint32_t *hal_ab_mode = POINTER_OF_META(CAM_INTF_PARM_ANTIBANDING, metadata);
+            int val = lookupFwkName(ANTIBANDING_MODES_MAP, METADATA_MAP_SIZE(ANTIBANDING_MODES_MAP),
+                    *hal_ab_mode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwk_ab_mode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_AE_ANTIBANDING_MODE, &fwk_ab_mode, 1);
+            }
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, blackLevelLock, CAM_INTF_META_BLACK_LEVEL_LOCK, metadata) {
-        uint8_t fwk_blackLevelLock = (uint8_t) *blackLevelLock;
-        camMetadata.update(ANDROID_BLACK_LEVEL_LOCK, &fwk_blackLevelLock, 1);
-    }
+        case CAM_INTF_PARM_BESTSHOT_MODE: {
+            uint32_t *bestshotMode = POINTER_OF_META(CAM_INTF_PARM_BESTSHOT_MODE, metadata);
+            int val = lookupFwkName(SCENE_MODES_MAP,
+                    METADATA_MAP_SIZE(SCENE_MODES_MAP), *bestshotMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwkBestshotMode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_SCENE_MODE, &fwkBestshotMode, 1);
+                CDBG("%s: Metadata : ANDROID_CONTROL_SCENE_MODE", __func__);
+            } else {
+                CDBG_HIGH("%s: Metadata not found : ANDROID_CONTROL_SCENE_MODE", __func__);
+            }
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, sceneFlicker, CAM_INTF_META_SCENE_FLICKER, metadata) {
-        uint8_t fwk_sceneFlicker = (uint8_t) *sceneFlicker;
-        camMetadata.update(ANDROID_STATISTICS_SCENE_FLICKER, &fwk_sceneFlicker, 1);
-    }
+        case CAM_INTF_META_MODE: {
+            uint32_t *mode = POINTER_OF_META(CAM_INTF_META_MODE, metadata);
+             uint8_t fwk_mode = (uint8_t) *mode;
+             camMetadata.update(ANDROID_CONTROL_MODE, &fwk_mode, 1);
+        }
+        break;
 
-    IF_META_AVAILABLE(uint32_t, effectMode, CAM_INTF_PARM_EFFECT, metadata) {
-        int val = lookupFwkName(EFFECT_MODES_MAP, METADATA_MAP_SIZE(EFFECT_MODES_MAP),
-                *effectMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwk_effectMode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_EFFECT_MODE, &fwk_effectMode, 1);
-        }
-    }
-
-    IF_META_AVAILABLE(cam_test_pattern_data_t, testPatternData,
-            CAM_INTF_META_TEST_PATTERN_DATA, metadata) {
-        int32_t fwk_testPatternMode = lookupFwkName(TEST_PATTERN_MAP,
-                METADATA_MAP_SIZE(TEST_PATTERN_MAP), testPatternData->mode);
-        if (NAME_NOT_FOUND != fwk_testPatternMode) {
-            camMetadata.update(ANDROID_SENSOR_TEST_PATTERN_MODE, &fwk_testPatternMode, 1);
-        }
-        int32_t fwk_testPatternData[4];
-        fwk_testPatternData[0] = testPatternData->r;
-        fwk_testPatternData[3] = testPatternData->b;
-        switch (gCamCapability[mCameraId]->color_arrangement) {
-        case CAM_FILTER_ARRANGEMENT_RGGB:
-        case CAM_FILTER_ARRANGEMENT_GRBG:
-            fwk_testPatternData[1] = testPatternData->gr;
-            fwk_testPatternData[2] = testPatternData->gb;
-            break;
-        case CAM_FILTER_ARRANGEMENT_GBRG:
-        case CAM_FILTER_ARRANGEMENT_BGGR:
-            fwk_testPatternData[2] = testPatternData->gr;
-            fwk_testPatternData[1] = testPatternData->gb;
-            break;
-        default:
-            ALOGE("%s: color arrangement %d is not supported", __func__,
-                gCamCapability[mCameraId]->color_arrangement);
-            break;
+        // CDS
+        case CAM_INTF_PARM_CDS_MODE: {
+            int32_t *cds = POINTER_OF_META(CAM_INTF_PARM_CDS_MODE, metadata);
+            camMetadata.update(QCAMERA3_CDS_MODE, cds, 1);
         }
-        camMetadata.update(ANDROID_SENSOR_TEST_PATTERN_DATA, fwk_testPatternData, 4);
-    }
+        break;
 
-    IF_META_AVAILABLE(double, gps_coords, CAM_INTF_META_JPEG_GPS_COORDINATES, metadata) {
-        camMetadata.update(ANDROID_JPEG_GPS_COORDINATES, gps_coords, 3);
-    }
+        // Reprocess crop data
+        case CAM_INTF_META_CROP_DATA: {
+            cam_crop_data_t *crop_data = POINTER_OF_META(CAM_INTF_META_CROP_DATA, metadata);
+            uint8_t cnt = crop_data->num_of_streams;
+            if ((0 < cnt) && (cnt < MAX_NUM_STREAMS)) {
+                int rc = NO_ERROR;
+                int32_t *crop = new int32_t[cnt*4];
+                if (NULL == crop) {
+                    rc = NO_MEMORY;
+                }
 
-    IF_META_AVAILABLE(uint8_t, gps_methods, CAM_INTF_META_JPEG_GPS_PROC_METHODS, metadata) {
-        String8 str((const char *)gps_methods);
-        camMetadata.update(ANDROID_JPEG_GPS_PROCESSING_METHOD, str);
-    }
+                int32_t *crop_stream_ids = new int32_t[cnt];
+                if (NULL == crop_stream_ids) {
+                    rc = NO_MEMORY;
+                }
 
-    IF_META_AVAILABLE(int64_t, gps_timestamp, CAM_INTF_META_JPEG_GPS_TIMESTAMP, metadata) {
-        camMetadata.update(ANDROID_JPEG_GPS_TIMESTAMP, gps_timestamp, 1);
-    }
+                Vector<int32_t> roi_map;
 
-    IF_META_AVAILABLE(int32_t, jpeg_orientation, CAM_INTF_META_JPEG_ORIENTATION, metadata) {
-        camMetadata.update(ANDROID_JPEG_ORIENTATION, jpeg_orientation, 1);
-    }
+                if (NO_ERROR == rc) {
+                    int32_t steams_found = 0;
+                    for (size_t i = 0; i < cnt; i++) {
+                        for (List<stream_info_t *>::iterator it = mStreamInfo.begin();
+                            it != mStreamInfo.end(); it++) {
+                            QCamera3Channel *channel = (QCamera3Channel *)(*it)->stream->priv;
+                            if (NULL != channel) {
+                                if (crop_data->crop_info[i].stream_id ==
+                                        channel->mStreams[0]->getMyServerID()) {
+                                    crop[steams_found*4] = crop_data->crop_info[i].crop.left;
+                                    crop[steams_found*4 + 1] = crop_data->crop_info[i].crop.top;
+                                    crop[steams_found*4 + 2] = crop_data->crop_info[i].crop.width;
+                                    crop[steams_found*4 + 3] = crop_data->crop_info[i].crop.height;
+                                    // In a more general case we may want to generate
+                                    // unique id depending on width, height, stream, private
+                                    // data etc.
+#ifdef __LP64__
+                                    // Using XORed value of lower and upper halves as ID
+                                    crop_stream_ids[steams_found] = (int32_t)
+                                            ((((int64_t)(*it)->stream) & 0x0000FFFF) ^
+                                                    (((int64_t)(*it)->stream) >> 0x20 & 0x0000FFFF));
+#else
+                                    // FIXME: Although using data address as ID doesn't guarantee
+                                    // that all IDs will be unique, we are keeping existing nostrum
+                                    // for now till found better solution.
+                                    crop_stream_ids[steams_found] = (int32_t)(*it)->stream;
+#endif
+                                    steams_found++;
+                                    roi_map.add(crop_data->crop_info[i].roi_map.left);
+                                    roi_map.add(crop_data->crop_info[i].roi_map.top);
+                                    roi_map.add(crop_data->crop_info[i].roi_map.width);
+                                    roi_map.add(crop_data->crop_info[i].roi_map.height);
+                                    CDBG("%s: Adding reprocess crop data for stream %p %dx%d, %dx%d",
+                                            __func__,
+                                            (*it)->stream,
+                                            crop_data->crop_info[i].crop.left,
+                                            crop_data->crop_info[i].crop.top,
+                                            crop_data->crop_info[i].crop.width,
+                                            crop_data->crop_info[i].crop.height);
+                                    CDBG("%s: Adding reprocess crop roi map for stream %p %dx%d, %dx%d",
+                                            __func__,
+                                            (*it)->stream,
+                                            crop_data->crop_info[i].roi_map.left,
+                                            crop_data->crop_info[i].roi_map.top,
+                                            crop_data->crop_info[i].roi_map.width,
+                                            crop_data->crop_info[i].roi_map.height);
+                                    break;
+                                }
+                            }
+                        }
+                    }
 
-    IF_META_AVAILABLE(uint32_t, jpeg_quality, CAM_INTF_META_JPEG_QUALITY, metadata) {
-        uint8_t fwk_jpeg_quality = (uint8_t) *jpeg_quality;
-        camMetadata.update(ANDROID_JPEG_QUALITY, &fwk_jpeg_quality, 1);
-    }
+                    camMetadata.update(QCAMERA3_CROP_COUNT_REPROCESS,
+                            &steams_found, 1);
+                    camMetadata.update(QCAMERA3_CROP_REPROCESS,
+                            crop, (size_t)(steams_found * 4));
+                    camMetadata.update(QCAMERA3_CROP_STREAM_ID_REPROCESS,
+                            crop_stream_ids, (size_t)steams_found);
+                    if (roi_map.array()) {
+                        camMetadata.update(QCAMERA3_CROP_ROI_MAP_REPROCESS,
+                                roi_map.array(), roi_map.size());
+                    }
+                }
 
-    IF_META_AVAILABLE(uint32_t, thumb_quality, CAM_INTF_META_JPEG_THUMB_QUALITY, metadata) {
-        uint8_t fwk_thumb_quality = (uint8_t) *thumb_quality;
-        camMetadata.update(ANDROID_JPEG_THUMBNAIL_QUALITY, &fwk_thumb_quality, 1);
-    }
+                if (crop) {
+                    delete [] crop;
+                }
+                if (crop_stream_ids) {
+                    delete [] crop_stream_ids;
+                }
+            } else {
+                // mm-qcamera-daemon only posts crop_data for streams
+                // not linked to pproc. So no valid crop metadata is not
+                // necessarily an error case.
+                CDBG("%s: No valid crop metadata entries", __func__);
+            }
+        }
+        break;
 
-    IF_META_AVAILABLE(cam_dimension_t, thumb_size, CAM_INTF_META_JPEG_THUMB_SIZE, metadata) {
-        int32_t fwk_thumb_size[2];
-        fwk_thumb_size[0] = thumb_size->width;
-        fwk_thumb_size[1] = thumb_size->height;
-        camMetadata.update(ANDROID_JPEG_THUMBNAIL_SIZE, fwk_thumb_size, 2);
-    }
+        case CAM_INTF_PARM_CAC: {
+            cam_aberration_mode_t *cacMode = POINTER_OF_META(CAM_INTF_PARM_CAC, metadata);
+            int val = lookupFwkName(COLOR_ABERRATION_MAP, METADATA_MAP_SIZE(COLOR_ABERRATION_MAP),
+                    *cacMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwkCacMode = (uint8_t)val;
+                camMetadata.update(ANDROID_COLOR_CORRECTION_ABERRATION_MODE, &fwkCacMode, 1);
+            } else {
+                ALOGE("%s: Invalid CAC camera parameter: %d", __func__, *cacMode);
+            }
+        }
+        break;
 
-    IF_META_AVAILABLE(int32_t, privateData, CAM_INTF_META_PRIVATE_DATA, metadata) {
-        camMetadata.update(QCAMERA3_PRIVATEDATA_REPROCESS,
-                privateData,
-                MAX_METADATA_PRIVATE_PAYLOAD_SIZE_IN_BYTES / sizeof(int32_t));
+        default:
+            break;
+        }
     }
 
     if (metadata->is_tuning_params_valid) {
@@ -3601,65 +4476,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
                 (size_t)(data-tuning_meta_data_blob) / sizeof(uint32_t));
     }
 
-    IF_META_AVAILABLE(cam_neutral_col_point_t, neuColPoint,
-            CAM_INTF_META_NEUTRAL_COL_POINT, metadata) {
-        camMetadata.update(ANDROID_SENSOR_NEUTRAL_COLOR_POINT,
-                (camera_metadata_rational_t *)(void *)neuColPoint->neutral_col_point,
-                NEUTRAL_COL_POINTS);
-    }
-
-    IF_META_AVAILABLE(uint32_t, shadingMapMode, CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata) {
-        uint8_t fwk_shadingMapMode = (uint8_t) *shadingMapMode;
-        camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP_MODE, &fwk_shadingMapMode, 1);
-    }
-
-    IF_META_AVAILABLE(cam_area_t, hAeRegions, CAM_INTF_META_AEC_ROI, metadata) {
-        int32_t aeRegions[MAX_ROI];
-        convertToRegions(hAeRegions->rect, aeRegions, hAeRegions->weight);
-        camMetadata.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, MAX_ROI);
-        CDBG("%s: Metadata : ANDROID_CONTROL_AE_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
-                __func__, aeRegions[0], aeRegions[1], aeRegions[2], aeRegions[3],
-                hAeRegions->rect.left, hAeRegions->rect.top, hAeRegions->rect.width,
-                hAeRegions->rect.height);
-    }
-
-    IF_META_AVAILABLE(cam_area_t, hAfRegions, CAM_INTF_META_AF_ROI, metadata) {
-        /*af regions*/
-        int32_t afRegions[MAX_ROI];
-        convertToRegions(hAfRegions->rect, afRegions, hAfRegions->weight);
-        camMetadata.update(ANDROID_CONTROL_AF_REGIONS, afRegions, MAX_ROI);
-        CDBG("%s: Metadata : ANDROID_CONTROL_AF_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
-                __func__, afRegions[0], afRegions[1], afRegions[2], afRegions[3],
-                hAfRegions->rect.left, hAfRegions->rect.top, hAfRegions->rect.width,
-                hAfRegions->rect.height);
-    }
-
-    IF_META_AVAILABLE(uint32_t, hal_ab_mode, CAM_INTF_PARM_ANTIBANDING, metadata) {
-        int val = lookupFwkName(ANTIBANDING_MODES_MAP, METADATA_MAP_SIZE(ANTIBANDING_MODES_MAP),
-                *hal_ab_mode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwk_ab_mode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_AE_ANTIBANDING_MODE, &fwk_ab_mode, 1);
-        }
-    }
-
-    IF_META_AVAILABLE(uint32_t, bestshotMode, CAM_INTF_PARM_BESTSHOT_MODE, metadata) {
-        int val = lookupFwkName(SCENE_MODES_MAP,
-                METADATA_MAP_SIZE(SCENE_MODES_MAP), *bestshotMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwkBestshotMode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_SCENE_MODE, &fwkBestshotMode, 1);
-            CDBG("%s: Metadata : ANDROID_CONTROL_SCENE_MODE", __func__);
-        } else {
-            CDBG_HIGH("%s: Metadata not found : ANDROID_CONTROL_SCENE_MODE", __func__);
-        }
-    }
-
-    IF_META_AVAILABLE(uint32_t, mode, CAM_INTF_META_MODE, metadata) {
-         uint8_t fwk_mode = (uint8_t) *mode;
-         camMetadata.update(ANDROID_CONTROL_MODE, &fwk_mode, 1);
-    }
-
     /* Constant metadata values to be update*/
     uint8_t hotPixelModeFast = ANDROID_HOT_PIXEL_MODE_FAST;
     camMetadata.update(ANDROID_HOT_PIXEL_MODE, &hotPixelModeFast, 1);
@@ -3670,117 +4486,6 @@ QCamera3HardwareInterface::translateFromHalMetadata(
     int32_t hotPixelMap[2];
     camMetadata.update(ANDROID_STATISTICS_HOT_PIXEL_MAP, &hotPixelMap[0], 0);
 
-    // CDS
-    IF_META_AVAILABLE(int32_t, cds, CAM_INTF_PARM_CDS_MODE, metadata) {
-        camMetadata.update(QCAMERA3_CDS_MODE, cds, 1);
-    }
-
-    // Reprocess crop data
-    IF_META_AVAILABLE(cam_crop_data_t, crop_data, CAM_INTF_META_CROP_DATA, metadata) {
-        uint8_t cnt = crop_data->num_of_streams;
-        if ((0 < cnt) && (cnt < MAX_NUM_STREAMS)) {
-            int rc = NO_ERROR;
-            int32_t *crop = new int32_t[cnt*4];
-            if (NULL == crop) {
-                rc = NO_MEMORY;
-            }
-
-            int32_t *crop_stream_ids = new int32_t[cnt];
-            if (NULL == crop_stream_ids) {
-                rc = NO_MEMORY;
-            }
-
-            Vector<int32_t> roi_map;
-
-            if (NO_ERROR == rc) {
-                int32_t steams_found = 0;
-                for (size_t i = 0; i < cnt; i++) {
-                    for (List<stream_info_t *>::iterator it = mStreamInfo.begin();
-                        it != mStreamInfo.end(); it++) {
-                        QCamera3Channel *channel = (QCamera3Channel *)(*it)->stream->priv;
-                        if (NULL != channel) {
-                            if (crop_data->crop_info[i].stream_id ==
-                                    channel->mStreams[0]->getMyServerID()) {
-                                crop[steams_found*4] = crop_data->crop_info[i].crop.left;
-                                crop[steams_found*4 + 1] = crop_data->crop_info[i].crop.top;
-                                crop[steams_found*4 + 2] = crop_data->crop_info[i].crop.width;
-                                crop[steams_found*4 + 3] = crop_data->crop_info[i].crop.height;
-                                // In a more general case we may want to generate
-                                // unique id depending on width, height, stream, private
-                                // data etc.
-#ifdef __LP64__
-                                // Using XORed value of lower and upper halves as ID
-                                crop_stream_ids[steams_found] = (int32_t)
-                                        ((((int64_t)(*it)->stream) & 0x0000FFFF) ^
-                                                (((int64_t)(*it)->stream) >> 0x20 & 0x0000FFFF));
-#else
-                                // FIXME: Although using data address as ID doesn't guarantee
-                                // that all IDs will be unique, we are keeping existing nostrum
-                                // for now till found better solution.
-                                crop_stream_ids[steams_found] = (int32_t)(*it)->stream;
-#endif
-                                steams_found++;
-                                roi_map.add(crop_data->crop_info[i].roi_map.left);
-                                roi_map.add(crop_data->crop_info[i].roi_map.top);
-                                roi_map.add(crop_data->crop_info[i].roi_map.width);
-                                roi_map.add(crop_data->crop_info[i].roi_map.height);
-                                CDBG("%s: Adding reprocess crop data for stream %p %dx%d, %dx%d",
-                                        __func__,
-                                        (*it)->stream,
-                                        crop_data->crop_info[i].crop.left,
-                                        crop_data->crop_info[i].crop.top,
-                                        crop_data->crop_info[i].crop.width,
-                                        crop_data->crop_info[i].crop.height);
-                                CDBG("%s: Adding reprocess crop roi map for stream %p %dx%d, %dx%d",
-                                        __func__,
-                                        (*it)->stream,
-                                        crop_data->crop_info[i].roi_map.left,
-                                        crop_data->crop_info[i].roi_map.top,
-                                        crop_data->crop_info[i].roi_map.width,
-                                        crop_data->crop_info[i].roi_map.height);
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                camMetadata.update(QCAMERA3_CROP_COUNT_REPROCESS,
-                        &steams_found, 1);
-                camMetadata.update(QCAMERA3_CROP_REPROCESS,
-                        crop, (size_t)(steams_found * 4));
-                camMetadata.update(QCAMERA3_CROP_STREAM_ID_REPROCESS,
-                        crop_stream_ids, (size_t)steams_found);
-                if (roi_map.array()) {
-                    camMetadata.update(QCAMERA3_CROP_ROI_MAP_REPROCESS,
-                            roi_map.array(), roi_map.size());
-                }
-            }
-
-            if (crop) {
-                delete [] crop;
-            }
-            if (crop_stream_ids) {
-                delete [] crop_stream_ids;
-            }
-        } else {
-            // mm-qcamera-daemon only posts crop_data for streams
-            // not linked to pproc. So no valid crop metadata is not
-            // necessarily an error case.
-            CDBG("%s: No valid crop metadata entries", __func__);
-        }
-    }
-
-    IF_META_AVAILABLE(cam_aberration_mode_t, cacMode, CAM_INTF_PARM_CAC, metadata) {
-        int val = lookupFwkName(COLOR_ABERRATION_MAP, METADATA_MAP_SIZE(COLOR_ABERRATION_MAP),
-                *cacMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwkCacMode = (uint8_t)val;
-            camMetadata.update(ANDROID_COLOR_CORRECTION_ABERRATION_MODE, &fwkCacMode, 1);
-        } else {
-            ALOGE("%s: Invalid CAC camera parameter: %d", __func__, *cacMode);
-        }
-    }
-
     resultMetadata = camMetadata.release();
     return resultMetadata;
 }
@@ -3800,7 +4505,7 @@ camera_metadata_t*
 QCamera3HardwareInterface::translateCbUrgentMetadataToResultMetadata
                                 (metadata_buffer_t *metadata)
 {
-    CameraMetadata camMetadata;
+    CameraMetadata camMetadata(acquireResultMetadata());
     camera_metadata_t *resultMetadata;
 
     IF_META_AVAILABLE(uint32_t, afState, CAM_INTF_META_AF_STATE, metadata) {
@@ -4389,6 +5094,12 @@ int QCamera3HardwareInterface::initParameters()
     mParameters = (metadata_buffer_t *) DATA_PTR(mParamHeap,0);
 
     mPrevParameters = (metadata_buffer_t *)malloc(sizeof(metadata_buffer_t));
+
+    mSentParameters = (metadata_buffer_t *)malloc(sizeof(metadata_buffer_t));
+    if (NULL != mSentParameters) {
+        clear_metadata_buffer(mSentParameters);
+    }
+    mSentParamsValid = false;
     return rc;
 }
 
@@ -4414,6 +5125,10 @@ void QCamera3HardwareInterface::deinitParameters()
 
     free(mPrevParameters);
     mPrevParameters = NULL;
+
+    invalidateSettingsCache();
+    free(mSentParameters);
+    mSentParameters = NULL;
 }
 
 /*===========================================================================
@@ -6022,14 +6737,113 @@ int QCamera3HardwareInterface::setFrameParameters(
     }
 
     if(request->settings != NULL){
+        /* Blob requests hand mParameters to the picture channel, which needs
+         * the complete settings */
+        bool sendAll = blob_request || !mSentParamsValid;
+
+        mSettingsCacheStats.requests++;
+        if (!sendAll && mSettingsCache.matches(request->settings, streamID)) {
+            mSettingsCacheStats.unchanged++;
+            CDBG("%s: settings unchanged for frame %u", __func__,
+                    request->frame_number);
+            return NO_ERROR;
+        }
+
         rc = translateToHalMetadata(request, mParameters, snapshotStreamId);
+        if (rc < 0) {
+            invalidateSettingsCache();
+            return rc;
+        }
         if (blob_request)
-            memcpy(mPrevParameters, mParameters, sizeof(metadata_buffer_t));
+            copy_metadata_buffer(mPrevParameters, mParameters);
+
+        if (NULL != mSentParameters) {
+            filterUnchangedParameters(mParameters, sendAll);
+            /* without a cached copy the next request is translated again */
+            mSettingsCache.update(request->settings, streamID);
+            mSentParamsValid = true;
+        }
     }
 
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : filterUnchangedParameters
+ *
+ * DESCRIPTION: drop the entries of a translated parameter batch whose value
+ *              the backend already holds, and record the ones that are sent.
+ *              The backend keeps parameters until they are set again, the
+ *              same as for requests with NULL settings.
+ *
+ * PARAMETERS :
+ *   @params  : translated parameter batch, filtered in place
+ *   @sendAll : keep every entry, only refresh the cache
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::filterUnchangedParameters(
+        metadata_buffer_t *params, bool sendAll)
+{
+    uint32_t ids[CAM_INTF_PARM_MAX];
+    uint32_t cnt = get_metadata_valid_ids(params, ids, CAM_INTF_PARM_MAX);
+
+    for (uint32_t i = 0; i < cnt; i++) {
+        cam_intf_parm_type_t id = (cam_intf_parm_type_t)ids[i];
+        uint32_t size = get_size_of(id);
+        void *p_new = get_pointer_of(id, params);
+        void *p_sent = get_pointer_of(id, mSentParameters);
+
+        switch (id) {
+        case CAM_INTF_PARM_HAL_VERSION:
+        case CAM_INTF_META_FRAME_NUMBER:
+        case CAM_INTF_META_STREAM_ID:
+        case CAM_INTF_PARM_UPDATE_DEBUG_LEVEL:
+        case CAM_INTF_META_AF_TRIGGER:
+        case CAM_INTF_META_AEC_PRECAPTURE_TRIGGER:
+            /* per request, always sent */
+            continue;
+        default:
+            break;
+        }
+
+        if ((0 == size) || (NULL == p_new) || (NULL == p_sent)) {
+            mSentParameters->is_valid[id] = 0;
+            mSettingsCacheStats.sent++;
+            continue;
+        }
+        if (!sendAll && mSentParameters->is_valid[id] &&
+                (0 == memcmp(p_new, p_sent, size))) {
+            params->is_valid[id] = 0;
+            mSettingsCacheStats.skipped++;
+            continue;
+        }
+        memcpy(p_sent, p_new, size);
+        mSentParameters->is_valid[id] = 1;
+        mSettingsCacheStats.sent++;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : invalidateSettingsCache
+ *
+ * DESCRIPTION: forget the cached settings, so the next request sends its
+ *              full translation. Used when the backend state is unknown,
+ *              e.g. after configureStreams, flush or a failed set_parms.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3HardwareInterface::invalidateSettingsCache()
+{
+    mSettingsCache.invalidate();
+    if (NULL != mSentParameters) {
+        clear_metadata_buffer(mSentParameters);
+    }
+    mSentParamsValid = false;
+}
+
 /*===========================================================================
  * FUNCTION   : setReprocParameters
  *
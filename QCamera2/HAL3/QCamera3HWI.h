@@ -38,6 +38,8 @@
 #include "QCamera3HALHeader.h"
 #include "QCamera3Channel.h"
 #include "QCamera3CropRegionMapper.h"
+#include "QCamera3FrameTable.h"
+#include "QCamera3SettingsCache.h"
 
 #include <hardware/power.h>
 
@@ -72,6 +74,15 @@ typedef int64_t nsecs_t;
 #define NSEC_PER_SEC 1000000000LLU
 #define NSEC_PER_USEC 1000LLU
 #define NSEC_PER_33MSEC 33000000LLU
+#ifndef NSEC_PER_MSEC
+#define NSEC_PER_MSEC 1000000LL
+#endif
+
+/* Buckets of the process_capture_request blocking time histogram */
+#define REQUEST_BLOCK_HIST_SIZE 9
+
+/* Maximum number of threads stopping channels in parallel during flush */
+#define MAX_FLUSH_STOP_THREADS 4
 
 extern volatile uint32_t gCamHal3LogLevel;
 
@@ -154,6 +165,8 @@ public:
             metadata_buffer_t *reprocParam, uint32_t snapshotStreamId);
     int translateToHalMetadata(const camera3_capture_request_t *request,
             metadata_buffer_t *parm, uint32_t snapshotStreamId);
+    void filterUnchangedParameters(metadata_buffer_t *params, bool sendAll);
+    void invalidateSettingsCache();
     camera_metadata_t* translateCbUrgentMetadataToResultMetadata (
                              metadata_buffer_t *metadata);
 
@@ -203,6 +216,12 @@ private:
     void handleBufferWithLock(camera3_stream_buffer_t *buffer,
             uint32_t frame_number);
     void unblockRequestIfNecessary();
+    void initInflightWindow();
+    void updateInflightWindow(nsecs_t requestTime, nsecs_t resultTime);
+    void recordRequestBlockTime(nsecs_t blockTime);
+    bool removePendingBuffer(uint32_t frame_number, buffer_handle_t *buffer);
+    void markPendingBufferDropped(uint32_t frame_number, camera3_stream_t *stream);
+    static void updateLockHoldStats(LockHoldStats &stats, nsecs_t lockTime);
     void dumpMetadataToFile(tuning_params_t &meta, uint32_t &dumpFrameCount,
             bool enabled, const char *type, uint32_t frameNumber);
     static void getLogLevel();
@@ -214,6 +233,16 @@ private:
     bool isSupportChannelNeeded(camera3_stream_configuration_t *streamList);
 
     int32_t getSensorOutputSize(cam_dimension_t &sensor_dim);
+    void startBufferPreallocation();
+    void waitForBufferPreallocation();
+    static void *bufferPreallocRoutine(void *data);
+    void stopAllChannels();
+    static void *channelStopRoutine(void *data);
+    int flushPendingWithLock();
+    void initResultMetadataPool();
+    void clearResultMetadataPool();
+    camera_metadata_t *acquireResultMetadata();
+    void recycleResultMetadata(camera_metadata_t *meta);
 
     camera3_device_t   mCameraDevice;
     uint32_t           mCameraId;
@@ -260,15 +289,11 @@ private:
         camera3_stream_buffer_t *input_buffer;
         const camera_metadata_t *settings;
         CameraMetadata jpegMetadata;
-        uint8_t pipeline_depth;
+        uint32_t pipeline_start; // mMetadataCount when the request was queued
+        nsecs_t request_time;
         uint32_t partial_result_cnt;
         uint8_t capture_intent;
     } PendingRequestInfo;
-    typedef struct {
-        uint32_t frame_number;
-        uint32_t stream_ID;
-    } PendingFrameDropInfo;
-
     // Store the Pending buffers for Flushing
     typedef struct {
         // Frame number pertaining to the buffer
@@ -276,13 +301,15 @@ private:
         camera3_stream_t *stream;
         // Buffer handle
         buffer_handle_t *buffer;
+        // Metadata reported this buffer as dropped
+        bool dropped;
     } PendingBufferInfo;
 
     typedef struct {
         // Total number of buffer requests pending
         uint32_t num_buffers;
-        // List of pending buffers
-        List<PendingBufferInfo> mPendingBufferList;
+        // Pending buffers of each frame, one entry per stream
+        QCamera3FrameTable<Vector<PendingBufferInfo> > mPendingBuffers;
     } PendingBuffersMap;
 
     typedef struct {
@@ -291,15 +318,61 @@ private:
         uint32_t frame_number;
     } PendingReprocessResult;
 
-    typedef KeyedVector<uint32_t, Vector<PendingBufferInfo> > FlushMap;
+    typedef struct {
+        uint32_t count;
+        nsecs_t total;
+        nsecs_t max;
+    } LockHoldStats;
 
-    List<PendingReprocessResult> mPendingReprocessResultList;
-    List<PendingRequestInfo> mPendingRequestsList;
-    List<PendingFrameDropInfo> mPendingFrameDropList;
+    typedef struct {
+        uint32_t requests;  // requests carrying settings
+        uint32_t unchanged; // settings identical to the previous ones
+        uint32_t sent;      // parameter entries sent to the backend
+        uint32_t skipped;   // entries dropped as already set in the backend
+    } SettingsCacheStats;
+
+    typedef struct {
+        Vector<QCamera3Channel *> channels;
+        uint32_t next;      // next channel to be stopped, claimed atomically
+    } ChannelStopJob;
+
+    typedef struct {
+        nsecs_t stop;       // stopping all channels
+        nsecs_t drain;      // error notifies and results for pending buffers
+        nsecs_t restart;    // restarting all channels
+        nsecs_t total;
+    } FlushTiming;
+
+    QCamera3FrameTable<PendingReprocessResult> mPendingReprocessResults;
+    QCamera3FrameTable<PendingRequestInfo> mPendingRequests;
     PendingBuffersMap mPendingBuffersMap;
+    // Number of metadata callbacks, used to derive the pipeline depth
+    uint32_t mMetadataCount;
+    // mMutex hold time of the metadata and buffer result paths
+    LockHoldStats mMetaLockStats;
+    LockHoldStats mBufferLockStats;
+    /* Request settings cache: settings and streams of the last translated
+     * request, and the last value of each parameter entry sent to the
+     * backend */
+    QCamera3SettingsCache mSettingsCache;
+    metadata_buffer_t *mSentParameters;
+    bool mSentParamsValid;
+    SettingsCacheStats mSettingsCacheStats;
     pthread_cond_t mRequestCond;
     int mPendingRequest;
     bool mWokenUpByDaemon;
+    /* Adaptive in-flight request window, see updateInflightWindow */
+    uint32_t mInflightWindow;
+    uint32_t mInflightFloor;
+    uint32_t mInflightCeiling;
+    nsecs_t mResultLatency;
+    nsecs_t mResultInterval;
+    nsecs_t mLastResultTime;
+    uint32_t mRequestBlockHist[REQUEST_BLOCK_HIST_SIZE];
+    // Per-phase duration of the last and the slowest flush
+    uint32_t mFlushCount;
+    FlushTiming mLastFlushTiming;
+    FlushTiming mMaxFlushTiming;
     int32_t mCurrentRequestId;
     cam_stream_size_info_t mStreamConfigInfo;
 
@@ -318,6 +391,20 @@ private:
     const camera_module_callbacks_t *mCallbacks;
 
     uint8_t mCaptureIntent;
+
+    /* Snapshot/reprocess buffer pre-allocation after configureStreams */
+    pthread_t mPreallocTid;
+    bool mPreallocActive;
+    bool mPreallocReprocess;
+    nsecs_t mConfigDoneTime;
+    /* First still capture of the session, for KPI logging */
+    bool mFirstShotPending;
+    uint32_t mFirstShotFrameNumber;
+    nsecs_t mFirstShotRequestTime;
+    /* Recycled result metadata buffers, pre-sized at configureStreams */
+    Vector<camera_metadata_t *> mResultMetadataPool;
+    size_t mResultMetaEntryCap;
+    size_t mResultMetaDataCap;
     metadata_buffer_t mRreprocMeta; //scratch meta buffer
 
     /* sensor output size with current stream configuration */
@@ -495,7 +495,13 @@ int32_t QCamera3PostProcessor::processData(mm_camera_super_buf_t *frame)
     QCamera3HardwareInterface* hal_obj = (QCamera3HardwareInterface*)m_parent->mUserData;
     pthread_mutex_lock(&mReprocJobLock);
     // enqueue to post proc input queue
-    m_inputPPQ.enqueue((void *)frame);
+    if (!m_inputPPQ.enqueue((void *)frame)) {
+        ALOGE("%s: Input PP Q is full or not active", __func__);
+        pthread_mutex_unlock(&mReprocJobLock);
+        releaseSuperBuf(frame);
+        free(frame);
+        return NO_MEMORY;
+    }
     if (!(m_inputMetaQ.isEmpty())) {
        CDBG("%s: meta queue is not empty, do next job", __func__);
        m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
@@ -526,7 +532,12 @@ int32_t QCamera3PostProcessor::processData(qcamera_fwk_input_pp_data_t *frame)
     if (hal_obj->needReprocess(mPostProcMask)) {
         pthread_mutex_lock(&mReprocJobLock);
         // enqueu to post proc input queue
-        m_inputFWKPPQ.enqueue((void *)frame);
+        if (!m_inputFWKPPQ.enqueue((void *)frame)) {
+            ALOGE("%s: Input FWK PP Q is full or not active", __func__);
+            pthread_mutex_unlock(&mReprocJobLock);
+            free(frame);
+            return NO_MEMORY;
+        }
         m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
         pthread_mutex_unlock(&mReprocJobLock);
     } else {
@@ -552,7 +563,12 @@ int32_t QCamera3PostProcessor::processData(qcamera_fwk_input_pp_data_t *frame)
                 (metadata_buffer_t *) frame->metadata_buffer.buffer;
 
         // enqueu to jpeg input queue
-        m_inputJpegQ.enqueue((void *)jpeg_job);
+        if (!m_inputJpegQ.enqueue((void *)jpeg_job)) {
+            ALOGE("%s: Input Jpeg Q is full or not active", __func__);
+            releaseJpegJobData(jpeg_job);
+            free(jpeg_job);
+            return NO_MEMORY;
+        }
         m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
     }
 
@@ -576,7 +592,13 @@ int32_t QCamera3PostProcessor::processPPMetadata(mm_camera_super_buf_t *reproc_m
 {
    pthread_mutex_lock(&mReprocJobLock);
     // enqueue to metadata input queue
-    m_inputMetaQ.enqueue((void *)reproc_meta);
+    if (!m_inputMetaQ.enqueue((void *)reproc_meta)) {
+        ALOGE("%s: Input Meta Q is full or not active", __func__);
+        pthread_mutex_unlock(&mReprocJobLock);
+        m_parent->metadataBufDone(reproc_meta);
+        free(reproc_meta);
+        return NO_MEMORY;
+    }
     if (!(m_inputPPQ.isEmpty())) {
        CDBG("%s: pp queue is not empty, do next job", __func__);
        m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
@@ -607,7 +629,12 @@ int32_t QCamera3PostProcessor::processJpegSettingData(
         ALOGE("%s: invalid jpeg settings pointer", __func__);
         return -EINVAL;
     }
-    return m_jpegSettingsQ.enqueue((void *)jpeg_settings);
+    if (!m_jpegSettingsQ.enqueue((void *)jpeg_settings)) {
+        ALOGE("%s: Jpeg settings Q is full or not active", __func__);
+        free(jpeg_settings);
+        return NO_MEMORY;
+    }
+    return NO_ERROR;
 }
 
 /*===========================================================================
@@ -625,7 +652,12 @@ int32_t QCamera3PostProcessor::processJpegSettingData(
 int32_t QCamera3PostProcessor::processRawData(mm_camera_super_buf_t *frame)
 {
     // enqueu to raw input queue
-    m_inputRawQ.enqueue((void *)frame);
+    if (!m_inputRawQ.enqueue((void *)frame)) {
+        ALOGE("%s: Input Raw Q is full or not active", __func__);
+        releaseSuperBuf(frame);
+        free(frame);
+        return NO_MEMORY;
+    }
     m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
     return NO_ERROR;
 }
@@ -682,7 +714,14 @@ int32_t QCamera3PostProcessor::processPPData(mm_camera_super_buf_t *frame)
     free(job);
 
     // enqueu reprocessed frame to jpeg input queue
-    m_inputJpegQ.enqueue((void *)jpeg_job);
+    if (!m_inputJpegQ.enqueue((void *)jpeg_job)) {
+        // the pp job is gone already, so release the frame here and
+        // report success to keep callers from releasing it again
+        ALOGE("%s: Input Jpeg Q is full or not active", __func__);
+        releaseJpegJobData(jpeg_job);
+        free(jpeg_job);
+        return NO_ERROR;
+    }
 
     // wait up data proc thread
     m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
@@ -1080,6 +1119,7 @@ int32_t QCamera3PostProcessor::encodeFWKData(qcamera_hal3_jpeg_data_t *jpeg_job_
     jpg_job.encode_job.session_id = mJpegSessionId;
     jpg_job.encode_job.src_index = 0;
     jpg_job.encode_job.dst_index = 0;
+    jpg_job.encode_job.priority = jpeg_settings->jpeg_priority;
 
     cam_rect_t crop;
     memset(&crop, 0, sizeof(cam_rect_t));
@@ -1333,6 +1373,7 @@ int32_t QCamera3PostProcessor::encodeData(qcamera_hal3_jpeg_data_t *jpeg_job_dat
     jpg_job.encode_job.session_id = mJpegSessionId;
     jpg_job.encode_job.src_index = (int32_t)main_frame->buf_idx;
     jpg_job.encode_job.dst_index = 0;
+    jpg_job.encode_job.priority = jpeg_settings->jpeg_priority;
 
     if (needJpegRotation) {
         jpg_job.encode_job.rotation = (uint32_t)jpeg_settings->jpeg_orientation;
@@ -1531,10 +1572,12 @@ void *QCamera3PostProcessor::dataProcessRoutine(void *data)
                         qcamera_hal3_jpeg_data_t *jpeg_job =
                             (qcamera_hal3_jpeg_data_t *)pme->m_inputJpegQ.dequeue();
 
-                        if (NULL != jpeg_job) {
-                            // add into ongoing jpeg job Q
-                            pme->m_ongoingJpegQ.enqueue((void *)jpeg_job);
-
+                        if ((NULL != jpeg_job) &&
+                                !pme->m_ongoingJpegQ.enqueue((void *)jpeg_job)) {
+                            ALOGE("%s: m_ongoingJpegQ is full or not active", __func__);
+                            pme->releaseJpegJobData(jpeg_job);
+                            free(jpeg_job);
+                        } else if (NULL != jpeg_job) {
                             if (jpeg_job->fwk_frame) {
                                 ret = pme->encodeFWKData(jpeg_job, needNewSess);
                             } else {
@@ -1568,11 +1611,16 @@ void *QCamera3PostProcessor::dataProcessRoutine(void *data)
                                     }
                                     // add into ongoing PP job Q
                                     pp_job->fwk_src_frame = fwk_frame;
-                                    pme->m_ongoingPPQ.enqueue((void *)pp_job);
-                                    ret = pme->m_pReprocChannel->doReprocessOffline(fwk_frame);
-                                    if (NO_ERROR != ret) {
-                                        // remove from ongoing PP job Q
-                                        pme->m_ongoingPPQ.dequeue(false);
+                                    if (!pme->m_ongoingPPQ.enqueue((void *)pp_job)) {
+                                        ALOGE("%s: m_ongoingPPQ is full or not active",
+                                                __func__);
+                                        ret = -1;
+                                    } else {
+                                        ret = pme->m_pReprocChannel->doReprocessOffline(fwk_frame);
+                                        if (NO_ERROR != ret) {
+                                            // remove from ongoing PP job Q
+                                            pme->m_ongoingPPQ.dequeue(false);
+                                        }
                                     }
                                 } else {
                                     ALOGE("%s: Reprocess channel is NULL", __func__);
@@ -1625,8 +1673,11 @@ void *QCamera3PostProcessor::dataProcessRoutine(void *data)
                                         meta_buffer->bufs[0]->buffer;
                             }
                             pp_job->jpeg_settings = jpeg_settings;
-                            pme->m_ongoingPPQ.enqueue((void *)pp_job);
-                            if (pme->m_pReprocChannel != NULL) {
+                            if (!pme->m_ongoingPPQ.enqueue((void *)pp_job)) {
+                                ALOGE("%s: m_ongoingPPQ is full or not active",
+                                        __func__);
+                                ret = -1;
+                            } else if (pme->m_pReprocChannel != NULL) {
                                 mm_camera_buf_def_t *meta_buffer_arg = NULL;
                                 meta_buffer_arg = meta_buffer->bufs[0];
                                 qcamera_fwk_input_pp_data_t fwk_frame;
@@ -0,0 +1,202 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#define LOG_TAG "QCamera3SettingsCache"
+
+#include <string.h>
+#include <utils/Errors.h>
+#include "QCamera3SettingsCache.h"
+
+using namespace android;
+
+namespace qcamera {
+
+/*===========================================================================
+ * FUNCTION   : QCamera3SettingsCache
+ *
+ * DESCRIPTION: constructor, the cache starts empty
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCamera3SettingsCache::QCamera3SettingsCache()
+    : mSettings(NULL)
+{
+    memset(&mStreamID, 0, sizeof(mStreamID));
+}
+
+/*===========================================================================
+ * FUNCTION   : ~QCamera3SettingsCache
+ *
+ * DESCRIPTION: destructor
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCamera3SettingsCache::~QCamera3SettingsCache()
+{
+    invalidate();
+}
+
+/*===========================================================================
+ * FUNCTION   : matches
+ *
+ * DESCRIPTION: compare request settings entry by entry against the cached
+ *              copy, and the requested streams against the cached set.
+ *              Settings carrying an AF or precapture trigger never match,
+ *              since the trigger has to reach the backend again.
+ *
+ * PARAMETERS :
+ *   @settings : request settings from framework
+ *   @streamID : streams requested by the same request
+ *
+ * RETURN     : true if translating the request would give the cached result
+ *==========================================================================*/
+bool QCamera3SettingsCache::matches(const camera_metadata_t *settings,
+        const cam_stream_ID_t &streamID) const
+{
+    if ((NULL == mSettings) || (NULL == settings) ||
+            !isSameStreamSet(streamID, mStreamID)) {
+        return false;
+    }
+
+    size_t count = get_camera_metadata_entry_count(settings);
+    if ((count != get_camera_metadata_entry_count(mSettings)) ||
+            (get_camera_metadata_data_count(settings) !=
+            get_camera_metadata_data_count(mSettings))) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        camera_metadata_ro_entry_t entry, last;
+        if ((0 != get_camera_metadata_ro_entry(settings, i, &entry)) ||
+                (0 != get_camera_metadata_ro_entry(mSettings, i, &last))) {
+            return false;
+        }
+        if ((entry.tag != last.tag) || (entry.type != last.type) ||
+                (entry.count != last.count) ||
+                memcmp(entry.data.u8, last.data.u8,
+                        entry.count * camera_metadata_type_size[entry.type])) {
+            return false;
+        }
+        if ((ANDROID_CONTROL_AF_TRIGGER == entry.tag) &&
+                (ANDROID_CONTROL_AF_TRIGGER_IDLE != entry.data.u8[0])) {
+            return false;
+        }
+        if ((ANDROID_CONTROL_AE_PRECAPTURE_TRIGGER == entry.tag) &&
+                (ANDROID_CONTROL_AE_PRECAPTURE_TRIGGER_IDLE != entry.data.u8[0])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : update
+ *
+ * DESCRIPTION: remember the settings and streams of a translated request
+ *
+ * PARAMETERS :
+ *   @settings : request settings from framework
+ *   @streamID : streams requested by the same request
+ *
+ * RETURN     : NO_ERROR on success, NO_MEMORY if the settings can not be
+ *              copied, in which case the cache is left empty
+ *==========================================================================*/
+int32_t QCamera3SettingsCache::update(const camera_metadata_t *settings,
+        const cam_stream_ID_t &streamID)
+{
+    invalidate();
+    if (NULL == settings) {
+        return BAD_VALUE;
+    }
+    mSettings = clone_camera_metadata(settings);
+    if (NULL == mSettings) {
+        return NO_MEMORY;
+    }
+    mStreamID = streamID;
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : invalidate
+ *
+ * DESCRIPTION: forget the cached request, the next one never matches
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3SettingsCache::invalidate()
+{
+    if (NULL != mSettings) {
+        free_camera_metadata(mSettings);
+        mSettings = NULL;
+    }
+    memset(&mStreamID, 0, sizeof(mStreamID));
+}
+
+/*===========================================================================
+ * FUNCTION   : isSameStreamSet
+ *
+ * DESCRIPTION: compare two stream id lists as sets. The order follows the
+ *              request's output buffers, which may differ between requests
+ *              for the same streams.
+ *
+ * PARAMETERS :
+ *   @a       : first stream id list
+ *   @b       : second stream id list
+ *
+ * RETURN     : true if both lists hold the same stream ids
+ *==========================================================================*/
+bool QCamera3SettingsCache::isSameStreamSet(const cam_stream_ID_t &a,
+        const cam_stream_ID_t &b)
+{
+    if ((a.num_streams != b.num_streams) ||
+            (a.num_streams > MAX_NUM_STREAMS)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.num_streams; i++) {
+        uint32_t j;
+        for (j = 0; j < b.num_streams; j++) {
+            if (a.streamID[i] == b.streamID[j]) {
+                break;
+            }
+        }
+        if (j == b.num_streams) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}; // namespace qcamera
@@ -0,0 +1,73 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef __QCAMERA3SETTINGSCACHE_H__
+#define __QCAMERA3SETTINGSCACHE_H__
+
+#include <stdint.h>
+#include <system/camera_metadata.h>
+#include "cam_types.h"
+
+namespace qcamera {
+
+/*===========================================================================
+ * CLASS      : QCamera3SettingsCache
+ *
+ * DESCRIPTION: key of the last request whose settings were translated to
+ *              HAL parameters: a copy of the framework settings and the set
+ *              of streams requested. translateToHalMetadata depends on both
+ *              (frame duration clamp, snapshot stream), so a request only
+ *              matches when both are unchanged.
+ *==========================================================================*/
+class QCamera3SettingsCache {
+public:
+    QCamera3SettingsCache();
+    ~QCamera3SettingsCache();
+
+    bool matches(const camera_metadata_t *settings,
+            const cam_stream_ID_t &streamID) const;
+    int32_t update(const camera_metadata_t *settings,
+            const cam_stream_ID_t &streamID);
+    void invalidate();
+
+    static bool isSameStreamSet(const cam_stream_ID_t &a,
+            const cam_stream_ID_t &b);
+
+private:
+    /* not copyable */
+    QCamera3SettingsCache(const QCamera3SettingsCache &);
+    QCamera3SettingsCache &operator=(const QCamera3SettingsCache &);
+
+    camera_metadata_t *mSettings;
+    cam_stream_ID_t mStreamID;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA3SETTINGSCACHE_H__ */
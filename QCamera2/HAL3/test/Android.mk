@@ -0,0 +1,36 @@
+LOCAL_PATH := $(call my-dir)
+
+# Host tests of the HAL3 helpers that do not need a camera. The kernel
+# headers are only needed for the types shared with the backend.
+
+qcamera3_test_includes := \
+        $(LOCAL_PATH)/.. \
+        $(LOCAL_PATH)/../../stack/common \
+        system/media/camera/include \
+        $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr/include
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := qcamera3-settings-cache-test
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+LOCAL_C_INCLUDES := $(qcamera3_test_includes)
+LOCAL_SRC_FILES := \
+        QCamera3SettingsCacheTest.cpp \
+        ../QCamera3SettingsCache.cpp
+LOCAL_SHARED_LIBRARIES := libcamera_metadata
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_ADDITIONAL_DEPENDENCIES := $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := qcamera3-frame-table-test
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+LOCAL_C_INCLUDES := $(qcamera3_test_includes) \
+        frameworks/native/include/media/openmax \
+        $(LOCAL_PATH)/../../../mm-image-codec/qexif \
+        $(LOCAL_PATH)/../../../mm-image-codec/qomx_core
+LOCAL_SRC_FILES := QCamera3FrameTableTest.cpp
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_ADDITIONAL_DEPENDENCIES := $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr
+include $(BUILD_HOST_EXECUTABLE)
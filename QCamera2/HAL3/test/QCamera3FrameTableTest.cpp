@@ -0,0 +1,238 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+/* Host test of QCamera3FrameTable, the frame number indexed table behind
+ * the HAL3 pending request, pending buffer and reprocess result lists.
+ * Frame numbers are fast-forwarded to just below 2^32 and the table is
+ * soaked across the wrap with results completing out of order; iteration
+ * from first() through next() has to stay in frame number order. Frames
+ * stuck for longer than the ring can span have to move to the overflow
+ * list and stay reachable in order.
+ *
+ * Usage: qcamera3-frame-table-test [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utils/Errors.h>
+#include "QCamera3FrameTable.h"
+
+using namespace qcamera;
+
+#define SOAK_WINDOW 8
+
+static int g_failures = 0;
+
+#define EXPECT(cond, what) do { \
+    if (!(cond)) { \
+        printf("FAIL %s\n", what); \
+        g_failures++; \
+    } \
+} while (0)
+
+/*===========================================================================
+ * FUNCTION   : checkOrder
+ *
+ * DESCRIPTION: walk the table like the result handlers do and compare it
+ *              with the reference list of pending frame numbers
+ *
+ * PARAMETERS :
+ *   @table   : table under test, items hold their frame number
+ *   @pending : reference frame numbers, sorted in frame number order
+ *   @count   : number of reference frame numbers
+ *
+ * RETURN     : true if the walk matches the reference
+ *==========================================================================*/
+static bool checkOrder(QCamera3FrameTable<uint32_t> &table,
+        const uint32_t *pending, size_t count)
+{
+    size_t n = 0;
+
+    if (table.size() != count) {
+        return false;
+    }
+    for (uint32_t *i = table.first(); i != NULL; i = table.next(*i)) {
+        if ((n >= count) || (*i != pending[n])) {
+            return false;
+        }
+        n++;
+    }
+    return (n == count);
+}
+
+/*===========================================================================
+ * FUNCTION   : testWrap
+ *
+ * DESCRIPTION: frame numbers on both sides of 2^32 added out of order
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+static void testWrap()
+{
+    static const uint32_t order[] = {
+        0xFFFFFFFEU, 2, 0xFFFFFFFCU, 0, 1, 0xFFFFFFFFU, 0xFFFFFFFDU
+    };
+    static const uint32_t sorted[] = {
+        0xFFFFFFFCU, 0xFFFFFFFDU, 0xFFFFFFFEU, 0xFFFFFFFFU, 0, 1, 2
+    };
+    QCamera3FrameTable<uint32_t> table;
+
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        EXPECT(table.add(order[i], order[i]) != NULL, "wrap: add");
+    }
+    EXPECT(table.add(0, 0) == NULL, "wrap: duplicate added");
+    EXPECT(checkOrder(table, sorted, sizeof(sorted) / sizeof(sorted[0])),
+            "wrap: walk not in frame number order");
+    EXPECT(*table.first() == 0xFFFFFFFCU, "wrap: oldest");
+    EXPECT(table.find(3) == NULL, "wrap: newer than newest found");
+    EXPECT(table.find(0xFFFFFFFBU) == NULL, "wrap: older than oldest found");
+
+    table.erase(0xFFFFFFFCU);
+    table.erase(0);
+    EXPECT(*table.first() == 0xFFFFFFFDU, "wrap: oldest after erase");
+    EXPECT(*table.next(0xFFFFFFFFU) == 1, "wrap: next skips erased 0");
+    table.clear();
+    EXPECT(table.isEmpty() && (table.first() == NULL), "wrap: clear");
+}
+
+/*===========================================================================
+ * FUNCTION   : testStuck
+ *
+ * DESCRIPTION: frames left pending while the stream runs far past
+ *              FRAME_TABLE_MAX_SLOTS, starting just below 2^32
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+static void testStuck()
+{
+    const uint32_t base = 0xFFFFFF00U;
+    const uint32_t span = 3 * FRAME_TABLE_MAX_SLOTS;
+    QCamera3FrameTable<uint32_t> table;
+    uint32_t bad = 0;
+
+    /* base and base + 1 never complete, everything else completes two
+     * frames later */
+    for (uint32_t n = 0; n < span; n++) {
+        uint32_t frameNumber = base + n;
+        if (table.add(frameNumber, frameNumber) == NULL) {
+            bad++;
+        }
+        if (n >= 4) {
+            table.erase(frameNumber - 2);
+        }
+    }
+    EXPECT(0 == bad, "stuck: add failed");
+    EXPECT(2 == table.overflowSize(), "stuck: stuck frames not overflowed");
+    EXPECT(4 == table.size(), "stuck: size");
+    {
+        const uint32_t sorted[] = { base, base + 1, base + span - 2,
+                base + span - 1 };
+        EXPECT(checkOrder(table, sorted, 4), "stuck: walk order");
+    }
+    EXPECT((table.find(base + 1) != NULL) && (*table.find(base + 1) == base + 1),
+            "stuck: overflowed frame not found");
+    EXPECT(table.add(base, base) == NULL, "stuck: overflowed duplicate added");
+
+    /* a late request older than the overflowed ones */
+    EXPECT(table.add(base - 5, base - 5) != NULL, "stuck: add older frame");
+    EXPECT(*table.first() == base - 5, "stuck: older frame first");
+
+    table.erase(base - 5);
+    table.erase(base);
+    EXPECT(*table.first() == base + 1, "stuck: oldest after overflow erase");
+    table.erase(base + 1);
+    EXPECT(0 == table.overflowSize(), "stuck: overflow drained");
+    EXPECT(*table.first() == base + span - 2, "stuck: ring oldest first");
+    EXPECT(*table.next(base + span - 2) == base + span - 1, "stuck: ring next");
+    table.clear();
+    EXPECT(table.isEmpty() && (table.first() == NULL), "stuck: clear");
+}
+
+/*===========================================================================
+ * FUNCTION   : soak
+ *
+ * DESCRIPTION: keep a window of pending frames, one new request and one
+ *              result per step, results completing out of order
+ *
+ * PARAMETERS :
+ *   @start   : first frame number
+ *   @frames  : number of requests
+ *
+ * RETURN     : None
+ *==========================================================================*/
+static void soak(uint32_t start, uint32_t frames)
+{
+    QCamera3FrameTable<uint32_t> table;
+    uint32_t pending[SOAK_WINDOW + 1];
+    size_t count = 0;
+    uint32_t seed = 1, bad = 0;
+
+    for (uint32_t n = 0; n < frames; n++) {
+        uint32_t frameNumber = start + n;
+
+        if (table.add(frameNumber, frameNumber) == NULL) {
+            bad++;
+        }
+        pending[count++] = frameNumber;
+
+        if (count > SOAK_WINDOW) {
+            /* complete a random pending frame, like a late result */
+            seed = seed * 1103515245U + 12345U;
+            size_t done = (seed >> 16) % count;
+            table.erase(pending[done]);
+            memmove(&pending[done], &pending[done + 1],
+                    (count - done - 1) * sizeof(pending[0]));
+            count--;
+        }
+        if (!checkOrder(table, pending, count)) {
+            bad++;
+        }
+    }
+    printf("soak %u frames from 0x%08x, %zu pending at the end\n",
+            frames, start, count);
+    EXPECT(0 == bad, "soak: pending walk out of frame number order");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 100000;
+
+    testWrap();
+    testStuck();
+    soak(0U - frames / 2, frames);
+    soak(0xFFFFFFFFU, frames);
+
+    printf("%s (%d failures)\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
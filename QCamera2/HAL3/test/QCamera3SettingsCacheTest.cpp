@@ -0,0 +1,149 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+/* Host test of QCamera3SettingsCache, the key deciding whether a request's
+ * settings have to be translated again.
+ *
+ * Usage: qcamera3-settings-cache-test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "QCamera3SettingsCache.h"
+
+using namespace qcamera;
+
+static int g_failures = 0;
+
+#define EXPECT(cond, what) do { \
+    if (!(cond)) { \
+        printf("FAIL %s\n", what); \
+        g_failures++; \
+    } \
+} while (0)
+
+/*===========================================================================
+ * FUNCTION   : makeSettings
+ *
+ * DESCRIPTION: build request settings with the entries the cache looks at
+ *
+ * PARAMETERS :
+ *   @aeMode    : ANDROID_CONTROL_AE_MODE value
+ *   @afTrigger : ANDROID_CONTROL_AF_TRIGGER value
+ *
+ * RETURN     : settings, freed by the caller
+ *==========================================================================*/
+static camera_metadata_t *makeSettings(uint8_t aeMode, uint8_t afTrigger)
+{
+    camera_metadata_t *settings = allocate_camera_metadata(4, 64);
+    int64_t exposure = 33000000;
+    int32_t fpsRange[2] = {15, 30};
+
+    add_camera_metadata_entry(settings, ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    add_camera_metadata_entry(settings, ANDROID_CONTROL_AF_TRIGGER,
+            &afTrigger, 1);
+    add_camera_metadata_entry(settings, ANDROID_SENSOR_EXPOSURE_TIME,
+            &exposure, 1);
+    add_camera_metadata_entry(settings,
+            ANDROID_CONTROL_AE_TARGET_FPS_RANGE, fpsRange, 2);
+    return settings;
+}
+
+static cam_stream_ID_t makeStreams(uint32_t num, const uint32_t *ids)
+{
+    cam_stream_ID_t streamID;
+
+    memset(&streamID, 0, sizeof(streamID));
+    streamID.num_streams = num;
+    memcpy(streamID.streamID, ids, num * sizeof(ids[0]));
+    return streamID;
+}
+
+int main()
+{
+    static const uint32_t previewIds[] = {3};
+    static const uint32_t previewBlobIds[] = {3, 5};
+    static const uint32_t blobPreviewIds[] = {5, 3};
+    static const uint32_t previewRawIds[] = {3, 7};
+    static const uint32_t otherIds[] = {4};
+    cam_stream_ID_t preview = makeStreams(1, previewIds);
+    cam_stream_ID_t previewBlob = makeStreams(2, previewBlobIds);
+    cam_stream_ID_t blobPreview = makeStreams(2, blobPreviewIds);
+    cam_stream_ID_t previewRaw = makeStreams(2, previewRawIds);
+    cam_stream_ID_t other = makeStreams(1, otherIds);
+    camera_metadata_t *settings = makeSettings(ANDROID_CONTROL_AE_MODE_ON,
+            ANDROID_CONTROL_AF_TRIGGER_IDLE);
+    camera_metadata_t *same = makeSettings(ANDROID_CONTROL_AE_MODE_ON,
+            ANDROID_CONTROL_AF_TRIGGER_IDLE);
+    camera_metadata_t *changed = makeSettings(ANDROID_CONTROL_AE_MODE_OFF,
+            ANDROID_CONTROL_AF_TRIGGER_IDLE);
+    camera_metadata_t *trigger = makeSettings(ANDROID_CONTROL_AE_MODE_ON,
+            ANDROID_CONTROL_AF_TRIGGER_START);
+    QCamera3SettingsCache cache;
+
+    EXPECT(!cache.matches(settings, preview), "empty cache matches");
+    EXPECT(cache.update(settings, preview) == 0, "update failed");
+
+    /* identical settings, identical streams */
+    EXPECT(cache.matches(same, preview), "identical request not matched");
+    EXPECT(!cache.matches(changed, preview), "changed settings matched");
+    EXPECT(!cache.matches(NULL, preview), "NULL settings matched");
+
+    /* identical settings, different streams: the frame duration clamp and
+     * the snapshot stream depend on the stream set */
+    EXPECT(!cache.matches(same, previewRaw), "RAW stream added, matched");
+    EXPECT(!cache.matches(same, other), "other stream matched");
+
+    cache.update(settings, previewBlob);
+    EXPECT(!cache.matches(same, preview),
+            "preview only after blob request matched");
+    EXPECT(cache.matches(same, blobPreview),
+            "same streams in another order not matched");
+
+    /* an active trigger is never skipped, even when repeated */
+    cache.update(trigger, preview);
+    EXPECT(!cache.matches(trigger, preview), "active AF trigger matched");
+
+    cache.update(settings, preview);
+    cache.invalidate();
+    EXPECT(!cache.matches(same, preview), "invalidated cache matches");
+
+    EXPECT(QCamera3SettingsCache::isSameStreamSet(previewBlob, blobPreview),
+            "reordered stream set differs");
+    EXPECT(!QCamera3SettingsCache::isSameStreamSet(previewBlob, previewRaw),
+            "different stream sets equal");
+
+    free_camera_metadata(settings);
+    free_camera_metadata(same);
+    free_camera_metadata(changed);
+    free_camera_metadata(trigger);
+
+    printf("%s (%d failures)\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
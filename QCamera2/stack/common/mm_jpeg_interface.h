@@ -96,6 +96,15 @@ typedef enum {
   JPEG_JOB_STATUS_ERROR
 } jpeg_job_status_t;
 
+/* scheduling class of a job, the job manager serves lower values first.
+ * Zeroed jobs default to single shot */
+typedef enum {
+  MM_JPEG_JOB_PRIO_SINGLE_SHOT = 0,
+  MM_JPEG_JOB_PRIO_BURST,
+  MM_JPEG_JOB_PRIO_PREVIEW_THUMB,
+  MM_JPEG_JOB_PRIO_MAX
+} mm_jpeg_job_prio_t;
+
 typedef void (*jpeg_encode_callback_t)(jpeg_job_status_t status,
   uint32_t client_hdl,
   uint32_t jobId,
@@ -233,6 +242,9 @@ typedef struct {
   /* flag to enable/disable mobicat */
   uint8_t mobicat_mask;
 
+  /* scheduling class */
+  mm_jpeg_job_prio_t priority;
+
 } mm_jpeg_encode_job_t;
 
 typedef struct {
@@ -249,6 +261,9 @@ typedef struct {
 
   /*session id*/
   uint32_t session_id;
+
+  /* scheduling class */
+  mm_jpeg_job_prio_t priority;
 } mm_jpeg_decode_job_t;
 
 typedef enum {
@@ -318,4 +333,24 @@ uint32_t jpeg_open(mm_jpeg_ops_t *ops, mm_dimension picture_size);
  * jpeg ops tbl will be filled in if open succeeds */
 uint32_t jpegdec_open(mm_jpegdec_ops_t *ops);
 
+/* sort key placing an exif tag where it is written in APP1: 0th IFD,
+ * Exif IFD, GPS IFD and 1st IFD, each ordered by tag number. Exif
+ * tables handed to the encoder are kept in this order. */
+static inline uint32_t mm_jpeg_exif_tag_order(exif_tag_id_t tag_id)
+{
+  uint32_t offset = tag_id >> 16;
+  uint32_t ifd;
+
+  if (offset <= GPS_DIFFERENTIAL) {
+    ifd = 2;
+  } else if (offset < EXIF_IFD) {
+    ifd = 0;
+  } else if ((offset >= TN_IMAGE_WIDTH) && (offset <= TN_COPYRIGHT)) {
+    ifd = 3;
+  } else {
+    ifd = 1;
+  }
+  return (ifd << 16) | (tag_id & 0xFFFF);
+}
+
 #endif /* MM_JPEG_INTERFACE_H_ */
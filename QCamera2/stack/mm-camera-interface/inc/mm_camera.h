@@ -160,8 +160,7 @@ typedef struct {
     int32_t state;
     int timeoutms;
     uint32_t cmd;
-    struct pollfd poll_fds[MAX_STREAM_NUM_IN_BUNDLE + 1];
-    uint8_t num_fds;
+    int32_t epoll_fd; /* epoll set of pipe read fd and entry fds */
     pthread_mutex_t mutex;
     pthread_cond_t cond_v;
     int32_t status;
@@ -345,12 +344,20 @@ typedef struct {
     int32_t plane_idx;
 } mm_evt_paylod_unmap_stream_buf_t;
 
+/* number of slots in frame_idx indexed map of unmatched superbufs,
+ * must be power of 2 */
+#define MM_CHANNEL_FRAME_MAP_SIZE 64
+
 typedef struct {
     uint8_t num_of_bufs;
     mm_camera_buf_info_t super_buf[MAX_STREAM_NUM_IN_BUNDLE];
     uint8_t matched;
     uint8_t expected;
     uint32_t frame_idx;
+    /* link in unmatched list of superbuf queue, valid while not matched */
+    struct cam_list unmatched;
+    /* owning node in superbuf queue */
+    cam_node_t *q_node;
 } mm_channel_queue_node_t;
 
 typedef struct {
@@ -368,6 +375,13 @@ typedef struct {
     uint32_t once;
     uint32_t frame_skip_count;
     uint32_t nomatch_frame_id;
+    /* unmatched superbufs sorted by frame_idx */
+    struct cam_list unmatched_list;
+    uint32_t unmatched_cnt;
+    /* unmatched superbufs indexed by frame_idx */
+    mm_channel_queue_node_t *frame_map[MM_CHANNEL_FRAME_MAP_SIZE];
+    /* number of unmatched superbufs not in frame_map due to collision */
+    uint32_t frame_map_overflow;
 } mm_channel_queue_t;
 
 typedef struct {
@@ -27,691 +27,205 @@
  *
  */
 
+#include <stddef.h>
+#include <string.h>
 #include "cam_intf.h"
 
+/* location of an entry inside metadata_data_t, size 0 if it has none */
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+} cam_intf_meta_entry_t;
+
+#define META_TABLE_ENTRY(PARAM_ID, DATATYPE, COUNT) \
+    [PARAM_ID] = { \
+        offsetof(metadata_data_t, member_variable_##PARAM_ID), \
+        sizeof(((metadata_data_t *)0)->member_variable_##PARAM_ID) },
+
+#define STREAM_PARM_TABLE_ENTRY(PARAM_ID) \
+    [PARAM_ID] = { 0, 0 },
+
+#define NO_TABLE_ENTRY(PARAM_ID, DATATYPE, COUNT)
+
+static const cam_intf_meta_entry_t g_cam_intf_meta_table[CAM_INTF_PARM_MAX] = {
+    CAM_INTF_METADATA_LIST(META_TABLE_ENTRY, NO_TABLE_ENTRY)
+    CAM_INTF_STREAM_PARM_LIST(STREAM_PARM_TABLE_ENTRY)
+};
+
+/* Every cam_intf_parm_type_t must be listed exactly once in either
+ * CAM_INTF_METADATA_LIST or CAM_INTF_STREAM_PARM_LIST. Duplicates are
+ * caught by -Woverride-init, missing ids by this count check. */
+#define META_COUNT_ENTRY(PARAM_ID, DATATYPE, COUNT) + 1
+#define STREAM_PARM_COUNT_ENTRY(PARAM_ID) + 1
+typedef char cam_intf_meta_table_is_complete[
+        ((0 CAM_INTF_METADATA_LIST(META_COUNT_ENTRY, NO_TABLE_ENTRY)
+          CAM_INTF_STREAM_PARM_LIST(STREAM_PARM_COUNT_ENTRY)) ==
+         CAM_INTF_PARM_MAX) ? 1 : -1];
+
+/*===========================================================================
+ * FUNCTION   : get_pointer_of
+ *
+ * DESCRIPTION: get location of a parameter/metadata entry
+ *
+ * PARAMETERS :
+ *   @meta_id : id of the entry
+ *   @metadata: metadata or parameter buffer
+ *
+ * RETURN     : ptr to the entry, NULL if the id has no entry
+ *==========================================================================*/
 void *get_pointer_of(cam_intf_parm_type_t meta_id,
         const metadata_buffer_t* metadata)
 {
-    switch(meta_id) {
-        case CAM_INTF_META_HISTOGRAM:
-            return POINTER_OF_META(CAM_INTF_META_HISTOGRAM, metadata);
-        case CAM_INTF_META_FACE_DETECTION:
-            return POINTER_OF_META(CAM_INTF_META_FACE_DETECTION, metadata);
-        case CAM_INTF_META_AUTOFOCUS_DATA:
-            return POINTER_OF_META(CAM_INTF_META_AUTOFOCUS_DATA, metadata);
-        case CAM_INTF_PARM_UPDATE_DEBUG_LEVEL:
-            return POINTER_OF_META(CAM_INTF_PARM_UPDATE_DEBUG_LEVEL, metadata);
-        case CAM_INTF_META_CROP_DATA:
-            return POINTER_OF_META(CAM_INTF_META_CROP_DATA, metadata);
-        case CAM_INTF_META_PREP_SNAPSHOT_DONE:
-            return POINTER_OF_META(CAM_INTF_META_PREP_SNAPSHOT_DONE, metadata);
-        case CAM_INTF_META_GOOD_FRAME_IDX_RANGE:
-            return POINTER_OF_META(CAM_INTF_META_GOOD_FRAME_IDX_RANGE, metadata);
-        case CAM_INTF_META_ASD_HDR_SCENE_DATA:
-            return POINTER_OF_META(CAM_INTF_META_ASD_HDR_SCENE_DATA, metadata);
-        case CAM_INTF_META_ASD_SCENE_TYPE:
-            return POINTER_OF_META(CAM_INTF_META_ASD_SCENE_TYPE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ISP:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_ISP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_PP:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_PP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AE:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_AE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AWB:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_AWB, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AF:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_AF, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ASD:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_ASD, metadata);
-        case CAM_INTF_BUF_DIVERT_INFO:
-            return POINTER_OF_META(CAM_INTF_BUF_DIVERT_INFO, metadata);
-        case CAM_INTF_META_FRAME_NUMBER_VALID:
-            return POINTER_OF_META(CAM_INTF_META_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER_VALID:
-            return POINTER_OF_META(CAM_INTF_META_URGENT_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_FRAME_DROPPED:
-            return POINTER_OF_META(CAM_INTF_META_FRAME_DROPPED, metadata);
-        case CAM_INTF_META_FRAME_NUMBER:
-            return POINTER_OF_META(CAM_INTF_META_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER:
-            return POINTER_OF_META(CAM_INTF_META_URGENT_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_MODE:
-            return POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_MODE, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_TRANSFORM:
-            return POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_GAINS:
-            return POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM:
-            return POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_GAINS:
-            return POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_AEC_ROI:
-            return POINTER_OF_META(CAM_INTF_META_AEC_ROI, metadata);
-        case CAM_INTF_META_AEC_STATE:
-            return POINTER_OF_META(CAM_INTF_META_AEC_STATE, metadata);
-        case CAM_INTF_PARM_FOCUS_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_FOCUS_MODE, metadata);
-        case CAM_INTF_PARM_MANUAL_FOCUS_POS:
-            return POINTER_OF_META(CAM_INTF_PARM_MANUAL_FOCUS_POS, metadata);
-        case CAM_INTF_META_AF_ROI:
-            return POINTER_OF_META(CAM_INTF_META_AF_ROI, metadata);
-        case CAM_INTF_META_AF_STATE:
-            return POINTER_OF_META(CAM_INTF_META_AF_STATE, metadata);
-        case CAM_INTF_PARM_WHITE_BALANCE:
-            return POINTER_OF_META(CAM_INTF_PARM_WHITE_BALANCE, metadata);
-        case CAM_INTF_META_AWB_REGIONS:
-            return POINTER_OF_META(CAM_INTF_META_AWB_REGIONS, metadata);
-        case CAM_INTF_META_AWB_STATE:
-            return POINTER_OF_META(CAM_INTF_META_AWB_STATE, metadata);
-        case CAM_INTF_META_BLACK_LEVEL_LOCK:
-            return POINTER_OF_META(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata);
-        case CAM_INTF_META_MODE:
-            return POINTER_OF_META(CAM_INTF_META_MODE, metadata);
-        case CAM_INTF_META_EDGE_MODE:
-            return POINTER_OF_META(CAM_INTF_META_EDGE_MODE, metadata);
-        case CAM_INTF_META_FLASH_POWER:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_POWER, metadata);
-        case CAM_INTF_META_FLASH_FIRING_TIME:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_FIRING_TIME, metadata);
-        case CAM_INTF_META_FLASH_MODE:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_MODE, metadata);
-        case CAM_INTF_META_FLASH_STATE:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_STATE, metadata);
-        case CAM_INTF_META_HOTPIXEL_MODE:
-            return POINTER_OF_META(CAM_INTF_META_HOTPIXEL_MODE, metadata);
-        case CAM_INTF_META_LENS_APERTURE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_APERTURE, metadata);
-        case CAM_INTF_META_LENS_FILTERDENSITY:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FILTERDENSITY, metadata);
-        case CAM_INTF_META_LENS_FOCAL_LENGTH:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata);
-        case CAM_INTF_META_LENS_FOCUS_DISTANCE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_DISTANCE, metadata);
-        case CAM_INTF_META_LENS_FOCUS_RANGE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_RANGE, metadata);
-        case CAM_INTF_META_LENS_STATE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_STATE, metadata);
-        case CAM_INTF_META_LENS_OPT_STAB_MODE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_MODE:
-            return POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata);
-        case CAM_INTF_META_SCALER_CROP_REGION:
-            return POINTER_OF_META(CAM_INTF_META_SCALER_CROP_REGION, metadata);
-        case CAM_INTF_META_SCENE_FLICKER:
-            return POINTER_OF_META(CAM_INTF_META_SCENE_FLICKER, metadata);
-        case CAM_INTF_META_SENSOR_EXPOSURE_TIME:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata);
-        case CAM_INTF_META_SENSOR_FRAME_DURATION:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata);
-        case CAM_INTF_META_SENSOR_SENSITIVITY:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_SENSITIVITY, metadata);
-        case CAM_INTF_META_SENSOR_TIMESTAMP:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_TIMESTAMP, metadata);
-        case CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW, metadata);
-        case CAM_INTF_META_SHADING_MODE:
-            return POINTER_OF_META(CAM_INTF_META_SHADING_MODE, metadata);
-        case CAM_INTF_META_STATS_FACEDETECT_MODE:
-            return POINTER_OF_META(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata);
-        case CAM_INTF_META_STATS_HISTOGRAM_MODE:
-            return POINTER_OF_META(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP_MODE:
-            return POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP:
-            return POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata);
-        case CAM_INTF_META_TONEMAP_CURVES:
-            return POINTER_OF_META(CAM_INTF_META_TONEMAP_CURVES, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP:
-            return POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP, metadata);
-        case CAM_INTF_META_AEC_INFO:
-            return POINTER_OF_META(CAM_INTF_META_AEC_INFO, metadata);
-        case CAM_INTF_META_SENSOR_INFO:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_INFO, metadata);
-        case CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE:
-            return POINTER_OF_META(CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE, metadata);
-        case CAM_INTF_PARM_EFFECT:
-            return POINTER_OF_META(CAM_INTF_PARM_EFFECT, metadata);
-        case CAM_INTF_META_PRIVATE_DATA:
-            return POINTER_OF_META(CAM_INTF_META_PRIVATE_DATA, metadata);
-        case CAM_INTF_PARM_HAL_VERSION:
-            return POINTER_OF_META(CAM_INTF_PARM_HAL_VERSION, metadata);
-        case CAM_INTF_PARM_ANTIBANDING:
-            return POINTER_OF_META(CAM_INTF_PARM_ANTIBANDING, metadata);
-        case CAM_INTF_PARM_EXPOSURE_COMPENSATION:
-            return POINTER_OF_META(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata);
-        case CAM_INTF_PARM_EV_STEP:
-            return POINTER_OF_META(CAM_INTF_PARM_EV_STEP, metadata);
-        case CAM_INTF_PARM_AEC_LOCK:
-            return POINTER_OF_META(CAM_INTF_PARM_AEC_LOCK, metadata);
-        case CAM_INTF_PARM_FPS_RANGE:
-            return POINTER_OF_META(CAM_INTF_PARM_FPS_RANGE, metadata);
-        case CAM_INTF_PARM_AWB_LOCK:
-            return POINTER_OF_META(CAM_INTF_PARM_AWB_LOCK, metadata);
-        case CAM_INTF_PARM_BESTSHOT_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_BESTSHOT_MODE, metadata);
-        case CAM_INTF_PARM_DIS_ENABLE:
-            return POINTER_OF_META(CAM_INTF_PARM_DIS_ENABLE, metadata);
-        case CAM_INTF_PARM_LED_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_LED_MODE, metadata);
-        case CAM_INTF_META_LED_MODE_OVERRIDE:
-            return POINTER_OF_META(CAM_INTF_META_LED_MODE_OVERRIDE, metadata);
-        case CAM_INTF_PARM_QUERY_FLASH4SNAP:
-            return POINTER_OF_META(CAM_INTF_PARM_QUERY_FLASH4SNAP, metadata);
-        case CAM_INTF_PARM_EXPOSURE:
-            return POINTER_OF_META(CAM_INTF_PARM_EXPOSURE, metadata);
-        case CAM_INTF_PARM_SHARPNESS:
-            return POINTER_OF_META(CAM_INTF_PARM_SHARPNESS, metadata);
-        case CAM_INTF_PARM_CONTRAST:
-            return POINTER_OF_META(CAM_INTF_PARM_CONTRAST, metadata);
-        case CAM_INTF_PARM_SATURATION:
-            return POINTER_OF_META(CAM_INTF_PARM_SATURATION, metadata);
-        case CAM_INTF_PARM_BRIGHTNESS:
-            return POINTER_OF_META(CAM_INTF_PARM_BRIGHTNESS, metadata);
-        case CAM_INTF_PARM_ISO:
-            return POINTER_OF_META(CAM_INTF_PARM_ISO, metadata);
-        case CAM_INTF_PARM_EXPOSURE_TIME:
-            return POINTER_OF_META(CAM_INTF_PARM_EXPOSURE_TIME, metadata);
-        case CAM_INTF_PARM_ZOOM:
-            return POINTER_OF_META(CAM_INTF_PARM_ZOOM, metadata);
-        case CAM_INTF_PARM_ROLLOFF:
-            return POINTER_OF_META(CAM_INTF_PARM_ROLLOFF, metadata);
-        case CAM_INTF_PARM_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_MODE, metadata);
-        case CAM_INTF_PARM_AEC_ALGO_TYPE:
-            return POINTER_OF_META(CAM_INTF_PARM_AEC_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_FOCUS_ALGO_TYPE:
-            return POINTER_OF_META(CAM_INTF_PARM_FOCUS_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_AEC_ROI:
-            return POINTER_OF_META(CAM_INTF_PARM_AEC_ROI, metadata);
-        case CAM_INTF_PARM_AF_ROI:
-            return POINTER_OF_META(CAM_INTF_PARM_AF_ROI, metadata);
-        case CAM_INTF_PARM_SCE_FACTOR:
-            return POINTER_OF_META(CAM_INTF_PARM_SCE_FACTOR, metadata);
-        case CAM_INTF_PARM_FD:
-            return POINTER_OF_META(CAM_INTF_PARM_FD, metadata);
-        case CAM_INTF_PARM_MCE:
-            return POINTER_OF_META(CAM_INTF_PARM_MCE, metadata);
-        case CAM_INTF_PARM_HFR:
-            return POINTER_OF_META(CAM_INTF_PARM_HFR, metadata);
-        case CAM_INTF_PARM_REDEYE_REDUCTION:
-            return POINTER_OF_META(CAM_INTF_PARM_REDEYE_REDUCTION, metadata);
-        case CAM_INTF_PARM_WAVELET_DENOISE:
-            return POINTER_OF_META(CAM_INTF_PARM_WAVELET_DENOISE, metadata);
-        case CAM_INTF_PARM_TEMPORAL_DENOISE:
-            return POINTER_OF_META(CAM_INTF_PARM_TEMPORAL_DENOISE, metadata);
-        case CAM_INTF_PARM_HISTOGRAM:
-            return POINTER_OF_META(CAM_INTF_PARM_HISTOGRAM, metadata);
-        case CAM_INTF_PARM_ASD_ENABLE:
-            return POINTER_OF_META(CAM_INTF_PARM_ASD_ENABLE, metadata);
-        case CAM_INTF_PARM_RECORDING_HINT:
-            return POINTER_OF_META(CAM_INTF_PARM_RECORDING_HINT, metadata);
-        case CAM_INTF_PARM_HDR:
-            return POINTER_OF_META(CAM_INTF_PARM_HDR, metadata);
-        case CAM_INTF_PARM_FRAMESKIP:
-            return POINTER_OF_META(CAM_INTF_PARM_FRAMESKIP, metadata);
-        case CAM_INTF_PARM_ZSL_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_ZSL_MODE, metadata);
-        case CAM_INTF_PARM_HDR_NEED_1X:
-            return POINTER_OF_META(CAM_INTF_PARM_HDR_NEED_1X, metadata);
-        case CAM_INTF_PARM_LOCK_CAF:
-            return POINTER_OF_META(CAM_INTF_PARM_LOCK_CAF, metadata);
-        case CAM_INTF_PARM_VIDEO_HDR:
-            return POINTER_OF_META(CAM_INTF_PARM_VIDEO_HDR, metadata);
-        case CAM_INTF_PARM_VT:
-            return POINTER_OF_META(CAM_INTF_PARM_VT, metadata);
-        case CAM_INTF_PARM_GET_CHROMATIX:
-            return POINTER_OF_META(CAM_INTF_PARM_GET_CHROMATIX, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_CHROMATIX:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_RELOAD_CHROMATIX, metadata);
-        case CAM_INTF_PARM_GET_AFTUNE:
-            return POINTER_OF_META(CAM_INTF_PARM_GET_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_AFTUNE:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_RELOAD_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_AUTOFOCUSTUNING:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_AUTOFOCUSTUNING, metadata);
-        case CAM_INTF_PARM_SET_VFE_COMMAND:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_VFE_COMMAND, metadata);
-        case CAM_INTF_PARM_SET_PP_COMMAND:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_PP_COMMAND, metadata);
-        case CAM_INTF_PARM_MAX_DIMENSION:
-            return POINTER_OF_META(CAM_INTF_PARM_MAX_DIMENSION, metadata);
-        case CAM_INTF_PARM_RAW_DIMENSION:
-            return POINTER_OF_META(CAM_INTF_PARM_RAW_DIMENSION, metadata);
-        case CAM_INTF_PARM_TINTLESS:
-            return POINTER_OF_META(CAM_INTF_PARM_TINTLESS, metadata);
-        case CAM_INTF_PARM_WB_MANUAL:
-            return POINTER_OF_META(CAM_INTF_PARM_WB_MANUAL, metadata);
-        case CAM_INTF_PARM_EZTUNE_CMD:
-            return POINTER_OF_META(CAM_INTF_PARM_EZTUNE_CMD, metadata);
-        case CAM_INTF_PARM_INT_EVT:
-            return POINTER_OF_META(CAM_INTF_PARM_INT_EVT, metadata);
-        case CAM_INTF_PARM_RDI_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_RDI_MODE, metadata);
-        case CAM_INTF_PARM_BURST_NUM:
-            return POINTER_OF_META(CAM_INTF_PARM_BURST_NUM, metadata);
-        case CAM_INTF_PARM_RETRO_BURST_NUM:
-            return POINTER_OF_META(CAM_INTF_PARM_RETRO_BURST_NUM, metadata);
-        case CAM_INTF_PARM_BURST_LED_ON_PERIOD:
-            return POINTER_OF_META(CAM_INTF_PARM_BURST_LED_ON_PERIOD, metadata);
-        case CAM_INTF_PARM_LONGSHOT_ENABLE:
-            return POINTER_OF_META(CAM_INTF_PARM_LONGSHOT_ENABLE, metadata);
-        case CAM_INTF_META_STREAM_INFO:
-            return POINTER_OF_META(CAM_INTF_META_STREAM_INFO, metadata);
-        case CAM_INTF_META_AEC_MODE:
-            return POINTER_OF_META(CAM_INTF_META_AEC_MODE, metadata);
-        case CAM_INTF_META_AEC_PRECAPTURE_TRIGGER:
-            return POINTER_OF_META(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER, metadata);
-        case CAM_INTF_META_AF_TRIGGER:
-            return POINTER_OF_META(CAM_INTF_META_AF_TRIGGER, metadata);
-        case CAM_INTF_META_CAPTURE_INTENT:
-            return POINTER_OF_META(CAM_INTF_META_CAPTURE_INTENT, metadata);
-        case CAM_INTF_META_DEMOSAIC:
-            return POINTER_OF_META(CAM_INTF_META_DEMOSAIC, metadata);
-        case CAM_INTF_META_SHARPNESS_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_SHARPNESS_STRENGTH, metadata);
-        case CAM_INTF_META_GEOMETRIC_MODE:
-            return POINTER_OF_META(CAM_INTF_META_GEOMETRIC_MODE, metadata);
-        case CAM_INTF_META_GEOMETRIC_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_GEOMETRIC_STRENGTH, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP_MODE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata);
-        case CAM_INTF_META_SHADING_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_SHADING_STRENGTH, metadata);
-        case CAM_INTF_META_TONEMAP_MODE:
-            return POINTER_OF_META(CAM_INTF_META_TONEMAP_MODE, metadata);
-        case CAM_INTF_META_AWB_INFO:
-            return POINTER_OF_META(CAM_INTF_META_AWB_INFO, metadata);
-        case CAM_INTF_META_FOCUS_POSITION:
-            return POINTER_OF_META(CAM_INTF_META_FOCUS_POSITION, metadata);
-        case CAM_INTF_META_STREAM_ID:
-            return POINTER_OF_META(CAM_INTF_META_STREAM_ID, metadata);
-        case CAM_INTF_PARM_STATS_DEBUG_MASK:
-            return POINTER_OF_META(CAM_INTF_PARM_STATS_DEBUG_MASK, metadata);
-        case CAM_INTF_PARM_STATS_AF_PAAF:
-            return POINTER_OF_META(CAM_INTF_PARM_STATS_AF_PAAF, metadata);
-        case CAM_INTF_PARM_FOCUS_BRACKETING:
-            return POINTER_OF_META(CAM_INTF_PARM_FOCUS_BRACKETING, metadata);
-        case CAM_INTF_PARM_FLASH_BRACKETING:
-            return POINTER_OF_META(CAM_INTF_PARM_FLASH_BRACKETING, metadata);
-        case CAM_INTF_META_JPEG_GPS_COORDINATES:
-            return POINTER_OF_META(CAM_INTF_META_JPEG_GPS_COORDINATES, metadata);
-        case CAM_INTF_META_JPEG_GPS_PROC_METHODS:
-            return POINTER_OF_META(CAM_INTF_META_JPEG_GPS_PROC_METHODS, metadata);
-        case CAM_INTF_META_JPEG_GPS_TIMESTAMP:
-            return POINTER_OF_META(CAM_INTF_META_JPEG_GPS_TIMESTAMP, metadata);
-        case CAM_INTF_META_JPEG_ORIENTATION:
-            return POINTER_OF_META(CAM_INTF_META_JPEG_ORIENTATION, metadata);
-        case CAM_INTF_META_JPEG_QUALITY:
-            return POINTER_OF_META(CAM_INTF_META_JPEG_QUALITY, metadata);
-        case CAM_INTF_META_JPEG_THUMB_QUALITY:
-            return POINTER_OF_META(CAM_INTF_META_JPEG_THUMB_QUALITY, metadata);
-        case CAM_INTF_META_JPEG_THUMB_SIZE:
-            return POINTER_OF_META(CAM_INTF_META_JPEG_THUMB_SIZE, metadata);
-        case CAM_INTF_META_TEST_PATTERN_DATA:
-            return POINTER_OF_META(CAM_INTF_META_TEST_PATTERN_DATA, metadata);
-        case CAM_INTF_META_PROFILE_TONE_CURVE:
-            return POINTER_OF_META(CAM_INTF_META_PROFILE_TONE_CURVE, metadata);
-        case CAM_INTF_META_OTP_WB_GRGB:
-            return POINTER_OF_META(CAM_INTF_META_OTP_WB_GRGB, metadata);
-        case CAM_INTF_PARM_CAC:
-            return POINTER_OF_META(CAM_INTF_PARM_CAC, metadata);
-        case CAM_INTF_META_NEUTRAL_COL_POINT:
-            return POINTER_OF_META(CAM_INTF_META_NEUTRAL_COL_POINT, metadata);
-        case CAM_INTF_PARM_CDS_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_CDS_MODE, metadata);
-        case CAM_INTF_PARM_ROTATION:
-          return POINTER_OF_META(CAM_INTF_PARM_ROTATION, metadata);
-        case CAM_INTF_PARM_TONE_MAP_MODE:
-          return POINTER_OF_META(CAM_INTF_PARM_TONE_MAP_MODE, metadata);
-        case CAM_INTF_META_IMGLIB:
-          return POINTER_OF_META(CAM_INTF_META_IMGLIB, metadata);
-        default:
-            return NULL;
+    if ((NULL == metadata) || ((uint32_t)meta_id >= CAM_INTF_PARM_MAX) ||
+            (0 == g_cam_intf_meta_table[meta_id].size)) {
+        return NULL;
     }
+    return (uint8_t *)&metadata->data + g_cam_intf_meta_table[meta_id].offset;
 }
 
+/*===========================================================================
+ * FUNCTION   : get_size_of
+ *
+ * DESCRIPTION: get size of a parameter/metadata entry
+ *
+ * PARAMETERS :
+ *   @param_id : id of the entry
+ *
+ * RETURN     : size of the entry, 0 if the id has no entry
+ *==========================================================================*/
 uint32_t get_size_of(cam_intf_parm_type_t param_id)
 {
-    metadata_buffer_t* metadata = NULL;
-    switch(param_id) {
-        case CAM_INTF_META_HISTOGRAM:
-            return SIZE_OF_PARAM(CAM_INTF_META_HISTOGRAM, metadata);
-        case CAM_INTF_META_FACE_DETECTION:
-            return SIZE_OF_PARAM(CAM_INTF_META_FACE_DETECTION, metadata);
-        case CAM_INTF_META_AUTOFOCUS_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_AUTOFOCUS_DATA, metadata);
-        case CAM_INTF_PARM_UPDATE_DEBUG_LEVEL:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_UPDATE_DEBUG_LEVEL, metadata);
-        case CAM_INTF_META_CROP_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_CROP_DATA, metadata);
-        case CAM_INTF_META_PREP_SNAPSHOT_DONE:
-            return SIZE_OF_PARAM(CAM_INTF_META_PREP_SNAPSHOT_DONE, metadata);
-        case CAM_INTF_META_GOOD_FRAME_IDX_RANGE:
-            return SIZE_OF_PARAM(CAM_INTF_META_GOOD_FRAME_IDX_RANGE, metadata);
-        case CAM_INTF_META_ASD_HDR_SCENE_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_ASD_HDR_SCENE_DATA, metadata);
-        case CAM_INTF_META_ASD_SCENE_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_META_ASD_SCENE_TYPE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ISP:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_ISP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_PP:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_PP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AE:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_AE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AWB:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_AWB, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AF:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_AF, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ASD:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_ASD, metadata);
-        case CAM_INTF_BUF_DIVERT_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_BUF_DIVERT_INFO, metadata);
-        case CAM_INTF_META_FRAME_NUMBER_VALID:
-            return SIZE_OF_PARAM(CAM_INTF_META_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER_VALID:
-            return SIZE_OF_PARAM(CAM_INTF_META_URGENT_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_FRAME_DROPPED:
-            return SIZE_OF_PARAM(CAM_INTF_META_FRAME_DROPPED, metadata);
-        case CAM_INTF_META_FRAME_NUMBER:
-            return SIZE_OF_PARAM(CAM_INTF_META_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER:
-            return SIZE_OF_PARAM(CAM_INTF_META_URGENT_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_COLOR_CORRECT_MODE, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_TRANSFORM:
-            return SIZE_OF_PARAM(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_GAINS:
-            return SIZE_OF_PARAM(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM:
-            return SIZE_OF_PARAM(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_GAINS:
-            return SIZE_OF_PARAM(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_AEC_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_ROI, metadata);
-        case CAM_INTF_META_AEC_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_STATE, metadata);
-        case CAM_INTF_PARM_FOCUS_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FOCUS_MODE, metadata);
-        case CAM_INTF_PARM_MANUAL_FOCUS_POS:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_MANUAL_FOCUS_POS, metadata);
-        case CAM_INTF_META_AF_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_META_AF_ROI, metadata);
-        case CAM_INTF_META_AF_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AF_STATE, metadata);
-        case CAM_INTF_PARM_WHITE_BALANCE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_WHITE_BALANCE, metadata);
-        case CAM_INTF_META_AWB_REGIONS:
-            return SIZE_OF_PARAM(CAM_INTF_META_AWB_REGIONS, metadata);
-        case CAM_INTF_META_AWB_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AWB_STATE, metadata);
-        case CAM_INTF_META_BLACK_LEVEL_LOCK:
-            return SIZE_OF_PARAM(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata);
-        case CAM_INTF_META_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_MODE, metadata);
-        case CAM_INTF_META_EDGE_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_EDGE_MODE, metadata);
-        case CAM_INTF_META_FLASH_POWER:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_POWER, metadata);
-        case CAM_INTF_META_FLASH_FIRING_TIME:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_FIRING_TIME, metadata);
-        case CAM_INTF_META_FLASH_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_MODE, metadata);
-        case CAM_INTF_META_FLASH_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_STATE, metadata);
-        case CAM_INTF_META_HOTPIXEL_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_HOTPIXEL_MODE, metadata);
-        case CAM_INTF_META_LENS_APERTURE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_APERTURE, metadata);
-        case CAM_INTF_META_LENS_FILTERDENSITY:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FILTERDENSITY, metadata);
-        case CAM_INTF_META_LENS_FOCAL_LENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata);
-        case CAM_INTF_META_LENS_FOCUS_DISTANCE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FOCUS_DISTANCE, metadata);
-        case CAM_INTF_META_LENS_FOCUS_RANGE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FOCUS_RANGE, metadata);
-        case CAM_INTF_META_LENS_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_STATE, metadata);
-        case CAM_INTF_META_LENS_OPT_STAB_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata);
-        case CAM_INTF_META_SCALER_CROP_REGION:
-            return SIZE_OF_PARAM(CAM_INTF_META_SCALER_CROP_REGION, metadata);
-        case CAM_INTF_META_SCENE_FLICKER:
-            return SIZE_OF_PARAM(CAM_INTF_META_SCENE_FLICKER, metadata);
-        case CAM_INTF_META_SENSOR_EXPOSURE_TIME:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata);
-        case CAM_INTF_META_SENSOR_FRAME_DURATION:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata);
-        case CAM_INTF_META_SENSOR_SENSITIVITY:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_SENSITIVITY, metadata);
-        case CAM_INTF_META_SENSOR_TIMESTAMP:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_TIMESTAMP, metadata);
-        case CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW, metadata);
-        case CAM_INTF_META_SHADING_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_SHADING_MODE, metadata);
-        case CAM_INTF_META_STATS_FACEDETECT_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata);
-        case CAM_INTF_META_STATS_HISTOGRAM_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata);
-        case CAM_INTF_META_TONEMAP_CURVES:
-            return SIZE_OF_PARAM(CAM_INTF_META_TONEMAP_CURVES, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_SHADING_MAP, metadata);
-        case CAM_INTF_META_AEC_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_INFO, metadata);
-        case CAM_INTF_META_SENSOR_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_INFO, metadata);
-        case CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE, metadata);
-        case CAM_INTF_PARM_EFFECT:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EFFECT, metadata);
-        case CAM_INTF_META_PRIVATE_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_PRIVATE_DATA, metadata);
-        case CAM_INTF_PARM_HAL_VERSION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HAL_VERSION, metadata);
-        case CAM_INTF_PARM_ANTIBANDING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ANTIBANDING, metadata);
-        case CAM_INTF_PARM_EXPOSURE_COMPENSATION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata);
-        case CAM_INTF_PARM_EV_STEP:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EV_STEP, metadata);
-        case CAM_INTF_PARM_AEC_LOCK:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AEC_LOCK, metadata);
-        case CAM_INTF_PARM_FPS_RANGE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FPS_RANGE, metadata);
-        case CAM_INTF_PARM_AWB_LOCK:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AWB_LOCK, metadata);
-        case CAM_INTF_PARM_BESTSHOT_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BESTSHOT_MODE, metadata);
-        case CAM_INTF_PARM_DIS_ENABLE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_DIS_ENABLE, metadata);
-        case CAM_INTF_PARM_LED_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_LED_MODE, metadata);
-        case CAM_INTF_META_LED_MODE_OVERRIDE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LED_MODE_OVERRIDE, metadata);
-        case CAM_INTF_PARM_QUERY_FLASH4SNAP:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_QUERY_FLASH4SNAP, metadata);
-        case CAM_INTF_PARM_EXPOSURE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EXPOSURE, metadata);
-        case CAM_INTF_PARM_SHARPNESS:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SHARPNESS, metadata);
-        case CAM_INTF_PARM_CONTRAST:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_CONTRAST, metadata);
-        case CAM_INTF_PARM_SATURATION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SATURATION, metadata);
-        case CAM_INTF_PARM_BRIGHTNESS:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BRIGHTNESS, metadata);
-        case CAM_INTF_PARM_ISO:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ISO, metadata);
-        case CAM_INTF_PARM_EXPOSURE_TIME:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EXPOSURE_TIME, metadata);
-        case CAM_INTF_PARM_ZOOM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ZOOM, metadata);
-        case CAM_INTF_PARM_ROLLOFF:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ROLLOFF, metadata);
-        case CAM_INTF_PARM_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_MODE, metadata);
-        case CAM_INTF_PARM_AEC_ALGO_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AEC_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_FOCUS_ALGO_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FOCUS_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_AEC_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AEC_ROI, metadata);
-        case CAM_INTF_PARM_AF_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AF_ROI, metadata);
-        case CAM_INTF_PARM_SCE_FACTOR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SCE_FACTOR, metadata);
-        case CAM_INTF_PARM_FD:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FD, metadata);
-        case CAM_INTF_PARM_MCE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_MCE, metadata);
-        case CAM_INTF_PARM_HFR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HFR, metadata);
-        case CAM_INTF_PARM_REDEYE_REDUCTION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_REDEYE_REDUCTION, metadata);
-        case CAM_INTF_PARM_WAVELET_DENOISE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_WAVELET_DENOISE, metadata);
-        case CAM_INTF_PARM_TEMPORAL_DENOISE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_TEMPORAL_DENOISE, metadata);
-        case CAM_INTF_PARM_HISTOGRAM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HISTOGRAM, metadata);
-        case CAM_INTF_PARM_ASD_ENABLE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ASD_ENABLE, metadata);
-        case CAM_INTF_PARM_RECORDING_HINT:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RECORDING_HINT, metadata);
-        case CAM_INTF_PARM_HDR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HDR, metadata);
-        case CAM_INTF_PARM_FRAMESKIP:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FRAMESKIP, metadata);
-        case CAM_INTF_PARM_ZSL_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ZSL_MODE, metadata);
-        case CAM_INTF_PARM_HDR_NEED_1X:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HDR_NEED_1X, metadata);
-        case CAM_INTF_PARM_LOCK_CAF:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_LOCK_CAF, metadata);
-        case CAM_INTF_PARM_VIDEO_HDR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_VIDEO_HDR, metadata);
-        case CAM_INTF_PARM_VT:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_VT, metadata);
-        case CAM_INTF_PARM_GET_CHROMATIX:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_GET_CHROMATIX, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_CHROMATIX:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_RELOAD_CHROMATIX, metadata);
-        case CAM_INTF_PARM_GET_AFTUNE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_GET_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_AFTUNE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_RELOAD_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_AUTOFOCUSTUNING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_AUTOFOCUSTUNING, metadata);
-        case CAM_INTF_PARM_SET_VFE_COMMAND:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_VFE_COMMAND, metadata);
-        case CAM_INTF_PARM_SET_PP_COMMAND:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_PP_COMMAND, metadata);
-        case CAM_INTF_PARM_MAX_DIMENSION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_MAX_DIMENSION, metadata);
-        case CAM_INTF_PARM_RAW_DIMENSION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RAW_DIMENSION, metadata);
-        case CAM_INTF_PARM_TINTLESS:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_TINTLESS, metadata);
-        case CAM_INTF_PARM_WB_MANUAL:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_WB_MANUAL, metadata);
-        case CAM_INTF_PARM_EZTUNE_CMD:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EZTUNE_CMD, metadata);
-        case CAM_INTF_PARM_INT_EVT:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_INT_EVT, metadata);
-        case CAM_INTF_PARM_RDI_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RDI_MODE, metadata);
-        case CAM_INTF_PARM_BURST_NUM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BURST_NUM, metadata);
-        case CAM_INTF_PARM_RETRO_BURST_NUM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RETRO_BURST_NUM, metadata);
-        case CAM_INTF_PARM_BURST_LED_ON_PERIOD:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BURST_LED_ON_PERIOD, metadata);
-        case CAM_INTF_PARM_LONGSHOT_ENABLE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_LONGSHOT_ENABLE, metadata);
-        case CAM_INTF_META_STREAM_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_META_STREAM_INFO, metadata);
-        case CAM_INTF_META_AEC_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_MODE, metadata);
-        case CAM_INTF_META_AEC_PRECAPTURE_TRIGGER:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER, metadata);
-        case CAM_INTF_META_AF_TRIGGER:
-            return SIZE_OF_PARAM(CAM_INTF_META_AF_TRIGGER, metadata);
-        case CAM_INTF_META_CAPTURE_INTENT:
-            return SIZE_OF_PARAM(CAM_INTF_META_CAPTURE_INTENT, metadata);
-        case CAM_INTF_META_DEMOSAIC:
-            return SIZE_OF_PARAM(CAM_INTF_META_DEMOSAIC, metadata);
-        case CAM_INTF_META_SHARPNESS_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_SHARPNESS_STRENGTH, metadata);
-        case CAM_INTF_META_GEOMETRIC_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_GEOMETRIC_MODE, metadata);
-        case CAM_INTF_META_GEOMETRIC_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_GEOMETRIC_STRENGTH, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata);
-        case CAM_INTF_META_SHADING_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_SHADING_STRENGTH, metadata);
-        case CAM_INTF_META_TONEMAP_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_TONEMAP_MODE, metadata);
-        case CAM_INTF_META_AWB_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_META_AWB_INFO, metadata);
-        case CAM_INTF_META_FOCUS_POSITION:
-            return SIZE_OF_PARAM(CAM_INTF_META_FOCUS_POSITION, metadata);
-        case CAM_INTF_META_STREAM_ID:
-            return SIZE_OF_PARAM(CAM_INTF_META_STREAM_ID, metadata);
-        case CAM_INTF_PARM_STATS_DEBUG_MASK:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_STATS_DEBUG_MASK, metadata);
-        case CAM_INTF_PARM_STATS_AF_PAAF:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_STATS_AF_PAAF, metadata);
-        case CAM_INTF_PARM_FOCUS_BRACKETING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FOCUS_BRACKETING, metadata);
-        case CAM_INTF_PARM_FLASH_BRACKETING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FLASH_BRACKETING, metadata);
-        case CAM_INTF_META_JPEG_GPS_COORDINATES:
-            return SIZE_OF_PARAM(CAM_INTF_META_JPEG_GPS_COORDINATES, metadata);
-        case CAM_INTF_META_JPEG_GPS_PROC_METHODS:
-            return SIZE_OF_PARAM(CAM_INTF_META_JPEG_GPS_PROC_METHODS, metadata);
-        case CAM_INTF_META_JPEG_GPS_TIMESTAMP:
-            return SIZE_OF_PARAM(CAM_INTF_META_JPEG_GPS_TIMESTAMP, metadata);
-        case CAM_INTF_META_JPEG_ORIENTATION:
-            return SIZE_OF_PARAM(CAM_INTF_META_JPEG_ORIENTATION, metadata);
-        case CAM_INTF_META_JPEG_QUALITY:
-            return SIZE_OF_PARAM(CAM_INTF_META_JPEG_QUALITY, metadata);
-        case CAM_INTF_META_JPEG_THUMB_QUALITY:
-            return SIZE_OF_PARAM(CAM_INTF_META_JPEG_THUMB_QUALITY, metadata);
-        case CAM_INTF_META_JPEG_THUMB_SIZE:
-            return SIZE_OF_PARAM(CAM_INTF_META_JPEG_THUMB_SIZE, metadata);
-        case CAM_INTF_META_TEST_PATTERN_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_TEST_PATTERN_DATA, metadata);
-        case CAM_INTF_META_PROFILE_TONE_CURVE:
-            return SIZE_OF_PARAM(CAM_INTF_META_PROFILE_TONE_CURVE, metadata);
-        case CAM_INTF_META_OTP_WB_GRGB:
-            return SIZE_OF_PARAM(CAM_INTF_META_OTP_WB_GRGB, metadata);
-        case CAM_INTF_PARM_CAC:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_CAC, metadata);
-        case CAM_INTF_META_NEUTRAL_COL_POINT:
-            return SIZE_OF_PARAM(CAM_INTF_META_NEUTRAL_COL_POINT, metadata);
-        case CAM_INTF_PARM_CDS_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_CDS_MODE, metadata);
-        case CAM_INTF_PARM_ROTATION:
-          return SIZE_OF_PARAM(CAM_INTF_PARM_ROTATION, metadata);
-        case CAM_INTF_PARM_TONE_MAP_MODE:
-          return SIZE_OF_PARAM(CAM_INTF_PARM_TONE_MAP_MODE, metadata);
-        case CAM_INTF_META_IMGLIB:
-          return SIZE_OF_PARAM(CAM_INTF_META_IMGLIB, metadata);
-        default:
-            return 0;
+    if ((uint32_t)param_id >= CAM_INTF_PARM_MAX) {
+        return 0;
+    }
+    return g_cam_intf_meta_table[param_id].size;
+}
+
+/*===========================================================================
+ * FUNCTION   : get_metadata_valid_ids
+ *
+ * DESCRIPTION: build packed list of valid entry ids of a metadata buffer.
+ *              The valid table is read eight entries at a time. Absent
+ *              entries cost nothing beyond their share of a word load, so
+ *              the cost is CAM_INTF_PARM_MAX / 8 loads plus one step per
+ *              valid entry.
+ *
+ * PARAMETERS :
+ *   @meta    : metadata buffer
+ *   @ids     : output array of valid entry ids, in ascending order
+ *   @max_ids : size of ids array
+ *
+ * RETURN     : number of valid entries stored in ids
+ *==========================================================================*/
+uint32_t get_metadata_valid_ids(const metadata_buffer_t *meta,
+        uint32_t *ids, uint32_t max_ids)
+{
+    const uint8_t *valid = NULL;
+    uint64_t word = 0;
+    uint32_t cnt = 0;
+    uint32_t i = 0;
+    uint32_t b = 0;
+
+    if ((NULL == meta) || (NULL == ids)) {
+        return 0;
+    }
+
+    valid = meta->is_valid;
+    for (i = 0; ((i + sizeof(word)) <= CAM_INTF_PARM_MAX) && (cnt < max_ids);
+            i += (uint32_t)sizeof(word)) {
+        memcpy(&word, &valid[i], sizeof(word));
+        if (0 == word) {
+            continue;
+        }
+        if ((cnt + sizeof(word)) > max_ids) {
+            break;
+        }
+        /* branch free: the slot is always written, kept only if valid */
+        for (b = 0; b < sizeof(word); b++) {
+            ids[cnt] = i + b;
+            cnt += (0 != valid[i + b]);
+        }
+    }
+    for (; (i < CAM_INTF_PARM_MAX) && (cnt < max_ids); i++) {
+        if (valid[i]) {
+            ids[cnt++] = i;
+        }
+    }
+
+    return cnt;
+}
+
+/*===========================================================================
+ * FUNCTION   : copy_metadata_buffer
+ *
+ * DESCRIPTION: copy a metadata buffer, moving only the valid entries instead
+ *              of the whole metadata_data_t union
+ *
+ * PARAMETERS :
+ *   @dst     : destination metadata buffer
+ *   @src     : source metadata buffer
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t copy_metadata_buffer(metadata_buffer_t *dst,
+        const metadata_buffer_t *src)
+{
+    uint32_t ids[CAM_INTF_PARM_MAX];
+    uint32_t cnt, i, size;
+    void *p_src = NULL;
+    void *p_dst = NULL;
+
+    if ((NULL == dst) || (NULL == src)) {
+        return -1;
+    }
+    if (dst == src) {
+        return 0;
     }
+
+    cnt = get_metadata_valid_ids(src, ids, CAM_INTF_PARM_MAX);
+    memcpy(dst->is_valid, src->is_valid, sizeof(dst->is_valid));
+    for (i = 0; i < cnt; i++) {
+        size = get_size_of((cam_intf_parm_type_t)ids[i]);
+        p_src = get_pointer_of((cam_intf_parm_type_t)ids[i], src);
+        p_dst = get_pointer_of((cam_intf_parm_type_t)ids[i], dst);
+        if ((0 == size) || (NULL == p_src) || (NULL == p_dst)) {
+            /* entry without lookup, fall back to copying all data */
+            memcpy(&dst->data, &src->data, sizeof(dst->data));
+            break;
+        }
+        memcpy(p_dst, p_src, size);
+    }
+
+    dst->is_tuning_params_valid = src->is_tuning_params_valid;
+    if (src->is_tuning_params_valid) {
+        dst->tuning_params = src->tuning_params;
+    }
+    dst->is_mobicat_aec_params_valid = src->is_mobicat_aec_params_valid;
+    if (src->is_mobicat_aec_params_valid) {
+        dst->mobicat_aec_params = src->mobicat_aec_params;
+    }
+    dst->is_statsdebug_ae_params_valid = src->is_statsdebug_ae_params_valid;
+    if (src->is_statsdebug_ae_params_valid) {
+        dst->statsdebug_ae_data = src->statsdebug_ae_data;
+    }
+    dst->is_statsdebug_awb_params_valid = src->is_statsdebug_awb_params_valid;
+    if (src->is_statsdebug_awb_params_valid) {
+        dst->statsdebug_awb_data = src->statsdebug_awb_data;
+    }
+    dst->is_statsdebug_af_params_valid = src->is_statsdebug_af_params_valid;
+    if (src->is_statsdebug_af_params_valid) {
+        dst->statsdebug_af_data = src->statsdebug_af_data;
+    }
+    dst->is_statsdebug_asd_params_valid = src->is_statsdebug_asd_params_valid;
+    if (src->is_statsdebug_asd_params_valid) {
+        dst->statsdebug_asd_data = src->statsdebug_asd_data;
+    }
+    dst->is_statsdebug_stats_params_valid = src->is_statsdebug_stats_params_valid;
+    if (src->is_statsdebug_stats_params_valid) {
+        dst->statsdebug_stats_buffer_data = src->statsdebug_stats_buffer_data;
+    }
+
     return 0;
 }
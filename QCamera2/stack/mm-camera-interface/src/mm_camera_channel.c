@@ -2004,6 +2004,10 @@ int32_t mm_channel_unmap_stream_buf(mm_channel_t *my_obj,
  *==========================================================================*/
 int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t * queue)
 {
+    cam_list_init(&queue->unmatched_list);
+    queue->unmatched_cnt = 0;
+    queue->frame_map_overflow = 0;
+    memset(queue->frame_map, 0, sizeof(queue->frame_map));
     return cam_queue_init(&queue->que);
 }
 
@@ -2021,7 +2025,12 @@ int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t * queue)
  *==========================================================================*/
 int32_t mm_channel_superbuf_queue_deinit(mm_channel_queue_t * queue)
 {
-    return cam_queue_deinit(&queue->que);
+    int32_t rc = cam_queue_deinit(&queue->que);
+    cam_list_init(&queue->unmatched_list);
+    queue->unmatched_cnt = 0;
+    queue->frame_map_overflow = 0;
+    memset(queue->frame_map, 0, sizeof(queue->frame_map));
+    return rc;
 }
 
 /*===========================================================================
@@ -2042,11 +2051,13 @@ int8_t mm_channel_util_seq_comp_w_rollover(uint32_t v1,
                                            uint32_t v2)
 {
     int8_t ret = 0;
+    /* serial number arithmetic: distance modulo 2^32 interpreted as signed,
+     * valid as long as v1 and v2 are less than 2^31 apart */
+    int32_t diff = (int32_t)(v1 - v2);
 
-    /* TODO: need to handle the case if v2 roll over to 0 */
-    if (v1 > v2) {
+    if (diff > 0) {
         ret = 1;
-    } else if (v1 < v2) {
+    } else if (diff < 0) {
         ret = -1;
     }
 
@@ -2083,6 +2094,8 @@ int32_t mm_channel_handle_metadata(
     cam_frame_idx_range_t good_frame_idx_range;
     uint8_t is_crop_1x_found = 0;
     uint32_t snapshot_stream_id = 0;
+    uint32_t valid_ids[CAM_INTF_PARM_MAX];
+    uint32_t num_valid, k;
     uint32_t i;
     /* Set expected frame id to a future frame idx, large enough to wait
     * for good_frame_idx_range, and small enough to still capture an image */
@@ -2116,52 +2129,69 @@ int32_t mm_channel_handle_metadata(
         }
         CDBG("%s: E , expected frame id: %d", __func__, queue->expected_frame_id);
 
-        IF_META_AVAILABLE(const int32_t, p_prep_snapshot_done_state,
-                CAM_INTF_META_PREP_SNAPSHOT_DONE, metadata) {
-            prep_snapshot_done_state = *p_prep_snapshot_done_state;
-            is_prep_snapshot_done_valid = 1;
-            CDBG("%s: prepare snapshot done valid ", __func__);
-        }
-        IF_META_AVAILABLE(const cam_frame_idx_range_t, p_good_frame_idx_range,
-                CAM_INTF_META_GOOD_FRAME_IDX_RANGE, metadata) {
-            good_frame_idx_range = *p_good_frame_idx_range;
-            is_good_frame_idx_range_valid = 1;
-            CDBG("%s: good_frame_idx_range : min: %d, max: %d , num frames = %d",
-                __func__, good_frame_idx_range.min_frame_idx,
-                good_frame_idx_range.max_frame_idx, good_frame_idx_range.num_led_on_frames);
-        }
-        IF_META_AVAILABLE(const cam_crop_data_t, p_crop_data,
-                CAM_INTF_META_CROP_DATA, metadata) {
-            cam_crop_data_t crop_data = *p_crop_data;
-
-            for (i = 0; i < ARRAY_SIZE(ch_obj->streams); i++) {
-                if (MM_STREAM_STATE_NOTUSED == ch_obj->streams[i].state) {
-                    continue;
-                }
-                if (CAM_STREAM_TYPE_SNAPSHOT ==
-                    ch_obj->streams[i].stream_info->stream_type) {
-                    snapshot_stream_id = ch_obj->streams[i].server_stream_id;
-                    break;
-                }
+        /* visit only the entries present in this frame */
+        num_valid = get_metadata_valid_ids(metadata, valid_ids,
+                CAM_INTF_PARM_MAX);
+        for (k = 0; k < num_valid; k++) {
+            switch (valid_ids[k]) {
+            case CAM_INTF_META_PREP_SNAPSHOT_DONE: {
+                const int32_t *p_prep_snapshot_done_state =
+                        POINTER_OF_META(CAM_INTF_META_PREP_SNAPSHOT_DONE, metadata);
+                prep_snapshot_done_state = *p_prep_snapshot_done_state;
+                is_prep_snapshot_done_valid = 1;
+                CDBG("%s: prepare snapshot done valid ", __func__);
             }
-
-            for (i=0; i<crop_data.num_of_streams; i++) {
-                if (snapshot_stream_id == crop_data.crop_info[i].stream_id) {
-                    if (!crop_data.crop_info[i].crop.left &&
-                            !crop_data.crop_info[i].crop.top) {
-                        is_crop_1x_found = 1;
+                break;
+            case CAM_INTF_META_GOOD_FRAME_IDX_RANGE: {
+                const cam_frame_idx_range_t *p_good_frame_idx_range =
+                        POINTER_OF_META(CAM_INTF_META_GOOD_FRAME_IDX_RANGE, metadata);
+                good_frame_idx_range = *p_good_frame_idx_range;
+                is_good_frame_idx_range_valid = 1;
+                CDBG("%s: good_frame_idx_range : min: %d, max: %d , num frames = %d",
+                    __func__, good_frame_idx_range.min_frame_idx,
+                    good_frame_idx_range.max_frame_idx, good_frame_idx_range.num_led_on_frames);
+            }
+                break;
+            case CAM_INTF_META_CROP_DATA: {
+                const cam_crop_data_t *p_crop_data =
+                        POINTER_OF_META(CAM_INTF_META_CROP_DATA, metadata);
+                cam_crop_data_t crop_data = *p_crop_data;
+
+                for (i = 0; i < ARRAY_SIZE(ch_obj->streams); i++) {
+                    if (MM_STREAM_STATE_NOTUSED == ch_obj->streams[i].state) {
+                        continue;
+                    }
+                    if (CAM_STREAM_TYPE_SNAPSHOT ==
+                        ch_obj->streams[i].stream_info->stream_type) {
+                        snapshot_stream_id = ch_obj->streams[i].server_stream_id;
                         break;
                     }
                 }
-            }
-        }
 
-        IF_META_AVAILABLE(const cam_buf_divert_info_t, divert_info,
-                CAM_INTF_BUF_DIVERT_INFO, metadata) {
-            if (divert_info->frame_id >= buf_info->frame_idx) {
-                ch_obj->diverted_frame_id = divert_info->frame_id;
-            } else {
-                ch_obj->diverted_frame_id = 0;
+                for (i=0; i<crop_data.num_of_streams; i++) {
+                    if (snapshot_stream_id == crop_data.crop_info[i].stream_id) {
+                        if (!crop_data.crop_info[i].crop.left &&
+                                !crop_data.crop_info[i].crop.top) {
+                            is_crop_1x_found = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+                break;
+            case CAM_INTF_BUF_DIVERT_INFO: {
+                const cam_buf_divert_info_t *divert_info =
+                        POINTER_OF_META(CAM_INTF_BUF_DIVERT_INFO, metadata);
+                if (mm_channel_util_seq_comp_w_rollover(divert_info->frame_id,
+                        buf_info->frame_idx) >= 0) {
+                    ch_obj->diverted_frame_id = divert_info->frame_id;
+                } else {
+                    ch_obj->diverted_frame_id = 0;
+                }
+            }
+                break;
+            default:
+                break;
             }
         }
 
@@ -2193,7 +2223,8 @@ int32_t mm_channel_handle_metadata(
             }
         }
         if (is_good_frame_idx_range_valid) {
-            if (good_frame_idx_range.min_frame_idx > queue->expected_frame_id) {
+            if (mm_channel_util_seq_comp_w_rollover(good_frame_idx_range.min_frame_idx,
+                    queue->expected_frame_id) > 0) {
                 CDBG_HIGH("%s: [ZSL Retro] min_frame_idx %d is greater than expected_frame_id %d",
                         __func__, good_frame_idx_range.min_frame_idx, queue->expected_frame_id);
             }
@@ -2234,8 +2265,8 @@ int32_t mm_channel_handle_metadata(
                 good_frame_idx_range.max_frame_idx;
 
         } else if (is_good_frame_idx_range_valid) {
-            if (good_frame_idx_range.min_frame_idx >
-                queue->expected_frame_id) {
+            if (mm_channel_util_seq_comp_w_rollover(good_frame_idx_range.min_frame_idx,
+                queue->expected_frame_id) > 0) {
                 CDBG_HIGH("%s: min_frame_idx %d is greater than expected_frame_id %d",
                         __func__, good_frame_idx_range.min_frame_idx,
                         queue->expected_frame_id);
@@ -2263,7 +2294,8 @@ int32_t mm_channel_handle_metadata(
             && !ch_obj->isFlashBracketingEnabled
             && (MM_CHANNEL_BRACKETING_STATE_OFF == ch_obj->bracketingState)
             && ch_obj->frame_config == NULL) {
-            if((buf_info->frame_idx >= queue->led_off_start_frame_id)
+            if((mm_channel_util_seq_comp_w_rollover(buf_info->frame_idx,
+                    queue->led_off_start_frame_id) >= 0)
                     &&  !queue->once) {
                 CDBG("%s: [ZSL Retro]Burst snap num = %d ",
                         __func__, ch_obj->burstSnapNum);
@@ -2282,6 +2314,133 @@ end:
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_track_unmatched
+ *
+ * DESCRIPTION: add an unmatched superbuf to the unmatched list and frame map
+ *              of the superbuf queue. Queue lock must be held.
+ *
+ * PARAMETERS :
+ *   @queue   : superbuf queue
+ *   @super_buf : unmatched superbuf
+ *   @next_buf  : unmatched superbuf to insert before, NULL to append
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_channel_superbuf_track_unmatched(mm_channel_queue_t *queue,
+        mm_channel_queue_node_t *super_buf,
+        mm_channel_queue_node_t *next_buf)
+{
+    uint32_t slot = super_buf->frame_idx & (MM_CHANNEL_FRAME_MAP_SIZE - 1);
+
+    if (NULL != next_buf) {
+        cam_list_insert_before_node(&super_buf->unmatched, &next_buf->unmatched);
+    } else {
+        cam_list_add_tail_node(&super_buf->unmatched, &queue->unmatched_list);
+    }
+    queue->unmatched_cnt++;
+
+    if (NULL == queue->frame_map[slot]) {
+        queue->frame_map[slot] = super_buf;
+    } else {
+        queue->frame_map_overflow++;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_untrack_unmatched
+ *
+ * DESCRIPTION: remove a superbuf from the unmatched list and frame map once
+ *              it is matched or released. Queue lock must be held.
+ *
+ * PARAMETERS :
+ *   @queue   : superbuf queue
+ *   @super_buf : superbuf previously tracked as unmatched
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_channel_superbuf_untrack_unmatched(mm_channel_queue_t *queue,
+        mm_channel_queue_node_t *super_buf)
+{
+    uint32_t slot = super_buf->frame_idx & (MM_CHANNEL_FRAME_MAP_SIZE - 1);
+
+    cam_list_del_node(&super_buf->unmatched);
+    queue->unmatched_cnt--;
+
+    if (queue->frame_map[slot] == super_buf) {
+        queue->frame_map[slot] = NULL;
+    } else {
+        queue->frame_map_overflow--;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_find_unmatched
+ *
+ * DESCRIPTION: look up unmatched superbuf by frame idx. Resolved by the frame
+ *              map, the unmatched list is only walked after a map collision.
+ *
+ * PARAMETERS :
+ *   @queue   : superbuf queue
+ *   @frame_idx : frame idx to look for
+ *
+ * RETURN     : ptr to unmatched superbuf, NULL if not found
+ *==========================================================================*/
+static mm_channel_queue_node_t *mm_channel_superbuf_find_unmatched(
+        mm_channel_queue_t *queue, uint32_t frame_idx)
+{
+    uint32_t slot = frame_idx & (MM_CHANNEL_FRAME_MAP_SIZE - 1);
+    mm_channel_queue_node_t *super_buf = queue->frame_map[slot];
+    struct cam_list *pos = NULL;
+
+    if ((NULL != super_buf) && (super_buf->frame_idx == frame_idx)) {
+        return super_buf;
+    }
+    if (0 == queue->frame_map_overflow) {
+        return NULL;
+    }
+
+    for (pos = queue->unmatched_list.next; pos != &queue->unmatched_list;
+            pos = pos->next) {
+        super_buf = member_of(pos, mm_channel_queue_node_t, unmatched);
+        if (super_buf->frame_idx == frame_idx) {
+            return super_buf;
+        }
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_release_unmatched
+ *
+ * DESCRIPTION: bufdone and remove an unmatched superbuf from the superbuf
+ *              queue. Queue lock must be held.
+ *
+ * PARAMETERS :
+ *   @ch_obj  : channel object
+ *   @queue   : superbuf queue
+ *   @super_buf : unmatched superbuf to be released
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_channel_superbuf_release_unmatched(mm_channel_t *ch_obj,
+        mm_channel_queue_t *queue, mm_channel_queue_node_t *super_buf)
+{
+    uint8_t i;
+    cam_node_t *node = super_buf->q_node;
+
+    mm_channel_superbuf_untrack_unmatched(queue, super_buf);
+    for (i = 0; i < super_buf->num_of_bufs; i++) {
+        if (super_buf->super_buf[i].frame_idx != 0) {
+            mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
+        }
+    }
+    queue->que.size--;
+    cam_list_del_node(&node->list);
+    free(node);
+    free(super_buf);
+}
+
 /*===========================================================================
  * FUNCTION   : mm_channel_superbuf_comp_and_enqueue
  *
@@ -2301,12 +2460,11 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                         mm_channel_queue_t *queue,
                         mm_camera_buf_info_t *buf_info)
 {
-    cam_node_t* node = NULL;
-    struct cam_list *head = NULL;
     struct cam_list *pos = NULL;
     mm_channel_queue_node_t* super_buf = NULL;
-    uint8_t buf_s_idx, i, found_super_buf, unmatched_bundles;
-    struct cam_list *last_buf, *insert_before_buf, *last_buf_ptr;
+    mm_channel_queue_node_t* oldest_buf = NULL;
+    mm_channel_queue_node_t* next_buf = NULL;
+    uint8_t buf_s_idx, i, is_meta;
 
     CDBG("%s: E", __func__);
 
@@ -2338,9 +2496,11 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
         return 0;
     }
 
+    is_meta = (buf_info->buf->stream_type == CAM_STREAM_TYPE_METADATA);
     if((queue->nomatch_frame_id != 0)
-            && (queue->nomatch_frame_id > buf_info->frame_idx)
-            && (buf_info->buf->stream_type == CAM_STREAM_TYPE_METADATA)) {
+            && (mm_channel_util_seq_comp_w_rollover(queue->nomatch_frame_id,
+                    buf_info->frame_idx) > 0)
+            && is_meta) {
         /*Incoming metadata is older than expected*/
         mm_channel_qbuf(ch_obj, buf_info->buf);
         return 0;
@@ -2348,60 +2508,53 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
 
     /* comp */
     pthread_mutex_lock(&queue->que.lock);
-    head = &queue->que.head.list;
-    /* get the last one in the queue which is possibly having no matching */
-    pos = head->next;
-
-    found_super_buf = 0;
-    unmatched_bundles = 0;
-    last_buf = NULL;
-    insert_before_buf = NULL;
-    last_buf_ptr = NULL;
-
-    while (pos != head) {
-        node = member_of(pos, cam_node_t, list);
-        super_buf = (mm_channel_queue_node_t*)node->data;
 
-        if (NULL != super_buf) {
-            if (super_buf->matched) {
-                /* find a matched super buf, move to next one */
-                pos = pos->next;
-                continue;
-            } else if ( buf_info->frame_idx == super_buf->frame_idx
+    if (((queue->nomatch_frame_id != 0) && is_meta) ||
+            ((queue->attr.priority == MM_CAMERA_SUPER_BUF_PRIORITY_LOW) && !is_meta)) {
+        /* Relaxed matching: besides exact frame idx, a superbuf still
+         * missing this stream can be picked. Walk unmatched superbufs only. */
+        for (pos = queue->unmatched_list.next; pos != &queue->unmatched_list;
+                pos = pos->next) {
+            super_buf = member_of(pos, mm_channel_queue_node_t, unmatched);
+            if ( buf_info->frame_idx == super_buf->frame_idx
                     /*Pick metadata greater than available frameID*/
                     || ((queue->nomatch_frame_id != 0)
-                    && (queue->nomatch_frame_id <= buf_info->frame_idx)
+                    && (mm_channel_util_seq_comp_w_rollover(queue->nomatch_frame_id,
+                            buf_info->frame_idx) <= 0)
                     && (super_buf->super_buf[buf_s_idx].frame_idx == 0)
-                    && (buf_info->buf->stream_type == CAM_STREAM_TYPE_METADATA))
+                    && is_meta)
                     /*Pick available metadata closest to frameID*/
                     || ((queue->attr.priority == MM_CAMERA_SUPER_BUF_PRIORITY_LOW)
-                    && (buf_info->buf->stream_type != CAM_STREAM_TYPE_METADATA)
+                    && !is_meta
                     && (super_buf->super_buf[buf_s_idx].frame_idx == 0)
-                    && (super_buf->frame_idx > buf_info->frame_idx))){
-                /*super buffer frame IDs matching OR In low priority bundling
-                metadata frameID greater than avialbale super buffer frameID  OR
-                metadata frame closest to incoming frameID will be bundled*/
-                found_super_buf = 1;
-                queue->nomatch_frame_id = 0;
+                    && (mm_channel_util_seq_comp_w_rollover(super_buf->frame_idx,
+                            buf_info->frame_idx) > 0))){
                 break;
-            } else {
-                unmatched_bundles++;
-                if ( NULL == last_buf ) {
-                    if ( super_buf->frame_idx < buf_info->frame_idx ) {
-                        last_buf = pos;
-                    }
-                }
-                if ( NULL == insert_before_buf ) {
-                    if ( super_buf->frame_idx > buf_info->frame_idx ) {
-                        insert_before_buf = pos;
-                    }
-                }
-                pos = pos->next;
             }
         }
+        if (pos == &queue->unmatched_list) {
+            super_buf = NULL;
+        }
+    } else {
+        super_buf = mm_channel_superbuf_find_unmatched(queue, buf_info->frame_idx);
     }
 
-    if ( found_super_buf ) {
+    /* oldest unmatched superbuf, if older than incoming frame */
+    if (queue->unmatched_list.next != &queue->unmatched_list) {
+        oldest_buf = member_of(queue->unmatched_list.next,
+                mm_channel_queue_node_t, unmatched);
+        if ((oldest_buf == super_buf) ||
+                (mm_channel_util_seq_comp_w_rollover(oldest_buf->frame_idx,
+                        buf_info->frame_idx) >= 0)) {
+            oldest_buf = NULL;
+        }
+    }
+
+    if (NULL != super_buf) {
+        /*super buffer frame IDs matching OR In low priority bundling
+        metadata frameID greater than avialbale super buffer frameID  OR
+        metadata frame closest to incoming frameID will be bundled*/
+        queue->nomatch_frame_id = 0;
 
         if(super_buf->super_buf[buf_s_idx].frame_idx != 0) {
             //This can cause frame drop. We are overwriting same memory.
@@ -2428,8 +2581,8 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
             if(ch_obj->isFlashBracketingEnabled) {
                queue->expected_frame_id =
                    queue->expected_frame_id_without_led;
-               if (buf_info->frame_idx >=
-                       queue->expected_frame_id_without_led) {
+               if (mm_channel_util_seq_comp_w_rollover(buf_info->frame_idx,
+                       queue->expected_frame_id_without_led) >= 0) {
                    ch_obj->isFlashBracketingEnabled = FALSE;
                }
             } else {
@@ -2446,27 +2599,15 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
             queue->match_cnt++;
 
             /* Any older unmatched buffer need to be released */
-            if ( last_buf ) {
-                while ( last_buf != pos ) {
-                    node = member_of(last_buf, cam_node_t, list);
-                    super_buf = (mm_channel_queue_node_t*)node->data;
-                    if (NULL != super_buf) {
-                        for (i=0; i<super_buf->num_of_bufs; i++) {
-                            if (super_buf->super_buf[i].frame_idx != 0) {
-                                mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
-                            }
-                        }
-                        queue->que.size--;
-                        last_buf = last_buf->next;
-                        cam_list_del_node(&node->list);
-                        free(node);
-                        free(super_buf);
-                    } else {
-                        CDBG_ERROR(" %s : Invalid superbuf in queue!", __func__);
-                        break;
-                    }
+            if (NULL != oldest_buf) {
+                pos = queue->unmatched_list.next;
+                while (pos != &super_buf->unmatched) {
+                    oldest_buf = member_of(pos, mm_channel_queue_node_t, unmatched);
+                    pos = pos->next;
+                    mm_channel_superbuf_release_unmatched(ch_obj, queue, oldest_buf);
                 }
             }
+            mm_channel_superbuf_untrack_unmatched(queue, super_buf);
         }else {
             if (ch_obj->diverted_frame_id == buf_info->frame_idx) {
                 super_buf->expected = TRUE;
@@ -2474,46 +2615,45 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
             }
         }
     } else {
-        if ((queue->attr.max_unmatched_frames < unmatched_bundles)
-                && ( NULL == last_buf )) {
+        /* first unmatched superbuf newer than incoming frame, walked from
+         * the newest end since incoming frames are usually the latest */
+        for (pos = queue->unmatched_list.prev; pos != &queue->unmatched_list;
+                pos = pos->prev) {
+            super_buf = member_of(pos, mm_channel_queue_node_t, unmatched);
+            if (mm_channel_util_seq_comp_w_rollover(super_buf->frame_idx,
+                    buf_info->frame_idx) <= 0) {
+                break;
+            }
+            next_buf = super_buf;
+        }
+
+        if ((queue->attr.max_unmatched_frames < queue->unmatched_cnt)
+                && ( NULL == oldest_buf )) {
             /* incoming frame is older than the last bundled one */
             mm_channel_qbuf(ch_obj, buf_info->buf);
         } else {
-            last_buf_ptr = last_buf;
-
             /* Loop to remove unmatched frames */
-            while ((queue->attr.max_unmatched_frames < unmatched_bundles)
-                    && (last_buf_ptr != NULL && last_buf_ptr != pos)) {
-                node = member_of(last_buf_ptr, cam_node_t, list);
-                super_buf = (mm_channel_queue_node_t*)node->data;
-                if (NULL != super_buf && super_buf->expected == FALSE
-                        && (&node->list != insert_before_buf)) {
-                    for (i=0; i<super_buf->num_of_bufs; i++) {
-                        if (super_buf->super_buf[i].frame_idx != 0) {
-                            mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
-                        }
-                    }
-                    queue->que.size--;
-                    cam_list_del_node(&node->list);
-                    free(node);
-                    free(super_buf);
-                    unmatched_bundles--;
+            pos = queue->unmatched_list.next;
+            while ((queue->attr.max_unmatched_frames < queue->unmatched_cnt)
+                    && (pos != &queue->unmatched_list)) {
+                super_buf = member_of(pos, mm_channel_queue_node_t, unmatched);
+                pos = pos->next;
+                if (super_buf->expected == FALSE && super_buf != next_buf) {
+                    mm_channel_superbuf_release_unmatched(ch_obj, queue, super_buf);
                 }
-                last_buf_ptr = last_buf_ptr->next;
             }
 
-            if (queue->attr.max_unmatched_frames < unmatched_bundles) {
-                node = member_of(last_buf, cam_node_t, list);
-                super_buf = (mm_channel_queue_node_t*)node->data;
-                for (i=0; i<super_buf->num_of_bufs; i++) {
-                    if (super_buf->super_buf[i].frame_idx != 0) {
-                        mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
-                    }
+            if (queue->attr.max_unmatched_frames < queue->unmatched_cnt) {
+                super_buf = member_of(queue->unmatched_list.next,
+                        mm_channel_queue_node_t, unmatched);
+                if (super_buf == next_buf) {
+                    /* keep frame_idx order: the new frame goes before the
+                     * successor of the released one, not at the tail */
+                    next_buf = (super_buf->unmatched.next != &queue->unmatched_list) ?
+                            member_of(super_buf->unmatched.next,
+                                    mm_channel_queue_node_t, unmatched) : NULL;
                 }
-                queue->que.size--;
-                cam_list_del_node(&node->list);
-                free(node);
-                free(super_buf);
+                mm_channel_superbuf_release_unmatched(ch_obj, queue, super_buf);
             }
 
             /* insert the new frame at the appropriate position. */
@@ -2527,6 +2667,7 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                 memset(new_buf, 0, sizeof(mm_channel_queue_node_t));
                 memset(new_node, 0, sizeof(cam_node_t));
                 new_node->data = (void *)new_buf;
+                new_buf->q_node = new_node;
                 new_buf->num_of_bufs = queue->num_streams;
                 new_buf->super_buf[buf_s_idx] = *buf_info;
                 new_buf->frame_idx = buf_info->frame_idx;
@@ -2537,8 +2678,9 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                 }
 
                 /* enqueue */
-                if ( insert_before_buf ) {
-                    cam_list_insert_before_node(&new_node->list, insert_before_buf);
+                if ( next_buf ) {
+                    cam_list_insert_before_node(&new_node->list,
+                            &next_buf->q_node->list);
                 } else {
                     cam_list_add_tail_node(&new_node->list, &queue->que.head.list);
                 }
@@ -2549,10 +2691,12 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                     new_buf->expected = FALSE;
                     queue->expected_frame_id = buf_info->frame_idx + queue->attr.post_frame_skip;
                     queue->match_cnt++;
+                } else {
+                    mm_channel_superbuf_track_unmatched(queue, new_buf, next_buf);
                 }
 
                 if ((queue->attr.priority == MM_CAMERA_SUPER_BUF_PRIORITY_LOW)
-                        && (buf_info->buf->stream_type != CAM_STREAM_TYPE_METADATA)) {
+                        && !is_meta) {
                     CDBG_ERROR ("%s : No metadata matching for frame = %d",
                             __func__, buf_info->frame_idx);
                     queue->nomatch_frame_id = buf_info->frame_idx;
@@ -2614,6 +2758,8 @@ mm_channel_queue_node_t* mm_channel_superbuf_dequeue_internal(mm_channel_queue_t
             queue->que.size--;
             if (super_buf->matched == TRUE) {
                 queue->match_cnt--;
+            } else {
+                mm_channel_superbuf_untrack_unmatched(queue, super_buf);
             }
             free(node);
         }
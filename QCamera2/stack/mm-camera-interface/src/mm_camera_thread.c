@@ -34,18 +34,22 @@
 #include <sys/stat.h>
 #include <sys/prctl.h>
 #include <fcntl.h>
-#include <poll.h>
+#include <sys/epoll.h>
 #include <cam_semaphore.h>
 
 #include "mm_camera_dbg.h"
 #include "mm_camera_interface.h"
 #include "mm_camera.h"
 
+/* epoll user data of the command pipe, stream entries use their index */
+#define MM_CAMERA_POLL_PIPE_IDX   0xFFFFFFFF
+#define MM_CAMERA_POLL_EVENTS     (EPOLLIN | EPOLLRDNORM | EPOLLPRI)
+/* max events drained per wake up: all entries plus the command pipe */
+#define MM_CAMERA_POLL_MAX_EVENTS (MAX_STREAM_NUM_IN_BUNDLE + 1)
+
 typedef enum {
     /* poll entries updated */
     MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED,
-    /* poll entries updated asynchronous */
-    MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC,
     /* commit updates */
     MM_CAMERA_PIPE_CMD_COMMIT,
     /* exit */
@@ -66,52 +70,6 @@ typedef struct {
 } mm_camera_sig_evt_t;
 
 
-/*===========================================================================
- * FUNCTION   : mm_camera_poll_sig_async
- *
- * DESCRIPTION: Asynchoronous call to send a command through pipe.
- *
- * PARAMETERS :
- *   @poll_cb      : ptr to poll thread object
- *   @cmd          : command to be sent
- *
- * RETURN     : int32_t type of status
- *              0  -- success
- *              -1 -- failure
- *==========================================================================*/
-static int32_t mm_camera_poll_sig_async(mm_camera_poll_thread_t *poll_cb,
-                                  uint32_t cmd)
-{
-    /* send through pipe */
-    /* get the mutex */
-    mm_camera_sig_evt_t cmd_evt;
-
-    CDBG("%s: E cmd = %d", __func__,cmd);
-    memset(&cmd_evt, 0, sizeof(cmd_evt));
-    cmd_evt.cmd = cmd;
-    pthread_mutex_lock(&poll_cb->mutex);
-    /* reset the statue to false */
-    poll_cb->status = FALSE;
-
-    /* send cmd to worker */
-    ssize_t len = write(poll_cb->pfds[1], &cmd_evt, sizeof(cmd_evt));
-    if (len < 1) {
-        CDBG_ERROR("%s: len = %lld, errno = %d", __func__,
-                (long long int)len, errno);
-        /* Avoid waiting for the signal */
-        pthread_mutex_unlock(&poll_cb->mutex);
-        return 0;
-    }
-    CDBG("%s: begin IN mutex write done, len = %lld", __func__,
-            (long long int)len);
-    pthread_mutex_unlock(&poll_cb->mutex);
-    CDBG("%s: X", __func__);
-    return 0;
-}
-
-
-
-
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_sig
  *
@@ -197,6 +155,43 @@ static void mm_camera_poll_set_state(mm_camera_poll_thread_t *poll_cb,
     poll_cb->state = state;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_ctl
+ *
+ * DESCRIPTION: add/modify/remove a fd in the epoll set of the poll thread.
+ *              The epoll set can be updated from any thread, also while the
+ *              poll thread is waiting on it.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *   @op      : EPOLL_CTL_ADD/EPOLL_CTL_MOD/EPOLL_CTL_DEL
+ *   @fd      : file descriptor
+ *   @handler : handler of the poll entry owning the fd
+ *   @idx     : index of the poll entry, or MM_CAMERA_POLL_PIPE_IDX
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+static int32_t mm_camera_poll_ctl(mm_camera_poll_thread_t *poll_cb,
+                                  int op,
+                                  int32_t fd,
+                                  uint32_t handler,
+                                  uint32_t idx)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = MM_CAMERA_POLL_EVENTS;
+    ev.data.u64 = ((uint64_t)handler << 32) | idx;
+    if (epoll_ctl(poll_cb->epoll_fd, op, fd, &ev) < 0) {
+        CDBG_ERROR("%s: epoll_ctl op %d fd %d failed, errno = %d",
+                   __func__, op, fd, errno);
+        return -1;
+    }
+    return 0;
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_proc_pipe
  *
@@ -210,55 +205,17 @@ static void mm_camera_poll_set_state(mm_camera_poll_thread_t *poll_cb,
 static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
 {
     ssize_t read_len;
-    int i;
     mm_camera_sig_evt_t cmd_evt;
+
+    memset(&cmd_evt, 0, sizeof(cmd_evt));
     read_len = read(poll_cb->pfds[0], &cmd_evt, sizeof(cmd_evt));
     CDBG("%s: read_fd = %d, read_len = %d, expect_len = %d cmd = %d",
          __func__, poll_cb->pfds[0], (int)read_len, (int)sizeof(cmd_evt), cmd_evt.cmd);
     switch (cmd_evt.cmd) {
     case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED:
-    case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC:
-        /* we always have index 0 for pipe read */
-        poll_cb->num_fds = 0;
-        poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->pfds[0];
-        poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-        poll_cb->num_fds++;
-
-        if (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type &&
-                poll_cb->num_fds < MAX_STREAM_NUM_IN_BUNDLE) {
-            if (poll_cb->poll_entries[0].fd >= 0) {
-                /* fd is valid, we update poll_fds */
-                poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->poll_entries[0].fd;
-                poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-                poll_cb->num_fds++;
-            }
-        } else if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type &&
-                poll_cb->num_fds <= MAX_STREAM_NUM_IN_BUNDLE) {
-            for(i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
-                if(poll_cb->poll_entries[i].fd >= 0) {
-                    /* fd is valid, we update poll_fds to this fd */
-                    poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->poll_entries[i].fd;
-                    poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-                    poll_cb->num_fds++;
-                } else {
-                    /* fd is invalid, we set the entry to -1 to prevent polling.
-                     * According to spec, polling will not poll on entry with fd=-1.
-                     * If this is not the case, we need to skip these invalid fds
-                     * when updating this array.
-                     * We still keep fd=-1 in this array because this makes easier to
-                     * map cb associated with this fd once incoming data avail by directly
-                     * using the index-1(0 is reserved for pipe read, so need to reduce index by 1) */
-                    poll_cb->poll_fds[poll_cb->num_fds].fd = -1;
-                    poll_cb->poll_fds[poll_cb->num_fds].events = 0;
-                    poll_cb->num_fds++;
-                }
-            }
-        }
-        if (cmd_evt.cmd != MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC)
-            mm_camera_poll_sig_done(poll_cb);
-        break;
-
     case MM_CAMERA_PIPE_CMD_COMMIT:
+        /* the epoll set is already updated by the caller, the command only
+         * tells that all events of the previous batch have been dispatched */
         mm_camera_poll_sig_done(poll_cb);
         break;
     case MM_CAMERA_PIPE_CMD_EXIT:
@@ -282,51 +239,68 @@ static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
 static void *mm_camera_poll_fn(mm_camera_poll_thread_t *poll_cb)
 {
     int rc = 0, i;
+    uint8_t pipe_ready;
+    uint32_t idx, handler;
+    struct epoll_event events[MM_CAMERA_POLL_MAX_EVENTS];
+    mm_camera_poll_entry_t entry;
 
     if (NULL == poll_cb) {
         CDBG_ERROR("%s: poll_cb is NULL!\n", __func__);
         return NULL;
     }
-    CDBG("%s: poll type = %d, num_fd = %d poll_cb = %p\n",
-         __func__, poll_cb->poll_type, poll_cb->num_fds,poll_cb);
+    CDBG("%s: poll type = %d, epoll fd = %d poll_cb = %p\n",
+         __func__, poll_cb->poll_type, poll_cb->epoll_fd, poll_cb);
     do {
-         for(i = 0; i < poll_cb->num_fds; i++) {
-            poll_cb->poll_fds[i].events = POLLIN|POLLRDNORM|POLLPRI;
-         }
-
-         rc = poll(poll_cb->poll_fds, poll_cb->num_fds, poll_cb->timeoutms);
-         if(rc > 0) {
-            if ((poll_cb->poll_fds[0].revents & POLLIN) &&
-                (poll_cb->poll_fds[0].revents & POLLRDNORM)) {
-                /* if we have data on pipe, we only process pipe in this iteration */
-                CDBG("%s: cmd received on pipe\n", __func__);
-                mm_camera_poll_proc_pipe(poll_cb);
-            } else {
-                for(i=1; i<poll_cb->num_fds; i++) {
-                    /* Checking for ctrl events */
-                    if ((poll_cb->poll_type == MM_CAMERA_POLL_TYPE_EVT) &&
-                        (poll_cb->poll_fds[i].revents & POLLPRI)) {
-                        CDBG("%s: mm_camera_evt_notify\n", __func__);
-                        if (NULL != poll_cb->poll_entries[i-1].notify_cb) {
-                            poll_cb->poll_entries[i-1].notify_cb(poll_cb->poll_entries[i-1].user_data);
-                        }
-                    }
-
-                    if ((MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) &&
-                        (poll_cb->poll_fds[i].revents & POLLIN) &&
-                        (poll_cb->poll_fds[i].revents & POLLRDNORM)) {
-                        CDBG("%s: mm_stream_data_notify\n", __func__);
-                        if (NULL != poll_cb->poll_entries[i-1].notify_cb) {
-                            poll_cb->poll_entries[i-1].notify_cb(poll_cb->poll_entries[i-1].user_data);
-                        }
-                    }
-                }
-            }
-        } else {
+        rc = epoll_wait(poll_cb->epoll_fd, events, MM_CAMERA_POLL_MAX_EVENTS,
+                poll_cb->timeoutms);
+        if (rc <= 0) {
             /* in error case sleep 10 us and then continue. hard coded here */
             usleep(10);
             continue;
         }
+
+        pipe_ready = FALSE;
+        for (i = 0; i < rc; i++) {
+            idx = (uint32_t)events[i].data.u64;
+            handler = (uint32_t)(events[i].data.u64 >> 32);
+            if (MM_CAMERA_POLL_PIPE_IDX == idx) {
+                pipe_ready = (events[i].events & EPOLLIN) ? TRUE : FALSE;
+                continue;
+            }
+            if (MAX_STREAM_NUM_IN_BUNDLE <= idx) {
+                continue;
+            }
+
+            /* Checking for ctrl events */
+            if ((MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) &&
+                !(events[i].events & EPOLLPRI)) {
+                continue;
+            }
+            if ((MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) &&
+                !(events[i].events & EPOLLIN)) {
+                continue;
+            }
+
+            pthread_mutex_lock(&poll_cb->mutex);
+            entry = poll_cb->poll_entries[idx];
+            pthread_mutex_unlock(&poll_cb->mutex);
+
+            /* the fd may have been removed or replaced after epoll_wait
+             * returned, drop its stale event */
+            if ((entry.fd < 0) || (entry.handler != handler) ||
+                (NULL == entry.notify_cb)) {
+                continue;
+            }
+            CDBG("%s: notify entry %d\n", __func__, idx);
+            entry.notify_cb(entry.user_data);
+        }
+
+        /* commands are processed after the whole batch is dispatched, so
+         * a synchronous removal returns only once no callback is running */
+        if (pipe_ready) {
+            CDBG("%s: cmd received on pipe\n", __func__);
+            mm_camera_poll_proc_pipe(poll_cb);
+        }
     } while ((poll_cb != NULL) && (poll_cb->state == MM_CAMERA_POLL_TASK_STATE_POLL));
     return NULL;
 }
@@ -346,9 +320,6 @@ static void *mm_camera_poll_thread(void *data)
     prctl(PR_SET_NAME, (unsigned long)"mm_cam_poll_th", 0, 0, 0);
     mm_camera_poll_thread_t *poll_cb = (mm_camera_poll_thread_t *)data;
 
-    /* add pipe read fd into poll first */
-    poll_cb->poll_fds[poll_cb->num_fds++].fd = poll_cb->pfds[0];
-
     mm_camera_poll_sig_done(poll_cb);
     mm_camera_poll_set_state(poll_cb, MM_CAMERA_POLL_TASK_STATE_POLL);
     return mm_camera_poll_fn(poll_cb);
@@ -391,7 +362,9 @@ int32_t mm_camera_poll_thread_commit_updates(mm_camera_poll_thread_t * poll_cb)
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_thread_add_poll_fd
  *
- * DESCRIPTION: add a new fd into polling thread
+ * DESCRIPTION: add a new fd into polling thread. The fd is registered in
+ *              the epoll set directly, so neither call type waits for the
+ *              polling thread.
  *
  * PARAMETERS :
  *   @poll_cb   : ptr to poll thread object
@@ -412,6 +385,7 @@ int32_t mm_camera_poll_thread_add_poll_fd(mm_camera_poll_thread_t * poll_cb,
                                           mm_camera_call_type_t call_type)
 {
     int32_t rc = -1;
+    int32_t old_fd;
     uint8_t idx = 0;
 
     if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) {
@@ -423,16 +397,26 @@ int32_t mm_camera_poll_thread_add_poll_fd(mm_camera_poll_thread_t * poll_cb,
     }
 
     if (MAX_STREAM_NUM_IN_BUNDLE > idx) {
+        pthread_mutex_lock(&poll_cb->mutex);
+        old_fd = poll_cb->poll_entries[idx].fd;
+        if ((old_fd >= 0) && (old_fd != fd)) {
+            mm_camera_poll_ctl(poll_cb, EPOLL_CTL_DEL, old_fd, 0, idx);
+        }
         poll_cb->poll_entries[idx].fd = fd;
         poll_cb->poll_entries[idx].handler = handler;
         poll_cb->poll_entries[idx].notify_cb = notify_cb;
         poll_cb->poll_entries[idx].user_data = userdata;
-        /* send poll entries updated signal to poll thread */
-        if (call_type == mm_camera_sync_call ) {
-            rc = mm_camera_poll_sig(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED);
-        } else {
-            rc = mm_camera_poll_sig_async(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC );
+        rc = mm_camera_poll_ctl(poll_cb,
+                (old_fd == fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                fd, handler, idx);
+        if (rc < 0) {
+            poll_cb->poll_entries[idx].fd = -1;
+            poll_cb->poll_entries[idx].handler = 0;
+            poll_cb->poll_entries[idx].notify_cb = NULL;
         }
+        pthread_mutex_unlock(&poll_cb->mutex);
+        CDBG("%s: fd %d added to entry %d (%s), rc = %d", __func__, fd, idx,
+             (call_type == mm_camera_sync_call) ? "sync" : "async", rc);
     } else {
         CDBG_ERROR("%s: invalid handler %d (%d)",
                    __func__, handler, idx);
@@ -443,7 +427,9 @@ int32_t mm_camera_poll_thread_add_poll_fd(mm_camera_poll_thread_t * poll_cb,
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_thread_del_poll_fd
  *
- * DESCRIPTION: delete a fd from polling thread
+ * DESCRIPTION: delete a fd from polling thread. A synchronous call also
+ *              waits until the polling thread has finished dispatching any
+ *              event it already picked up for this fd.
  *
  * PARAMETERS :
  *   @poll_cb   : ptr to poll thread object
@@ -459,6 +445,7 @@ int32_t mm_camera_poll_thread_del_poll_fd(mm_camera_poll_thread_t * poll_cb,
                                           mm_camera_call_type_t call_type)
 {
     int32_t rc = -1;
+    int32_t fd;
     uint8_t idx = 0;
 
     if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) {
@@ -469,20 +456,27 @@ int32_t mm_camera_poll_thread_del_poll_fd(mm_camera_poll_thread_t * poll_cb,
         idx = 0;
     }
 
+    pthread_mutex_lock(&poll_cb->mutex);
     if ((MAX_STREAM_NUM_IN_BUNDLE > idx) &&
         (handler == poll_cb->poll_entries[idx].handler)) {
         /* reset poll entry */
+        fd = poll_cb->poll_entries[idx].fd;
         poll_cb->poll_entries[idx].fd = -1; /* set fd to invalid */
         poll_cb->poll_entries[idx].handler = 0;
         poll_cb->poll_entries[idx].notify_cb = NULL;
+        if (fd >= 0) {
+            /* fd might already be closed, which removed it from the set */
+            mm_camera_poll_ctl(poll_cb, EPOLL_CTL_DEL, fd, handler, idx);
+        }
+        pthread_mutex_unlock(&poll_cb->mutex);
 
-        /* send poll entries updated signal to poll thread */
         if (call_type == mm_camera_sync_call ) {
             rc = mm_camera_poll_sig(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED);
         } else {
-            rc = mm_camera_poll_sig_async(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC );
+            rc = 0;
         }
     } else {
+        pthread_mutex_unlock(&poll_cb->mutex);
         CDBG_ERROR("%s: invalid handler %d (%d)",
                    __func__, handler, idx);
         return -1;
@@ -498,11 +492,6 @@ int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
     size_t i = 0, cnt = 0;
     poll_cb->poll_type = poll_type;
 
-    //Initialize poll_fds
-    cnt = sizeof(poll_cb->poll_fds) / sizeof(poll_cb->poll_fds[0]);
-    for (i = 0; i < cnt; i++) {
-        poll_cb->poll_fds[i].fd = -1;
-    }
     //Initialize poll_entries
     cnt = sizeof(poll_cb->poll_entries) / sizeof(poll_cb->poll_entries[0]);
     for (i = 0; i < cnt; i++) {
@@ -517,11 +506,34 @@ int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
         return -1;
     }
 
+    poll_cb->epoll_fd = epoll_create(MM_CAMERA_POLL_MAX_EVENTS);
+    if (poll_cb->epoll_fd < 0) {
+        CDBG_ERROR("%s: epoll_create failed, errno = %d\n", __func__, errno);
+        close(poll_cb->pfds[0]);
+        close(poll_cb->pfds[1]);
+        poll_cb->pfds[0] = -1;
+        poll_cb->pfds[1] = -1;
+        return -1;
+    }
+
+    /* add pipe read fd into epoll set first */
+    rc = mm_camera_poll_ctl(poll_cb, EPOLL_CTL_ADD, poll_cb->pfds[0], 0,
+            MM_CAMERA_POLL_PIPE_IDX);
+    if (rc < 0) {
+        close(poll_cb->epoll_fd);
+        close(poll_cb->pfds[0]);
+        close(poll_cb->pfds[1]);
+        poll_cb->epoll_fd = -1;
+        poll_cb->pfds[0] = -1;
+        poll_cb->pfds[1] = -1;
+        return -1;
+    }
+
     poll_cb->timeoutms = -1;  /* Infinite seconds */
 
-    CDBG("%s: poll_type = %d, read fd = %d, write fd = %d timeout = %d",
+    CDBG("%s: poll_type = %d, read fd = %d, write fd = %d, epoll fd = %d timeout = %d",
         __func__, poll_cb->poll_type,
-        poll_cb->pfds[0], poll_cb->pfds[1],poll_cb->timeoutms);
+        poll_cb->pfds[0], poll_cb->pfds[1], poll_cb->epoll_fd, poll_cb->timeoutms);
 
     pthread_mutex_init(&poll_cb->mutex, NULL);
     pthread_cond_init(&poll_cb->cond_v, NULL);
@@ -558,19 +570,23 @@ int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb)
         CDBG_ERROR("%s: pthread dead already\n", __func__);
     }
 
-    /* close pipe */
+    /* close pipe and epoll set */
     if(poll_cb->pfds[0] >= 0) {
         close(poll_cb->pfds[0]);
     }
     if(poll_cb->pfds[1] >= 0) {
         close(poll_cb->pfds[1]);
     }
+    if (poll_cb->epoll_fd >= 0) {
+        close(poll_cb->epoll_fd);
+    }
 
     pthread_mutex_destroy(&poll_cb->mutex);
     pthread_cond_destroy(&poll_cb->cond_v);
     memset(poll_cb, 0, sizeof(mm_camera_poll_thread_t));
     poll_cb->pfds[0] = -1;
     poll_cb->pfds[1] = -1;
+    poll_cb->epoll_fd = -1;
     return rc;
 }
 
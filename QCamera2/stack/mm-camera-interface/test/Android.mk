@@ -0,0 +1,73 @@
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CHANNEL_TEST_PATH := $(call my-dir)
+
+# Host tests of the superbuf matcher in mm_camera_channel.c: a match cost
+# benchmark, a frame index rollover soak and a per-frame metadata handling
+# benchmark. The stream, poll and cmd
+# thread layers are stubbed in mm_channel_test_util.c; the kernel headers
+# are only needed for the types shared with the backend.
+# mm-camera-poll-test runs the real poll thread of mm_camera_thread.c
+# with eventfds standing in for the stream nodes.
+
+include $(MM_CHANNEL_TEST_PATH)/../../../../common.mk
+
+mm_channel_test_includes := \
+        $(MM_CHANNEL_TEST_PATH)/../inc \
+        $(MM_CHANNEL_TEST_PATH)/../../common \
+        system/media/camera/include \
+        $(kernel_includes)
+
+mm_channel_test_src := \
+        ../src/mm_camera_channel.c \
+        ../src/cam_intf.c \
+        mm_channel_test_util.c
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CHANNEL_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror -D_ANDROID_
+LOCAL_C_INCLUDES := $(mm_channel_test_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+LOCAL_SRC_FILES := $(mm_channel_test_src) mm_channel_match_bench.c
+LOCAL_MODULE := mm-camera-channel-match-bench
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_LDLIBS := -lpthread -lrt
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CHANNEL_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror -D_ANDROID_
+LOCAL_C_INCLUDES := $(mm_channel_test_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+LOCAL_SRC_FILES := $(mm_channel_test_src) mm_channel_rollover_test.c
+LOCAL_MODULE := mm-camera-channel-rollover-test
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_LDLIBS := -lpthread -lrt
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CHANNEL_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror -D_ANDROID_
+LOCAL_C_INCLUDES := $(mm_channel_test_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+LOCAL_SRC_FILES := $(mm_channel_test_src) mm_channel_meta_bench.c
+LOCAL_MODULE := mm-camera-channel-meta-bench
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_LDLIBS := -lpthread -lrt
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CHANNEL_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror -D_ANDROID_
+LOCAL_C_INCLUDES := $(mm_channel_test_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+LOCAL_SRC_FILES := ../src/mm_camera_thread.c mm_camera_poll_test.c
+LOCAL_MODULE := mm-camera-poll-test
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_LDLIBS := -lpthread -lrt
+include $(BUILD_HOST_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
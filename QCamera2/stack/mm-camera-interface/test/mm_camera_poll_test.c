@@ -0,0 +1,272 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host test of the epoll based poll thread in mm_camera_thread.c. An
+ * eventfd stands in for each V4L2 stream node: writing to it makes it
+ * readable like a node with a buffer ready, and the notify callback reads
+ * it back like a dqbuf. Covers async add, dispatch of several ready fds,
+ * sync remove waiting for a running callback, rejected double remove,
+ * re-add of a new fd at the same entry index and release.
+ *
+ * Usage: mm-camera-poll-test
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "mm_camera_dbg.h"
+#include "mm_camera_interface.h"
+#include "mm_camera.h"
+
+#define POLL_TEST_ENTRIES     4
+#define POLL_TEST_TIMEOUT_MS  2000
+#define POLL_TEST_SETTLE_US   50000
+#define POLL_TEST_SLOW_CB_US  100000
+
+/** poll_test_entry_t: one stand-in stream
+ *    @fd: eventfd standing in for the stream node
+ *    @handler: stream handle, its low byte is the poll entry index
+ *    @notified: number of notify callbacks run
+ *    @in_cb: callback is running
+ *    @slow: callback sleeps before returning
+ **/
+typedef struct {
+    int fd;
+    uint32_t handler;
+    uint32_t notified;
+    int in_cb;
+    int slow;
+} poll_test_entry_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static int g_failures = 0;
+
+volatile uint32_t gMmCameraIntfLogLevel = 0;
+
+#define EXPECT(cond, what) do { \
+    if (!(cond)) { \
+        printf("FAIL %s\n", what); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* handler to poll entry index, as in mm_camera_interface.c */
+uint8_t mm_camera_util_get_index_by_handler(uint32_t handler)
+{
+    return (handler&0x000000ff);
+}
+
+/*===========================================================================
+ * FUNCTION   : poll_test_notify
+ *
+ * DESCRIPTION: notify callback of a stand-in stream, consumes the event
+ *
+ * PARAMETERS :
+ *   @user_data : ptr to poll_test_entry_t
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void poll_test_notify(void *user_data)
+{
+    poll_test_entry_t *e = (poll_test_entry_t *)user_data;
+    uint64_t val;
+    int slow;
+
+    pthread_mutex_lock(&g_lock);
+    e->in_cb = 1;
+    slow = e->slow;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+
+    if (read(e->fd, &val, sizeof(val)) != (ssize_t)sizeof(val)) {
+        printf("FAIL notify without a pending event on fd %d\n", e->fd);
+        g_failures++;
+    }
+    if (slow) {
+        usleep(POLL_TEST_SLOW_CB_US);
+    }
+
+    pthread_mutex_lock(&g_lock);
+    e->in_cb = 0;
+    e->notified++;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : poll_test_signal
+ *
+ * DESCRIPTION: make a stand-in stream readable
+ *
+ * PARAMETERS :
+ *   @e       : stand-in stream
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void poll_test_signal(poll_test_entry_t *e)
+{
+    uint64_t one = 1;
+
+    if (write(e->fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+        printf("FAIL write to eventfd %d\n", e->fd);
+        g_failures++;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : poll_test_wait
+ *
+ * DESCRIPTION: wait until a stand-in stream has been notified a number of
+ *              times or is inside its callback
+ *
+ * PARAMETERS :
+ *   @e        : stand-in stream
+ *   @notified : notify count to wait for
+ *   @in_cb    : wait for the callback to be running instead
+ *
+ * RETURN     : 1 if the condition was met, 0 on timeout
+ *==========================================================================*/
+static int poll_test_wait(poll_test_entry_t *e, uint32_t notified, int in_cb)
+{
+    struct timespec ts;
+    int met;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += POLL_TEST_TIMEOUT_MS / 1000;
+    pthread_mutex_lock(&g_lock);
+    while (!(met = in_cb ? e->in_cb : (e->notified >= notified))) {
+        if (pthread_cond_timedwait(&g_cond, &g_lock, &ts) != 0) {
+            met = in_cb ? e->in_cb : (e->notified >= notified);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return met;
+}
+
+static uint32_t poll_test_notified(poll_test_entry_t *e)
+{
+    uint32_t n;
+
+    pthread_mutex_lock(&g_lock);
+    n = e->notified;
+    pthread_mutex_unlock(&g_lock);
+    return n;
+}
+
+int main(void)
+{
+    mm_camera_poll_thread_t poll_cb;
+    poll_test_entry_t entries[POLL_TEST_ENTRIES];
+    poll_test_entry_t *e;
+    int old_fd;
+    uint8_t i;
+
+    memset(&poll_cb, 0, sizeof(poll_cb));
+    memset(entries, 0, sizeof(entries));
+    EXPECT(0 == mm_camera_poll_thread_launch(&poll_cb, MM_CAMERA_POLL_TYPE_DATA),
+            "launch data poll thread");
+
+    /* async add: the fd is live as soon as the call returns */
+    for (i = 0; i < POLL_TEST_ENTRIES; i++) {
+        e = &entries[i];
+        e->fd = eventfd(0, EFD_NONBLOCK);
+        e->handler = 0x100U | i;
+        EXPECT(e->fd >= 0, "eventfd");
+        EXPECT(0 == mm_camera_poll_thread_add_poll_fd(&poll_cb, e->handler,
+                e->fd, poll_test_notify, e, mm_camera_async_call),
+                "async add");
+    }
+    poll_test_signal(&entries[0]);
+    EXPECT(poll_test_wait(&entries[0], 1, 0), "async add: first event");
+
+    /* several fds ready at once are all dispatched */
+    for (i = 0; i < POLL_TEST_ENTRIES; i++) {
+        poll_test_signal(&entries[i]);
+    }
+    for (i = 0; i < POLL_TEST_ENTRIES; i++) {
+        EXPECT(poll_test_wait(&entries[i], (0 == i) ? 2 : 1, 0),
+                "batch: every ready fd notified");
+    }
+
+    /* sync remove returns only after the running callback is done */
+    e = &entries[1];
+    pthread_mutex_lock(&g_lock);
+    e->slow = 1;
+    pthread_mutex_unlock(&g_lock);
+    poll_test_signal(e);
+    EXPECT(poll_test_wait(e, 0, 1), "sync remove: callback started");
+    EXPECT(0 == mm_camera_poll_thread_del_poll_fd(&poll_cb, e->handler,
+            mm_camera_sync_call), "sync remove");
+    pthread_mutex_lock(&g_lock);
+    EXPECT(0 == e->in_cb, "sync remove: no callback running on return");
+    pthread_mutex_unlock(&g_lock);
+    poll_test_signal(e);
+    usleep(POLL_TEST_SETTLE_US);
+    EXPECT(2 == poll_test_notified(e), "sync remove: no event after removal");
+
+    /* the entry is gone, a second removal is rejected */
+    EXPECT(-1 == mm_camera_poll_thread_del_poll_fd(&poll_cb, e->handler,
+            mm_camera_sync_call), "double remove rejected");
+
+    /* a new fd and handle at the same index replace the old ones */
+    e = &entries[2];
+    old_fd = e->fd;
+    e->fd = eventfd(0, EFD_NONBLOCK);
+    e->handler = 0x200U | 2;
+    EXPECT(0 == mm_camera_poll_thread_add_poll_fd(&poll_cb, e->handler,
+            e->fd, poll_test_notify, e, mm_camera_async_call),
+            "re-add at the same index");
+    {
+        uint64_t one = 1;
+        EXPECT((ssize_t)sizeof(one) == write(old_fd, &one, sizeof(one)),
+                "write to replaced fd");
+    }
+    usleep(POLL_TEST_SETTLE_US);
+    EXPECT(1 == poll_test_notified(e), "re-add: replaced fd not polled");
+    poll_test_signal(e);
+    EXPECT(poll_test_wait(e, 2, 0), "re-add: new fd polled");
+    close(old_fd);
+
+    EXPECT(0 == mm_camera_poll_thread_commit_updates(&poll_cb), "commit");
+    EXPECT(0 == mm_camera_poll_thread_release(&poll_cb), "release");
+    EXPECT(-1 == poll_cb.epoll_fd, "release: epoll set closed");
+
+    for (i = 0; i < POLL_TEST_ENTRIES; i++) {
+        close(entries[i].fd);
+    }
+
+    printf("%s (%d failures)\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
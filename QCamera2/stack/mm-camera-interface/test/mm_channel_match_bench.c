@@ -0,0 +1,188 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host microbenchmark of the superbuf matcher: cost of
+ * mm_channel_superbuf_comp_and_enqueue against the number of unmatched
+ * superbufs held by the queue (max_unmatched_frames). Two streams are
+ * bundled; "match" completes the oldest unmatched superbuf, "insert" adds a
+ * new one and evicts the oldest. The queue order is checked after each run,
+ * and a regression check covers an older frame arriving while the matcher
+ * has to evict the superbuf it would have been inserted before.
+ *
+ * Usage: mm-camera-channel-match-bench [-n iterations]
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "mm_channel_test.h"
+
+static const cam_stream_type_t g_types[] = {
+    CAM_STREAM_TYPE_SNAPSHOT,
+    CAM_STREAM_TYPE_PREVIEW,
+};
+
+static const uint32_t g_depths[] = { 2, 4, 8, 16, 32, 64, 128, 255 };
+
+static int g_failures = 0;
+
+#define EXPECT(cond, what) do { \
+    if (!(cond)) { \
+        printf("FAIL %s\n", what); \
+        g_failures++; \
+    } \
+} while (0)
+
+/*===========================================================================
+ * FUNCTION   : test_evict_next
+ *
+ * DESCRIPTION: an incoming frame older than every unmatched superbuf, with
+ *              the queue over its limit, forces the matcher to release the
+ *              superbuf it would be inserted before. The new one has to go
+ *              before the successor of the released one, not at the tail.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void test_evict_next(void)
+{
+    mm_channel_test_t test;
+    mm_channel_queue_t *queue = &test.ch.bundle.superbuf_queue;
+    mm_channel_queue_node_t *head;
+
+    mm_channel_test_init(&test, g_types, 2, 8);
+    mm_channel_test_push(&test, 0, 3);
+    mm_channel_test_push(&test, 0, 7);
+    /* frame 8 was diverted, it is kept while the queue is trimmed */
+    test.ch.diverted_frame_id = 8;
+    mm_channel_test_push(&test, 0, 8);
+    EXPECT(3 == queue->unmatched_cnt, "evict: setup");
+
+    queue->attr.max_unmatched_frames = 1;
+    mm_channel_test_push(&test, 0, 5);
+    EXPECT(0 == mm_channel_test_check_order(&test), "evict: order kept");
+    EXPECT(2 == queue->unmatched_cnt, "evict: unmatched count");
+    head = member_of(queue->unmatched_list.next, mm_channel_queue_node_t,
+            unmatched);
+    EXPECT(5 == head->frame_idx, "evict: new frame before successor");
+    mm_channel_test_deinit(&test);
+}
+
+/*===========================================================================
+ * FUNCTION   : bench_depth
+ *
+ * DESCRIPTION: time the matcher at one queue depth
+ *
+ * PARAMETERS :
+ *   @depth   : max_unmatched_frames (at most 255), filled before timing
+ *   @iters   : number of timed frames per mode
+ *   @p_match : ns per matching frame
+ *   @p_insert : ns per inserted frame
+ *
+ * RETURN     : 0 on success, -1 if the queue order was broken
+ *==========================================================================*/
+static int bench_depth(uint32_t depth, uint32_t iters, double *p_match,
+        double *p_insert)
+{
+    mm_channel_test_t test;
+    uint64_t start;
+    uint32_t i, matched = 0;
+    int rc = 0;
+
+    /* match: snapshot runs depth frames ahead of preview */
+    mm_channel_test_init(&test, g_types, 2, depth);
+    for (i = 1; i <= depth; i++) {
+        mm_channel_test_push(&test, 0, i);
+    }
+    start = mm_channel_test_now_ns();
+    for (i = 1; i <= iters; i++) {
+        mm_channel_test_push(&test, 1, i);
+        mm_channel_test_push(&test, 0, i + depth);
+        matched += mm_channel_test_pop_matched(&test, NULL);
+    }
+    *p_match = (double)(mm_channel_test_now_ns() - start) / (2.0 * iters);
+    if ((matched != iters) || mm_channel_test_check_order(&test)) {
+        rc = -1;
+    }
+    mm_channel_test_deinit(&test);
+
+    /* insert: preview never arrives, the oldest superbuf is evicted */
+    mm_channel_test_init(&test, g_types, 2, depth);
+    for (i = 1; i <= depth; i++) {
+        mm_channel_test_push(&test, 0, i);
+    }
+    start = mm_channel_test_now_ns();
+    for (i = 1; i <= iters; i++) {
+        mm_channel_test_push(&test, 0, i + depth);
+    }
+    *p_insert = (double)(mm_channel_test_now_ns() - start) / iters;
+    if (mm_channel_test_check_order(&test)) {
+        rc = -1;
+    }
+    mm_channel_test_deinit(&test);
+    return rc;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t iters = 200000;
+    double match_ns, insert_ns;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            iters = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("Usage: %s [-n iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (0 == iters) {
+        printf("Usage: %s [-n iterations]\n", argv[0]);
+        return 1;
+    }
+
+    test_evict_next();
+
+    printf("%8s %12s %12s\n", "depth", "match ns", "insert ns");
+    for (i = 0; i < sizeof(g_depths) / sizeof(g_depths[0]); i++) {
+        if (bench_depth(g_depths[i], iters, &match_ns, &insert_ns)) {
+            printf("FAIL depth %u: queue order or match count\n",
+                    g_depths[i]);
+            g_failures++;
+        }
+        printf("%8u %12.1f %12.1f\n", g_depths[i], match_ns, insert_ns);
+    }
+
+    printf("%s (%d failures)\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
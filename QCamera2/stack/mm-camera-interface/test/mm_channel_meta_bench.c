@@ -0,0 +1,310 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host microbenchmark of per-frame metadata handling. For a metadata
+ * buffer with a given number of valid entries it times:
+ *   - "channel": mm_channel_handle_metadata, which walks the valid-id list
+ *     of the buffer for the entries the matcher needs.
+ *   - "probe": a consumer testing every id the HAL3 result translation
+ *     handles, which is what translateFromHalMetadata did before it walked
+ *     the valid-id list.
+ *   - "list": the same consumer walking the valid-id list instead.
+ * A check first verifies that mm_channel_handle_metadata still picks up
+ * every entry it acts on.
+ *
+ * Usage: mm-camera-channel-meta-bench [-n iterations]
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "mm_channel_test.h"
+
+static const cam_stream_type_t g_types[] = {
+    CAM_STREAM_TYPE_METADATA,
+    CAM_STREAM_TYPE_PREVIEW,
+};
+
+/* ids translated into the framework result by translateFromHalMetadata */
+static const cam_intf_parm_type_t g_result_ids[] = {
+    CAM_INTF_META_FRAME_NUMBER, CAM_INTF_PARM_FPS_RANGE,
+    CAM_INTF_PARM_EXPOSURE_COMPENSATION, CAM_INTF_PARM_AEC_LOCK,
+    CAM_INTF_PARM_AWB_LOCK, CAM_INTF_META_FACE_DETECTION,
+    CAM_INTF_META_COLOR_CORRECT_MODE, CAM_INTF_META_EDGE_MODE,
+    CAM_INTF_META_FLASH_POWER, CAM_INTF_META_FLASH_FIRING_TIME,
+    CAM_INTF_META_FLASH_STATE, CAM_INTF_META_FLASH_MODE,
+    CAM_INTF_META_HOTPIXEL_MODE, CAM_INTF_META_LENS_APERTURE,
+    CAM_INTF_META_LENS_FILTERDENSITY, CAM_INTF_META_LENS_FOCAL_LENGTH,
+    CAM_INTF_META_LENS_OPT_STAB_MODE, CAM_INTF_META_NOISE_REDUCTION_MODE,
+    CAM_INTF_META_NOISE_REDUCTION_STRENGTH, CAM_INTF_META_SCALER_CROP_REGION,
+    CAM_INTF_META_SENSOR_EXPOSURE_TIME, CAM_INTF_META_SENSOR_FRAME_DURATION,
+    CAM_INTF_META_SENSOR_ROLLING_SHUTTER_SKEW,
+    CAM_INTF_META_SENSOR_SENSITIVITY, CAM_INTF_META_SHADING_MODE,
+    CAM_INTF_META_STATS_FACEDETECT_MODE, CAM_INTF_META_STATS_HISTOGRAM_MODE,
+    CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, CAM_INTF_META_STATS_SHARPNESS_MAP,
+    CAM_INTF_META_LENS_SHADING_MAP, CAM_INTF_META_TONEMAP_MODE,
+    CAM_INTF_META_TONEMAP_CURVES, CAM_INTF_META_COLOR_CORRECT_GAINS,
+    CAM_INTF_META_COLOR_CORRECT_TRANSFORM, CAM_INTF_META_PROFILE_TONE_CURVE,
+    CAM_INTF_META_PRED_COLOR_CORRECT_GAINS,
+    CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, CAM_INTF_META_OTP_WB_GRGB,
+    CAM_INTF_META_BLACK_LEVEL_LOCK, CAM_INTF_META_SCENE_FLICKER,
+    CAM_INTF_PARM_EFFECT, CAM_INTF_META_TEST_PATTERN_DATA,
+    CAM_INTF_META_JPEG_GPS_COORDINATES, CAM_INTF_META_JPEG_GPS_PROC_METHODS,
+    CAM_INTF_META_JPEG_GPS_TIMESTAMP, CAM_INTF_META_JPEG_ORIENTATION,
+    CAM_INTF_META_JPEG_QUALITY, CAM_INTF_META_JPEG_THUMB_QUALITY,
+    CAM_INTF_META_JPEG_THUMB_SIZE, CAM_INTF_META_PRIVATE_DATA,
+    CAM_INTF_META_NEUTRAL_COL_POINT, CAM_INTF_META_LENS_SHADING_MAP_MODE,
+    CAM_INTF_META_AEC_ROI, CAM_INTF_META_AF_ROI, CAM_INTF_PARM_ANTIBANDING,
+    CAM_INTF_PARM_BESTSHOT_MODE, CAM_INTF_META_MODE, CAM_INTF_PARM_CDS_MODE,
+    CAM_INTF_META_CROP_DATA, CAM_INTF_PARM_CAC,
+};
+
+#define NUM_RESULT_IDS (sizeof(g_result_ids) / sizeof(g_result_ids[0]))
+
+static const uint32_t g_num_valid[] = { 8, 32, 64, 128, CAM_INTF_PARM_MAX };
+
+static uint8_t g_is_result_id[CAM_INTF_PARM_MAX];
+static volatile uint32_t g_sink;
+static int g_failures = 0;
+
+#define EXPECT(cond, what) do { \
+    if (!(cond)) { \
+        printf("FAIL %s\n", what); \
+        g_failures++; \
+    } \
+} while (0)
+
+/*===========================================================================
+ * FUNCTION   : fill_metadata
+ *
+ * DESCRIPTION: mark entries valid: the ones the matcher acts on, then the
+ *              result ids, then every other id, until num_valid are set
+ *
+ * PARAMETERS :
+ *   @meta      : metadata buffer, cleared first
+ *   @num_valid : number of valid entries wanted
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void fill_metadata(metadata_buffer_t *meta, uint32_t num_valid)
+{
+    cam_frame_idx_range_t range;
+    cam_buf_divert_info_t divert;
+    uint32_t cnt = 0;
+    uint32_t i;
+
+    memset(meta, 0, sizeof(*meta));
+
+    memset(&range, 0, sizeof(range));
+    range.min_frame_idx = 40;
+    range.max_frame_idx = 44;
+    ADD_SET_PARAM_ENTRY_TO_BATCH(meta, CAM_INTF_META_GOOD_FRAME_IDX_RANGE,
+            range);
+    memset(&divert, 0, sizeof(divert));
+    divert.frame_id = 33;
+    ADD_SET_PARAM_ENTRY_TO_BATCH(meta, CAM_INTF_BUF_DIVERT_INFO, divert);
+    cnt = 2;
+
+    for (i = 0; (i < NUM_RESULT_IDS) && (cnt < num_valid); i++) {
+        if (!meta->is_valid[g_result_ids[i]]) {
+            meta->is_valid[g_result_ids[i]] = 1;
+            cnt++;
+        }
+    }
+    for (i = 0; (i < CAM_INTF_PARM_MAX) && (cnt < num_valid); i++) {
+        if (!meta->is_valid[i]) {
+            meta->is_valid[i] = 1;
+            cnt++;
+        }
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : test_handle_metadata
+ *
+ * DESCRIPTION: the entries the matcher acts on are found through the
+ *              valid-id list, whatever else is valid in the buffer
+ *
+ * PARAMETERS :
+ *   @meta    : scratch metadata buffer
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void test_handle_metadata(metadata_buffer_t *meta)
+{
+    mm_channel_test_t test;
+    mm_channel_queue_t *queue = &test.ch.bundle.superbuf_queue;
+    mm_camera_buf_info_t buf_info;
+    uint32_t n;
+
+    for (n = 0; n < sizeof(g_num_valid) / sizeof(g_num_valid[0]); n++) {
+        mm_channel_test_init(&test, g_types, 2, 8);
+        fill_metadata(meta, g_num_valid[n]);
+        test.bufs[0].buffer = meta;
+        memset(&buf_info, 0, sizeof(buf_info));
+        buf_info.buf = &test.bufs[0];
+        buf_info.stream_id = test.bufs[0].stream_id;
+        buf_info.frame_idx = 33;
+        queue->expected_frame_id = 30;
+
+        mm_channel_handle_metadata(&test.ch, queue, &buf_info);
+        EXPECT(40 == queue->expected_frame_id, "metadata: good frame range");
+        EXPECT(33 == test.ch.diverted_frame_id, "metadata: divert info");
+        mm_channel_test_deinit(&test);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : bench_channel
+ *
+ * DESCRIPTION: time mm_channel_handle_metadata on one metadata buffer
+ *
+ * PARAMETERS :
+ *   @meta    : filled metadata buffer
+ *   @iters   : number of timed frames
+ *
+ * RETURN     : ns per frame
+ *==========================================================================*/
+static double bench_channel(metadata_buffer_t *meta, uint32_t iters)
+{
+    mm_channel_test_t test;
+    mm_channel_queue_t *queue = &test.ch.bundle.superbuf_queue;
+    mm_camera_buf_info_t buf_info;
+    uint64_t start;
+    uint32_t i;
+
+    mm_channel_test_init(&test, g_types, 2, 8);
+    test.bufs[0].buffer = meta;
+    memset(&buf_info, 0, sizeof(buf_info));
+    buf_info.buf = &test.bufs[0];
+    buf_info.stream_id = test.bufs[0].stream_id;
+
+    start = mm_channel_test_now_ns();
+    for (i = 0; i < iters; i++) {
+        buf_info.frame_idx = 33;
+        mm_channel_handle_metadata(&test.ch, queue, &buf_info);
+    }
+    mm_channel_test_deinit(&test);
+    return (double)(mm_channel_test_now_ns() - start) / iters;
+}
+
+/*===========================================================================
+ * FUNCTION   : bench_consumer
+ *
+ * DESCRIPTION: time a consumer reading every valid result entry, either by
+ *              testing each result id or by walking the valid-id list
+ *
+ * PARAMETERS :
+ *   @meta    : filled metadata buffer
+ *   @iters   : number of timed frames
+ *   @list    : walk the valid-id list instead of probing
+ *
+ * RETURN     : ns per frame
+ *==========================================================================*/
+static double bench_consumer(metadata_buffer_t *meta, uint32_t iters,
+        int list)
+{
+    uint32_t ids[CAM_INTF_PARM_MAX];
+    uint32_t cnt, i, k, sum = 0;
+    uint8_t *p;
+    uint64_t start;
+
+    start = mm_channel_test_now_ns();
+    for (i = 0; i < iters; i++) {
+        if (list) {
+            cnt = get_metadata_valid_ids(meta, ids, CAM_INTF_PARM_MAX);
+            for (k = 0; k < cnt; k++) {
+                if (g_is_result_id[ids[k]]) {
+                    p = get_pointer_of((cam_intf_parm_type_t)ids[k], meta);
+                    sum += p[0];
+                }
+            }
+        } else {
+            for (k = 0; k < NUM_RESULT_IDS; k++) {
+                if (meta->is_valid[g_result_ids[k]]) {
+                    p = get_pointer_of(g_result_ids[k], meta);
+                    sum += p[0];
+                }
+            }
+        }
+        /* keep the loads from being hoisted out of the timed loop */
+        __asm__ __volatile__("" ::: "memory");
+    }
+    g_sink = sum;
+    return (double)(mm_channel_test_now_ns() - start) / iters;
+}
+
+int main(int argc, char *argv[])
+{
+    metadata_buffer_t *meta;
+    uint32_t iters = 200000;
+    double channel_ns, probe_ns, list_ns;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            iters = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("Usage: %s [-n iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (0 == iters) {
+        printf("Usage: %s [-n iterations]\n", argv[0]);
+        return 1;
+    }
+
+    meta = (metadata_buffer_t *)malloc(sizeof(*meta));
+    if (NULL == meta) {
+        printf("FAIL no memory for metadata buffer\n");
+        return 1;
+    }
+    for (i = 0; i < NUM_RESULT_IDS; i++) {
+        g_is_result_id[g_result_ids[i]] = 1;
+    }
+
+    test_handle_metadata(meta);
+
+    printf("%8s %12s %12s %12s\n", "valid", "channel ns", "probe ns",
+            "list ns");
+    for (i = 0; i < sizeof(g_num_valid) / sizeof(g_num_valid[0]); i++) {
+        fill_metadata(meta, g_num_valid[i]);
+        channel_ns = bench_channel(meta, iters);
+        probe_ns = bench_consumer(meta, iters, 0);
+        list_ns = bench_consumer(meta, iters, 1);
+        printf("%8u %12.1f %12.1f %12.1f\n", g_num_valid[i], channel_ns,
+                probe_ns, list_ns);
+    }
+
+    free(meta);
+    printf("%s (%d failures)\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
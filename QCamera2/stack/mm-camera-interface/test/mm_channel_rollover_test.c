@@ -0,0 +1,177 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host soak test of frame index rollover in the superbuf matcher. The
+ * channel is fast-forwarded to just below 2^32, as after days of
+ * streaming, and snapshot and preview frames are matched across the wrap
+ * with preview lagging and some snapshot frames dropped. Every matched
+ * superbuf has to come out in order and none may be lost to the wrap.
+ *
+ * Usage: mm-camera-channel-rollover-test [-n frames]
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "mm_channel_test.h"
+
+#define ROLLOVER_TEST_LAG 2
+#define ROLLOVER_TEST_DROP_PERIOD 17
+
+static const cam_stream_type_t g_types[] = {
+    CAM_STREAM_TYPE_SNAPSHOT,
+    CAM_STREAM_TYPE_PREVIEW,
+};
+
+static int g_failures = 0;
+
+#define EXPECT(cond, what) do { \
+    if (!(cond)) { \
+        printf("FAIL %s\n", what); \
+        g_failures++; \
+    } \
+} while (0)
+
+/*===========================================================================
+ * FUNCTION   : test_seq_comp
+ *
+ * DESCRIPTION: serial number comparison around 0, 2^31 and 2^32
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void test_seq_comp(void)
+{
+    EXPECT(mm_channel_util_seq_comp_w_rollover(5, 5) == 0, "seq: equal");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(6, 5) > 0, "seq: newer");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(5, 6) < 0, "seq: older");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(1, 0xFFFFFFFFU) > 0,
+            "seq: newer across wrap");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(0xFFFFFFFFU, 1) < 0,
+            "seq: older across wrap");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(0xFFFFFFF0U + 100U,
+            0xFFFFFFF0U) > 0, "seq: future offset wraps");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(0x7FFFFFFFU, 0) > 0,
+            "seq: 2^31 - 1 ahead");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(0x80000001U, 0) < 0,
+            "seq: more than 2^31 ahead reads as behind");
+}
+
+/*===========================================================================
+ * FUNCTION   : soak
+ *
+ * DESCRIPTION: stream frames through the matcher across the wrap
+ *
+ * PARAMETERS :
+ *   @start   : frame idx of the first frame
+ *   @frames  : number of frames
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void soak(uint32_t start, uint32_t frames)
+{
+    mm_channel_test_t test;
+    mm_channel_queue_t *queue = &test.ch.bundle.superbuf_queue;
+    uint32_t f, n, last = 0, expected = 0, matched = 0, out_of_order = 0;
+    uint32_t unordered = 0;
+    int have_last = 0;
+
+    mm_channel_test_init(&test, g_types, 2, 4);
+    /* the channel has been streaming for a while */
+    queue->expected_frame_id = start;
+
+    for (n = 0, f = start; n < frames; n++, f++) {
+        uint32_t p = f - ROLLOVER_TEST_LAG;
+        uint32_t cnt, idx = 0;
+
+        if ((0 != f) && (0 != (f % ROLLOVER_TEST_DROP_PERIOD))) {
+            mm_channel_test_push(&test, 0, f);
+        }
+        if ((n >= ROLLOVER_TEST_LAG) && (0 != p)) {
+            mm_channel_test_push(&test, 1, p);
+            if (0 != (p % ROLLOVER_TEST_DROP_PERIOD)) {
+                expected++;
+            }
+        }
+
+        while (0 != (cnt = mm_channel_test_pop_matched(&test, &idx))) {
+            matched += cnt;
+            /* pop_matched reports the last one of a batch, one per frame
+             * is expected here */
+            if (have_last &&
+                    (mm_channel_util_seq_comp_w_rollover(idx, last) <= 0)) {
+                out_of_order++;
+            }
+            last = idx;
+            have_last = 1;
+        }
+        if (mm_channel_test_check_order(&test)) {
+            unordered++;
+        }
+    }
+
+    printf("soak %u frames from 0x%08x: %u matched, %u expected, "
+            "last 0x%08x\n", frames, start, matched, expected, last);
+    EXPECT(matched == expected, "soak: every complete frame matched");
+    EXPECT(0 == out_of_order, "soak: matched frames in order");
+    EXPECT(0 == unordered, "soak: queue kept in frame order");
+    EXPECT(mm_channel_util_seq_comp_w_rollover(last, start) > 0,
+            "soak: matching went past the wrap");
+    mm_channel_test_deinit(&test);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t frames = 100000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            frames = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("Usage: %s [-n frames]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 2 * ROLLOVER_TEST_LAG) {
+        printf("Usage: %s [-n frames]\n", argv[0]);
+        return 1;
+    }
+
+    test_seq_comp();
+    /* wrap in the middle of the run */
+    soak(0U - frames / 2, frames);
+    /* and right after the first frame */
+    soak(0xFFFFFFFFU, frames);
+
+    printf("%s (%d failures)\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __MM_CHANNEL_TEST_H__
+#define __MM_CHANNEL_TEST_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "mm_camera_dbg.h"
+#include "mm_camera_interface.h"
+#include "mm_camera.h"
+
+/* Host fixture for the superbuf matcher in mm_camera_channel.c. The stream
+ * layer is stubbed: a qbuf only increments qbuf_cnt, so the matcher runs
+ * without a kernel or a camera daemon. */
+
+#define MM_CHANNEL_TEST_MAX_STREAMS 4
+
+/** mm_channel_test_t: channel with bundled streams
+ *    @ch: channel object, streams[i] is bundled stream i
+ *    @info: stream info of each stream
+ *    @bufs: the one buffer each stream hands to the matcher
+ *    @num_streams: number of bundled streams
+ **/
+typedef struct {
+    mm_channel_t ch;
+    cam_stream_info_t info[MM_CHANNEL_TEST_MAX_STREAMS];
+    mm_camera_buf_def_t bufs[MM_CHANNEL_TEST_MAX_STREAMS];
+    uint8_t num_streams;
+} mm_channel_test_t;
+
+/* number of buffers returned to the stream layer by the matcher */
+extern uint32_t mm_channel_test_qbuf_cnt;
+
+extern int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t *queue);
+extern int32_t mm_channel_superbuf_comp_and_enqueue(mm_channel_t *ch_obj,
+        mm_channel_queue_t *queue, mm_camera_buf_info_t *buf);
+extern mm_channel_queue_node_t *mm_channel_superbuf_dequeue(
+        mm_channel_queue_t *queue);
+extern int32_t mm_channel_superbuf_flush(mm_channel_t *my_obj,
+        mm_channel_queue_t *queue, cam_stream_type_t cam_type);
+extern int32_t mm_channel_handle_metadata(mm_channel_t *ch_obj,
+        mm_channel_queue_t *queue, mm_camera_buf_info_t *buf_info);
+extern int8_t mm_channel_util_seq_comp_w_rollover(uint32_t v1, uint32_t v2);
+
+void mm_channel_test_init(mm_channel_test_t *test,
+        const cam_stream_type_t *types, uint8_t num_streams,
+        uint32_t max_unmatched);
+void mm_channel_test_deinit(mm_channel_test_t *test);
+int32_t mm_channel_test_push(mm_channel_test_t *test, uint8_t stream,
+        uint32_t frame_idx);
+uint32_t mm_channel_test_pop_matched(mm_channel_test_t *test,
+        uint32_t *p_frame_idx);
+int mm_channel_test_check_order(mm_channel_test_t *test);
+uint64_t mm_channel_test_now_ns(void);
+
+#endif /* __MM_CHANNEL_TEST_H__ */
@@ -0,0 +1,285 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include "mm_channel_test.h"
+
+volatile uint32_t gMmCameraIntfLogLevel = 0;
+uint32_t mm_channel_test_qbuf_cnt = 0;
+
+/* stream and thread layer stubs, the matcher only needs qbuf */
+int32_t mm_stream_fsm_fn(mm_stream_t *my_obj, mm_stream_evt_type_t evt,
+        void *in_val, void *out_val)
+{
+    (void)my_obj;
+    (void)in_val;
+    (void)out_val;
+    if (MM_STREAM_EVT_QBUF == evt) {
+        mm_channel_test_qbuf_cnt++;
+    }
+    return 0;
+}
+
+int32_t mm_stream_map_buf(mm_stream_t *my_obj, uint8_t buf_type,
+        uint32_t frame_idx, int32_t plane_idx, int fd, size_t size)
+{
+    (void)my_obj; (void)buf_type; (void)frame_idx;
+    (void)plane_idx; (void)fd; (void)size;
+    return -1;
+}
+
+int32_t mm_stream_unmap_buf(mm_stream_t *my_obj, uint8_t buf_type,
+        uint32_t frame_idx, int32_t plane_idx)
+{
+    (void)my_obj; (void)buf_type; (void)frame_idx; (void)plane_idx;
+    return -1;
+}
+
+uint32_t mm_camera_util_generate_handler(uint8_t index)
+{
+    return (uint32_t)index + 1;
+}
+
+int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t *poll_cb,
+        mm_camera_poll_thread_type_t poll_type)
+{
+    (void)poll_cb; (void)poll_type;
+    return -1;
+}
+
+int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb)
+{
+    (void)poll_cb;
+    return 0;
+}
+
+int32_t mm_camera_cmd_thread_launch(mm_camera_cmd_thread_t *cmd_thread,
+        mm_camera_cmd_cb_t cb, void *user_data)
+{
+    (void)cmd_thread; (void)cb; (void)user_data;
+    return -1;
+}
+
+int32_t mm_camera_cmd_thread_name(const char *name)
+{
+    (void)name;
+    return 0;
+}
+
+int32_t mm_camera_cmd_thread_release(mm_camera_cmd_thread_t *cmd_thread)
+{
+    (void)cmd_thread;
+    return 0;
+}
+
+int32_t mm_camera_start_zsl_snapshot(mm_camera_obj_t *my_obj)
+{
+    (void)my_obj;
+    return 0;
+}
+
+int32_t mm_camera_stop_zsl_snapshot(mm_camera_obj_t *my_obj)
+{
+    (void)my_obj;
+    return 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_test_init
+ *
+ * DESCRIPTION: set up a channel bundling the given streams
+ *
+ * PARAMETERS :
+ *   @test        : fixture
+ *   @types       : stream type of each bundled stream
+ *   @num_streams : number of bundled streams
+ *   @max_unmatched : max_unmatched_frames of the bundle
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void mm_channel_test_init(mm_channel_test_t *test,
+        const cam_stream_type_t *types, uint8_t num_streams,
+        uint32_t max_unmatched)
+{
+    mm_channel_queue_t *queue = &test->ch.bundle.superbuf_queue;
+    uint8_t i;
+
+    memset(test, 0, sizeof(*test));
+    test->num_streams = num_streams;
+    mm_channel_superbuf_queue_init(queue);
+    queue->num_streams = num_streams;
+    queue->attr.notify_mode = MM_CAMERA_SUPER_BUF_NOTIFY_CONTINUOUS;
+    queue->attr.priority = MM_CAMERA_SUPER_BUF_PRIORITY_NORMAL;
+    queue->attr.max_unmatched_frames = max_unmatched;
+
+    for (i = 0; i < num_streams; i++) {
+        mm_stream_t *s_obj = &test->ch.streams[i];
+
+        test->info[i].stream_type = types[i];
+        s_obj->my_hdl = mm_camera_util_generate_handler(i);
+        s_obj->state = MM_STREAM_STATE_ACTIVE;
+        s_obj->stream_info = &test->info[i];
+        s_obj->ch_obj = &test->ch;
+        test->bufs[i].stream_id = s_obj->my_hdl;
+        test->bufs[i].stream_type = types[i];
+        queue->bundled_streams[i] = s_obj->my_hdl;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_test_deinit
+ *
+ * DESCRIPTION: release every superbuf left in the queue
+ *
+ * PARAMETERS :
+ *   @test    : fixture
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void mm_channel_test_deinit(mm_channel_test_t *test)
+{
+    mm_channel_queue_t *queue = &test->ch.bundle.superbuf_queue;
+
+    mm_channel_superbuf_flush(&test->ch, queue, CAM_STREAM_TYPE_DEFAULT);
+    pthread_mutex_destroy(&queue->que.lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_test_push
+ *
+ * DESCRIPTION: hand one frame of a stream to the matcher
+ *
+ * PARAMETERS :
+ *   @test      : fixture
+ *   @stream    : bundled stream index
+ *   @frame_idx : frame idx of the buffer
+ *
+ * RETURN     : result of mm_channel_superbuf_comp_and_enqueue
+ *==========================================================================*/
+int32_t mm_channel_test_push(mm_channel_test_t *test, uint8_t stream,
+        uint32_t frame_idx)
+{
+    mm_camera_buf_info_t buf_info;
+
+    memset(&buf_info, 0, sizeof(buf_info));
+    test->bufs[stream].frame_idx = frame_idx;
+    buf_info.buf = &test->bufs[stream];
+    buf_info.frame_idx = frame_idx;
+    buf_info.stream_id = test->bufs[stream].stream_id;
+    return mm_channel_superbuf_comp_and_enqueue(&test->ch,
+            &test->ch.bundle.superbuf_queue, &buf_info);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_test_pop_matched
+ *
+ * DESCRIPTION: dequeue and free all matched superbufs at the queue head
+ *
+ * PARAMETERS :
+ *   @test        : fixture
+ *   @p_frame_idx : set to the frame idx of the last one dequeued
+ *
+ * RETURN     : number of superbufs dequeued
+ *==========================================================================*/
+uint32_t mm_channel_test_pop_matched(mm_channel_test_t *test,
+        uint32_t *p_frame_idx)
+{
+    mm_channel_queue_node_t *super_buf;
+    uint32_t cnt = 0;
+
+    while (NULL != (super_buf = mm_channel_superbuf_dequeue(
+            &test->ch.bundle.superbuf_queue))) {
+        if (NULL != p_frame_idx) {
+            *p_frame_idx = super_buf->frame_idx;
+        }
+        free(super_buf);
+        cnt++;
+    }
+    return cnt;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_test_check_order
+ *
+ * DESCRIPTION: check that the superbuf queue and the unmatched list are
+ *              both sorted by frame idx, rollover included
+ *
+ * PARAMETERS :
+ *   @test    : fixture
+ *
+ * RETURN     : 0 if sorted, -1 otherwise
+ *==========================================================================*/
+int mm_channel_test_check_order(mm_channel_test_t *test)
+{
+    mm_channel_queue_t *queue = &test->ch.bundle.superbuf_queue;
+    mm_channel_queue_node_t *prev = NULL;
+    mm_channel_queue_node_t *cur;
+    struct cam_list *pos;
+    uint32_t cnt = 0;
+
+    for (pos = queue->que.head.list.next; pos != &queue->que.head.list;
+            pos = pos->next) {
+        cur = (mm_channel_queue_node_t *)member_of(pos, cam_node_t, list)->data;
+        if ((NULL != prev) && (mm_channel_util_seq_comp_w_rollover(
+                prev->frame_idx, cur->frame_idx) >= 0)) {
+            return -1;
+        }
+        prev = cur;
+    }
+
+    prev = NULL;
+    for (pos = queue->unmatched_list.next; pos != &queue->unmatched_list;
+            pos = pos->next) {
+        cur = member_of(pos, mm_channel_queue_node_t, unmatched);
+        if ((NULL != prev) && (mm_channel_util_seq_comp_w_rollover(
+                prev->frame_idx, cur->frame_idx) >= 0)) {
+            return -1;
+        }
+        prev = cur;
+        cnt++;
+    }
+    return (cnt == queue->unmatched_cnt) ? 0 : -1;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_test_now_ns
+ *
+ * DESCRIPTION: monotonic time stamp
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : time in ns
+ *==========================================================================*/
+uint64_t mm_channel_test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
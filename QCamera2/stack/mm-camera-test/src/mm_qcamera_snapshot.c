@@ -115,6 +115,7 @@ int encodeData(mm_camera_test_obj_t *test_obj, mm_camera_super_buf_t* recvd_fram
 
     /* fill in sink img param */
     job.encode_job.dst_index = 0;
+    job.encode_job.priority = MM_JPEG_JOB_PRIO_SINGLE_SHOT;
 
     if (test_obj->metadata != NULL) {
         job.encode_job.p_metadata = test_obj->metadata;
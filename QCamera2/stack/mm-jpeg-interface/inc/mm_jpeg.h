@@ -44,10 +44,33 @@
 #define MM_JPEG_CIRQ_SIZE 30
 #define MM_JPEG_MAX_SESSION 10
 #define MAX_EXIF_TABLE_ENTRIES 50
+/* storage for the string and array values of the metadata exif tags */
+#define MM_JPEG_EXIF_ARENA_SIZE 512
 #define MAX_JPEG_SIZE 20000000
 #define MAX_OMX_HANDLES (5)
 #define ASPECT_TOLERANCE 0.001
 
+/* software encoder, used when the hardware component is not available
+ * or when persist.camera.jpeg.swenc is set */
+#define MM_JPEG_SW_ENCODER "OMX.qcom.image.jpeg.encoder.sw"
+
+
+/** mm_jpeg_exif_builder_t:
+ *  @info: tag table handed to the encoder, kept in APP1 order
+ *  @max_entries: capacity of the tag table
+ *  @p_arena: storage for the string and array values
+ *  @arena_size: size of @p_arena
+ *  @arena_used: bytes taken from @p_arena
+ *
+ *  Exif tags of one job
+ **/
+typedef struct {
+  QOMX_EXIF_INFO info;
+  uint32_t max_entries;
+  uint8_t *p_arena;
+  uint32_t arena_size;
+  uint32_t arena_used;
+} mm_jpeg_exif_builder_t;
 
 /** mm_jpeg_abort_state_t:
  *  @MM_JPEG_ABORT_NONE: Abort is not issued
@@ -70,6 +93,13 @@ typedef enum {
 #define JOB_ID_MAGICVAL 0x1
 #define JOB_HIST_MAX 10000
 
+/* job manager workers, persist.camera.jpeg.workers selects the count */
+#define MM_JPEG_MAX_WORKERS 4
+#define MM_JPEG_DEFAULT_WORKERS NUM_MAX_JPEG_CNCURRENT_JOBS
+
+/* released job nodes kept for reuse by the job manager */
+#define MM_JPEG_JOB_NODE_CACHE_MAX 8
+
 /** DUMP_TO_FILE:
  *  @filename: file name
  *  @p_addr: address of the buffer
@@ -127,6 +157,8 @@ typedef enum {
 #define GET_CLIENT_IDX(x) ((x) & 0xff)
 #define GET_SESSION_IDX(x) (((x) >> 8) & 0xff)
 #define GET_JOB_IDX(x) (((x) >> 16) & 0xff)
+/* non zero key of the session a job or session id belongs to */
+#define GET_SESSION_KEY(x) (((x) & 0xffff) + 1)
 
 typedef struct {
   union {
@@ -247,15 +279,29 @@ typedef union {
   void* p;
 } mm_jpeg_q_data_t;
 
-  typedef struct {
+/* number of buckets of the queue key index, power of 2 */
+#define MM_JPEG_Q_INDEX_SIZE 16
+
+typedef enum {
+  MM_JPEG_Q_NODE_SPARE,          /* owned by the queue, recycled on removal */
+  MM_JPEG_Q_NODE_EMBEDDED,       /* embedded in the element it links */
+} mm_jpeg_q_node_type_t;
+
+typedef struct mm_jpeg_q_node {
   struct cam_list list;
   mm_jpeg_q_data_t data;
+  uint32_t key;                  /* index key, 0 if not indexed */
+  struct mm_jpeg_q_node *hnext;  /* next node in the index bucket */
+  mm_jpeg_q_node_type_t type;
 } mm_jpeg_q_node_t;
 
 typedef struct {
   mm_jpeg_q_node_t head; /* dummy head */
   uint32_t size;
   pthread_mutex_t lock;
+  struct cam_list free_list;     /* spare nodes not in use */
+  uint32_t num_spare;            /* spare nodes owned by the queue */
+  mm_jpeg_q_node_t *index[MM_JPEG_Q_INDEX_SIZE]; /* key -> node */
 } mm_jpeg_queue_t;
 
 typedef enum {
@@ -300,7 +346,8 @@ typedef struct mm_jpeg_job_session {
   pthread_cond_t cond;
 
   QEXIF_INFO_DATA exif_info_local[MAX_EXIF_TABLE_ENTRIES];  //all exif tags for JPEG encoder
-  int exif_count_local;
+  uint64_t exif_arena_local[MM_JPEG_EXIF_ARENA_SIZE / sizeof(uint64_t)];
+  mm_jpeg_exif_builder_t exif_builder;
 
   mm_jpeg_cirq_t cb_q;
   int32_t ebd_count;
@@ -352,11 +399,15 @@ typedef struct {
 } mm_jpeg_decode_job_info_t;
 
 typedef struct {
+  mm_jpeg_q_node_t link;          /* queue link, the node is in one queue */
   mm_jpeg_cmd_type_t type;
   union {
     mm_jpeg_encode_job_info_t enc_info;
     mm_jpeg_decode_job_info_t dec_info;
   };
+  uint32_t prio;                  /* scheduling class, index of the todo queue */
+  int64_t enq_time_us;            /* time the job was queued */
+  int64_t start_time_us;          /* time the job was handed to its session */
 } mm_jpeg_job_q_node_t;
 
 typedef struct {
@@ -366,10 +417,49 @@ typedef struct {
   pthread_mutex_t lock;           /* job lock */
 } mm_jpeg_client_t;
 
+/** mm_jpeg_job_stats_t:
+ *  @queued: jobs waiting in the todo queue
+ *  @max_queued: peak of @queued
+ *  @dispatched: jobs handed to a session
+ *  @completed: jobs reported done by their session
+ *  @stalls: dispatch attempts that found only jobs of busy sessions
+ *  @total_wait_us: sum of the queue to dispatch times
+ *  @max_wait_us: worst queue to dispatch time
+ *  @total_run_us: sum of the dispatch to done times
+ *  @max_run_us: worst dispatch to done time
+ *
+ *  Job statistics of one scheduling class
+ **/
+typedef struct {
+  uint32_t queued;
+  uint32_t max_queued;
+  uint32_t dispatched;
+  uint32_t completed;
+  uint32_t stalls;
+  int64_t total_wait_us;
+  int64_t max_wait_us;
+  int64_t total_run_us;
+  int64_t max_run_us;
+} mm_jpeg_job_stats_t;
+
+typedef struct {
+  pthread_t pid;                  /* worker thread ID */
+  void *jpeg_obj;                 /* ptr to mm_jpeg_obj */
+  uint32_t dispatch_key;          /* session being dispatched, 0 if idle.
+                                   * Other workers skip its jobs, this is
+                                   * mutual exclusion, not an affinity */
+} mm_jpeg_job_worker_t;
+
 typedef struct {
-  pthread_t pid;                  /* job cmd thread ID */
-  cam_semaphore_t job_sem;        /* semaphore for job cmd thread */
-  mm_jpeg_queue_t job_queue;      /* queue for job to do */
+  mm_jpeg_job_worker_t worker[MM_JPEG_MAX_WORKERS]; /* job cmd threads */
+  uint32_t num_workers;
+  cam_semaphore_t job_sem;        /* semaphore for job cmd threads */
+  mm_jpeg_queue_t job_queue[MM_JPEG_JOB_PRIO_MAX]; /* jobs to do per class */
+  pthread_cond_t dispatch_cond;   /* signalled when a dispatch completes */
+  int exit;                       /* set to stop the workers */
+  pthread_mutex_t stats_lock;     /* protects stats */
+  mm_jpeg_job_stats_t stats[MM_JPEG_JOB_PRIO_MAX];
+  mm_jpeg_queue_t node_cache;     /* released job nodes kept for reuse */
 } mm_jpeg_job_cmd_thread_t;
 
 #define MAX_JPEG_CLIENT_NUM 8
@@ -425,6 +515,19 @@ extern int32_t mm_jpegdec_init(mm_jpeg_obj *my_obj);
 extern int32_t mm_jpegdec_deinit(mm_jpeg_obj *my_obj);
 extern int32_t mm_jpeg_jobmgr_thread_release(mm_jpeg_obj * my_obj);
 extern int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj);
+extern int32_t mm_jpeg_jobmgr_enq(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_q_node_t *node, uint32_t prio);
+extern mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_remove_job_by_job_id(
+  mm_jpeg_obj *my_obj, uint32_t job_id);
+extern mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_remove_job_by_session_id(
+  mm_jpeg_obj *my_obj, uint32_t session_id);
+extern void mm_jpeg_jobmgr_wait_dispatch(mm_jpeg_obj *my_obj, uint32_t id);
+extern void mm_jpeg_jobmgr_job_done(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_q_node_t *node);
+extern void mm_jpeg_jobmgr_dump_stats(mm_jpeg_obj *my_obj);
+extern mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_node_get(mm_jpeg_obj *my_obj);
+extern void mm_jpeg_jobmgr_node_put(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_q_node_t *node);
 extern int32_t mm_jpegdec_start_decode_job(mm_jpeg_obj *my_obj,
   mm_jpeg_job_t* job,
   uint32_t* jobId);
@@ -459,11 +562,24 @@ extern int32_t mm_jpeg_queue_deinit(mm_jpeg_queue_t* queue);
 extern int32_t mm_jpeg_queue_flush(mm_jpeg_queue_t* queue);
 extern uint32_t mm_jpeg_queue_get_size(mm_jpeg_queue_t* queue);
 extern mm_jpeg_q_data_t mm_jpeg_queue_peek(mm_jpeg_queue_t* queue);
-extern int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
-  exif_tag_type_t type, uint32_t count, void *data);
-extern int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data);
+extern int32_t mm_jpeg_queue_enq_node(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node, uint32_t key);
+extern int32_t mm_jpeg_queue_enq_head_node(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node, uint32_t key);
+extern mm_jpeg_q_node_t* mm_jpeg_queue_find_unlk(mm_jpeg_queue_t* queue,
+    uint32_t key);
+extern void mm_jpeg_queue_del_node_unlk(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node);
+extern mm_jpeg_q_data_t mm_jpeg_queue_remove_by_key(mm_jpeg_queue_t* queue,
+    uint32_t key);
+extern void mm_jpeg_exif_builder_init(mm_jpeg_exif_builder_t *p_builder,
+  QEXIF_INFO_DATA *p_table, uint32_t max_entries, void *p_arena,
+  uint32_t arena_size);
+extern void mm_jpeg_exif_builder_reset(mm_jpeg_exif_builder_t *p_builder);
+extern int32_t addExifEntry(mm_jpeg_exif_builder_t *p_builder,
+  exif_tag_id_t tagid, exif_tag_type_t type, uint32_t count, void *data);
 extern int process_meta_data(metadata_buffer_t *p_meta,
-  QOMX_EXIF_INFO *exif_info, mm_jpeg_exif_params_t *p_cam3a_params,
+  mm_jpeg_exif_builder_t *exif_info, mm_jpeg_exif_params_t *p_cam3a_params,
   cam_hal_version_t hal_version);
 
 OMX_ERRORTYPE mm_jpeg_session_change_state(mm_jpeg_job_session_t* p_session,
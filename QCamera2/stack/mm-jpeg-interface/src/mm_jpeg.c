@@ -31,6 +31,8 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -38,7 +40,10 @@
 #include <fcntl.h>
 #include <poll.h>
 #include <cutils/trace.h>
+#include <cutils/properties.h>
 #include <math.h>
+#include <time.h>
+#include <assert.h>
 
 #include "mm_jpeg_dbg.h"
 #include "mm_jpeg_interface.h"
@@ -282,6 +287,7 @@ OMX_ERRORTYPE mm_jpeg_session_create(mm_jpeg_job_session_t* p_session)
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   mm_jpeg_obj *my_obj = (mm_jpeg_obj *) p_session->jpeg_obj;
   char *omx_lib = "OMX.qcom.image.jpeg.encoder";
+  char prop[PROPERTY_VALUE_MAX];
 
   pthread_mutex_init(&p_session->lock, NULL);
   pthread_cond_init(&p_session->cond, NULL);
@@ -293,7 +299,9 @@ OMX_ERRORTYPE mm_jpeg_session_create(mm_jpeg_job_session_t* p_session)
   p_session->fbd_count = 0;
   p_session->encode_pid = -1;
   p_session->config = OMX_FALSE;
-  p_session->exif_count_local = 0;
+  mm_jpeg_exif_builder_init(&p_session->exif_builder,
+    p_session->exif_info_local, MAX_EXIF_TABLE_ENTRIES,
+    p_session->exif_arena_local, sizeof(p_session->exif_arena_local));
   p_session->auto_out_buf = OMX_FALSE;
 
   p_session->omx_callbacks.EmptyBufferDone = mm_jpeg_ebd;
@@ -306,10 +314,27 @@ OMX_ERRORTYPE mm_jpeg_session_create(mm_jpeg_job_session_t* p_session)
   omx_lib = "OMX.qcom.image.jpeg.encoder_pipeline";
 #endif
 
+  memset(prop, 0x0, sizeof(prop));
+  property_get("persist.camera.jpeg.swenc", prop, "0");
+  if (atoi(prop)) {
+    p_session->thumb_from_main = 0;
+    omx_lib = MM_JPEG_SW_ENCODER;
+  }
+
   rc = OMX_GetHandle(&p_session->omx_handle,
       omx_lib,
       (void *)p_session,
       &p_session->omx_callbacks);
+  if ((OMX_ErrorNone != rc) && strcmp(omx_lib, MM_JPEG_SW_ENCODER)) {
+    CDBG_ERROR("%s:%d] %s unavailable (%d), using %s", __func__, __LINE__,
+      omx_lib, rc, MM_JPEG_SW_ENCODER);
+    p_session->thumb_from_main = 0;
+    omx_lib = MM_JPEG_SW_ENCODER;
+    rc = OMX_GetHandle(&p_session->omx_handle,
+        omx_lib,
+        (void *)p_session,
+        &p_session->omx_callbacks);
+  }
   if (OMX_ErrorNone != rc) {
     CDBG_ERROR("%s:%d] OMX_GetHandle failed (%d)", __func__, __LINE__, rc);
     return rc;
@@ -1214,7 +1239,6 @@ OMX_ERRORTYPE mm_jpeg_session_config_common(mm_jpeg_job_session_t *p_session)
   OMX_INDEXTYPE exif_idx;
   OMX_CONFIG_ROTATIONTYPE rotate;
   mm_jpeg_encode_job_t *p_jobparams = &p_session->encode_job;
-  QOMX_EXIF_INFO exif_info;
 
   /* set rotation */
   memset(&rotate, 0, sizeof(rotate));
@@ -1230,7 +1254,7 @@ OMX_ERRORTYPE mm_jpeg_session_config_common(mm_jpeg_job_session_t *p_session)
     (int)p_jobparams->rotation, (int)rotate.nPortIndex);
 
   /* Set Exif data*/
-  memset(&p_session->exif_info_local[0], 0, sizeof(p_session->exif_info_local));
+  mm_jpeg_exif_builder_reset(&p_session->exif_builder);
   rc = OMX_GetExtensionIndex(p_session->omx_handle, QOMX_IMAGE_EXT_EXIF_NAME,
     &exif_idx);
   if (OMX_ErrorNone != rc) {
@@ -1249,20 +1273,17 @@ OMX_ERRORTYPE mm_jpeg_session_config_common(mm_jpeg_job_session_t *p_session)
     }
   }
   /*parse aditional exif data from the metadata*/
-  exif_info.numOfEntries = 0;
-  exif_info.exif_data = &p_session->exif_info_local[0];
-  process_meta_data(p_jobparams->p_metadata, &exif_info,
+  process_meta_data(p_jobparams->p_metadata, &p_session->exif_builder,
     &p_jobparams->cam_exif_params, p_jobparams->hal_version);
-  /* After Parse metadata */
-  p_session->exif_count_local = (int)exif_info.numOfEntries;
 
-  if (exif_info.numOfEntries > 0) {
+  if (p_session->exif_builder.info.numOfEntries > 0) {
     /* set exif tags */
-    CDBG("%s:%d] exif tags from metadata count %d", __func__, __LINE__,
-      (int)exif_info.numOfEntries);
+    CDBG("%s:%d] exif tags from metadata count %d, arena %u bytes",
+      __func__, __LINE__, (int)p_session->exif_builder.info.numOfEntries,
+      p_session->exif_builder.arena_used);
 
     rc = OMX_SetConfig(p_session->omx_handle, exif_idx,
-      &exif_info);
+      &p_session->exif_builder.info);
     if (OMX_ErrorNone != rc) {
       CDBG_ERROR("%s:%d] Error %d", __func__, __LINE__, rc);
       return rc;
@@ -1624,22 +1645,27 @@ int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t*
   CDBG("%s:%d] before dequeue session %d",
                 __func__, __LINE__, ret);
 
-  /* dequeue available omx handle */
+  /* dequeue available omx handle. mm_jpeg_jobmgr_pick only hands out a
+   * job after seeing a free handle under job_lock, and it marks the
+   * session as in dispatch by this worker. Handles are taken only here
+   * and by destroy, which waits for the dispatch, so the handle can not
+   * be gone. */
   qdata = mm_jpeg_queue_deq(p_session->session_handle_q);
-  p_session = qdata.p;
-
-  if (NULL == p_session) {
-    CDBG_HIGH("%s:%d] No available sessions %d",
-          __func__, __LINE__, ret);
-    /* No available handles */
-    qdata.p = job_node;
-    mm_jpeg_queue_enq_head(&my_obj->job_mgr.job_queue, qdata);
-
-    CDBG_HIGH("%s:%d]end enqueue %d",
-              __func__, __LINE__, ret);
-    return rc;
-
+  assert(NULL != qdata.p);
+  if (NULL == qdata.p) {
+    CDBG_ERROR("%s:%d] No available sessions for job %x",
+      __func__, __LINE__, job_node->enc_info.job_id);
+    if (NULL != p_session->params.jpeg_cb) {
+      p_session->params.jpeg_cb(JPEG_JOB_STATUS_ERROR,
+        p_session->client_hdl,
+        job_node->enc_info.job_id,
+        NULL,
+        p_session->params.userdata);
+    }
+    mm_jpeg_jobmgr_node_put(my_obj, job_node);
+    return -1;
   }
+  p_session = qdata.p;
 
   p_session->auto_out_buf = OMX_FALSE;
   if (job_node->enc_info.encode_job.dst_index < 0) {
@@ -1660,8 +1686,8 @@ int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t*
   }
 
   /* sent encode cmd to OMX, queue job into ongoing queue */
-  qdata.p = job_node;
-  rc = mm_jpeg_queue_enq(&my_obj->ongoing_job_q, qdata);
+  rc = mm_jpeg_queue_enq_node(&my_obj->ongoing_job_q, &job_node->link,
+    job_node->enc_info.job_id);
   if (rc) {
     CDBG_ERROR("%s:%d] jpeg enqueue failed %d",
       __func__, __LINE__, ret);
@@ -1702,6 +1728,469 @@ error:
 
 
 
+/** mm_jpeg_time_us:
+ *
+ *  Arguments:
+ *    None
+ *
+ *  Return:
+ *       monotonic time in microseconds
+ *
+ *  Description:
+ *       Timestamp used for the job statistics
+ *
+ **/
+static int64_t mm_jpeg_time_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/** mm_jpeg_job_node_id:
+ *
+ *  Arguments:
+ *    @node: job node
+ *
+ *  Return:
+ *       job id of the encode or decode job
+ *
+ **/
+static inline uint32_t mm_jpeg_job_node_id(mm_jpeg_job_q_node_t *node)
+{
+  return (MM_JPEG_CMD_TYPE_DECODE_JOB == node->type) ?
+    node->dec_info.job_id : node->enc_info.job_id;
+}
+
+/** mm_jpeg_jobmgr_node_get:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *
+ *  Return:
+ *       job node, NULL if out of memory
+ *
+ *  Description:
+ *       Get a job node, reusing a released one when available so that
+ *       bursts do not allocate per job. The node is not cleared.
+ *
+ **/
+mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_node_get(mm_jpeg_obj *my_obj)
+{
+  mm_jpeg_q_data_t qdata;
+
+  qdata = mm_jpeg_queue_deq(&my_obj->job_mgr.node_cache);
+  if (NULL != qdata.p) {
+    return (mm_jpeg_job_q_node_t *)qdata.p;
+  }
+  return (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
+}
+
+/** mm_jpeg_jobmgr_node_put:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @node: job node no longer in any queue
+ *
+ *  Return:
+ *       None
+ *
+ *  Description:
+ *       Release a job node, keeping up to MM_JPEG_JOB_NODE_CACHE_MAX of
+ *       them for reuse
+ *
+ **/
+void mm_jpeg_jobmgr_node_put(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t *node)
+{
+  mm_jpeg_queue_t *cache = &my_obj->job_mgr.node_cache;
+
+  if (NULL == node) {
+    return;
+  }
+  if (mm_jpeg_queue_get_size(cache) >= MM_JPEG_JOB_NODE_CACHE_MAX) {
+    free(node);
+    return;
+  }
+  node->link.data.p = node;
+  mm_jpeg_queue_enq_node(cache, &node->link, 0);
+}
+
+/** mm_jpeg_jobmgr_enq:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @node: job node
+ *    @prio: scheduling class
+ *
+ *  Return:
+ *       0 for success else failure
+ *
+ *  Description:
+ *       Queue a job into the todo queue of its class and wake up a
+ *       worker
+ *
+ **/
+int32_t mm_jpeg_jobmgr_enq(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t *node,
+  uint32_t prio)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_job_stats_t *p_stats;
+  int32_t rc;
+
+  if (prio >= MM_JPEG_JOB_PRIO_MAX) {
+    CDBG_ERROR("%s:%d] invalid priority %u, using single shot",
+      __func__, __LINE__, prio);
+    prio = MM_JPEG_JOB_PRIO_SINGLE_SHOT;
+  }
+  node->prio = prio;
+  node->enq_time_us = mm_jpeg_time_us();
+
+  /* count the job before a worker can see it */
+  p_stats = &cmd_thread->stats[prio];
+  pthread_mutex_lock(&cmd_thread->stats_lock);
+  if (++p_stats->queued > p_stats->max_queued) {
+    p_stats->max_queued = p_stats->queued;
+  }
+  pthread_mutex_unlock(&cmd_thread->stats_lock);
+
+  node->link.data.p = node;
+  rc = mm_jpeg_queue_enq_node(&cmd_thread->job_queue[prio], &node->link,
+    mm_jpeg_job_node_id(node));
+  if (0 != rc) {
+    pthread_mutex_lock(&cmd_thread->stats_lock);
+    p_stats->queued--;
+    pthread_mutex_unlock(&cmd_thread->stats_lock);
+    return rc;
+  }
+  cam_sem_post(&cmd_thread->job_sem);
+  return 0;
+}
+
+/** mm_jpeg_jobmgr_remove_job:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @id: job or session id
+ *    @mask: bits of the job id compared against @id
+ *
+ *  Return:
+ *       removed job node, NULL if none matched
+ *
+ *  Description:
+ *       Remove the first matching job from the todo queues. A full job
+ *       id is looked up in the queue index, a session id needs a scan.
+ *
+ **/
+static mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_remove_job(mm_jpeg_obj *my_obj,
+  uint32_t id, uint32_t mask)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_queue_t *queue;
+  mm_jpeg_q_node_t *node;
+  mm_jpeg_job_q_node_t *data;
+  mm_jpeg_job_q_node_t *job_node = NULL;
+  struct cam_list *head;
+  struct cam_list *pos;
+  uint32_t prio;
+
+  for (prio = 0; (prio < MM_JPEG_JOB_PRIO_MAX) && !job_node; prio++) {
+    queue = &cmd_thread->job_queue[prio];
+    pthread_mutex_lock(&queue->lock);
+    if (0xFFFFFFFF == mask) {
+      job_node = mm_jpeg_queue_remove_job_unlk(queue, id);
+    } else {
+      head = &queue->head.list;
+      pos = head->next;
+      while (pos != head) {
+        node = member_of(pos, mm_jpeg_q_node_t, list);
+        data = (mm_jpeg_job_q_node_t *)node->data.p;
+        if (data && ((mm_jpeg_job_node_id(data) & mask) == (id & mask))) {
+          job_node = data;
+          mm_jpeg_queue_del_node_unlk(queue, node);
+          break;
+        }
+        pos = pos->next;
+      }
+    }
+    pthread_mutex_unlock(&queue->lock);
+  }
+
+  if (job_node) {
+    pthread_mutex_lock(&cmd_thread->stats_lock);
+    cmd_thread->stats[job_node->prio].queued--;
+    pthread_mutex_unlock(&cmd_thread->stats_lock);
+  }
+  return job_node;
+}
+
+/** mm_jpeg_jobmgr_remove_job_by_job_id:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @job_id: job id
+ *
+ *  Return:
+ *       removed job node, NULL if not queued
+ *
+ **/
+mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_remove_job_by_job_id(
+  mm_jpeg_obj *my_obj, uint32_t job_id)
+{
+  return mm_jpeg_jobmgr_remove_job(my_obj, job_id, 0xFFFFFFFF);
+}
+
+/** mm_jpeg_jobmgr_remove_job_by_session_id:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @session_id: session id
+ *
+ *  Return:
+ *       first queued job of the session, NULL if none
+ *
+ **/
+mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_remove_job_by_session_id(
+  mm_jpeg_obj *my_obj, uint32_t session_id)
+{
+  return mm_jpeg_jobmgr_remove_job(my_obj, session_id, 0xFFFF);
+}
+
+/** mm_jpeg_jobmgr_wait_dispatch:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @id: job or session id
+ *
+ *  Return:
+ *       None
+ *
+ *  Description:
+ *       Wait until no worker is handing a job of the session to OMX.
+ *       Called with job_lock held, the workers take it to report the end
+ *       of a dispatch, so the session can be aborted or destroyed safely.
+ *
+ **/
+void mm_jpeg_jobmgr_wait_dispatch(mm_jpeg_obj *my_obj, uint32_t id)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  uint32_t key = GET_SESSION_KEY(id);
+  uint32_t i;
+
+  for (i = 0; i < cmd_thread->num_workers; i++) {
+    while (cmd_thread->worker[i].dispatch_key == key) {
+      pthread_cond_wait(&cmd_thread->dispatch_cond, &my_obj->job_lock);
+    }
+  }
+}
+
+/** mm_jpeg_jobmgr_job_done:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @node: job node removed from the ongoing queue
+ *
+ *  Return:
+ *       None
+ *
+ *  Description:
+ *       Account the run time of a finished job. Called from the OMX
+ *       callback context, so only stats_lock is taken.
+ *
+ **/
+void mm_jpeg_jobmgr_job_done(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t *node)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_job_stats_t *p_stats;
+  int64_t run_us;
+
+  if ((NULL == node) || (node->prio >= MM_JPEG_JOB_PRIO_MAX) ||
+    !node->start_time_us) {
+    return;
+  }
+  run_us = mm_jpeg_time_us() - node->start_time_us;
+  p_stats = &cmd_thread->stats[node->prio];
+
+  pthread_mutex_lock(&cmd_thread->stats_lock);
+  p_stats->completed++;
+  p_stats->total_run_us += run_us;
+  if (run_us > p_stats->max_run_us) {
+    p_stats->max_run_us = run_us;
+  }
+  pthread_mutex_unlock(&cmd_thread->stats_lock);
+
+  CDBG_HIGH("%s:%d] job 0x%x prio %u wait %lld us run %lld us", __func__,
+    __LINE__, mm_jpeg_job_node_id(node), node->prio,
+    (long long)(node->start_time_us - node->enq_time_us),
+    (long long)run_us);
+}
+
+/** mm_jpeg_jobmgr_dump_stats:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *
+ *  Return:
+ *       None
+ *
+ *  Description:
+ *       Log the job statistics of every scheduling class
+ *
+ **/
+void mm_jpeg_jobmgr_dump_stats(mm_jpeg_obj *my_obj)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_job_stats_t stats[MM_JPEG_JOB_PRIO_MAX];
+  uint32_t prio;
+
+  pthread_mutex_lock(&cmd_thread->stats_lock);
+  memcpy(stats, cmd_thread->stats, sizeof(stats));
+  pthread_mutex_unlock(&cmd_thread->stats_lock);
+
+  for (prio = 0; prio < MM_JPEG_JOB_PRIO_MAX; prio++) {
+    if (!stats[prio].dispatched && !stats[prio].queued) {
+      continue;
+    }
+    CDBG_HIGH("%s:%d] prio %u queued %u peak %u dispatched %u done %u "
+      "stalls %u wait avg %lld max %lld us run avg %lld max %lld us",
+      __func__, __LINE__, prio, stats[prio].queued, stats[prio].max_queued,
+      stats[prio].dispatched, stats[prio].completed, stats[prio].stalls,
+      (long long)(stats[prio].dispatched ?
+        stats[prio].total_wait_us / stats[prio].dispatched : 0),
+      (long long)stats[prio].max_wait_us,
+      (long long)(stats[prio].completed ?
+        stats[prio].total_run_us / stats[prio].completed : 0),
+      (long long)stats[prio].max_run_us);
+  }
+}
+
+/** mm_jpeg_jobmgr_session_ready:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @node: job node
+ *
+ *  Return:
+ *       1 if the job can be handed to its session now
+ *
+ *  Description:
+ *       Encode jobs need a free OMX handle of their session. Jobs of
+ *       unknown sessions are reported ready so they fail in the normal
+ *       error path instead of staying queued.
+ *
+ **/
+static int mm_jpeg_jobmgr_session_ready(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_q_node_t *node)
+{
+  mm_jpeg_job_session_t *p_session;
+
+  if (MM_JPEG_CMD_TYPE_JOB != node->type) {
+    return 1;
+  }
+  p_session = mm_jpeg_get_session(my_obj, node->enc_info.job_id);
+  if ((NULL == p_session) || (NULL == p_session->session_handle_q)) {
+    return 1;
+  }
+  return (mm_jpeg_queue_get_size(p_session->session_handle_q) > 0);
+}
+
+/** mm_jpeg_jobmgr_pick:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @p_worker: worker asking for a job
+ *
+ *  Return:
+ *       job to dispatch, NULL if none can run now
+ *
+ *  Description:
+ *       Take the oldest runnable job of the highest class. Jobs of a
+ *       session that is being dispatched by another worker or has no
+ *       free OMX handle stay queued in order and do not block the jobs
+ *       of other sessions. Called with job_lock held.
+ *
+ **/
+static mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_pick(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_worker_t *p_worker)
+{
+  mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
+  mm_jpeg_job_stats_t *p_stats;
+  mm_jpeg_queue_t *queue;
+  mm_jpeg_q_node_t *node;
+  mm_jpeg_job_q_node_t *data;
+  mm_jpeg_job_q_node_t *job_node = NULL;
+  struct cam_list *head;
+  struct cam_list *pos;
+  uint32_t i, prio, key = 0, busy = 0;
+  uint32_t stall_prio = MM_JPEG_JOB_PRIO_MAX;
+  int64_t wait_us;
+  int in_dispatch;
+
+  for (i = 0; i < cmd_thread->num_workers; i++) {
+    if (cmd_thread->worker[i].dispatch_key) {
+      busy++;
+    }
+  }
+  if (mm_jpeg_queue_get_size(&my_obj->ongoing_job_q) + busy >=
+    NUM_MAX_JPEG_CNCURRENT_JOBS) {
+    CDBG("%s:%d] ongoing jobs already reach max", __func__, __LINE__);
+    return NULL;
+  }
+
+  for (prio = 0; (prio < MM_JPEG_JOB_PRIO_MAX) && !job_node; prio++) {
+    queue = &cmd_thread->job_queue[prio];
+    pthread_mutex_lock(&queue->lock);
+    head = &queue->head.list;
+    pos = head->next;
+    while (pos != head) {
+      node = member_of(pos, mm_jpeg_q_node_t, list);
+      data = (mm_jpeg_job_q_node_t *)node->data.p;
+      pos = pos->next;
+      if (NULL == data) {
+        continue;
+      }
+      key = GET_SESSION_KEY(mm_jpeg_job_node_id(data));
+      in_dispatch = 0;
+      for (i = 0; i < cmd_thread->num_workers; i++) {
+        if (cmd_thread->worker[i].dispatch_key == key) {
+          in_dispatch = 1;
+          break;
+        }
+      }
+      if (in_dispatch || !mm_jpeg_jobmgr_session_ready(my_obj, data)) {
+        if (MM_JPEG_JOB_PRIO_MAX == stall_prio) {
+          stall_prio = prio;
+        }
+        continue;
+      }
+      job_node = data;
+      mm_jpeg_queue_del_node_unlk(queue, node);
+      break;
+    }
+    pthread_mutex_unlock(&queue->lock);
+  }
+
+  if (job_node) {
+    p_worker->dispatch_key = key;
+    job_node->start_time_us = mm_jpeg_time_us();
+    wait_us = job_node->start_time_us - job_node->enq_time_us;
+    p_stats = &cmd_thread->stats[job_node->prio];
+    pthread_mutex_lock(&cmd_thread->stats_lock);
+    p_stats->queued--;
+    p_stats->dispatched++;
+    p_stats->total_wait_us += wait_us;
+    if (wait_us > p_stats->max_wait_us) {
+      p_stats->max_wait_us = wait_us;
+    }
+    pthread_mutex_unlock(&cmd_thread->stats_lock);
+  } else if (MM_JPEG_JOB_PRIO_MAX != stall_prio) {
+    pthread_mutex_lock(&cmd_thread->stats_lock);
+    cmd_thread->stats[stall_prio].stalls++;
+    pthread_mutex_unlock(&cmd_thread->stats_lock);
+  }
+  return job_node;
+}
+
 /** mm_jpeg_jobmgr_thread:
  *
  *  Arguments:
@@ -1711,16 +2200,17 @@ error:
  *       0 for success else failure
  *
  *  Description:
- *       job manager thread main function
+ *       job manager worker main function. Every wakeup drains all the
+ *       jobs that can run; jobs that cannot stay queued until a job
+ *       completes or a session is destroyed, which posts job_sem again.
  *
  **/
 static void *mm_jpeg_jobmgr_thread(void *data)
 {
-  mm_jpeg_q_data_t qdata;
   int rc = 0;
   int running = 1;
-  uint32_t num_ongoing_jobs = 0;
-  mm_jpeg_obj *my_obj = (mm_jpeg_obj*)data;
+  mm_jpeg_job_worker_t *p_worker = (mm_jpeg_job_worker_t *)data;
+  mm_jpeg_obj *my_obj = (mm_jpeg_obj *)p_worker->jpeg_obj;
   mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
   mm_jpeg_job_q_node_t* node = NULL;
   prctl(PR_SET_NAME, (unsigned long)"mm_jpeg_thread", 0, 0, 0);
@@ -1735,19 +2225,12 @@ static void *mm_jpeg_jobmgr_thread(void *data)
       }
     } while (rc != 0);
 
-    /* check ongoing q size */
-    num_ongoing_jobs = mm_jpeg_queue_get_size(&my_obj->ongoing_job_q);
-    if (num_ongoing_jobs >= NUM_MAX_JPEG_CNCURRENT_JOBS) {
-      CDBG("%s:%d] ongoing job already reach max %d", __func__,
-        __LINE__, num_ongoing_jobs);
-      continue;
-    }
-
     pthread_mutex_lock(&my_obj->job_lock);
-    /* can go ahead with new work */
-    qdata = mm_jpeg_queue_deq(&cmd_thread->job_queue);
-    node = (mm_jpeg_job_q_node_t*)qdata.p;
-    if (node != NULL) {
+    while (!cmd_thread->exit &&
+      (NULL != (node = mm_jpeg_jobmgr_pick(my_obj, p_worker)))) {
+      /* the dispatch key keeps destroy/abort of this session waiting,
+       * other sessions go ahead on the other workers */
+      pthread_mutex_unlock(&my_obj->job_lock);
       switch (node->type) {
       case MM_JPEG_CMD_TYPE_JOB:
         rc = mm_jpeg_process_encoding_job(my_obj, node);
@@ -1755,15 +2238,15 @@ static void *mm_jpeg_jobmgr_thread(void *data)
       case MM_JPEG_CMD_TYPE_DECODE_JOB:
         rc = mm_jpegdec_process_decoding_job(my_obj, node);
         break;
-      case MM_JPEG_CMD_TYPE_EXIT:
       default:
-        /* free node */
-        free(node);
-        /* set running flag to false */
-        running = 0;
+        mm_jpeg_jobmgr_node_put(my_obj, node);
         break;
       }
+      pthread_mutex_lock(&my_obj->job_lock);
+      p_worker->dispatch_key = 0;
+      pthread_cond_broadcast(&cmd_thread->dispatch_cond);
     }
+    running = !cmd_thread->exit;
     pthread_mutex_unlock(&my_obj->job_lock);
 
   } while (running);
@@ -1779,23 +2262,57 @@ static void *mm_jpeg_jobmgr_thread(void *data)
  *       0 for success else failure
  *
  *  Description:
- *       launches the job manager thread
+ *       launches the job manager threads
  *
  **/
 int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj)
 {
   int32_t rc = 0;
   mm_jpeg_job_cmd_thread_t *job_mgr = &my_obj->job_mgr;
+  char prop[PROPERTY_VALUE_MAX];
+  uint32_t num_workers, i;
+  char name[16];
+
+  memset(prop, 0x0, sizeof(prop));
+  property_get("persist.camera.jpeg.workers", prop, "0");
+  num_workers = (uint32_t)atoi(prop);
+  if (0 == num_workers) {
+    num_workers = MM_JPEG_DEFAULT_WORKERS;
+  } else if (num_workers > MM_JPEG_MAX_WORKERS) {
+    num_workers = MM_JPEG_MAX_WORKERS;
+  }
 
   cam_sem_init(&job_mgr->job_sem, 0);
-  mm_jpeg_queue_init(&job_mgr->job_queue);
-
-  /* launch the thread */
-  pthread_create(&job_mgr->pid,
-    NULL,
-    mm_jpeg_jobmgr_thread,
-    (void *)my_obj);
-  pthread_setname_np(job_mgr->pid, "CAM_jpeg_jobmgr");
+  for (i = 0; i < MM_JPEG_JOB_PRIO_MAX; i++) {
+    mm_jpeg_queue_init(&job_mgr->job_queue[i]);
+  }
+  mm_jpeg_queue_init(&job_mgr->node_cache);
+  pthread_cond_init(&job_mgr->dispatch_cond, NULL);
+  pthread_mutex_init(&job_mgr->stats_lock, NULL);
+  memset(job_mgr->stats, 0x0, sizeof(job_mgr->stats));
+  job_mgr->exit = 0;
+  job_mgr->num_workers = 0;
+
+  /* launch the threads */
+  for (i = 0; i < num_workers; i++) {
+    job_mgr->worker[i].jpeg_obj = my_obj;
+    job_mgr->worker[i].dispatch_key = 0;
+    if (pthread_create(&job_mgr->worker[i].pid,
+      NULL,
+      mm_jpeg_jobmgr_thread,
+      (void *)&job_mgr->worker[i])) {
+      CDBG_ERROR("%s:%d] Cannot create worker %u", __func__, __LINE__, i);
+      break;
+    }
+    snprintf(name, sizeof(name), "CAM_jpeg_job%u", i);
+    pthread_setname_np(job_mgr->worker[i].pid, name);
+    job_mgr->num_workers++;
+  }
+  if (0 == job_mgr->num_workers) {
+    rc = -1;
+  }
+  CDBG_HIGH("%s:%d] %u job workers", __func__, __LINE__,
+    job_mgr->num_workers);
   return rc;
 }
 
@@ -1808,34 +2325,36 @@ int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj)
  *       0 for success else failure
  *
  *  Description:
- *       Releases the job manager thread
+ *       Releases the job manager threads
  *
  **/
 int32_t mm_jpeg_jobmgr_thread_release(mm_jpeg_obj * my_obj)
 {
-  mm_jpeg_q_data_t qdata;
   int32_t rc = 0;
   mm_jpeg_job_cmd_thread_t * cmd_thread = &my_obj->job_mgr;
-  mm_jpeg_job_q_node_t* node =
-    (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
-  if (NULL == node) {
-    CDBG_ERROR("%s: No memory for mm_jpeg_job_q_node_t", __func__);
-    return -1;
-  }
-
-  memset(node, 0, sizeof(mm_jpeg_job_q_node_t));
-  node->type = MM_JPEG_CMD_TYPE_EXIT;
+  uint32_t i;
 
-  qdata.p = node;
-  mm_jpeg_queue_enq(&cmd_thread->job_queue, qdata);
-  cam_sem_post(&cmd_thread->job_sem);
+  pthread_mutex_lock(&my_obj->job_lock);
+  cmd_thread->exit = 1;
+  pthread_mutex_unlock(&my_obj->job_lock);
+  for (i = 0; i < cmd_thread->num_workers; i++) {
+    cam_sem_post(&cmd_thread->job_sem);
+  }
 
-  /* wait until cmd thread exits */
-  if (pthread_join(cmd_thread->pid, NULL) != 0) {
-    CDBG("%s: pthread dead already", __func__);
+  /* wait until cmd threads exit */
+  for (i = 0; i < cmd_thread->num_workers; i++) {
+    if (pthread_join(cmd_thread->worker[i].pid, NULL) != 0) {
+      CDBG("%s: pthread dead already", __func__);
+    }
   }
-  mm_jpeg_queue_deinit(&cmd_thread->job_queue);
+  mm_jpeg_jobmgr_dump_stats(my_obj);
 
+  for (i = 0; i < MM_JPEG_JOB_PRIO_MAX; i++) {
+    mm_jpeg_queue_deinit(&cmd_thread->job_queue[i]);
+  }
+  mm_jpeg_queue_deinit(&cmd_thread->node_cache);
+  pthread_cond_destroy(&cmd_thread->dispatch_cond);
+  pthread_mutex_destroy(&cmd_thread->stats_lock);
   cam_sem_destroy(&cmd_thread->job_sem);
   memset(cmd_thread, 0, sizeof(mm_jpeg_job_cmd_thread_t));
   return rc;
@@ -2052,7 +2571,6 @@ int32_t mm_jpeg_start_job(mm_jpeg_obj *my_obj,
   mm_jpeg_job_t *job,
   uint32_t *job_id)
 {
-  mm_jpeg_q_data_t qdata;
   int32_t rc = -1;
   uint8_t session_idx = 0;
   uint8_t client_idx = 0;
@@ -2089,7 +2607,7 @@ int32_t mm_jpeg_start_job(mm_jpeg_obj *my_obj,
   }
 
   /* enqueue new job into todo job queue */
-  node = (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
+  node = mm_jpeg_jobmgr_node_get(my_obj);
   if (NULL == node) {
     CDBG_ERROR("%s: No memory for mm_jpeg_job_q_node_t", __func__);
     return -1;
@@ -2115,11 +2633,7 @@ int32_t mm_jpeg_start_job(mm_jpeg_obj *my_obj,
 
 
 
-  qdata.p = node;
-  rc = mm_jpeg_queue_enq(&my_obj->job_mgr.job_queue, qdata);
-  if (0 == rc) {
-      cam_sem_post(&my_obj->job_mgr.job_sem);
-  }
+  rc = mm_jpeg_jobmgr_enq(my_obj, node, job->encode_job.priority);
 
   CDBG_HIGH("%s:%d] X", __func__, __LINE__);
 
@@ -2152,10 +2666,13 @@ int32_t mm_jpeg_abort_job(mm_jpeg_obj *my_obj,
   CDBG("%s:%d] ", __func__, __LINE__);
   pthread_mutex_lock(&my_obj->job_lock);
 
+  /* let a worker finish handing a job of this session to OMX */
+  mm_jpeg_jobmgr_wait_dispatch(my_obj, jobId);
+
   /* abort job if in todo queue */
-  node = mm_jpeg_queue_remove_job_by_job_id(&my_obj->job_mgr.job_queue, jobId);
+  node = mm_jpeg_jobmgr_remove_job_by_job_id(my_obj, jobId);
   if (NULL != node) {
-    free(node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
     goto abort_done;
   }
 
@@ -2170,7 +2687,7 @@ int32_t mm_jpeg_abort_job(mm_jpeg_obj *my_obj,
       CDBG_ERROR("%s:%d] Invalid job id 0x%x", __func__, __LINE__,
         node->enc_info.job_id);
     }
-    free(node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
     goto abort_done;
   }
 
@@ -2431,20 +2948,13 @@ error2:
 static int32_t mm_jpegenc_destroy_job(mm_jpeg_job_session_t *p_session)
 {
   mm_jpeg_encode_job_t *p_jobparams = &p_session->encode_job;
-  int i = 0, rc = 0;
 
   CDBG_HIGH("%s:%d] Exif entry count %d %d", __func__, __LINE__,
     (int)p_jobparams->exif_info.numOfEntries,
-    (int)p_session->exif_count_local);
-  for (i = 0; i < p_session->exif_count_local; i++) {
-    rc = releaseExifEntry(&p_session->exif_info_local[i]);
-    if (rc) {
-      CDBG_ERROR("%s:%d] Exif release failed (%d)", __func__, __LINE__, rc);
-    }
-  }
-  p_session->exif_count_local = 0;
+    (int)p_session->exif_builder.info.numOfEntries);
+  mm_jpeg_exif_builder_reset(&p_session->exif_builder);
 
-  return rc;
+  return 0;
 }
 
 /** mm_jpeg_session_encode:
@@ -2472,7 +2982,8 @@ static void mm_jpegenc_job_done(mm_jpeg_job_session_t *p_session)
   node = mm_jpeg_queue_remove_job_by_job_id(&my_obj->ongoing_job_q,
     p_session->jobId);
   if (node) {
-    free(node);
+    mm_jpeg_jobmgr_job_done(my_obj, node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
   }
   p_session->encoding = OMX_FALSE;
 
@@ -2522,19 +3033,22 @@ int32_t mm_jpeg_destroy_session(mm_jpeg_obj *my_obj,
 
   pthread_mutex_lock(&my_obj->job_lock);
 
+  /* let a worker finish handing a job of this session to OMX */
+  mm_jpeg_jobmgr_wait_dispatch(my_obj, session_id);
+
   /* abort job if in todo queue */
   CDBG_HIGH("%s:%d] abort todo jobs", __func__, __LINE__);
-  node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->job_mgr.job_queue, session_id);
+  node = mm_jpeg_jobmgr_remove_job_by_session_id(my_obj, session_id);
   while (NULL != node) {
-    free(node);
-    node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->job_mgr.job_queue, session_id);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
+    node = mm_jpeg_jobmgr_remove_job_by_session_id(my_obj, session_id);
   }
 
   /* abort job if in ongoing queue */
   CDBG_HIGH("%s:%d] abort ongoing jobs", __func__, __LINE__);
   node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->ongoing_job_q, session_id);
   while (NULL != node) {
-    free(node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
     node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->ongoing_job_q, session_id);
   }
 
@@ -2570,6 +3084,8 @@ int32_t mm_jpeg_destroy_session(mm_jpeg_obj *my_obj,
   p_session->out_buf_q = NULL;
 
 
+  mm_jpeg_jobmgr_dump_stats(my_obj);
+
   /* wake up jobMgr thread to work on new job if there is any */
   cam_sem_post(&my_obj->job_mgr.job_sem);
 
@@ -2610,19 +3126,22 @@ int32_t mm_jpeg_destroy_session_unlocked(mm_jpeg_obj *my_obj,
 
   session_id = p_session->sessionId;
 
+  /* let a worker finish handing a job of this session to OMX */
+  mm_jpeg_jobmgr_wait_dispatch(my_obj, session_id);
+
   /* abort job if in todo queue */
   CDBG("%s:%d] abort todo jobs", __func__, __LINE__);
-  node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->job_mgr.job_queue, session_id);
+  node = mm_jpeg_jobmgr_remove_job_by_session_id(my_obj, session_id);
   while (NULL != node) {
-    free(node);
-    node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->job_mgr.job_queue, session_id);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
+    node = mm_jpeg_jobmgr_remove_job_by_session_id(my_obj, session_id);
   }
 
   /* abort job if in ongoing queue */
   CDBG("%s:%d] abort ongoing jobs", __func__, __LINE__);
   node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->ongoing_job_q, session_id);
   while (NULL != node) {
-    free(node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
     node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->ongoing_job_q, session_id);
   }
 
@@ -2851,9 +3370,7 @@ mm_jpeg_job_q_node_t* mm_jpeg_queue_remove_job_by_client_id(
     if (data && (data->enc_info.client_handle == client_hdl)) {
       CDBG_HIGH("%s:%d] found matching client handle", __func__, __LINE__);
       job_node = data;
-      cam_list_del_node(&node->list);
-      queue->size--;
-      free(node);
+      mm_jpeg_queue_del_node_unlk(queue, node);
       CDBG_HIGH("%s: queue size = %d", __func__, queue->size);
       break;
     }
@@ -2885,9 +3402,7 @@ mm_jpeg_job_q_node_t* mm_jpeg_queue_remove_job_by_session_id(
     if (data && (data->enc_info.encode_job.session_id == session_id)) {
       CDBG_HIGH("%s:%d] found matching session id", __func__, __LINE__);
       job_node = data;
-      cam_list_del_node(&node->list);
-      queue->size--;
-      free(node);
+      mm_jpeg_queue_del_node_unlk(queue, node);
       CDBG_HIGH("%s: queue size = %d", __func__, queue->size);
       break;
     }
@@ -2903,72 +3418,31 @@ mm_jpeg_job_q_node_t* mm_jpeg_queue_remove_job_by_session_id(
 mm_jpeg_job_q_node_t* mm_jpeg_queue_remove_job_by_job_id(
   mm_jpeg_queue_t* queue, uint32_t job_id)
 {
-  mm_jpeg_q_node_t* node = NULL;
-  mm_jpeg_job_q_node_t* data = NULL;
   mm_jpeg_job_q_node_t* job_node = NULL;
-  struct cam_list *head = NULL;
-  struct cam_list *pos = NULL;
-  uint32_t lq_job_id;
 
   pthread_mutex_lock(&queue->lock);
-  head = &queue->head.list;
-  pos = head->next;
-  while(pos != head) {
-    node = member_of(pos, mm_jpeg_q_node_t, list);
-    data = (mm_jpeg_job_q_node_t *)node->data.p;
-
-    if(NULL == data) {
-      CDBG_ERROR("%s:%d] Data is NULL", __func__, __LINE__);
-      pthread_mutex_unlock(&queue->lock);
-      return NULL;
-    }
-
-    if (data->type == MM_JPEG_CMD_TYPE_DECODE_JOB) {
-      lq_job_id = data->dec_info.job_id;
-    } else {
-      lq_job_id = data->enc_info.job_id;
-    }
+  job_node = mm_jpeg_queue_remove_job_unlk(queue, job_id);
+  pthread_mutex_unlock(&queue->lock);
 
-    if (data && (lq_job_id == job_id)) {
-      CDBG_HIGH("%s:%d] found matching job id", __func__, __LINE__);
-      job_node = data;
-      cam_list_del_node(&node->list);
-      queue->size--;
-      free(node);
-      break;
-    }
-    pos = pos->next;
+  if (job_node) {
+    CDBG_HIGH("%s:%d] found matching job id", __func__, __LINE__);
   }
 
-  pthread_mutex_unlock(&queue->lock);
-
   return job_node;
 }
 
-/* remove job from the queue with matching job id */
+/* remove job from the queue with matching job id, job nodes are indexed
+ * by job id so no scan is needed */
 mm_jpeg_job_q_node_t* mm_jpeg_queue_remove_job_unlk(
   mm_jpeg_queue_t* queue, uint32_t job_id)
 {
   mm_jpeg_q_node_t* node = NULL;
-  mm_jpeg_job_q_node_t* data = NULL;
   mm_jpeg_job_q_node_t* job_node = NULL;
-  struct cam_list *head = NULL;
-  struct cam_list *pos = NULL;
-
-  head = &queue->head.list;
-  pos = head->next;
-  while(pos != head) {
-    node = member_of(pos, mm_jpeg_q_node_t, list);
-    data = (mm_jpeg_job_q_node_t *)node->data.p;
 
-    if (data && (data->enc_info.job_id == job_id)) {
-      job_node = data;
-      cam_list_del_node(&node->list);
-      queue->size--;
-      free(node);
-      break;
-    }
-    pos = pos->next;
+  node = mm_jpeg_queue_find_unlk(queue, job_id);
+  if (node) {
+    job_node = (mm_jpeg_job_q_node_t *)node->data.p;
+    mm_jpeg_queue_del_node_unlk(queue, node);
   }
 
   return job_node;
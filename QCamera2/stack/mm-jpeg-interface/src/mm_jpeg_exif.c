@@ -41,241 +41,153 @@
         ((a >= 0) ? (uint32_t)(a + 0.5) : (uint32_t)(a - 0.5))
 
 
-/** addExifEntry:
+/** mm_jpeg_exif_builder_init:
  *
  *  Arguments:
- *   @exif_info : Exif info struct
- *   @p_session: job session
- *   @tagid   : exif tag ID
- *   @type    : data type
- *   @count   : number of data in uint of its type
- *   @data    : input data ptr
+ *   @p_builder : exif builder
+ *   @p_table   : tag table filled by the builder
+ *   @max_entries: number of entries in @p_table
+ *   @p_arena   : storage for strings and arrays
+ *   @arena_size: size of @p_arena in bytes
  *
- *  Retrun     : int32_t type of status
- *               0  -- success
- *              none-zero failure code
+ *  Return     : none
  *
  *  Description:
- *       Function to add an entry to exif data
+ *       Attach the tag table and the arena to the builder. Both are
+ *       owned by the caller and live as long as the builder.
  *
  **/
-int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
-  exif_tag_type_t type, uint32_t count, void *data)
+void mm_jpeg_exif_builder_init(mm_jpeg_exif_builder_t *p_builder,
+  QEXIF_INFO_DATA *p_table, uint32_t max_entries, void *p_arena,
+  uint32_t arena_size)
 {
-    int32_t rc = 0;
-    uint32_t numOfEntries = (uint32_t)p_exif_info->numOfEntries;
-    QEXIF_INFO_DATA *p_info_data = p_exif_info->exif_data;
-    if(numOfEntries >= MAX_EXIF_TABLE_ENTRIES) {
-        ALOGE("%s: Number of entries exceeded limit", __func__);
-        return -1;
-    }
+  p_builder->info.exif_data = p_table;
+  p_builder->max_entries = max_entries;
+  p_builder->p_arena = (uint8_t *)p_arena;
+  p_builder->arena_size = arena_size;
+  mm_jpeg_exif_builder_reset(p_builder);
+}
 
-    p_info_data[numOfEntries].tag_id = tagid;
-    p_info_data[numOfEntries].tag_entry.type = type;
-    p_info_data[numOfEntries].tag_entry.count = count;
-    p_info_data[numOfEntries].tag_entry.copy = 1;
-    switch (type) {
-    case EXIF_BYTE: {
-      if (count > 1) {
-        uint8_t *values = (uint8_t *)malloc(count);
-        if (values == NULL) {
-          ALOGE("%s: No memory for byte array", __func__);
-          rc = -1;
-        } else {
-          memcpy(values, data, count);
-          p_info_data[numOfEntries].tag_entry.data._bytes = values;
-        }
-      } else {
-        p_info_data[numOfEntries].tag_entry.data._byte = *(uint8_t *)data;
-      }
-    }
-    break;
-    case EXIF_ASCII: {
-      char *str = NULL;
-      str = (char *)malloc(count + 1);
-      if (str == NULL) {
-        ALOGE("%s: No memory for ascii string", __func__);
-        rc = -1;
-      } else {
-        memset(str, 0, count + 1);
-        memcpy(str, data, count);
-        p_info_data[numOfEntries].tag_entry.data._ascii = str;
-      }
-    }
-    break;
-    case EXIF_SHORT: {
-      if (count > 1) {
-        uint16_t *values = (uint16_t *)malloc(count * sizeof(uint16_t));
-        if (values == NULL) {
-          ALOGE("%s: No memory for short array", __func__);
-          rc = -1;
-        } else {
-          memcpy(values, data, count * sizeof(uint16_t));
-          p_info_data[numOfEntries].tag_entry.data._shorts = values;
-        }
-      } else {
-        p_info_data[numOfEntries].tag_entry.data._short = *(uint16_t *)data;
-      }
-    }
-    break;
-    case EXIF_LONG: {
-      if (count > 1) {
-        uint32_t *values = (uint32_t *)malloc(count * sizeof(uint32_t));
-        if (values == NULL) {
-          ALOGE("%s: No memory for long array", __func__);
-          rc = -1;
-        } else {
-          memcpy(values, data, count * sizeof(uint32_t));
-          p_info_data[numOfEntries].tag_entry.data._longs = values;
-        }
-      } else {
-        p_info_data[numOfEntries].tag_entry.data._long = *(uint32_t *)data;
-      }
-    }
-    break;
-    case EXIF_RATIONAL: {
-      if (count > 1) {
-        rat_t *values = (rat_t *)malloc(count * sizeof(rat_t));
-        if (values == NULL) {
-          ALOGE("%s: No memory for rational array", __func__);
-          rc = -1;
-        } else {
-          memcpy(values, data, count * sizeof(rat_t));
-          p_info_data[numOfEntries].tag_entry.data._rats = values;
-        }
-      } else {
-        p_info_data[numOfEntries].tag_entry.data._rat = *(rat_t *)data;
-      }
-    }
-    break;
-    case EXIF_UNDEFINED: {
-      uint8_t *values = (uint8_t *)malloc(count);
-      if (values == NULL) {
-        ALOGE("%s: No memory for undefined array", __func__);
-        rc = -1;
-      } else {
-        memcpy(values, data, count);
-        p_info_data[numOfEntries].tag_entry.data._undefined = values;
-      }
-    }
-    break;
-    case EXIF_SLONG: {
-      if (count > 1) {
-        int32_t *values = (int32_t *)malloc(count * sizeof(int32_t));
-        if (values == NULL) {
-          ALOGE("%s: No memory for signed long array", __func__);
-          rc = -1;
-        } else {
-          memcpy(values, data, count * sizeof(int32_t));
-          p_info_data[numOfEntries].tag_entry.data._slongs = values;
-        }
-      } else {
-        p_info_data[numOfEntries].tag_entry.data._slong = *(int32_t *)data;
-      }
-    }
-    break;
-    case EXIF_SRATIONAL: {
-      if (count > 1) {
-        srat_t *values = (srat_t *)malloc(count * sizeof(srat_t));
-        if (values == NULL) {
-          ALOGE("%s: No memory for signed rational array", __func__);
-          rc = -1;
-        } else {
-          memcpy(values, data, count * sizeof(srat_t));
-          p_info_data[numOfEntries].tag_entry.data._srats = values;
-        }
-      } else {
-        p_info_data[numOfEntries].tag_entry.data._srat = *(srat_t *)data;
-      }
-    }
-    break;
-    }
+/** mm_jpeg_exif_builder_reset:
+ *
+ *  Arguments:
+ *   @p_builder : exif builder
+ *
+ *  Return     : none
+ *
+ *  Description:
+ *       Drop all tags. Values stored in the arena are released at
+ *       once, there is nothing to free per tag.
+ *
+ **/
+void mm_jpeg_exif_builder_reset(mm_jpeg_exif_builder_t *p_builder)
+{
+  p_builder->info.numOfEntries = 0;
+  p_builder->arena_used = 0;
+}
 
-    // Increase number of entries
-    p_exif_info->numOfEntries++;
-    return rc;
+/** mm_jpeg_exif_type_size:
+ *
+ *  Arguments:
+ *   @type    : exif data type
+ *
+ *  Return     : size of one value of @type
+ *
+ *  Description:
+ *       Get the exif type size
+ *
+ **/
+static uint32_t mm_jpeg_exif_type_size(exif_tag_type_t type)
+{
+  switch (type) {
+  case EXIF_SHORT:
+    return sizeof(uint16_t);
+  case EXIF_LONG:
+  case EXIF_SLONG:
+    return sizeof(uint32_t);
+  case EXIF_RATIONAL:
+  case EXIF_SRATIONAL:
+    return sizeof(rat_t);
+  default:
+    return 1;
+  }
 }
 
-/** releaseExifEntry
+/** addExifEntry:
  *
  *  Arguments:
- *   @p_exif_data : Exif info struct
+ *   @p_builder : exif builder
+ *   @tagid   : exif tag ID
+ *   @type    : data type
+ *   @count   : number of data in uint of its type
+ *   @data    : input data ptr
  *
  *  Retrun     : int32_t type of status
  *               0  -- success
  *              none-zero failure code
  *
  *  Description:
- *       Function to release an entry from exif data
+ *       Function to add an entry to exif data. Strings and arrays
+ *       are copied into the builder arena. The table is kept in the
+ *       order the tags are written into APP1 and a repeated tag
+ *       replaces the earlier value.
  *
  **/
-int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
+int32_t addExifEntry(mm_jpeg_exif_builder_t *p_builder, exif_tag_id_t tagid,
+  exif_tag_type_t type, uint32_t count, void *data)
 {
- switch (p_exif_data->tag_entry.type) {
-  case EXIF_BYTE: {
-    if (p_exif_data->tag_entry.count > 1 &&
-      p_exif_data->tag_entry.data._bytes != NULL) {
-      free(p_exif_data->tag_entry.data._bytes);
-      p_exif_data->tag_entry.data._bytes = NULL;
-    }
-  }
-  break;
-  case EXIF_ASCII: {
-    if (p_exif_data->tag_entry.data._ascii != NULL) {
-      free(p_exif_data->tag_entry.data._ascii);
-      p_exif_data->tag_entry.data._ascii = NULL;
-    }
+  QEXIF_INFO_DATA *p_table = p_builder->info.exif_data;
+  uint32_t numOfEntries = (uint32_t)p_builder->info.numOfEntries;
+  uint32_t order = mm_jpeg_exif_tag_order(tagid);
+  uint32_t i = numOfEntries;
+  uint32_t size, aligned;
+  int replace;
+  exif_tag_entry_t entry;
+  uint8_t *p_copy;
+
+  /* tags mostly arrive in order, search from the back */
+  while ((i > 0) && (mm_jpeg_exif_tag_order(p_table[i - 1].tag_id) > order)) {
+    i--;
   }
-  break;
-  case EXIF_SHORT: {
-    if (p_exif_data->tag_entry.count > 1 &&
-      p_exif_data->tag_entry.data._shorts != NULL) {
-      free(p_exif_data->tag_entry.data._shorts);
-      p_exif_data->tag_entry.data._shorts = NULL;
-    }
-  }
-  break;
-  case EXIF_LONG: {
-    if (p_exif_data->tag_entry.count > 1 &&
-      p_exif_data->tag_entry.data._longs != NULL) {
-      free(p_exif_data->tag_entry.data._longs);
-      p_exif_data->tag_entry.data._longs = NULL;
-    }
-  }
-  break;
-  case EXIF_RATIONAL: {
-    if (p_exif_data->tag_entry.count > 1 &&
-      p_exif_data->tag_entry.data._rats != NULL) {
-      free(p_exif_data->tag_entry.data._rats);
-      p_exif_data->tag_entry.data._rats = NULL;
-    }
+  replace = (i > 0) && (p_table[i - 1].tag_id == tagid);
+  if (!replace && (numOfEntries >= p_builder->max_entries)) {
+    ALOGE("%s: Number of entries exceeded limit", __func__);
+    return -1;
   }
-  break;
-  case EXIF_UNDEFINED: {
-    if (p_exif_data->tag_entry.data._undefined != NULL) {
-      free(p_exif_data->tag_entry.data._undefined);
-      p_exif_data->tag_entry.data._undefined = NULL;
-    }
-  }
-  break;
-  case EXIF_SLONG: {
-    if (p_exif_data->tag_entry.count > 1 &&
-      p_exif_data->tag_entry.data._slongs != NULL) {
-      free(p_exif_data->tag_entry.data._slongs);
-      p_exif_data->tag_entry.data._slongs = NULL;
-    }
-  }
-  break;
-  case EXIF_SRATIONAL: {
-    if (p_exif_data->tag_entry.count > 1 &&
-      p_exif_data->tag_entry.data._srats != NULL) {
-      free(p_exif_data->tag_entry.data._srats);
-      p_exif_data->tag_entry.data._srats = NULL;
-    }
+
+  memset(&entry, 0, sizeof(entry));
+  entry.type = type;
+  entry.count = count;
+  entry.copy = 1;
+  size = count * mm_jpeg_exif_type_size(type);
+  if ((count > 1) || (EXIF_ASCII == type) || (EXIF_UNDEFINED == type)) {
+    /* keep the strings terminated and every chunk aligned for rationals */
+    aligned = (size + 1 + 7) & ~7U;
+    if (aligned > p_builder->arena_size - p_builder->arena_used) {
+      ALOGE("%s: No arena space for tag 0x%x (%u bytes)", __func__, tagid,
+        size);
+      return -1;
+    }
+    p_copy = p_builder->p_arena + p_builder->arena_used;
+    p_builder->arena_used += aligned;
+    memcpy(p_copy, data, size);
+    p_copy[size] = 0;
+    /* all pointer members of the union share its first word */
+    entry.data._bytes = p_copy;
+  } else {
+    /* so do the single values */
+    memcpy(&entry.data, data, size);
   }
-  break;
-  } /*end of switch*/
 
+  if (replace) {
+    i--;
+  } else {
+    memmove(&p_table[i + 1], &p_table[i],
+      (numOfEntries - i) * sizeof(p_table[0]));
+    p_builder->info.numOfEntries++;
+  }
+  p_table[i].tag_id = tagid;
+  p_table[i].tag_entry = entry;
   return 0;
 }
 
@@ -294,7 +206,7 @@ int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data)
  *  Notes: this needs to be filled for the metadata
  **/
 int process_sensor_data(cam_sensor_params_t *p_sensor_params,
-  QOMX_EXIF_INFO *exif_info)
+  mm_jpeg_exif_builder_t *exif_info)
 {
   int rc = 0;
   rat_t val_rat;
@@ -398,7 +310,8 @@ int process_sensor_data(cam_sensor_params_t *p_sensor_params,
  *
  *  Notes: this needs to be filled for the metadata
  **/
-int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
+int process_3a_data(cam_3a_params_t *p_3a_params,
+  mm_jpeg_exif_builder_t *exif_info)
 {
   int rc = 0;
   srat_t val_srat;
@@ -518,7 +431,7 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
  *
  *  Arguments:
  *   @p_meta : ptr to metadata
- *   @exif_info: Exif info struct
+ *   @exif_info: exif builder
  *   @mm_jpeg_exif_params: exif params
  *
  *  Return     : int32_t type of status
@@ -528,8 +441,9 @@ int process_3a_data(cam_3a_params_t *p_3a_params, QOMX_EXIF_INFO *exif_info)
  *  Description:
  *       Extract exif data from the metadata
  **/
-int process_meta_data(metadata_buffer_t *p_meta, QOMX_EXIF_INFO *exif_info,
-  mm_jpeg_exif_params_t *p_cam_exif_params, cam_hal_version_t hal_version)
+int process_meta_data(metadata_buffer_t *p_meta,
+  mm_jpeg_exif_builder_t *exif_info, mm_jpeg_exif_params_t *p_cam_exif_params,
+  cam_hal_version_t hal_version)
 {
   int rc = 0;
   cam_sensor_params_t p_sensor_params;
@@ -31,29 +31,89 @@
 #include "mm_jpeg_dbg.h"
 #include "mm_jpeg.h"
 
+/* queue nodes come from the queue's spare list or are embedded in the
+ * queued element, so steady state enq/deq does not allocate. Nodes queued
+ * with a non zero key are also linked into a small hash index for O(1)
+ * lookup and removal by key. The static helpers and the _unlk functions
+ * expect queue->lock held. */
+
+static inline uint32_t mm_jpeg_queue_bucket(uint32_t key)
+{
+    return ((key >> 16) ^ key) & (MM_JPEG_Q_INDEX_SIZE - 1);
+}
+
+static mm_jpeg_q_node_t* mm_jpeg_queue_get_spare(mm_jpeg_queue_t* queue)
+{
+    mm_jpeg_q_node_t* node = NULL;
+    struct cam_list *pos = queue->free_list.next;
+
+    if (pos != &queue->free_list) {
+        node = member_of(pos, mm_jpeg_q_node_t, list);
+        cam_list_del_node(&node->list);
+    } else {
+        node = (mm_jpeg_q_node_t *)malloc(sizeof(mm_jpeg_q_node_t));
+        if (NULL == node) {
+            CDBG_ERROR("%s: No memory for mm_jpeg_q_node_t", __func__);
+            return NULL;
+        }
+        queue->num_spare++;
+    }
+    memset(node, 0, sizeof(mm_jpeg_q_node_t));
+    node->type = MM_JPEG_Q_NODE_SPARE;
+    return node;
+}
+
+static void mm_jpeg_queue_put_spare(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node)
+{
+    if (MM_JPEG_Q_NODE_SPARE == node->type) {
+        cam_list_add_tail_node(&node->list, &queue->free_list);
+    }
+}
+
+static void mm_jpeg_queue_add(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node, uint32_t key, int at_head)
+{
+    uint32_t bucket;
+
+    if (at_head) {
+        cam_list_insert_before_node(&node->list, queue->head.list.next);
+    } else {
+        cam_list_add_tail_node(&node->list, &queue->head.list);
+    }
+    node->key = key;
+    node->hnext = NULL;
+    if (key) {
+        bucket = mm_jpeg_queue_bucket(key);
+        node->hnext = queue->index[bucket];
+        queue->index[bucket] = node;
+    }
+    queue->size++;
+}
+
 int32_t mm_jpeg_queue_init(mm_jpeg_queue_t* queue)
 {
     pthread_mutex_init(&queue->lock, NULL);
     cam_list_init(&queue->head.list);
+    cam_list_init(&queue->free_list);
+    memset(queue->index, 0, sizeof(queue->index));
+    queue->num_spare = 0;
     queue->size = 0;
     return 0;
 }
 
 int32_t mm_jpeg_queue_enq(mm_jpeg_queue_t* queue, mm_jpeg_q_data_t data)
 {
-    mm_jpeg_q_node_t* node =
-        (mm_jpeg_q_node_t *)malloc(sizeof(mm_jpeg_q_node_t));
+    mm_jpeg_q_node_t* node = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    node = mm_jpeg_queue_get_spare(queue);
     if (NULL == node) {
-        CDBG_ERROR("%s: No memory for mm_jpeg_q_node_t", __func__);
+        pthread_mutex_unlock(&queue->lock);
         return -1;
     }
-
-    memset(node, 0, sizeof(mm_jpeg_q_node_t));
     node->data = data;
-
-    pthread_mutex_lock(&queue->lock);
-    cam_list_add_tail_node(&node->list, &queue->head.list);
-    queue->size++;
+    mm_jpeg_queue_add(queue, node, 0, 0);
     pthread_mutex_unlock(&queue->lock);
 
     return 0;
@@ -62,29 +122,100 @@ int32_t mm_jpeg_queue_enq(mm_jpeg_queue_t* queue, mm_jpeg_q_data_t data)
 
 int32_t mm_jpeg_queue_enq_head(mm_jpeg_queue_t* queue, mm_jpeg_q_data_t data)
 {
-  struct cam_list *head = NULL;
-  struct cam_list *pos = NULL;
-  mm_jpeg_q_node_t* node =
-        (mm_jpeg_q_node_t *)malloc(sizeof(mm_jpeg_q_node_t));
+    mm_jpeg_q_node_t* node = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    node = mm_jpeg_queue_get_spare(queue);
     if (NULL == node) {
-        CDBG_ERROR("%s: No memory for mm_jpeg_q_node_t", __func__);
+        pthread_mutex_unlock(&queue->lock);
         return -1;
     }
-
-    memset(node, 0, sizeof(mm_jpeg_q_node_t));
     node->data = data;
+    mm_jpeg_queue_add(queue, node, 0, 1);
+    pthread_mutex_unlock(&queue->lock);
 
-    head = &queue->head.list;
-    pos = head->next;
+    return 0;
+}
+
+int32_t mm_jpeg_queue_enq_node(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node, uint32_t key)
+{
+    node->type = MM_JPEG_Q_NODE_EMBEDDED;
 
     pthread_mutex_lock(&queue->lock);
-    cam_list_insert_before_node(&node->list, pos);
-    queue->size++;
+    mm_jpeg_queue_add(queue, node, key, 0);
     pthread_mutex_unlock(&queue->lock);
 
     return 0;
 }
 
+int32_t mm_jpeg_queue_enq_head_node(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node, uint32_t key)
+{
+    node->type = MM_JPEG_Q_NODE_EMBEDDED;
+
+    pthread_mutex_lock(&queue->lock);
+    mm_jpeg_queue_add(queue, node, key, 1);
+    pthread_mutex_unlock(&queue->lock);
+
+    return 0;
+}
+
+mm_jpeg_q_node_t* mm_jpeg_queue_find_unlk(mm_jpeg_queue_t* queue,
+    uint32_t key)
+{
+    mm_jpeg_q_node_t* node = NULL;
+
+    if (0 == key) {
+        return NULL;
+    }
+    node = queue->index[mm_jpeg_queue_bucket(key)];
+    while ((NULL != node) && (node->key != key)) {
+        node = node->hnext;
+    }
+    return node;
+}
+
+void mm_jpeg_queue_del_node_unlk(mm_jpeg_queue_t* queue,
+    mm_jpeg_q_node_t* node)
+{
+    mm_jpeg_q_node_t **pp_node = NULL;
+
+    cam_list_del_node(&node->list);
+    if (node->key) {
+        pp_node = &queue->index[mm_jpeg_queue_bucket(node->key)];
+        while ((NULL != *pp_node) && (*pp_node != node)) {
+            pp_node = &(*pp_node)->hnext;
+        }
+        if (NULL != *pp_node) {
+            *pp_node = node->hnext;
+        }
+        node->key = 0;
+        node->hnext = NULL;
+    }
+    queue->size--;
+    mm_jpeg_queue_put_spare(queue, node);
+}
+
+mm_jpeg_q_data_t mm_jpeg_queue_remove_by_key(mm_jpeg_queue_t* queue,
+    uint32_t key)
+{
+    mm_jpeg_q_data_t data;
+    mm_jpeg_q_node_t* node = NULL;
+
+    memset(&data, 0, sizeof(data));
+
+    pthread_mutex_lock(&queue->lock);
+    node = mm_jpeg_queue_find_unlk(queue, key);
+    if (NULL != node) {
+        data = node->data;
+        mm_jpeg_queue_del_node_unlk(queue, node);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return data;
+}
+
 mm_jpeg_q_data_t mm_jpeg_queue_deq(mm_jpeg_queue_t* queue)
 {
     mm_jpeg_q_data_t data;
@@ -99,15 +230,10 @@ mm_jpeg_q_data_t mm_jpeg_queue_deq(mm_jpeg_queue_t* queue)
     pos = head->next;
     if (pos != head) {
         node = member_of(pos, mm_jpeg_q_node_t, list);
-        cam_list_del_node(&node->list);
-        queue->size--;
-    }
-    pthread_mutex_unlock(&queue->lock);
-
-    if (NULL != node) {
         data = node->data;
-        free(node);
+        mm_jpeg_queue_del_node_unlk(queue, node);
     }
+    pthread_mutex_unlock(&queue->lock);
 
     return data;
 }
@@ -126,7 +252,22 @@ uint32_t mm_jpeg_queue_get_size(mm_jpeg_queue_t* queue)
 
 int32_t mm_jpeg_queue_deinit(mm_jpeg_queue_t* queue)
 {
+    mm_jpeg_q_node_t* node = NULL;
+    struct cam_list *pos = NULL;
+
     mm_jpeg_queue_flush(queue);
+
+    pthread_mutex_lock(&queue->lock);
+    pos = queue->free_list.next;
+    while (pos != &queue->free_list) {
+        node = member_of(pos, mm_jpeg_q_node_t, list);
+        pos = pos->next;
+        free(node);
+    }
+    cam_list_init(&queue->free_list);
+    queue->num_spare = 0;
+    pthread_mutex_unlock(&queue->lock);
+
     pthread_mutex_destroy(&queue->lock);
     return 0;
 }
@@ -136,6 +277,7 @@ int32_t mm_jpeg_queue_flush(mm_jpeg_queue_t* queue)
     mm_jpeg_q_node_t* node = NULL;
     struct cam_list *head = NULL;
     struct cam_list *pos = NULL;
+    void *p_data = NULL;
 
     pthread_mutex_lock(&queue->lock);
     head = &queue->head.list;
@@ -143,16 +285,16 @@ int32_t mm_jpeg_queue_flush(mm_jpeg_queue_t* queue)
 
     while(pos != head) {
         node = member_of(pos, mm_jpeg_q_node_t, list);
-        cam_list_del_node(&node->list);
-        queue->size--;
+        pos = pos->next;
+        p_data = node->data.p;
+        mm_jpeg_queue_del_node_unlk(queue, node);
 
         /* for now we only assume there is no ptr inside data
-         * so we free data directly */
-        if (NULL != node->data.p) {
-            free(node->data.p);
+         * so we free data directly. An embedded node lives inside
+         * its data and goes with it */
+        if (NULL != p_data) {
+            free(p_data);
         }
-        free(node);
-        pos = pos->next;
     }
     queue->size = 0;
     pthread_mutex_unlock(&queue->lock);
@@ -97,7 +97,8 @@ static void mm_jpegdec_job_done(mm_jpeg_job_session_t *p_session)
   node = mm_jpeg_queue_remove_job_by_job_id(&my_obj->ongoing_job_q,
     p_session->jobId);
   if (node) {
-    free(node);
+    mm_jpeg_jobmgr_job_done(my_obj, node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
   }
   p_session->encoding = OMX_FALSE;
 
@@ -213,7 +214,9 @@ OMX_ERRORTYPE mm_jpegdec_session_create(mm_jpeg_job_session_t* p_session)
   p_session->omx_callbacks.EmptyBufferDone = mm_jpegdec_ebd;
   p_session->omx_callbacks.FillBufferDone = mm_jpegdec_fbd;
   p_session->omx_callbacks.EventHandler = mm_jpegdec_event_handler;
-  p_session->exif_count_local = 0;
+  mm_jpeg_exif_builder_init(&p_session->exif_builder,
+    p_session->exif_info_local, MAX_EXIF_TABLE_ENTRIES,
+    p_session->exif_arena_local, sizeof(p_session->exif_arena_local));
 
   rc = OMX_GetHandle(&p_session->omx_handle,
     "OMX.qcom.image.jpeg.decoder",
@@ -663,7 +666,6 @@ error:
  **/
 int32_t mm_jpegdec_process_decoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t* job_node)
 {
-  mm_jpeg_q_data_t qdata;
   int32_t rc = 0;
   OMX_ERRORTYPE ret = OMX_ErrorNone;
   mm_jpeg_job_session_t *p_session = NULL;
@@ -677,8 +679,8 @@ int32_t mm_jpegdec_process_decoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_
   }
 
   /* sent encode cmd to OMX, queue job into ongoing queue */
-  qdata.p = job_node;
-  rc = mm_jpeg_queue_enq(&my_obj->ongoing_job_q, qdata);
+  rc = mm_jpeg_queue_enq_node(&my_obj->ongoing_job_q, &job_node->link,
+    job_node->dec_info.job_id);
   if (rc) {
     CDBG_ERROR("%s:%d] jpeg enqueue failed %d",
       __func__, __LINE__, ret);
@@ -736,7 +738,6 @@ int32_t mm_jpegdec_start_decode_job(mm_jpeg_obj *my_obj,
   mm_jpeg_job_t *job,
   uint32_t *job_id)
 {
-  mm_jpeg_q_data_t qdata;
   int32_t rc = -1;
   uint8_t session_idx = 0;
   uint8_t client_idx = 0;
@@ -773,7 +774,7 @@ int32_t mm_jpegdec_start_decode_job(mm_jpeg_obj *my_obj,
   }
 
   /* enqueue new job into todo job queue */
-  node = (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
+  node = mm_jpeg_jobmgr_node_get(my_obj);
   if (NULL == node) {
     CDBG_ERROR("%s: No memory for mm_jpeg_job_q_node_t", __func__);
     return -1;
@@ -788,11 +789,7 @@ int32_t mm_jpegdec_start_decode_job(mm_jpeg_obj *my_obj,
   node->dec_info.client_handle = p_session->client_hdl;
   node->type = MM_JPEG_CMD_TYPE_DECODE_JOB;
 
-  qdata.p = node;
-  rc = mm_jpeg_queue_enq(&my_obj->job_mgr.job_queue, qdata);
-  if (0 == rc) {
-    cam_sem_post(&my_obj->job_mgr.job_sem);
-  }
+  rc = mm_jpeg_jobmgr_enq(my_obj, node, job->decode_job.priority);
 
   return rc;
 }
@@ -890,19 +887,22 @@ int32_t mm_jpegdec_destroy_session(mm_jpeg_obj *my_obj,
   uint32_t session_id = p_session->sessionId;
   pthread_mutex_lock(&my_obj->job_lock);
 
+  /* let a worker finish handing a job of this session to OMX */
+  mm_jpeg_jobmgr_wait_dispatch(my_obj, session_id);
+
   /* abort job if in todo queue */
   CDBG("%s:%d] abort todo jobs", __func__, __LINE__);
-  node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->job_mgr.job_queue, session_id);
+  node = mm_jpeg_jobmgr_remove_job_by_session_id(my_obj, session_id);
   while (NULL != node) {
-    free(node);
-    node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->job_mgr.job_queue, session_id);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
+    node = mm_jpeg_jobmgr_remove_job_by_session_id(my_obj, session_id);
   }
 
   /* abort job if in ongoing queue */
   CDBG("%s:%d] abort ongoing jobs", __func__, __LINE__);
   node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->ongoing_job_q, session_id);
   while (NULL != node) {
-    free(node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
     node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->ongoing_job_q, session_id);
   }
 
@@ -1081,10 +1081,13 @@ int32_t mm_jpegdec_abort_job(mm_jpeg_obj *my_obj,
   CDBG("%s:%d] ", __func__, __LINE__);
   pthread_mutex_lock(&my_obj->job_lock);
 
+  /* let a worker finish handing a job of this session to OMX */
+  mm_jpeg_jobmgr_wait_dispatch(my_obj, jobId);
+
   /* abort job if in todo queue */
-  node = mm_jpeg_queue_remove_job_by_job_id(&my_obj->job_mgr.job_queue, jobId);
+  node = mm_jpeg_jobmgr_remove_job_by_job_id(my_obj, jobId);
   if (NULL != node) {
-    free(node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
     goto abort_done;
   }
 
@@ -1099,7 +1102,7 @@ int32_t mm_jpegdec_abort_job(mm_jpeg_obj *my_obj,
       CDBG_ERROR("%s:%d] Invalid job id 0x%x", __func__, __LINE__,
         node->dec_info.job_id);
     }
-    free(node);
+    mm_jpeg_jobmgr_node_put(my_obj, node);
     goto abort_done;
   }
 
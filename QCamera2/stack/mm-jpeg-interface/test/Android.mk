@@ -76,4 +76,29 @@ LOCAL_SHARED_LIBRARIES := libcutils libdl libmmjpeg_interface
 
 include $(BUILD_EXECUTABLE)
 
+#queue host test, run it under ASan
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_JPEG_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_JPEG_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_JPEG_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += $(OMX_HEADER_DIR)
+LOCAL_C_INCLUDES += $(OMX_CORE_DIR)/qexif
+LOCAL_C_INCLUDES += $(OMX_CORE_DIR)/qomx_core
+
+LOCAL_C_INCLUDES+= $(kernel_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+
+LOCAL_SRC_FILES := ../src/mm_jpeg_queue.c mm_jpeg_queue_test.c
+
+LOCAL_MODULE           := mm-jpeg-queue-test
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_LDLIBS           := -lpthread
+
+include $(BUILD_HOST_EXECUTABLE)
+
 LOCAL_PATH := $(OLD_LOCAL_PATH)
@@ -0,0 +1,249 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Host test of mm_jpeg_queue.c: FIFO and head order, spare node reuse,
+ * embedded nodes indexed by key with removal from the head, middle and
+ * tail, lookups of missing keys and keys sharing an index bucket, and
+ * deinit freeing the elements that embed their nodes. Run it under ASan
+ * to catch leaked or double freed nodes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mm_jpeg_dbg.h"
+#include "mm_jpeg.h"
+
+#define QUEUE_TEST_NUM_ELEMS 8
+#define QUEUE_TEST_CYCLES 1000
+
+/** queue_test_elem_t: element linked through an embedded node
+ *    @link: queue node, data.p points back to the element
+ *    @val: payload
+ **/
+typedef struct {
+  mm_jpeg_q_node_t link;
+  uint32_t val;
+} queue_test_elem_t;
+
+static int g_failures = 0;
+
+#define EXPECT(cond, what) do { \
+  if (!(cond)) { \
+    printf("FAIL %s\n", what); \
+    g_failures++; \
+  } \
+} while (0)
+
+/** queue_test_key:
+ *
+ *  Arguments:
+ *    @i: element number
+ *
+ *  Return:
+ *    key of element i, consecutive elements share an index bucket
+ *
+ *  Description:
+ *    bucket = ((key >> 16) ^ key) & (MM_JPEG_Q_INDEX_SIZE - 1), so keys
+ *    MM_JPEG_Q_INDEX_SIZE apart collide
+ *
+ **/
+static uint32_t queue_test_key(uint32_t i)
+{
+  return 0x10000U + (i / 2) + (i % 2) * MM_JPEG_Q_INDEX_SIZE;
+}
+
+/** queue_test_order:
+ *
+ *  Arguments:
+ *    @queue: queue of embedded elements
+ *    @vals: expected payloads from head to tail
+ *    @cnt: number of expected payloads
+ *
+ *  Return:
+ *    1 if the queue holds exactly @vals in order
+ *
+ *  Description:
+ *    walks the queue without dequeuing
+ *
+ **/
+static int queue_test_order(mm_jpeg_queue_t *queue, const uint32_t *vals,
+  uint32_t cnt)
+{
+  struct cam_list *head = &queue->head.list;
+  struct cam_list *pos = head->next;
+  queue_test_elem_t *elem;
+  uint32_t n = 0;
+
+  while (pos != head) {
+    elem = (queue_test_elem_t *)member_of(pos, mm_jpeg_q_node_t, list)->data.p;
+    if ((n >= cnt) || (elem->val != vals[n])) {
+      return 0;
+    }
+    pos = pos->next;
+    n++;
+  }
+  return (n == cnt) && (mm_jpeg_queue_get_size(queue) == cnt);
+}
+
+/** test_fifo:
+ *
+ *  Arguments:
+ *    none
+ *
+ *  Return:
+ *    none
+ *
+ *  Description:
+ *    FIFO and head order with spare nodes, and spare reuse in steady state
+ *
+ **/
+static void test_fifo(void)
+{
+  mm_jpeg_queue_t queue;
+  mm_jpeg_q_data_t data;
+  uint32_t i, spare;
+
+  mm_jpeg_queue_init(&queue);
+  for (i = 1; i <= 3; i++) {
+    data.u32 = i;
+    EXPECT(0 == mm_jpeg_queue_enq(&queue, data), "fifo: enq");
+  }
+  data.u32 = 10;
+  EXPECT(0 == mm_jpeg_queue_enq_head(&queue, data), "fifo: enq_head");
+  EXPECT(4 == mm_jpeg_queue_get_size(&queue), "fifo: size");
+  EXPECT(10 == mm_jpeg_queue_peek(&queue).u32, "fifo: peek head");
+  EXPECT(4 == mm_jpeg_queue_get_size(&queue), "fifo: peek keeps node");
+  EXPECT(10 == mm_jpeg_queue_deq(&queue).u32, "fifo: head first");
+  for (i = 1; i <= 3; i++) {
+    EXPECT(i == mm_jpeg_queue_deq(&queue).u32, "fifo: tail order");
+  }
+  EXPECT(0 == mm_jpeg_queue_get_size(&queue), "fifo: empty");
+  EXPECT(0 == mm_jpeg_queue_deq(&queue).u32, "fifo: deq of empty queue");
+  EXPECT(0 == mm_jpeg_queue_peek(&queue).u32, "fifo: peek of empty queue");
+
+  /* nodes freed by deq are reused, steady state does not allocate */
+  spare = queue.num_spare;
+  for (i = 0; i < QUEUE_TEST_CYCLES; i++) {
+    data.u32 = i + 1;
+    mm_jpeg_queue_enq(&queue, data);
+    mm_jpeg_queue_enq(&queue, data);
+    mm_jpeg_queue_deq(&queue);
+    mm_jpeg_queue_deq(&queue);
+  }
+  EXPECT(spare == queue.num_spare, "fifo: spare nodes reused");
+  mm_jpeg_queue_deinit(&queue);
+}
+
+/** test_keyed:
+ *
+ *  Arguments:
+ *    none
+ *
+ *  Return:
+ *    none
+ *
+ *  Description:
+ *    embedded nodes indexed by key: lookup, removal from head, middle and
+ *    tail, missing keys and deinit freeing the embedding elements
+ *
+ **/
+static void test_keyed(void)
+{
+  mm_jpeg_queue_t queue;
+  queue_test_elem_t *elems[QUEUE_TEST_NUM_ELEMS];
+  mm_jpeg_q_node_t *node;
+  mm_jpeg_q_data_t data;
+  uint32_t i;
+
+  mm_jpeg_queue_init(&queue);
+  for (i = 0; i < QUEUE_TEST_NUM_ELEMS; i++) {
+    elems[i] = (queue_test_elem_t *)calloc(1, sizeof(queue_test_elem_t));
+    elems[i]->val = i;
+    elems[i]->link.data.p = elems[i];
+  }
+  /* 1 2 3 4 5 6 7, then 0 at the head */
+  for (i = 1; i < QUEUE_TEST_NUM_ELEMS; i++) {
+    mm_jpeg_queue_enq_node(&queue, &elems[i]->link, queue_test_key(i));
+  }
+  mm_jpeg_queue_enq_head_node(&queue, &elems[0]->link, queue_test_key(0));
+  {
+    static const uint32_t all[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    EXPECT(queue_test_order(&queue, all, 8), "keyed: head and tail order");
+  }
+  EXPECT(0 == queue.num_spare, "keyed: embedded nodes take no spare");
+
+  pthread_mutex_lock(&queue.lock);
+  for (i = 0; i < QUEUE_TEST_NUM_ELEMS; i++) {
+    node = mm_jpeg_queue_find_unlk(&queue, queue_test_key(i));
+    EXPECT(node == &elems[i]->link, "keyed: find in shared bucket");
+  }
+  EXPECT(NULL == mm_jpeg_queue_find_unlk(&queue, 0), "keyed: key 0 not indexed");
+  EXPECT(NULL == mm_jpeg_queue_find_unlk(&queue,
+    queue_test_key(QUEUE_TEST_NUM_ELEMS)), "keyed: missing key");
+  pthread_mutex_unlock(&queue.lock);
+
+  /* head, middle and tail, including one of a pair sharing a bucket */
+  data = mm_jpeg_queue_remove_by_key(&queue, queue_test_key(0));
+  EXPECT(data.p == elems[0], "keyed: remove head");
+  data = mm_jpeg_queue_remove_by_key(&queue, queue_test_key(4));
+  EXPECT(data.p == elems[4], "keyed: remove middle");
+  data = mm_jpeg_queue_remove_by_key(&queue, queue_test_key(7));
+  EXPECT(data.p == elems[7], "keyed: remove tail");
+  data = mm_jpeg_queue_remove_by_key(&queue, queue_test_key(7));
+  EXPECT(NULL == data.p, "keyed: remove twice");
+  {
+    static const uint32_t left[] = { 1, 2, 3, 5, 6 };
+    EXPECT(queue_test_order(&queue, left, 5), "keyed: order after remove");
+  }
+  pthread_mutex_lock(&queue.lock);
+  EXPECT(&elems[5]->link == mm_jpeg_queue_find_unlk(&queue, queue_test_key(5)),
+    "keyed: bucket neighbour of removed key kept");
+  pthread_mutex_unlock(&queue.lock);
+  EXPECT(0 == queue.num_spare, "keyed: removal takes no spare");
+
+  /* a removed element can be queued again */
+  mm_jpeg_queue_enq_node(&queue, &elems[4]->link, queue_test_key(4));
+  EXPECT(mm_jpeg_queue_remove_by_key(&queue, queue_test_key(4)).p == elems[4],
+    "keyed: re-queued element");
+  free(elems[0]);
+  free(elems[4]);
+  free(elems[7]);
+
+  /* deinit frees the queued elements together with their nodes */
+  mm_jpeg_queue_deinit(&queue);
+}
+
+int main(void)
+{
+  test_fifo();
+  test_keyed();
+
+  printf("%s (%d failures)\n", g_failures ? "FAIL" : "PASS", g_failures);
+  return g_failures ? 1 : 0;
+}
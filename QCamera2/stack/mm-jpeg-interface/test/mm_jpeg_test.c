@@ -433,6 +433,8 @@ static int encode_test(jpeg_test_input_t *p_input)
     if (jpeg_obj.params.burst_mode && jpeg_obj.min_out_bufs) {
       jpeg_obj.job.encode_job.dst_index = -1;
     }
+    jpeg_obj.job.encode_job.priority = jpeg_obj.params.burst_mode ?
+      MM_JPEG_JOB_PRIO_BURST : MM_JPEG_JOB_PRIO_SINGLE_SHOT;
 
     rc = jpeg_obj.ops.start_job(&jpeg_obj.job, &jpeg_obj.job_id[i]);
 
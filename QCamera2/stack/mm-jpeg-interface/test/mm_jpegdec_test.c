@@ -293,6 +293,7 @@ static int decode_init(jpeg_test_input_t *p_input, mm_jpegdec_intf_test_t *p_obj
   p_job_params->dst_index = 0;
   p_job_params->src_index = 0;
   p_job_params->rotation = 0;
+  p_job_params->priority = MM_JPEG_JOB_PRIO_SINGLE_SHOT;
 
   /* main dimension */
   p_job_params->main_dim.src_dim.width = p_obj->width;
@@ -0,0 +1,175 @@
+/* Copyright (c) 2015, The Linux Foundataion. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include <stdlib.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include <cutils/properties.h>
+#include <utils/Log.h>
+#include "QCameraDebugConfig.h"
+
+namespace qcamera {
+
+static const char *const gDebugPropNames[QCAMERA_DBG_PROP_MAX] = {
+    "persist.camera.dumpimg",
+    "persist.camera.dumpmetadata",
+    "persist.camera.zsl_raw",
+    "persist.camera.zsl_yuv",
+    "persist.camera.zsl_matching",
+    "persist.camera.preview_raw",
+    "persist.camera.snapshot_raw",
+};
+
+uint32_t QCameraDebugConfig::sEnabledMask = 0;
+int32_t QCameraDebugConfig::sValues[QCAMERA_DBG_PROP_MAX];
+uint32_t QCameraDebugConfig::sUsers = 0;
+bool QCameraDebugConfig::sThreadActive = false;
+pthread_t QCameraDebugConfig::sThread;
+pthread_mutex_t QCameraDebugConfig::sLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t QCameraDebugConfig::sStartStopLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t QCameraDebugConfig::sCond = PTHREAD_COND_INITIALIZER;
+
+/*===========================================================================
+ * FUNCTION   : refresh
+ *
+ * DESCRIPTION: re-read all debug properties and publish the new snapshot
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraDebugConfig::refresh()
+{
+    char value[PROPERTY_VALUE_MAX];
+    uint32_t mask = 0;
+
+    for (uint32_t i = 0; i < QCAMERA_DBG_PROP_MAX; i++) {
+        property_get(gDebugPropNames[i], value, "0");
+        int32_t val = atoi(value);
+        __atomic_store_n(&sValues[i], val, __ATOMIC_RELAXED);
+        if (0 != val) {
+            mask |= (1U << i);
+        }
+    }
+    /* values are visible before the bit that gates them */
+    __atomic_store_n(&sEnabledMask, mask, __ATOMIC_RELEASE);
+}
+
+/*===========================================================================
+ * FUNCTION   : start
+ *
+ * DESCRIPTION: take a snapshot of the debug properties and keep it fresh
+ *              in the background. Called on camera open; calls nest.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraDebugConfig::start()
+{
+    refresh();
+
+    pthread_mutex_lock(&sStartStopLock);
+    pthread_mutex_lock(&sLock);
+    if ((0 == sUsers++) && !sThreadActive) {
+        if (pthread_create(&sThread, NULL, refreshRoutine, NULL) == 0) {
+            sThreadActive = true;
+        } else {
+            ALOGE("%s: Failed to start debug property refresh", __func__);
+        }
+    }
+    pthread_mutex_unlock(&sLock);
+    pthread_mutex_unlock(&sStartStopLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : stop
+ *
+ * DESCRIPTION: drop one user, stop the background refresh with the last one.
+ *              The snapshot stays valid after the refresh stops. Start and
+ *              stop are serialized through the join, so a concurrent start
+ *              can not spawn a new thread while the old one is exiting.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraDebugConfig::stop()
+{
+    bool join = false;
+    pthread_t tid;
+
+    pthread_mutex_lock(&sStartStopLock);
+    pthread_mutex_lock(&sLock);
+    if ((sUsers > 0) && (0 == --sUsers) && sThreadActive) {
+        sThreadActive = false;
+        tid = sThread;
+        join = true;
+        pthread_cond_signal(&sCond);
+    }
+    pthread_mutex_unlock(&sLock);
+
+    if (join) {
+        pthread_join(tid, NULL);
+    }
+    pthread_mutex_unlock(&sStartStopLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : refreshRoutine
+ *
+ * DESCRIPTION: background thread refreshing the snapshot periodically
+ *
+ * PARAMETERS :
+ *   @data    : unused
+ *
+ * RETURN     : NULL
+ *==========================================================================*/
+void *QCameraDebugConfig::refreshRoutine(void * /*data*/)
+{
+    prctl(PR_SET_NAME, (unsigned long)"CAM_dbgProp", 0, 0, 0);
+
+    pthread_mutex_lock(&sLock);
+    while (sThreadActive) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += QCAMERA_DEBUG_REFRESH_PERIOD_SEC;
+        pthread_cond_timedwait(&sCond, &sLock, &ts);
+        if (!sThreadActive) {
+            break;
+        }
+        pthread_mutex_unlock(&sLock);
+        refresh();
+        pthread_mutex_lock(&sLock);
+    }
+    pthread_mutex_unlock(&sLock);
+    return NULL;
+}
+
+}; // namespace qcamera
@@ -0,0 +1,90 @@
+/* Copyright (c) 2015, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA_DEBUG_CONFIG_H__
+#define __QCAMERA_DEBUG_CONFIG_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+namespace qcamera {
+
+/* Debug/dump properties polled on the frame path */
+typedef enum {
+    QCAMERA_DBG_DUMP_IMG,        /* persist.camera.dumpimg */
+    QCAMERA_DBG_DUMP_METADATA,   /* persist.camera.dumpmetadata */
+    QCAMERA_DBG_ZSL_RAW,         /* persist.camera.zsl_raw */
+    QCAMERA_DBG_ZSL_YUV,         /* persist.camera.zsl_yuv */
+    QCAMERA_DBG_ZSL_MATCHING,    /* persist.camera.zsl_matching */
+    QCAMERA_DBG_PREVIEW_RAW,     /* persist.camera.preview_raw */
+    QCAMERA_DBG_SNAPSHOT_RAW,    /* persist.camera.snapshot_raw */
+    QCAMERA_DBG_PROP_MAX
+} qcamera_debug_prop_t;
+
+/* period of the background property refresh while a camera is open */
+#define QCAMERA_DEBUG_REFRESH_PERIOD_SEC 1
+
+/* Process wide snapshot of the camera debug properties. The properties are
+ * read once per refresh; frame path checks are a single load of the cached
+ * bitmask of non-zero properties. A refresh happens on every camera open,
+ * on dumpsys and once per QCAMERA_DEBUG_REFRESH_PERIOD_SEC while any camera
+ * is open. */
+class QCameraDebugConfig {
+public:
+    static void start();
+    static void stop();
+    static void refresh();
+
+    static inline bool isEnabled(qcamera_debug_prop_t prop)
+    {
+        return (__atomic_load_n(&sEnabledMask, __ATOMIC_RELAXED) &
+                (1U << prop)) != 0;
+    }
+    static inline int32_t getValue(qcamera_debug_prop_t prop)
+    {
+        return __atomic_load_n(&sValues[prop], __ATOMIC_RELAXED);
+    }
+
+private:
+    static void *refreshRoutine(void *data);
+
+    static uint32_t sEnabledMask;
+    static int32_t sValues[QCAMERA_DBG_PROP_MAX];
+    static uint32_t sUsers;
+    static bool sThreadActive;
+    static pthread_t sThread;
+    static pthread_mutex_t sLock;
+    /* serializes start/stop, held by stop across the thread join */
+    static pthread_mutex_t sStartStopLock;
+    static pthread_cond_t sCond;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_DEBUG_CONFIG_H__ */
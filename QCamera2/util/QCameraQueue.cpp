@@ -27,6 +27,9 @@
 *
 */
 
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
 #include <utils/Errors.h>
 #include <utils/Log.h>
 #include "QCameraQueue.h"
@@ -45,11 +48,10 @@ namespace qcamera {
 QCameraQueue::QCameraQueue()
 {
     pthread_mutex_init(&m_lock, NULL);
-    cam_list_init(&m_head.list);
-    m_size = 0;
     m_dataFn = NULL;
     m_userData = NULL;
     m_active = true;
+    initRing(QCAMERA_QUEUE_DEFAULT_CAPACITY);
 }
 
 /*===========================================================================
@@ -60,17 +62,19 @@ QCameraQueue::QCameraQueue()
  * PARAMETERS :
  *   @data_rel_fn : function ptr to release node data internal resource
  *   @user_data   : user data ptr
+ *   @capacity    : initial number of nodes the queue can hold, rounded
+ *                  up to a power of 2. The ring grows when it is full.
  *
  * RETURN     : None
  *==========================================================================*/
-QCameraQueue::QCameraQueue(release_data_fn data_rel_fn, void *user_data)
+QCameraQueue::QCameraQueue(release_data_fn data_rel_fn, void *user_data,
+        uint32_t capacity)
 {
     pthread_mutex_init(&m_lock, NULL);
-    cam_list_init(&m_head.list);
-    m_size = 0;
     m_dataFn = data_rel_fn;
     m_userData = user_data;
     m_active = true;
+    initRing(capacity);
 }
 
 /*===========================================================================
@@ -85,9 +89,222 @@ QCameraQueue::QCameraQueue(release_data_fn data_rel_fn, void *user_data)
 QCameraQueue::~QCameraQueue()
 {
     flush();
+    if (NULL != m_slots) {
+        free(m_slots);
+        m_slots = NULL;
+    }
     pthread_mutex_destroy(&m_lock);
 }
 
+/*===========================================================================
+ * FUNCTION   : initRing
+ *
+ * DESCRIPTION: allocate the initial ring slots. Further allocation only
+ *              happens when the ring is full, see growLocked.
+ *
+ * PARAMETERS :
+ *   @capacity : requested number of slots
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraQueue::initRing(uint32_t capacity)
+{
+    uint32_t cap = 2;
+    while (cap < capacity && cap < 0x80000000) {
+        cap <<= 1;
+    }
+
+    m_head = 0;
+    m_tail = 0;
+    m_fastOps = 0;
+    m_exclusive = 0;
+    m_overflow = 0;
+    m_slots = (camera_q_slot *)malloc(sizeof(camera_q_slot) * cap);
+    if (NULL == m_slots) {
+        ALOGE("%s: No memory for %u queue slots", __func__, cap);
+        m_capacity = 0;
+        m_mask = 0;
+        return;
+    }
+    m_capacity = cap;
+    m_mask = cap - 1;
+    for (uint32_t i = 0; i < cap; i++) {
+        m_slots[i].seq = i;
+        m_slots[i].data = NULL;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : beginFastOp
+ *
+ * DESCRIPTION: enter a lock-free operation. Fails if an exclusive operation
+ *              is in progress, in which case caller has to take the
+ *              exclusive path instead.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : true -- fast path allowed; false -- use exclusive path
+ *==========================================================================*/
+bool QCameraQueue::beginFastOp()
+{
+    __atomic_fetch_add(&m_fastOps, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&m_exclusive, __ATOMIC_SEQ_CST)) {
+        __atomic_fetch_sub(&m_fastOps, 1, __ATOMIC_SEQ_CST);
+        return false;
+    }
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : endFastOp
+ *
+ * DESCRIPTION: leave a lock-free operation
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraQueue::endFastOp()
+{
+    __atomic_fetch_sub(&m_fastOps, 1, __ATOMIC_RELEASE);
+}
+
+/*===========================================================================
+ * FUNCTION   : beginExclusive
+ *
+ * DESCRIPTION: take queue lock and wait until all in-flight lock-free
+ *              operations are done. Ring can be modified freely afterwards.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraQueue::beginExclusive()
+{
+    pthread_mutex_lock(&m_lock);
+    __atomic_store_n(&m_exclusive, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&m_fastOps, __ATOMIC_SEQ_CST) != 0) {
+        sched_yield();
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : endExclusive
+ *
+ * DESCRIPTION: re-enable lock-free operations and release queue lock
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraQueue::endExclusive()
+{
+    __atomic_store_n(&m_exclusive, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : growLocked
+ *
+ * DESCRIPTION: double the ring, keeping every node at its position. Must be
+ *              called in exclusive mode, so no fast operation holds a slot.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : true -- success; false -- out of memory
+ *==========================================================================*/
+bool QCameraQueue::growLocked()
+{
+    if (m_capacity >= 0x80000000) {
+        return false;
+    }
+    uint32_t cap = m_capacity << 1;
+    uint32_t mask = cap - 1;
+    camera_q_slot *slots = (camera_q_slot *)malloc(sizeof(camera_q_slot) * cap);
+    if (NULL == slots) {
+        ALOGE("%s: No memory for %u queue slots", __func__, cap);
+        return false;
+    }
+    for (uint32_t pos = m_head; pos != m_tail; pos++) {
+        slots[pos & mask].seq = pos + 1;
+        slots[pos & mask].data = m_slots[pos & m_mask].data;
+    }
+    for (uint32_t pos = m_tail; pos != m_head + cap; pos++) {
+        slots[pos & mask].seq = pos;
+        slots[pos & mask].data = NULL;
+    }
+    free(m_slots);
+    __atomic_store_n(&m_slots, slots, __ATOMIC_RELAXED);
+    m_capacity = cap;
+    m_mask = mask;
+    m_overflow++;
+    ALOGD("%s: queue grown to %u slots", __func__, cap);
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : pushTailLocked
+ *
+ * DESCRIPTION: append data at tail, growing the ring if it is full. Must be
+ *              called in exclusive mode.
+ *
+ * PARAMETERS :
+ *   @data    : data to be enqueued
+ *
+ * RETURN     : true -- success; false -- out of memory
+ *==========================================================================*/
+bool QCameraQueue::pushTailLocked(void *data)
+{
+    if (((m_tail - m_head) >= m_capacity) && !growLocked()) {
+        return false;
+    }
+    camera_q_slot *slot = &m_slots[m_tail & m_mask];
+    slot->data = data;
+    slot->seq = m_tail + 1;
+    __atomic_store_n(&m_tail, m_tail + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : popHeadLocked
+ *
+ * DESCRIPTION: remove data at head. Must be called in exclusive mode with
+ *              a non-empty queue.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : data ptr
+ *==========================================================================*/
+void *QCameraQueue::popHeadLocked()
+{
+    camera_q_slot *slot = &m_slots[m_head & m_mask];
+    void *data = slot->data;
+    slot->data = NULL;
+    slot->seq = m_head + m_capacity;
+    __atomic_store_n(&m_head, m_head + 1, __ATOMIC_RELAXED);
+    return data;
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseNode
+ *
+ * DESCRIPTION: release internal resource of node data and free it
+ *
+ * PARAMETERS :
+ *   @data    : node data
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraQueue::releaseNode(void *data)
+{
+    if (NULL != data) {
+        if (m_dataFn) {
+            m_dataFn(data, m_userData);
+        }
+        free(data);
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : init
  *
@@ -99,9 +316,9 @@ QCameraQueue::~QCameraQueue()
  *==========================================================================*/
 void QCameraQueue::init()
 {
-    pthread_mutex_lock(&m_lock);
-    m_active = true;
-    pthread_mutex_unlock(&m_lock);
+    beginExclusive();
+    __atomic_store_n(&m_active, true, __ATOMIC_RELAXED);
+    endExclusive();
 }
 
 /*===========================================================================
@@ -115,48 +332,89 @@ void QCameraQueue::init()
  *==========================================================================*/
 bool QCameraQueue::isEmpty()
 {
-    bool flag = true;
-    pthread_mutex_lock(&m_lock);
-    if (m_size > 0) {
-        flag = false;
-    }
-    pthread_mutex_unlock(&m_lock);
-    return flag;
+    return (getCurrentSize() <= 0);
+}
+
+/*===========================================================================
+ * FUNCTION   : getCurrentSize
+ *
+ * DESCRIPTION: return number of nodes currently in the queue. Nodes being
+ *              enqueued concurrently may already be accounted.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : number of nodes
+ *==========================================================================*/
+int QCameraQueue::getCurrentSize()
+{
+    uint32_t head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+    int32_t size = (int32_t)(tail - head);
+    return (size > 0) ? size : 0;
 }
 
 /*===========================================================================
  * FUNCTION   : enqueue
  *
- * DESCRIPTION: enqueue data into the queue
+ * DESCRIPTION: enqueue data into the queue. Lock-free and allocation-free
+ *              unless an exclusive operation is in progress or the ring is
+ *              full, in which case the ring grows under the queue lock.
  *
  * PARAMETERS :
  *   @data    : data to be enqueued
  *
- * RETURN     : true -- success; false -- failed
+ * RETURN     : true -- success; false -- queue inactive or out of memory
  *==========================================================================*/
 bool QCameraQueue::enqueue(void *data)
 {
-    bool rc;
-    camera_q_node *node =
-        (camera_q_node *)malloc(sizeof(camera_q_node));
-    if (NULL == node) {
-        ALOGE("%s: No memory for camera_q_node", __func__);
+    bool rc = false;
+    bool slowPath = true;
+
+    if (NULL == __atomic_load_n(&m_slots, __ATOMIC_RELAXED)) {
         return false;
     }
 
-    memset(node, 0, sizeof(camera_q_node));
-    node->data = data;
+    if (beginFastOp()) {
+        slowPath = false;
+        if (__atomic_load_n(&m_active, __ATOMIC_ACQUIRE)) {
+            uint32_t pos = __atomic_load_n(&m_tail, __ATOMIC_RELAXED);
+            for (;;) {
+                camera_q_slot *slot = &m_slots[pos & m_mask];
+                uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+                int32_t diff = (int32_t)(seq - pos);
+                if (diff == 0) {
+                    if (__atomic_compare_exchange_n(&m_tail, &pos, pos + 1,
+                            true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        slot->data = data;
+                        __atomic_store_n(&slot->seq, pos + 1,
+                                         __ATOMIC_RELEASE);
+                        rc = true;
+                        break;
+                    }
+                } else if (diff < 0) {
+                    /* slot still owned by consumer: ring is full, grow it
+                     * once the fast operations drained */
+                    slowPath = true;
+                    break;
+                } else {
+                    pos = __atomic_load_n(&m_tail, __ATOMIC_RELAXED);
+                }
+            }
+        }
+        endFastOp();
+    }
 
-    pthread_mutex_lock(&m_lock);
-    if (m_active) {
-        cam_list_add_tail_node(&node->list, &m_head.list);
-        m_size++;
-        rc = true;
-    } else {
-        free(node);
-        rc = false;
+    if (slowPath) {
+        beginExclusive();
+        if (m_active) {
+            rc = pushTailLocked(data);
+            if (!rc) {
+                ALOGE("%s: cannot grow queue beyond %u nodes",
+                      __func__, m_capacity);
+            }
+        }
+        endExclusive();
     }
-    pthread_mutex_unlock(&m_lock);
     return rc;
 }
 
@@ -173,33 +431,27 @@ bool QCameraQueue::enqueue(void *data)
  *==========================================================================*/
 bool QCameraQueue::enqueueWithPriority(void *data)
 {
-    bool rc;
-    camera_q_node *node =
-        (camera_q_node *)malloc(sizeof(camera_q_node));
-    if (NULL == node) {
-        ALOGE("%s: No memory for camera_q_node", __func__);
+    bool rc = false;
+
+    if (NULL == __atomic_load_n(&m_slots, __ATOMIC_RELAXED)) {
         return false;
     }
 
-    memset(node, 0, sizeof(camera_q_node));
-    node->data = data;
-
-    pthread_mutex_lock(&m_lock);
+    beginExclusive();
     if (m_active) {
-        struct cam_list *p_next = m_head.list.next;
-
-        m_head.list.next = &node->list;
-        p_next->prev = &node->list;
-        node->list.next = p_next;
-        node->list.prev = &m_head.list;
-
-        m_size++;
-        rc = true;
-    } else {
-        free(node);
-        rc = false;
+        if (((m_tail - m_head) < m_capacity) || growLocked()) {
+            uint32_t pos = m_head - 1;
+            camera_q_slot *slot = &m_slots[pos & m_mask];
+            slot->data = data;
+            slot->seq = pos + 1;
+            __atomic_store_n(&m_head, pos, __ATOMIC_RELAXED);
+            rc = true;
+        } else {
+            ALOGE("%s: cannot grow queue beyond %u nodes",
+                  __func__, m_capacity);
+        }
     }
-    pthread_mutex_unlock(&m_lock);
+    endExclusive();
     return rc;
 }
 
@@ -214,24 +466,17 @@ bool QCameraQueue::enqueueWithPriority(void *data)
  *==========================================================================*/
 void* QCameraQueue::peek()
 {
-    camera_q_node* node = NULL;
     void* data = NULL;
-    struct cam_list *head = NULL;
-    struct cam_list *pos = NULL;
 
-    pthread_mutex_lock(&m_lock);
-    if (m_active) {
-        head = &m_head.list;
-        pos = head->next;
-        if (pos != head) {
-            node = member_of(pos, camera_q_node, list);
-        }
+    if (NULL == __atomic_load_n(&m_slots, __ATOMIC_RELAXED)) {
+        return NULL;
     }
-    pthread_mutex_unlock(&m_lock);
 
-    if (NULL != node) {
-        data = node->data;
+    beginExclusive();
+    if (m_active && (m_head != m_tail)) {
+        data = m_slots[m_head & m_mask].data;
     }
+    endExclusive();
 
     return data;
 }
@@ -239,7 +484,10 @@ void* QCameraQueue::peek()
 /*===========================================================================
  * FUNCTION   : dequeue
  *
- * DESCRIPTION: dequeue data from the queue
+ * DESCRIPTION: dequeue data from the queue. Dequeue from head is lock-free.
+ *              If a producer has claimed the head slot but not published it
+ *              yet, it waits for that producer, so every semaphore post
+ *              taken by the caller yields one node.
  *
  * PARAMETERS :
  *   @bFromHead : if true, dequeue from the head
@@ -249,31 +497,60 @@ void* QCameraQueue::peek()
  *==========================================================================*/
 void* QCameraQueue::dequeue(bool bFromHead)
 {
-    camera_q_node* node = NULL;
     void* data = NULL;
-    struct cam_list *head = NULL;
-    struct cam_list *pos = NULL;
 
-    pthread_mutex_lock(&m_lock);
-    if (m_active) {
-        head = &m_head.list;
-        if (bFromHead) {
-            pos = head->next;
-        } else {
-            pos = head->prev;
-        }
-        if (pos != head) {
-            node = member_of(pos, camera_q_node, list);
-            cam_list_del_node(&node->list);
-            m_size--;
+    if (NULL == __atomic_load_n(&m_slots, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+
+    if (!bFromHead || !beginFastOp()) {
+        beginExclusive();
+        if (m_active && (m_head != m_tail)) {
+            if (bFromHead) {
+                data = popHeadLocked();
+            } else {
+                uint32_t pos = m_tail - 1;
+                camera_q_slot *slot = &m_slots[pos & m_mask];
+                data = slot->data;
+                slot->data = NULL;
+                slot->seq = pos;
+                __atomic_store_n(&m_tail, pos, __ATOMIC_RELAXED);
+            }
         }
+        endExclusive();
+        return data;
     }
-    pthread_mutex_unlock(&m_lock);
 
-    if (NULL != node) {
-        data = node->data;
-        free(node);
+    if (__atomic_load_n(&m_active, __ATOMIC_ACQUIRE)) {
+        uint32_t pos = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+        for (;;) {
+            camera_q_slot *slot = &m_slots[pos & m_mask];
+            uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            int32_t diff = (int32_t)(seq - (pos + 1));
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&m_head, &pos, pos + 1, true,
+                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    data = slot->data;
+                    __atomic_store_n(&slot->seq, pos + m_capacity,
+                                     __ATOMIC_RELEASE);
+                    break;
+                }
+            } else if (diff < 0) {
+                if (__atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) == pos) {
+                    /* empty */
+                    break;
+                }
+                /* a producer claimed the head slot but has not published
+                 * it yet. Wait for it: returning NULL here would consume
+                 * the semaphore post of a later, already filled slot */
+                sched_yield();
+                pos = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+            } else {
+                pos = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+            }
+        }
     }
+    endFastOp();
 
     return data;
 }
@@ -289,34 +566,18 @@ void* QCameraQueue::dequeue(bool bFromHead)
  * RETURN     : None
  *==========================================================================*/
 void QCameraQueue::flush(){
-    camera_q_node* node = NULL;
-    struct cam_list *head = NULL;
-    struct cam_list *pos = NULL;
+    if (NULL == __atomic_load_n(&m_slots, __ATOMIC_RELAXED)) {
+        return;
+    }
 
-    pthread_mutex_lock(&m_lock);
+    beginExclusive();
     if (m_active) {
-        head = &m_head.list;
-        pos = head->next;
-
-        while(pos != head) {
-            node = member_of(pos, camera_q_node, list);
-            pos = pos->next;
-            cam_list_del_node(&node->list);
-            m_size--;
-
-            if (NULL != node->data) {
-                if (m_dataFn) {
-                    m_dataFn(node->data, m_userData);
-                }
-                free(node->data);
-            }
-            free(node);
-
+        while (m_head != m_tail) {
+            releaseNode(popHeadLocked());
         }
-        m_size = 0;
-        m_active = false;
+        __atomic_store_n(&m_active, false, __ATOMIC_RELAXED);
     }
-    pthread_mutex_unlock(&m_lock);
+    endExclusive();
 }
 
 /*===========================================================================
@@ -331,37 +592,33 @@ void QCameraQueue::flush(){
  * RETURN     : None
  *==========================================================================*/
 void QCameraQueue::flushNodes(match_fn match){
-    camera_q_node* node = NULL;
-    struct cam_list *head = NULL;
-    struct cam_list *pos = NULL;
-
-    if ( NULL == match ) {
+    if ((NULL == match) ||
+            (NULL == __atomic_load_n(&m_slots, __ATOMIC_RELAXED))) {
         return;
     }
 
-    pthread_mutex_lock(&m_lock);
+    beginExclusive();
     if (m_active) {
-        head = &m_head.list;
-        pos = head->next;
-
-        while(pos != head) {
-            node = member_of(pos, camera_q_node, list);
-            pos = pos->next;
-            if ( match(node->data, m_userData) ) {
-                cam_list_del_node(&node->list);
-                m_size--;
-
-                if (NULL != node->data) {
-                    if (m_dataFn) {
-                        m_dataFn(node->data, m_userData);
-                    }
-                    free(node->data);
+        uint32_t wr = m_head;
+        for (uint32_t pos = m_head; pos != m_tail; pos++) {
+            void *data = m_slots[pos & m_mask].data;
+            if (match(data, m_userData)) {
+                releaseNode(data);
+            } else {
+                if (wr != pos) {
+                    m_slots[wr & m_mask].data = data;
+                    m_slots[wr & m_mask].seq = wr + 1;
                 }
-                free(node);
+                wr++;
             }
         }
+        for (uint32_t pos = wr; pos != m_tail; pos++) {
+            m_slots[pos & m_mask].data = NULL;
+            m_slots[pos & m_mask].seq = pos;
+        }
+        __atomic_store_n(&m_tail, wr, __ATOMIC_RELAXED);
     }
-    pthread_mutex_unlock(&m_lock);
+    endExclusive();
 }
 
 /*===========================================================================
@@ -376,37 +633,33 @@ void QCameraQueue::flushNodes(match_fn match){
  * RETURN     : None
  *==========================================================================*/
 void QCameraQueue::flushNodes(match_fn_data match, void *match_data){
-    camera_q_node* node = NULL;
-    struct cam_list *head = NULL;
-    struct cam_list *pos = NULL;
-
-    if ( NULL == match ) {
+    if ((NULL == match) ||
+            (NULL == __atomic_load_n(&m_slots, __ATOMIC_RELAXED))) {
         return;
     }
 
-    pthread_mutex_lock(&m_lock);
+    beginExclusive();
     if (m_active) {
-        head = &m_head.list;
-        pos = head->next;
-
-        while(pos != head) {
-            node = member_of(pos, camera_q_node, list);
-            pos = pos->next;
-            if ( match(node->data, m_userData, match_data) ) {
-                cam_list_del_node(&node->list);
-                m_size--;
-
-                if (NULL != node->data) {
-                    if (m_dataFn) {
-                        m_dataFn(node->data, m_userData);
-                    }
-                    free(node->data);
+        uint32_t wr = m_head;
+        for (uint32_t pos = m_head; pos != m_tail; pos++) {
+            void *data = m_slots[pos & m_mask].data;
+            if (match(data, m_userData, match_data)) {
+                releaseNode(data);
+            } else {
+                if (wr != pos) {
+                    m_slots[wr & m_mask].data = data;
+                    m_slots[wr & m_mask].seq = wr + 1;
                 }
-                free(node);
+                wr++;
             }
         }
+        for (uint32_t pos = wr; pos != m_tail; pos++) {
+            m_slots[pos & m_mask].data = NULL;
+            m_slots[pos & m_mask].seq = pos;
+        }
+        __atomic_store_n(&m_tail, wr, __ATOMIC_RELAXED);
     }
-    pthread_mutex_unlock(&m_lock);
+    endExclusive();
 }
 
 }; // namespace qcamera
@@ -31,6 +31,7 @@
 #define __QCAMERA_QUEUE_H__
 
 #include <pthread.h>
+#include <stdint.h>
 #include "cam_list.h"
 
 namespace qcamera {
@@ -39,10 +40,28 @@ typedef bool (*match_fn_data)(void *data, void *user_data, void *match_data);
 typedef void (*release_data_fn)(void* data, void *user_data);
 typedef bool (*match_fn)(void *data, void *user_data);
 
+/* initial number of slots in the ring, must be a power of 2 */
+#define QCAMERA_QUEUE_DEFAULT_CAPACITY 256
+
+/* Ring queue. enqueue() and dequeue() from head do not allocate and do
+ * not take m_lock: producers claim slots with a CAS on the tail, the
+ * consumer releases them by sequence number. Operations that reorder or
+ * remove arbitrary nodes (enqueueWithPriority, dequeue from tail, peek,
+ * flush, flushNodes) are rare and run exclusively under m_lock after
+ * in-flight fast operations drained.
+ *
+ * A full ring doubles in size on the exclusive path, so like the list it
+ * replaced the queue is unbounded and enqueue only fails on an inactive
+ * queue or when out of memory. The capacity is the initial size.
+ *
+ * The fast paths are lock-free but not wait-free: dequeue from head spins
+ * on a slot a producer claimed but has not published yet, and any fast
+ * operation waits behind a running exclusive one. */
 class QCameraQueue {
 public:
     QCameraQueue();
-    QCameraQueue(release_data_fn data_rel_fn, void *user_data);
+    QCameraQueue(release_data_fn data_rel_fn, void *user_data,
+            uint32_t capacity = QCAMERA_QUEUE_DEFAULT_CAPACITY);
     virtual ~QCameraQueue();
     void init();
     bool enqueue(void *data);
@@ -55,15 +74,32 @@ public:
     void* dequeue(bool bFromHead = true);
     void* peek();
     bool isEmpty();
-    int getCurrentSize() {return m_size;}
+    int getCurrentSize();
+    uint32_t getCapacity() {return m_capacity;}
 private:
     typedef struct {
-        struct cam_list list;
+        uint32_t seq;   // == pos: free for producer, == pos + 1: filled
         void* data;
-    } camera_q_node;
+    } camera_q_slot;
+
+    void initRing(uint32_t capacity);
+    bool beginFastOp();
+    void endFastOp();
+    void beginExclusive();
+    void endExclusive();
+    bool growLocked();
+    bool pushTailLocked(void *data);
+    void *popHeadLocked();
+    void releaseNode(void *data);
 
-    camera_q_node m_head; // dummy head
-    int m_size;
+    camera_q_slot *m_slots;
+    uint32_t m_capacity;
+    uint32_t m_mask;
+    uint32_t m_head;        // next position to be consumed
+    uint32_t m_tail;        // next position to be produced
+    uint32_t m_fastOps;     // number of lock-free operations in flight
+    uint32_t m_exclusive;   // set while an exclusive operation is running
+    uint32_t m_overflow;    // number of times the ring had to grow
     bool m_active;
     pthread_mutex_t m_lock;
     release_data_fn m_dataFn;
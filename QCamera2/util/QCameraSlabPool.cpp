@@ -0,0 +1,213 @@
+/* Copyright (c) 2015, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include <utils/Log.h>
+#include "QCameraSlabPool.h"
+
+namespace qcamera {
+
+/*===========================================================================
+ * FUNCTION   : QCameraSlabPool
+ *
+ * DESCRIPTION: constructor of QCameraSlabPool. Allocates the slab and
+ *              threads all blocks onto the free list.
+ *
+ * PARAMETERS :
+ *   @blockSize : size of one block in bytes
+ *   @count     : number of blocks in the slab
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraSlabPool::QCameraSlabPool(size_t blockSize, uint32_t count)
+    : m_base(NULL),
+      m_blockSize(0),
+      m_count(0),
+      m_inUse(0),
+      m_overflow(0),
+      m_freeList(NULL)
+{
+    pthread_mutex_init(&m_lock, NULL);
+
+    // keep every block pointer-aligned and large enough for a free node
+    m_blockSize = (blockSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    if (m_blockSize < sizeof(slab_free_node_t)) {
+        m_blockSize = sizeof(slab_free_node_t);
+    }
+
+    m_base = (uint8_t *)malloc(m_blockSize * count);
+    if (NULL == m_base) {
+        ALOGE("%s: No memory for %u blocks of %zu bytes",
+                __func__, count, m_blockSize);
+        return;
+    }
+    m_count = count;
+
+    for (uint32_t i = m_count; i > 0; i--) {
+        slab_free_node_t *node =
+                (slab_free_node_t *)(m_base + (i - 1) * m_blockSize);
+        node->next = m_freeList;
+        m_freeList = node;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : ~QCameraSlabPool
+ *
+ * DESCRIPTION: deconstructor of QCameraSlabPool. Blocks still in use must
+ *              not be touched after this point.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraSlabPool::~QCameraSlabPool()
+{
+    if (m_inUse > 0) {
+        ALOGE("%s: %u slab blocks still in use", __func__, m_inUse);
+    }
+    free(m_base);
+    m_base = NULL;
+    m_freeList = NULL;
+    pthread_mutex_destroy(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : alloc
+ *
+ * DESCRIPTION: get a block from the slab, or from the heap once the slab
+ *              is exhausted
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : ptr to an uninitialized block, NULL if out of memory
+ *==========================================================================*/
+void *QCameraSlabPool::alloc()
+{
+    slab_free_node_t *node = NULL;
+
+    pthread_mutex_lock(&m_lock);
+    node = m_freeList;
+    if (NULL != node) {
+        m_freeList = node->next;
+        m_inUse++;
+    } else {
+        m_overflow++;
+    }
+    pthread_mutex_unlock(&m_lock);
+
+    if (NULL != node) {
+        return node;
+    }
+    return malloc(m_blockSize);
+}
+
+/*===========================================================================
+ * FUNCTION   : release
+ *
+ * DESCRIPTION: return a block to the slab, or free it if it came from the
+ *              heap
+ *
+ * PARAMETERS :
+ *   @block   : block to be released, may be NULL
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraSlabPool::release(void *block)
+{
+    if (NULL == block) {
+        return;
+    }
+
+    if (!owns(block)) {
+        free(block);
+        return;
+    }
+
+    slab_free_node_t *node = (slab_free_node_t *)block;
+    pthread_mutex_lock(&m_lock);
+    node->next = m_freeList;
+    m_freeList = node;
+    m_inUse--;
+    pthread_mutex_unlock(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : owns
+ *
+ * DESCRIPTION: check whether a block was carved out of this slab
+ *
+ * PARAMETERS :
+ *   @block   : block to be checked
+ *
+ * RETURN     : true if block belongs to the slab
+ *==========================================================================*/
+bool QCameraSlabPool::owns(void *block)
+{
+    uint8_t *ptr = (uint8_t *)block;
+    return (NULL != m_base) && (ptr >= m_base) &&
+            (ptr < m_base + m_blockSize * m_count);
+}
+
+/*===========================================================================
+ * FUNCTION   : getInUseCnt
+ *
+ * DESCRIPTION: number of slab blocks currently handed out
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : block count
+ *==========================================================================*/
+uint32_t QCameraSlabPool::getInUseCnt()
+{
+    pthread_mutex_lock(&m_lock);
+    uint32_t cnt = m_inUse;
+    pthread_mutex_unlock(&m_lock);
+    return cnt;
+}
+
+/*===========================================================================
+ * FUNCTION   : getOverflowCnt
+ *
+ * DESCRIPTION: number of alloc() calls served from the heap because the
+ *              slab was exhausted
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : overflow count
+ *==========================================================================*/
+uint32_t QCameraSlabPool::getOverflowCnt()
+{
+    pthread_mutex_lock(&m_lock);
+    uint32_t cnt = m_overflow;
+    pthread_mutex_unlock(&m_lock);
+    return cnt;
+}
+
+}; // namespace qcamera
@@ -0,0 +1,70 @@
+/* Copyright (c) 2015, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA_SLAB_POOL_H__
+#define __QCAMERA_SLAB_POOL_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace qcamera {
+
+/* Fixed number of equally sized blocks carved out of one allocation and
+ * handed out from a free list. Once the slab is exhausted, alloc() falls
+ * back to malloc and the overflow is counted; release() recognizes slab
+ * blocks by address and frees anything else, so blocks from either source
+ * can be released through the pool. */
+class QCameraSlabPool {
+public:
+    QCameraSlabPool(size_t blockSize, uint32_t count);
+    virtual ~QCameraSlabPool();
+    void *alloc();
+    void release(void *block);
+    bool owns(void *block);
+    uint32_t getCapacity() {return m_count;}
+    uint32_t getInUseCnt();
+    uint32_t getOverflowCnt();
+private:
+    typedef struct slab_free_node {
+        struct slab_free_node *next;
+    } slab_free_node_t;
+
+    uint8_t *m_base;
+    size_t m_blockSize;
+    uint32_t m_count;
+    uint32_t m_inUse;
+    uint32_t m_overflow;
+    slab_free_node_t *m_freeList;
+    pthread_mutex_t m_lock;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_SLAB_POOL_H__ */
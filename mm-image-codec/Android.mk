@@ -1,3 +1,10 @@
+MM_IMAGE_CODEC_PATH := $(call my-dir)
 ifeq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),arm arm64))
 include $(call all-subdir-makefiles)
+else
+# only the host build of the software encoder applies to other targets
+MM_IMAGE_CODEC_HOST_ONLY := true
+include $(MM_IMAGE_CODEC_PATH)/qomx_core/Android.mk
+include $(MM_IMAGE_CODEC_PATH)/qomx_swenc/Android.mk
+MM_IMAGE_CODEC_HOST_ONLY :=
 endif
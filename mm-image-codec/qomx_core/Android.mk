@@ -4,6 +4,7 @@ OMX_CORE_PATH := $(call my-dir)
 #                Make the shared library (libqomx_core)
 # ------------------------------------------------------------------------------
 
+ifneq ($(MM_IMAGE_CODEC_HOST_ONLY),true)
 include $(CLEAR_VARS)
 LOCAL_PATH := $(OMX_CORE_PATH)
 LOCAL_MODULE_TAGS := optional
@@ -26,3 +27,24 @@ LOCAL_SHARED_LIBRARIES := libcutils libdl
 
 LOCAL_32_BIT_ONLY := true
 include $(BUILD_SHARED_LIBRARY)
+endif
+
+# ------------------------------------------------------------------------------
+#                Make the host shared library (libqomx_core)
+# ------------------------------------------------------------------------------
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(OMX_CORE_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Werror -g -O2
+
+LOCAL_C_INCLUDES := frameworks/native/include/media/openmax
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../qexif
+
+LOCAL_SRC_FILES := qomx_core.c
+
+LOCAL_MODULE           := libqomx_core
+LOCAL_STATIC_LIBRARIES := liblog
+LOCAL_LDLIBS           := -ldl -lpthread
+include $(BUILD_HOST_SHARED_LIBRARY)
@@ -60,6 +60,7 @@ typedef enum {
 #define QOMX_IMAGE_EXT_META_ENC_KEY_NAME      "OMX.QCOM.image.exttype.metaEncKey"
 #define QOMX_IMAGE_EXT_MEM_OPS_NAME      "OMX.QCOM.image.exttype.mem_ops"
 #define QOMX_IMAGE_EXT_JPEG_SPEED_NAME      "OMX.QCOM.image.exttype.jpeg.speed"
+#define QOMX_IMAGE_EXT_ENCODING_THREADS_NAME "OMX.QCOM.image.exttype.encoding.threads"
 
 /** QOMX_IMAGE_EXT_INDEXTYPE
 *  This enum is an extension of the OMX_INDEXTYPE enum and
@@ -99,6 +100,9 @@ typedef enum {
   //Name: OMX.QCOM.image.exttype.jpeg.speed
   QOMX_IMAGE_EXT_JPEG_SPEED = 0x07F000B,
 
+  //Name: OMX.QCOM.image.exttype.encoding.threads
+  QOMX_IMAGE_EXT_ENCODING_THREADS = 0x07F000C,
+
 } QOMX_IMAGE_EXT_INDEXTYPE;
 
 /** QOMX_BUFFER_INFO
@@ -310,6 +314,16 @@ typedef struct {
   QOMX_JPEG_SPEED_MODE speedMode;
 } QOMX_JPEG_SPEED;
 
+/** QOMX_ENCODING_THREADS
+* Structure used to set the number of threads encoding one
+* image in OMX_Parallel_Encoding mode. Only the software
+* encoder supports it, and only in OMX_StateLoaded
+* @numThreads - number of threads, 0 selects the default
+**/
+typedef struct {
+  OMX_U32 numThreads;
+} QOMX_ENCODING_THREADS;
+
 #ifdef __cplusplus
  }
 #endif
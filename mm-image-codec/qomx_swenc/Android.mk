@@ -0,0 +1,61 @@
+OMX_SWENC_PATH := $(call my-dir)
+
+omx_swenc_defines:= -Wall -Wextra -Werror
+
+omx_swenc_src := qomx_swenc.c \
+                 qomx_swenc_jpeg.c \
+                 qomx_swenc_exif.c \
+                 qomx_swenc_pool.c
+
+OMX_HEADER_DIR := frameworks/native/include/media/openmax
+
+# ------------------------------------------------------------------------------
+#                Make the shared library (libqomx_jpegenc_sw)
+# ------------------------------------------------------------------------------
+
+ifneq ($(MM_IMAGE_CODEC_HOST_ONLY),true)
+include $(CLEAR_VARS)
+LOCAL_PATH := $(OMX_SWENC_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := $(omx_swenc_defines)
+
+LOCAL_C_INCLUDES := $(OMX_HEADER_DIR)
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../qexif
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../qomx_core
+LOCAL_C_INCLUDES += external/jpeg
+
+LOCAL_SRC_FILES := $(omx_swenc_src)
+
+LOCAL_MODULE           := libqomx_jpegenc_sw
+LOCAL_PRELINK_MODULE   := false
+LOCAL_SHARED_LIBRARIES := libcutils liblog libjpeg
+
+LOCAL_32_BIT_ONLY := true
+include $(BUILD_SHARED_LIBRARY)
+endif
+
+# ------------------------------------------------------------------------------
+#      Make the host shared library (libqomx_jpegenc_sw) on libjpeg-turbo
+# ------------------------------------------------------------------------------
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(OMX_SWENC_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := $(omx_swenc_defines)
+
+LOCAL_C_INCLUDES := $(OMX_HEADER_DIR)
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../qexif
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../qomx_core
+LOCAL_C_INCLUDES += external/libjpeg-turbo
+
+LOCAL_SRC_FILES := $(omx_swenc_src)
+
+LOCAL_MODULE           := libqomx_jpegenc_sw
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+LOCAL_SHARED_LIBRARIES := libjpeg
+LOCAL_LDLIBS           := -lpthread
+include $(BUILD_HOST_SHARED_LIBRARY)
+
+include $(OMX_SWENC_PATH)/test/Android.mk
@@ -0,0 +1,1168 @@
+/*Copyright (c) 2015, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#define LOG_NDEBUG 0
+#define LOG_NIDEBUG 0
+#define LOG_TAG "qomx_jpegenc_sw"
+#include <utils/Log.h>
+#include <sys/prctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <cutils/properties.h>
+
+#include "qomx_swenc.h"
+
+#define QOMX_SWENC_ALL_PORTS 0xFFFFFFFF
+
+#define QOMX_SWENC_GET_COMP(h) \
+  ((qomx_swenc_comp_t *)((OMX_COMPONENTTYPE *)(h))->pComponentPrivate)
+
+/** g_ext_idx: extension names understood by the component
+**/
+static const struct {
+  const char *name;
+  QOMX_IMAGE_EXT_INDEXTYPE index;
+} g_ext_idx[] = {
+  { QOMX_IMAGE_EXT_EXIF_NAME, QOMX_IMAGE_EXT_EXIF },
+  { QOMX_IMAGE_EXT_THUMBNAIL_NAME, QOMX_IMAGE_EXT_THUMBNAIL },
+  { QOMX_IMAGE_EXT_BUFFER_OFFSET_NAME, QOMX_IMAGE_EXT_BUFFER_OFFSET },
+  { QOMX_IMAGE_EXT_MOBICAT_NAME, QOMX_IMAGE_EXT_MOBICAT },
+  { QOMX_IMAGE_EXT_ENCODING_MODE_NAME, QOMX_IMAGE_EXT_ENCODING_MODE },
+  { QOMX_IMAGE_EXT_WORK_BUFFER_NAME, QOMX_IMAGE_EXT_WORK_BUFFER },
+  { QOMX_IMAGE_EXT_METADATA_NAME, QOMX_IMAGE_EXT_METADATA },
+  { QOMX_IMAGE_EXT_META_ENC_KEY_NAME, QOMX_IMAGE_EXT_META_ENC_KEY },
+  { QOMX_IMAGE_EXT_MEM_OPS_NAME, QOMX_IMAGE_EXT_MEM_OPS },
+  { QOMX_IMAGE_EXT_JPEG_SPEED_NAME, QOMX_IMAGE_EXT_JPEG_SPEED },
+  { QOMX_IMAGE_EXT_ENCODING_THREADS_NAME, QOMX_IMAGE_EXT_ENCODING_THREADS },
+};
+
+static int64_t qomx_swenc_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_event
+* Parameters: p_comp, event, data1, data2
+* Return Value : None
+* Description: Send an event to the client
+==============================================================================*/
+static void qomx_swenc_event(qomx_swenc_comp_t *p_comp, OMX_EVENTTYPE event,
+  OMX_U32 data1, OMX_U32 data2)
+{
+  if (p_comp->callbacks.EventHandler) {
+    p_comp->callbacks.EventHandler(&p_comp->omx, p_comp->app_data, event,
+      data1, data2, NULL);
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_error
+* Parameters: p_comp, err
+* Return Value : None
+* Description: Report an error. mm-jpeg-interface reads the error code
+* from nData2 so it is passed in both fields.
+==============================================================================*/
+static void qomx_swenc_error(qomx_swenc_comp_t *p_comp, OMX_ERRORTYPE err)
+{
+  ALOGE("%s:%d] Error 0x%x", __func__, __LINE__, err);
+  qomx_swenc_event(p_comp, OMX_EventError, (OMX_U32)err, (OMX_U32)err);
+}
+
+/*==============================================================================
+* Function : qomx_swenc_post_msg
+* Parameters: p_comp, p_msg
+* Return Value : OMX_ERRORTYPE
+* Description: Queue a message for the component thread
+==============================================================================*/
+static OMX_ERRORTYPE qomx_swenc_post_msg(qomx_swenc_comp_t *p_comp,
+  qomx_swenc_msg_t *p_msg)
+{
+  pthread_mutex_lock(&p_comp->lock);
+  if (p_comp->msg_cnt >= QOMX_SWENC_MSG_Q_SIZE) {
+    pthread_mutex_unlock(&p_comp->lock);
+    ALOGE("%s:%d] Message queue full", __func__, __LINE__);
+    return OMX_ErrorInsufficientResources;
+  }
+  p_comp->msg_q[(p_comp->msg_head + p_comp->msg_cnt) %
+    QOMX_SWENC_MSG_Q_SIZE] = *p_msg;
+  p_comp->msg_cnt++;
+  pthread_cond_signal(&p_comp->cond);
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_return_buffers
+* Parameters: p_comp
+* Return Value : None
+* Description: Hand all buffers held by the component back to the client
+==============================================================================*/
+static void qomx_swenc_return_buffers(qomx_swenc_comp_t *p_comp)
+{
+  OMX_BUFFERHEADERTYPE *p_buf[QOMX_SWENC_NUM_PORTS];
+  uint32_t i;
+
+  pthread_mutex_lock(&p_comp->lock);
+  for (i = 0; i < QOMX_SWENC_NUM_PORTS; i++) {
+    p_buf[i] = p_comp->port[i].p_pending;
+    p_comp->port[i].p_pending = NULL;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+
+  for (i = 0; i < QOMX_SWENC_NUM_PORTS; i++) {
+    if (!p_buf[i]) {
+      continue;
+    }
+    if (QOMX_SWENC_PORT_OUT == i) {
+      p_buf[i]->nFilledLen = 0;
+      if (p_comp->callbacks.FillBufferDone) {
+        p_comp->callbacks.FillBufferDone(&p_comp->omx, p_comp->app_data,
+          p_buf[i]);
+      }
+    } else if (p_comp->callbacks.EmptyBufferDone) {
+      p_comp->callbacks.EmptyBufferDone(&p_comp->omx, p_comp->app_data,
+        p_buf[i]);
+    }
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_check_transition
+* Parameters: p_comp
+* Return Value : None
+* Description: Complete a Loaded<->Idle transition once the enabled ports
+* are populated or all buffers are released
+==============================================================================*/
+static void qomx_swenc_check_transition(qomx_swenc_comp_t *p_comp)
+{
+  uint32_t i;
+  OMX_STATETYPE target;
+
+  pthread_mutex_lock(&p_comp->lock);
+  target = p_comp->target_state;
+  if (target == p_comp->state) {
+    pthread_mutex_unlock(&p_comp->lock);
+    return;
+  }
+  for (i = 0; i < QOMX_SWENC_NUM_PORTS; i++) {
+    qomx_swenc_port_t *p_port = &p_comp->port[i];
+    if ((OMX_StateIdle == target) && p_port->def.bEnabled &&
+      (p_port->buf_cnt < p_port->def.nBufferCountActual)) {
+      pthread_mutex_unlock(&p_comp->lock);
+      return;
+    }
+    if ((OMX_StateLoaded == target) && p_port->buf_cnt) {
+      pthread_mutex_unlock(&p_comp->lock);
+      return;
+    }
+  }
+  for (i = 0; i < QOMX_SWENC_NUM_PORTS; i++) {
+    p_comp->port[i].def.bPopulated =
+      (OMX_StateIdle == target) ? p_comp->port[i].def.bEnabled : OMX_FALSE;
+  }
+  p_comp->state = target;
+  pthread_mutex_unlock(&p_comp->lock);
+
+  qomx_swenc_event(p_comp, OMX_EventCmdComplete, OMX_CommandStateSet,
+    (OMX_U32)target);
+}
+
+/*==============================================================================
+* Function : qomx_swenc_set_state
+* Parameters: p_comp, new_state
+* Return Value : None
+* Description: Process a StateSet command on the component thread
+==============================================================================*/
+static void qomx_swenc_set_state(qomx_swenc_comp_t *p_comp,
+  OMX_STATETYPE new_state)
+{
+  OMX_STATETYPE cur;
+
+  pthread_mutex_lock(&p_comp->lock);
+  cur = p_comp->state;
+  pthread_mutex_unlock(&p_comp->lock);
+
+  if (cur == new_state) {
+    qomx_swenc_error(p_comp, OMX_ErrorSameState);
+    return;
+  }
+
+  switch (new_state) {
+  case OMX_StateIdle:
+    if (OMX_StateLoaded == cur) {
+      pthread_mutex_lock(&p_comp->lock);
+      p_comp->target_state = OMX_StateIdle;
+      pthread_mutex_unlock(&p_comp->lock);
+      qomx_swenc_check_transition(p_comp);
+      return;
+    }
+    if ((OMX_StateExecuting == cur) || (OMX_StatePause == cur)) {
+      qomx_swenc_return_buffers(p_comp);
+      break;
+    }
+    qomx_swenc_error(p_comp, OMX_ErrorIncorrectStateTransition);
+    return;
+  case OMX_StateLoaded:
+    if (OMX_StateIdle == cur) {
+      pthread_mutex_lock(&p_comp->lock);
+      p_comp->target_state = OMX_StateLoaded;
+      pthread_mutex_unlock(&p_comp->lock);
+      qomx_swenc_check_transition(p_comp);
+      return;
+    }
+    qomx_swenc_error(p_comp, OMX_ErrorIncorrectStateTransition);
+    return;
+  case OMX_StateExecuting:
+  case OMX_StatePause:
+    if ((OMX_StateIdle == cur) || (OMX_StateExecuting == cur) ||
+      (OMX_StatePause == cur)) {
+      break;
+    }
+    qomx_swenc_error(p_comp, OMX_ErrorIncorrectStateTransition);
+    return;
+  default:
+    qomx_swenc_error(p_comp, OMX_ErrorIncorrectStateTransition);
+    return;
+  }
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->state = p_comp->target_state = new_state;
+  pthread_mutex_unlock(&p_comp->lock);
+  qomx_swenc_event(p_comp, OMX_EventCmdComplete, OMX_CommandStateSet,
+    (OMX_U32)new_state);
+}
+
+/*==============================================================================
+* Function : qomx_swenc_fill_image
+* Parameters: p_img, p_port, p_buf, p_offset
+* Return Value : None
+* Description: Describe the source planes of an input buffer
+==============================================================================*/
+static void qomx_swenc_fill_image(qomx_swenc_image_t *p_img,
+  qomx_swenc_port_t *p_port, OMX_BUFFERHEADERTYPE *p_buf,
+  QOMX_YUV_FRAME_INFO *p_offset)
+{
+  OMX_IMAGE_PORTDEFINITIONTYPE *p_def = &p_port->def.format.image;
+  OMX_U32 cbcr_start;
+
+  memset(p_img, 0x0, sizeof(*p_img));
+  p_img->width = p_def->nFrameWidth;
+  p_img->height = p_def->nFrameHeight;
+  p_img->stride = p_def->nStride ? (OMX_U32)p_def->nStride : p_def->nFrameWidth;
+  p_img->scanline = p_def->nSliceHeight ? p_def->nSliceHeight :
+    p_def->nFrameHeight;
+  p_img->color_fmt = (int)p_def->eColorFormat;
+
+  cbcr_start = p_offset->cbcrStartOffset[0] ? p_offset->cbcrStartOffset[0] :
+    p_img->stride * p_img->scanline;
+  p_img->p_y = p_buf->pBuffer + p_offset->yOffset;
+  p_img->p_cbcr = p_buf->pBuffer + cbcr_start + p_offset->cbcrOffset[0];
+}
+
+/*==============================================================================
+* Function : qomx_swenc_encode_thumbnail
+* Parameters: p_comp, p_buf, p_size
+* Return Value : OMX_ERRORTYPE
+* Description: Encode the thumbnail into the component buffer. The quality
+* is lowered until the bitstream fits into the APP1 segment.
+==============================================================================*/
+static OMX_ERRORTYPE qomx_swenc_encode_thumbnail(qomx_swenc_comp_t *p_comp,
+  OMX_BUFFERHEADERTYPE *p_buf, size_t *p_size)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  qomx_swenc_image_t img;
+  QOMX_THUMBNAIL_INFO *p_info = &p_comp->thumb_info;
+  uint32_t i;
+
+  qomx_swenc_fill_image(&img, &p_comp->port[QOMX_SWENC_PORT_THUMB], p_buf,
+    &p_info->tmbOffset);
+  if (p_info->input_width && p_info->input_height) {
+    img.width = p_info->input_width;
+    img.height = p_info->input_height;
+  }
+  img.crop = p_info->crop_info;
+  if (p_info->scaling_enabled) {
+    img.out_width = p_info->output_width;
+    img.out_height = p_info->output_height;
+  }
+  img.rotation = p_info->rotation;
+  img.quality = ((p_info->quality > 0) && (p_info->quality <= 100)) ?
+    p_info->quality : QOMX_SWENC_DEFAULT_QUALITY;
+
+  for (i = 0; i <= QOMX_SWENC_THUMB_RETRY; i++) {
+    rc = qomx_swenc_encode(&img, p_comp->speed_mode, NULL, NULL, OMX_TRUE,
+      &p_comp->work, NULL, p_comp->p_thumb, QOMX_SWENC_MAX_THUMB_SIZE,
+      p_size);
+    if ((OMX_ErrorOverflow != rc) ||
+      (img.quality <= QOMX_SWENC_THUMB_QUALITY_STEP)) {
+      break;
+    }
+    img.quality -= QOMX_SWENC_THUMB_QUALITY_STEP;
+    ALOGI("%s:%d] Thumbnail too large, retry with quality %u",
+      __func__, __LINE__, img.quality);
+  }
+  return rc;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_process
+* Parameters: p_comp
+* Return Value : None
+* Description: Run the encode once the main input, the output and, if the
+* thumbnail port is enabled, the thumbnail input are all queued. The
+* thumbnail is encoded first since it has to be embedded in the APP1
+* segment that precedes the main image.
+==============================================================================*/
+static void qomx_swenc_process(qomx_swenc_comp_t *p_comp)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_BUFFERHEADERTYPE *p_main, *p_thumb, *p_out;
+  qomx_swenc_image_t img;
+  size_t thumb_size = 0, app1_size = 0, app1_len = 0, filled = 0;
+  int64_t start, thumb_done, end;
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_main = p_comp->port[QOMX_SWENC_PORT_MAIN].p_pending;
+  p_thumb = p_comp->port[QOMX_SWENC_PORT_THUMB].p_pending;
+  p_out = p_comp->port[QOMX_SWENC_PORT_OUT].p_pending;
+  if ((OMX_StateExecuting != p_comp->state) || !p_main || !p_out ||
+    (p_comp->port[QOMX_SWENC_PORT_THUMB].def.bEnabled && !p_thumb)) {
+    pthread_mutex_unlock(&p_comp->lock);
+    return;
+  }
+  p_comp->port[QOMX_SWENC_PORT_MAIN].p_pending = NULL;
+  p_comp->port[QOMX_SWENC_PORT_THUMB].p_pending = NULL;
+  p_comp->port[QOMX_SWENC_PORT_OUT].p_pending = NULL;
+  pthread_mutex_unlock(&p_comp->lock);
+
+  start = qomx_swenc_now_us();
+  if (p_thumb) {
+    rc = qomx_swenc_encode_thumbnail(p_comp, p_thumb, &thumb_size);
+    if (OMX_ErrorNone != rc) {
+      ALOGE("%s:%d] Thumbnail encode failed %d, dropping it",
+        __func__, __LINE__, rc);
+      thumb_size = 0;
+      qomx_swenc_event(p_comp, (OMX_EVENTTYPE)OMX_EVENT_THUMBNAIL_DROPPED,
+        0, 0);
+    }
+  }
+  thumb_done = qomx_swenc_now_us();
+
+  /* only measure the APP1 payload here, it is serialized into the output
+   * buffer once the main image has been encoded behind it */
+  if (p_comp->exif_cnt || thumb_size) {
+    rc = qomx_swenc_exif_build(p_comp->exif, p_comp->exif_cnt,
+      thumb_size ? p_comp->p_thumb : NULL, thumb_size,
+      NULL, QOMX_SWENC_MAX_APP1_SIZE, &app1_size);
+    if ((OMX_ErrorNone != rc) && thumb_size) {
+      ALOGE("%s:%d] EXIF too large with thumbnail, dropping it",
+        __func__, __LINE__);
+      qomx_swenc_event(p_comp, (OMX_EVENTTYPE)OMX_EVENT_THUMBNAIL_DROPPED,
+        0, 0);
+      thumb_size = 0;
+      rc = qomx_swenc_exif_build(p_comp->exif, p_comp->exif_cnt, NULL, 0,
+        NULL, QOMX_SWENC_MAX_APP1_SIZE, &app1_size);
+    }
+    if (OMX_ErrorNone != rc) {
+      ALOGE("%s:%d] EXIF dropped", __func__, __LINE__);
+      app1_size = 0;
+    }
+  }
+  app1_len = app1_size ? QOMX_SWENC_APP1_HDR_SIZE + app1_size : 0;
+
+  qomx_swenc_fill_image(&img, &p_comp->port[QOMX_SWENC_PORT_MAIN], p_main,
+    &p_comp->main_offset);
+  img.crop = p_comp->in_crop;
+  img.out_width = p_comp->out_crop.nWidth;
+  img.out_height = p_comp->out_crop.nHeight;
+  img.rotation = p_comp->rotation;
+  img.quality = p_comp->quality;
+  if (app1_len + 2 > p_out->nAllocLen) {
+    ALOGE("%s:%d] Output buffer too small for APP1", __func__, __LINE__);
+    rc = OMX_ErrorOverflow;
+  } else {
+    rc = qomx_swenc_encode(&img, p_comp->speed_mode, p_comp->qtable,
+      p_comp->qtable_set, app1_len ? OMX_FALSE : OMX_TRUE, &p_comp->work,
+      (OMX_Parallel_Encoding == p_comp->encoding_mode) ? &p_comp->pool : NULL,
+      p_out->pBuffer + app1_len, p_out->nAllocLen - app1_len, &filled);
+  }
+  if ((OMX_ErrorNone == rc) && app1_len) {
+    rc = qomx_swenc_exif_write_header(p_comp->exif, p_comp->exif_cnt,
+      thumb_size ? p_comp->p_thumb : NULL, thumb_size, p_out->pBuffer,
+      app1_size);
+    filled += app1_len;
+  }
+  end = qomx_swenc_now_us();
+
+  ALOGI("%s:%d] %ux%u rot %u speed %d threads %u: thumb %lld us, "
+    "main %lld us, %zu bytes", __func__, __LINE__, img.width, img.height,
+    img.rotation, p_comp->speed_mode,
+    (OMX_Parallel_Encoding == p_comp->encoding_mode) ?
+    p_comp->pool.num_threads + 1 : 1, (long long)(thumb_done - start),
+    (long long)(end - thumb_done), filled);
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->exif_cnt = 0;
+  pthread_mutex_unlock(&p_comp->lock);
+
+  if (p_comp->callbacks.EmptyBufferDone) {
+    p_comp->callbacks.EmptyBufferDone(&p_comp->omx, p_comp->app_data, p_main);
+    if (p_thumb) {
+      p_comp->callbacks.EmptyBufferDone(&p_comp->omx, p_comp->app_data,
+        p_thumb);
+    }
+  }
+
+  if (OMX_ErrorNone != rc) {
+    /* the output buffer is not returned, the client reclaims it when
+     * it handles the error */
+    qomx_swenc_error(p_comp, rc);
+    return;
+  }
+
+  p_out->nFilledLen = (OMX_U32)filled;
+  p_out->nOffset = 0;
+  p_out->nFlags = OMX_BUFFERFLAG_ENDOFFRAME | OMX_BUFFERFLAG_EOS;
+  if (p_comp->callbacks.FillBufferDone) {
+    p_comp->callbacks.FillBufferDone(&p_comp->omx, p_comp->app_data, p_out);
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_queue_buffer
+* Parameters: p_comp, port_idx, p_buf
+* Return Value : None
+* Description: Take ownership of a client buffer on the component thread
+==============================================================================*/
+static void qomx_swenc_queue_buffer(qomx_swenc_comp_t *p_comp,
+  OMX_U32 port_idx, OMX_BUFFERHEADERTYPE *p_buf)
+{
+  OMX_BUFFERHEADERTYPE *p_old;
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_old = p_comp->port[port_idx].p_pending;
+  p_comp->port[port_idx].p_pending = p_buf;
+  pthread_mutex_unlock(&p_comp->lock);
+
+  /* a second buffer on the same port replaces the first one */
+  if (p_old) {
+    ALOGE("%s:%d] Port %u already has a buffer queued", __func__, __LINE__,
+      port_idx);
+    if (QOMX_SWENC_PORT_OUT == port_idx) {
+      p_old->nFilledLen = 0;
+      if (p_comp->callbacks.FillBufferDone) {
+        p_comp->callbacks.FillBufferDone(&p_comp->omx, p_comp->app_data,
+          p_old);
+      }
+    } else if (p_comp->callbacks.EmptyBufferDone) {
+      p_comp->callbacks.EmptyBufferDone(&p_comp->omx, p_comp->app_data,
+        p_old);
+    }
+  }
+  qomx_swenc_process(p_comp);
+}
+
+/*==============================================================================
+* Function : qomx_swenc_thread
+* Parameters: data
+* Return Value : NULL
+* Description: Component thread. All client callbacks are issued from
+* here so the client can hold its own locks while calling into the
+* component.
+==============================================================================*/
+static void *qomx_swenc_thread(void *data)
+{
+  qomx_swenc_comp_t *p_comp = (qomx_swenc_comp_t *)data;
+  qomx_swenc_msg_t msg;
+
+  prctl(PR_SET_NAME, (unsigned long)"qomx_swenc", 0, 0, 0);
+  for (;;) {
+    pthread_mutex_lock(&p_comp->lock);
+    while ((0 == p_comp->msg_cnt) && !p_comp->thread_exit) {
+      pthread_cond_wait(&p_comp->cond, &p_comp->lock);
+    }
+    if (p_comp->thread_exit) {
+      pthread_mutex_unlock(&p_comp->lock);
+      break;
+    }
+    msg = p_comp->msg_q[p_comp->msg_head];
+    p_comp->msg_head = (p_comp->msg_head + 1) % QOMX_SWENC_MSG_Q_SIZE;
+    p_comp->msg_cnt--;
+    pthread_mutex_unlock(&p_comp->lock);
+
+    switch (msg.type) {
+    case QOMX_SWENC_MSG_CMD:
+      if (OMX_CommandStateSet == msg.cmd) {
+        qomx_swenc_set_state(p_comp, (OMX_STATETYPE)msg.param);
+      } else if (OMX_CommandFlush == msg.cmd) {
+        qomx_swenc_return_buffers(p_comp);
+        qomx_swenc_event(p_comp, OMX_EventCmdComplete, OMX_CommandFlush,
+          msg.param);
+      }
+      break;
+    case QOMX_SWENC_MSG_ETB:
+      qomx_swenc_queue_buffer(p_comp, msg.p_buf->nInputPortIndex, msg.p_buf);
+      break;
+    case QOMX_SWENC_MSG_FTB:
+      qomx_swenc_queue_buffer(p_comp, QOMX_SWENC_PORT_OUT, msg.p_buf);
+      break;
+    case QOMX_SWENC_MSG_BUF_CHANGE:
+      qomx_swenc_check_transition(p_comp);
+      break;
+    }
+  }
+  return NULL;
+}
+
+static OMX_ERRORTYPE qomx_swenc_get_version(OMX_HANDLETYPE hComp,
+  OMX_STRING pComponentName, OMX_VERSIONTYPE *pComponentVersion,
+  OMX_VERSIONTYPE *pSpecVersion, OMX_UUIDTYPE *pComponentUUID)
+{
+  (void)hComp;
+  (void)pComponentUUID;
+  if (!pComponentName || !pComponentVersion || !pSpecVersion) {
+    return OMX_ErrorBadParameter;
+  }
+  snprintf(pComponentName, OMX_MAX_STRINGNAME_SIZE, "%s", QOMX_SWENC_COMP_NAME);
+  pComponentVersion->nVersion = 1;
+  pSpecVersion->nVersion = 0x00000101;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_swenc_send_command(OMX_HANDLETYPE hComp,
+  OMX_COMMANDTYPE cmd, OMX_U32 param, OMX_PTR pCmdData)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  qomx_swenc_msg_t msg;
+  uint32_t i;
+
+  (void)pCmdData;
+  switch (cmd) {
+  case OMX_CommandStateSet:
+  case OMX_CommandFlush:
+    memset(&msg, 0x0, sizeof(msg));
+    msg.type = QOMX_SWENC_MSG_CMD;
+    msg.cmd = cmd;
+    msg.param = param;
+    return qomx_swenc_post_msg(p_comp, &msg);
+  case OMX_CommandPortEnable:
+  case OMX_CommandPortDisable:
+    if ((param >= QOMX_SWENC_NUM_PORTS) && (QOMX_SWENC_ALL_PORTS != param)) {
+      return OMX_ErrorBadPortIndex;
+    }
+    /* ports have no resources of their own, so the command completes
+     * immediately */
+    pthread_mutex_lock(&p_comp->lock);
+    for (i = 0; i < QOMX_SWENC_NUM_PORTS; i++) {
+      if ((i == param) || (QOMX_SWENC_ALL_PORTS == param)) {
+        p_comp->port[i].def.bEnabled =
+          (OMX_CommandPortEnable == cmd) ? OMX_TRUE : OMX_FALSE;
+      }
+    }
+    pthread_mutex_unlock(&p_comp->lock);
+    qomx_swenc_event(p_comp, OMX_EventCmdComplete, cmd, param);
+    return OMX_ErrorNone;
+  default:
+    return OMX_ErrorNotImplemented;
+  }
+}
+
+static OMX_ERRORTYPE qomx_swenc_get_parameter(OMX_HANDLETYPE hComp,
+  OMX_INDEXTYPE index, OMX_PTR data)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  if (!data) {
+    return OMX_ErrorBadParameter;
+  }
+
+  pthread_mutex_lock(&p_comp->lock);
+  switch ((int)index) {
+  case OMX_IndexParamPortDefinition: {
+    OMX_PARAM_PORTDEFINITIONTYPE *p_def = (OMX_PARAM_PORTDEFINITIONTYPE *)data;
+    if (p_def->nPortIndex >= QOMX_SWENC_NUM_PORTS) {
+      rc = OMX_ErrorBadPortIndex;
+      break;
+    }
+    *p_def = p_comp->port[p_def->nPortIndex].def;
+    break;
+  }
+  case OMX_IndexParamQFactor: {
+    OMX_IMAGE_PARAM_QFACTORTYPE *p_q = (OMX_IMAGE_PARAM_QFACTORTYPE *)data;
+    p_q->nQFactor = p_comp->quality;
+    break;
+  }
+  case OMX_IndexConfigCommonRotate: {
+    OMX_CONFIG_ROTATIONTYPE *p_rot = (OMX_CONFIG_ROTATIONTYPE *)data;
+    p_rot->nRotation = (OMX_S32)p_comp->rotation;
+    break;
+  }
+  case OMX_IndexConfigCommonInputCrop:
+    *(OMX_CONFIG_RECTTYPE *)data = p_comp->in_crop;
+    break;
+  case OMX_IndexConfigCommonOutputCrop:
+    *(OMX_CONFIG_RECTTYPE *)data = p_comp->out_crop;
+    break;
+  case QOMX_IMAGE_EXT_JPEG_SPEED:
+    ((QOMX_JPEG_SPEED *)data)->speedMode = p_comp->speed_mode;
+    break;
+  case QOMX_IMAGE_EXT_ENCODING_THREADS:
+    ((QOMX_ENCODING_THREADS *)data)->numThreads = p_comp->pool.num_threads + 1;
+    break;
+  default:
+    rc = OMX_ErrorUnsupportedIndex;
+    break;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+  return rc;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_get_num_threads
+* Parameters: None
+* Return Value : number of threads encoding the main image
+* Description: One thread per online core up to QOMX_SWENC_DEFAULT_THREADS,
+* persist.camera.jpeg.swenc.threads overrides it and 1 keeps the encode
+* on the component thread. QOMX_IMAGE_EXT_ENCODING_THREADS overrides both
+==============================================================================*/
+static OMX_U32 qomx_swenc_get_num_threads(void)
+{
+  char prop[PROPERTY_VALUE_MAX];
+  long num_cpus;
+  int num_threads;
+
+  memset(prop, 0x0, sizeof(prop));
+  property_get("persist.camera.jpeg.swenc.threads", prop, "0");
+  num_threads = atoi(prop);
+  if (num_threads <= 0) {
+    num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = (num_cpus > QOMX_SWENC_DEFAULT_THREADS) ?
+      QOMX_SWENC_DEFAULT_THREADS : (num_cpus > 0 ? (int)num_cpus : 1);
+  }
+  if (num_threads > QOMX_SWENC_MAX_THREADS) {
+    num_threads = QOMX_SWENC_MAX_THREADS;
+  }
+  return (OMX_U32)num_threads;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_set_parameter
+* Parameters: hComp, index, data
+* Return Value : OMX_ERRORTYPE
+* Description: Parameters and configs share one namespace, the client
+* sets some parameters (e.g. QFactor) through SetConfig
+==============================================================================*/
+static OMX_ERRORTYPE qomx_swenc_set_parameter(OMX_HANDLETYPE hComp,
+  OMX_INDEXTYPE index, OMX_PTR data)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  if (!data) {
+    return OMX_ErrorBadParameter;
+  }
+
+  pthread_mutex_lock(&p_comp->lock);
+  switch ((int)index) {
+  case OMX_IndexParamPortDefinition: {
+    OMX_PARAM_PORTDEFINITIONTYPE *p_in = (OMX_PARAM_PORTDEFINITIONTYPE *)data;
+    OMX_PARAM_PORTDEFINITIONTYPE *p_def;
+    if (p_in->nPortIndex >= QOMX_SWENC_NUM_PORTS) {
+      rc = OMX_ErrorBadPortIndex;
+      break;
+    }
+    p_def = &p_comp->port[p_in->nPortIndex].def;
+    if ((QOMX_SWENC_PORT_OUT != p_in->nPortIndex) &&
+      !qomx_swenc_is_fmt_supported((int)p_in->format.image.eColorFormat)) {
+      ALOGE("%s:%d] Unsupported color format %d", __func__, __LINE__,
+        p_in->format.image.eColorFormat);
+      rc = OMX_ErrorUnsupportedSetting;
+      break;
+    }
+    if (p_in->nBufferCountActual > QOMX_SWENC_MAX_BUFS) {
+      rc = OMX_ErrorBadParameter;
+      break;
+    }
+    p_def->nBufferCountActual = p_in->nBufferCountActual;
+    p_def->nBufferSize = p_in->nBufferSize;
+    if (QOMX_SWENC_PORT_OUT != p_in->nPortIndex) {
+      p_def->format.image.nFrameWidth = p_in->format.image.nFrameWidth;
+      p_def->format.image.nFrameHeight = p_in->format.image.nFrameHeight;
+      p_def->format.image.nStride = p_in->format.image.nStride;
+      p_def->format.image.nSliceHeight = p_in->format.image.nSliceHeight;
+      p_def->format.image.eColorFormat = p_in->format.image.eColorFormat;
+    }
+    break;
+  }
+  case OMX_IndexParamQFactor: {
+    OMX_U32 q = ((OMX_IMAGE_PARAM_QFACTORTYPE *)data)->nQFactor;
+    p_comp->quality = ((q > 0) && (q <= 100)) ? q : QOMX_SWENC_DEFAULT_QUALITY;
+    break;
+  }
+  case OMX_IndexParamQuantizationTable: {
+    OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE *p_qt =
+      (OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE *)data;
+    uint32_t idx =
+      (OMX_IMAGE_QuantizationTableLuma == p_qt->eQuantizationTable) ? 0 : 1;
+    p_comp->qtable[idx] = *p_qt;
+    p_comp->qtable_set[idx] = OMX_TRUE;
+    break;
+  }
+  case OMX_IndexConfigCommonRotate: {
+    OMX_S32 rot = ((OMX_CONFIG_ROTATIONTYPE *)data)->nRotation;
+    if ((rot % 90) != 0) {
+      rc = OMX_ErrorBadParameter;
+      break;
+    }
+    p_comp->rotation = (OMX_U32)(((rot % 360) + 360) % 360);
+    break;
+  }
+  case OMX_IndexConfigCommonInputCrop:
+    p_comp->in_crop = *(OMX_CONFIG_RECTTYPE *)data;
+    break;
+  case OMX_IndexConfigCommonOutputCrop:
+    p_comp->out_crop = *(OMX_CONFIG_RECTTYPE *)data;
+    break;
+  case QOMX_IMAGE_EXT_BUFFER_OFFSET:
+    p_comp->main_offset = *(QOMX_YUV_FRAME_INFO *)data;
+    break;
+  case QOMX_IMAGE_EXT_THUMBNAIL:
+    p_comp->thumb_info = *(QOMX_THUMBNAIL_INFO *)data;
+    break;
+  case QOMX_IMAGE_EXT_EXIF: {
+    QOMX_EXIF_INFO *p_exif = (QOMX_EXIF_INFO *)data;
+    OMX_U32 cnt = p_exif->numOfEntries;
+    if (p_comp->exif_cnt + cnt > QOMX_SWENC_MAX_EXIF_ENTRIES) {
+      ALOGE("%s:%d] Too many exif entries %u", __func__, __LINE__,
+        p_comp->exif_cnt + cnt);
+      cnt = QOMX_SWENC_MAX_EXIF_ENTRIES - p_comp->exif_cnt;
+    }
+    /* the tag data stays owned by the client until the job completes */
+    memcpy(&p_comp->exif[p_comp->exif_cnt], p_exif->exif_data,
+      cnt * sizeof(QEXIF_INFO_DATA));
+    p_comp->exif_cnt += cnt;
+    break;
+  }
+  case QOMX_IMAGE_EXT_ENCODING_MODE:
+    p_comp->encoding_mode = *(QOMX_ENCODING_MODE *)data;
+    break;
+  case QOMX_IMAGE_EXT_JPEG_SPEED:
+    p_comp->speed_mode = ((QOMX_JPEG_SPEED *)data)->speedMode;
+    break;
+  case QOMX_IMAGE_EXT_ENCODING_THREADS: {
+    OMX_U32 num_threads = ((QOMX_ENCODING_THREADS *)data)->numThreads;
+    /* the workers are idle only while no job can be queued */
+    if (OMX_StateLoaded != p_comp->state) {
+      rc = OMX_ErrorIncorrectStateOperation;
+      break;
+    }
+    qomx_swenc_pool_deinit(&p_comp->pool);
+    if (qomx_swenc_pool_init(&p_comp->pool,
+      num_threads ? num_threads : qomx_swenc_get_num_threads())) {
+      ALOGE("%s:%d] Cannot start %u strip workers, encoding single threaded",
+        __func__, __LINE__, num_threads);
+    }
+    break;
+  }
+  case QOMX_IMAGE_EXT_MEM_OPS:
+    p_comp->mem_ops = *(QOMX_MEM_OPS *)data;
+    break;
+  case QOMX_IMAGE_EXT_WORK_BUFFER:
+  case QOMX_IMAGE_EXT_METADATA:
+  case QOMX_IMAGE_EXT_META_ENC_KEY:
+  case QOMX_IMAGE_EXT_MOBICAT:
+    /* hardware specific, the software path does not need them */
+    break;
+  default:
+    rc = OMX_ErrorUnsupportedIndex;
+    break;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+  return rc;
+}
+
+static OMX_ERRORTYPE qomx_swenc_get_extension_index(OMX_HANDLETYPE hComp,
+  OMX_STRING name, OMX_INDEXTYPE *p_index)
+{
+  uint32_t i;
+
+  (void)hComp;
+  if (!name || !p_index) {
+    return OMX_ErrorBadParameter;
+  }
+  for (i = 0; i < sizeof(g_ext_idx)/sizeof(g_ext_idx[0]); i++) {
+    if (!strcmp(name, g_ext_idx[i].name)) {
+      *p_index = (OMX_INDEXTYPE)g_ext_idx[i].index;
+      return OMX_ErrorNone;
+    }
+  }
+  return OMX_ErrorUnsupportedIndex;
+}
+
+static OMX_ERRORTYPE qomx_swenc_get_state(OMX_HANDLETYPE hComp,
+  OMX_STATETYPE *p_state)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+
+  if (!p_state) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  *p_state = p_comp->state;
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_swenc_tunnel_request(OMX_HANDLETYPE hComp,
+  OMX_U32 nPort, OMX_HANDLETYPE hTunneledComp, OMX_U32 nTunneledPort,
+  OMX_TUNNELSETUPTYPE *pTunnelSetup)
+{
+  (void)hComp;
+  (void)nPort;
+  (void)hTunneledComp;
+  (void)nTunneledPort;
+  (void)pTunnelSetup;
+  return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE qomx_swenc_use_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE **pp_buf, OMX_U32 port_idx, OMX_PTR p_app_priv,
+  OMX_U32 size, OMX_U8 *p_data)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  qomx_swenc_port_t *p_port;
+  OMX_BUFFERHEADERTYPE *p_hdr;
+  qomx_swenc_msg_t msg;
+
+  if (!pp_buf || !p_data) {
+    return OMX_ErrorBadParameter;
+  }
+  if (port_idx >= QOMX_SWENC_NUM_PORTS) {
+    return OMX_ErrorBadPortIndex;
+  }
+
+  p_hdr = calloc(1, sizeof(*p_hdr));
+  if (!p_hdr) {
+    return OMX_ErrorInsufficientResources;
+  }
+  p_hdr->nSize = sizeof(*p_hdr);
+  p_hdr->nVersion.nVersion = 0x00000101;
+  p_hdr->pBuffer = p_data;
+  p_hdr->nAllocLen = size;
+  p_hdr->pAppPrivate = p_app_priv;
+  if (QOMX_SWENC_PORT_OUT == port_idx) {
+    p_hdr->nOutputPortIndex = port_idx;
+  } else {
+    p_hdr->nInputPortIndex = port_idx;
+  }
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_port = &p_comp->port[port_idx];
+  if (p_port->buf_cnt >= QOMX_SWENC_MAX_BUFS) {
+    pthread_mutex_unlock(&p_comp->lock);
+    free(p_hdr);
+    return OMX_ErrorInsufficientResources;
+  }
+  p_port->p_bufs[p_port->buf_cnt++] = p_hdr;
+  pthread_mutex_unlock(&p_comp->lock);
+  *pp_buf = p_hdr;
+
+  /* the client may hold its own lock here, complete the transition
+   * from the component thread */
+  memset(&msg, 0x0, sizeof(msg));
+  msg.type = QOMX_SWENC_MSG_BUF_CHANGE;
+  return qomx_swenc_post_msg(p_comp, &msg);
+}
+
+static OMX_ERRORTYPE qomx_swenc_allocate_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE **pp_buf, OMX_U32 port_idx, OMX_PTR p_app_priv,
+  OMX_U32 size)
+{
+  (void)hComp;
+  (void)pp_buf;
+  (void)port_idx;
+  (void)p_app_priv;
+  (void)size;
+  return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE qomx_swenc_free_buffer(OMX_HANDLETYPE hComp,
+  OMX_U32 port_idx, OMX_BUFFERHEADERTYPE *p_buf)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  qomx_swenc_port_t *p_port;
+  qomx_swenc_msg_t msg;
+  uint32_t i;
+
+  if (port_idx >= QOMX_SWENC_NUM_PORTS) {
+    return OMX_ErrorBadPortIndex;
+  }
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_port = &p_comp->port[port_idx];
+  for (i = 0; i < p_port->buf_cnt; i++) {
+    if (p_port->p_bufs[i] == p_buf) {
+      break;
+    }
+  }
+  if (i == p_port->buf_cnt) {
+    pthread_mutex_unlock(&p_comp->lock);
+    return OMX_ErrorBadParameter;
+  }
+  p_port->p_bufs[i] = p_port->p_bufs[--p_port->buf_cnt];
+  if (p_port->p_pending == p_buf) {
+    p_port->p_pending = NULL;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+  free(p_buf);
+
+  memset(&msg, 0x0, sizeof(msg));
+  msg.type = QOMX_SWENC_MSG_BUF_CHANGE;
+  return qomx_swenc_post_msg(p_comp, &msg);
+}
+
+static OMX_ERRORTYPE qomx_swenc_empty_this_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  qomx_swenc_msg_t msg;
+
+  if (!p_buf || (QOMX_SWENC_PORT_OUT == p_buf->nInputPortIndex) ||
+    (p_buf->nInputPortIndex >= QOMX_SWENC_NUM_PORTS)) {
+    return OMX_ErrorBadParameter;
+  }
+  memset(&msg, 0x0, sizeof(msg));
+  msg.type = QOMX_SWENC_MSG_ETB;
+  msg.p_buf = p_buf;
+  return qomx_swenc_post_msg(p_comp, &msg);
+}
+
+static OMX_ERRORTYPE qomx_swenc_fill_this_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  qomx_swenc_msg_t msg;
+
+  if (!p_buf) {
+    return OMX_ErrorBadParameter;
+  }
+  memset(&msg, 0x0, sizeof(msg));
+  msg.type = QOMX_SWENC_MSG_FTB;
+  msg.p_buf = p_buf;
+  return qomx_swenc_post_msg(p_comp, &msg);
+}
+
+static OMX_ERRORTYPE qomx_swenc_set_callbacks(OMX_HANDLETYPE hComp,
+  OMX_CALLBACKTYPE *p_callbacks, OMX_PTR p_app_data)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+
+  if (!p_callbacks) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->callbacks = *p_callbacks;
+  p_comp->app_data = p_app_data;
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_swenc_deinit(OMX_HANDLETYPE hComp)
+{
+  qomx_swenc_comp_t *p_comp = QOMX_SWENC_GET_COMP(hComp);
+  uint32_t i, j;
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->thread_exit = OMX_TRUE;
+  pthread_cond_signal(&p_comp->cond);
+  pthread_mutex_unlock(&p_comp->lock);
+  pthread_join(p_comp->thread_id, NULL);
+
+  for (i = 0; i < QOMX_SWENC_NUM_PORTS; i++) {
+    for (j = 0; j < p_comp->port[i].buf_cnt; j++) {
+      free(p_comp->port[i].p_bufs[j]);
+    }
+  }
+  qomx_swenc_pool_deinit(&p_comp->pool);
+  qomx_swenc_work_free(&p_comp->work);
+  free(p_comp->p_thumb);
+  pthread_mutex_destroy(&p_comp->lock);
+  pthread_cond_destroy(&p_comp->cond);
+  free(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_swenc_use_egl_image(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE **pp_buf, OMX_U32 port_idx, OMX_PTR p_app_priv,
+  void *egl_image)
+{
+  (void)hComp;
+  (void)pp_buf;
+  (void)port_idx;
+  (void)p_app_priv;
+  (void)egl_image;
+  return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE qomx_swenc_role_enum(OMX_HANDLETYPE hComp,
+  OMX_U8 *cRole, OMX_U32 nIndex)
+{
+  (void)hComp;
+  if (!cRole) {
+    return OMX_ErrorBadParameter;
+  }
+  if (nIndex) {
+    return OMX_ErrorNoMore;
+  }
+  snprintf((char *)cRole, OMX_MAX_STRINGNAME_SIZE, "%s", "image_encoder.jpeg");
+  return OMX_ErrorNone;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_init_port
+* Parameters: p_port, idx, dir
+* Return Value : None
+* Description: Set the default port definition
+==============================================================================*/
+static void qomx_swenc_init_port(qomx_swenc_port_t *p_port, OMX_U32 idx,
+  OMX_DIRTYPE dir)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE *p_def = &p_port->def;
+
+  p_def->nSize = sizeof(*p_def);
+  p_def->nVersion.nVersion = 0x00000101;
+  p_def->nPortIndex = idx;
+  p_def->eDir = dir;
+  p_def->nBufferCountActual = 1;
+  p_def->nBufferCountMin = 1;
+  p_def->bEnabled = OMX_TRUE;
+  p_def->bPopulated = OMX_FALSE;
+  p_def->eDomain = OMX_PortDomainImage;
+  if (OMX_DirInput == dir) {
+    p_def->format.image.eCompressionFormat = OMX_IMAGE_CodingUnused;
+    p_def->format.image.eColorFormat =
+      (OMX_COLOR_FORMATTYPE)OMX_QCOM_IMG_COLOR_FormatYVU420SemiPlanar;
+  } else {
+    p_def->format.image.eCompressionFormat = OMX_IMAGE_CodingJPEG;
+    p_def->format.image.eColorFormat = OMX_COLOR_FormatUnused;
+  }
+}
+
+/*==============================================================================
+* Function : getInstance
+* Parameters: None
+* Return Value : component object, NULL on failure
+* Description: Called by qomx_core to create a new component instance
+==============================================================================*/
+void *getInstance(void)
+{
+  qomx_swenc_comp_t *p_comp = calloc(1, sizeof(qomx_swenc_comp_t));
+
+  if (!p_comp) {
+    ALOGE("%s:%d] Cannot allocate component", __func__, __LINE__);
+    return NULL;
+  }
+  p_comp->p_thumb = malloc(QOMX_SWENC_MAX_THUMB_SIZE);
+  if (!p_comp->p_thumb) {
+    ALOGE("%s:%d] Cannot allocate component buffers", __func__, __LINE__);
+    free(p_comp);
+    return NULL;
+  }
+
+  qomx_swenc_init_port(&p_comp->port[QOMX_SWENC_PORT_MAIN],
+    QOMX_SWENC_PORT_MAIN, OMX_DirInput);
+  qomx_swenc_init_port(&p_comp->port[QOMX_SWENC_PORT_OUT],
+    QOMX_SWENC_PORT_OUT, OMX_DirOutput);
+  qomx_swenc_init_port(&p_comp->port[QOMX_SWENC_PORT_THUMB],
+    QOMX_SWENC_PORT_THUMB, OMX_DirInput);
+  p_comp->state = OMX_StateLoaded;
+  p_comp->target_state = OMX_StateLoaded;
+  p_comp->quality = QOMX_SWENC_DEFAULT_QUALITY;
+  p_comp->speed_mode = QOMX_JPEG_SPEED_MODE_NORMAL;
+  p_comp->encoding_mode = OMX_Serial_Encoding;
+  pthread_mutex_init(&p_comp->lock, NULL);
+  pthread_cond_init(&p_comp->cond, NULL);
+  return p_comp;
+}
+
+/*==============================================================================
+* Function : create_component_fns
+* Parameters: aobj - object returned by getInstance
+* Return Value : OMX component handle, NULL on failure
+* Description: Map the OMX entry points and start the component thread
+==============================================================================*/
+void *create_component_fns(OMX_PTR aobj)
+{
+  qomx_swenc_comp_t *p_comp = (qomx_swenc_comp_t *)aobj;
+  OMX_COMPONENTTYPE *p_omx;
+
+  if (!p_comp) {
+    return NULL;
+  }
+  p_omx = &p_comp->omx;
+  p_omx->nSize = sizeof(OMX_COMPONENTTYPE);
+  p_omx->nVersion.nVersion = 0x00000101;
+  p_omx->pComponentPrivate = p_comp;
+  p_omx->GetComponentVersion = qomx_swenc_get_version;
+  p_omx->SendCommand = qomx_swenc_send_command;
+  p_omx->GetParameter = qomx_swenc_get_parameter;
+  p_omx->SetParameter = qomx_swenc_set_parameter;
+  p_omx->GetConfig = qomx_swenc_get_parameter;
+  p_omx->SetConfig = qomx_swenc_set_parameter;
+  p_omx->GetExtensionIndex = qomx_swenc_get_extension_index;
+  p_omx->GetState = qomx_swenc_get_state;
+  p_omx->ComponentTunnelRequest = qomx_swenc_tunnel_request;
+  p_omx->UseBuffer = qomx_swenc_use_buffer;
+  p_omx->AllocateBuffer = qomx_swenc_allocate_buffer;
+  p_omx->FreeBuffer = qomx_swenc_free_buffer;
+  p_omx->EmptyThisBuffer = qomx_swenc_empty_this_buffer;
+  p_omx->FillThisBuffer = qomx_swenc_fill_this_buffer;
+  p_omx->SetCallbacks = qomx_swenc_set_callbacks;
+  p_omx->ComponentDeInit = qomx_swenc_deinit;
+  p_omx->UseEGLImage = qomx_swenc_use_egl_image;
+  p_omx->ComponentRoleEnum = qomx_swenc_role_enum;
+
+  if (qomx_swenc_pool_init(&p_comp->pool, qomx_swenc_get_num_threads())) {
+    ALOGE("%s:%d] Cannot start strip workers, encoding single threaded",
+      __func__, __LINE__);
+  }
+  if (pthread_create(&p_comp->thread_id, NULL, qomx_swenc_thread, p_comp)) {
+    ALOGE("%s:%d] Cannot create component thread", __func__, __LINE__);
+    qomx_swenc_pool_deinit(&p_comp->pool);
+    pthread_mutex_destroy(&p_comp->lock);
+    pthread_cond_destroy(&p_comp->cond);
+    free(p_comp->p_thumb);
+    free(p_comp);
+    return NULL;
+  }
+  return p_omx;
+}
@@ -0,0 +1,292 @@
+/*Copyright (c) 2015, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef QOMX_SWENC_H
+#define QOMX_SWENC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "OMX_Component.h"
+#include "QOMX_JpegExtensions.h"
+
+#define QOMX_SWENC_COMP_NAME "OMX.qcom.image.jpeg.encoder.sw"
+
+#define QOMX_SWENC_PORT_MAIN 0
+#define QOMX_SWENC_PORT_OUT 1
+#define QOMX_SWENC_PORT_THUMB 2
+#define QOMX_SWENC_NUM_PORTS 3
+
+#define QOMX_SWENC_MAX_BUFS 64
+#define QOMX_SWENC_MSG_Q_SIZE 32
+#define QOMX_SWENC_MAX_EXIF_ENTRIES 128
+#define QOMX_SWENC_DEFAULT_QUALITY 85
+
+/* APP1 payload is limited by the 16 bit marker length */
+#define QOMX_SWENC_MAX_APP1_SIZE 65533
+/* APP1 marker and length in front of the payload */
+#define QOMX_SWENC_APP1_HDR_SIZE 4
+/* room left for the thumbnail once the IFDs are written */
+#define QOMX_SWENC_MAX_THUMB_SIZE (QOMX_SWENC_MAX_APP1_SIZE - 4096)
+/* number of times a thumbnail is re-encoded at lower quality before
+ * it is dropped from the EXIF */
+#define QOMX_SWENC_THUMB_RETRY 3
+#define QOMX_SWENC_THUMB_QUALITY_STEP 20
+
+/* strip encoding: the main image is split into horizontal bands that are
+ * encoded concurrently and joined with restart markers */
+#define QOMX_SWENC_MAX_THREADS 8
+#define QOMX_SWENC_DEFAULT_THREADS 4
+/* below this size the thread handoff costs more than it saves */
+#define QOMX_SWENC_STRIP_MIN_PIXELS (1920 * 1080)
+
+/** qomx_swenc_msg_type_t: Messages processed by the component
+*   thread
+**/
+typedef enum {
+  QOMX_SWENC_MSG_CMD,
+  QOMX_SWENC_MSG_ETB,
+  QOMX_SWENC_MSG_FTB,
+  QOMX_SWENC_MSG_BUF_CHANGE,
+} qomx_swenc_msg_type_t;
+
+/** qomx_swenc_msg_t: component thread message
+*    @type: message type
+*    @cmd: OMX command for QOMX_SWENC_MSG_CMD
+*    @param: command parameter
+*    @p_buf: buffer for ETB/FTB
+**/
+typedef struct {
+  qomx_swenc_msg_type_t type;
+  OMX_COMMANDTYPE cmd;
+  OMX_U32 param;
+  OMX_BUFFERHEADERTYPE *p_buf;
+} qomx_swenc_msg_t;
+
+/** qomx_swenc_port_t: port bookkeeping
+*    @def: port definition
+*    @p_bufs: buffer headers registered with UseBuffer
+*    @buf_cnt: number of registered buffers
+*    @p_pending: buffer handed over by the client and not yet
+*              returned
+**/
+typedef struct {
+  OMX_PARAM_PORTDEFINITIONTYPE def;
+  OMX_BUFFERHEADERTYPE *p_bufs[QOMX_SWENC_MAX_BUFS];
+  OMX_U32 buf_cnt;
+  OMX_BUFFERHEADERTYPE *p_pending;
+} qomx_swenc_port_t;
+
+/** qomx_swenc_image_t: description of one image to encode
+*    @p_y: luma plane
+*    @p_cbcr: interleaved chroma plane
+*    @width: source width
+*    @height: source height
+*    @stride: luma stride in bytes
+*    @scanline: luma scanlines
+*    @color_fmt: source color format
+*    @crop: source crop window
+*    @out_width: output width before rotation
+*    @out_height: output height before rotation
+*    @rotation: clockwise rotation in degrees
+*    @quality: JPEG quality
+**/
+typedef struct {
+  OMX_U8 *p_y;
+  OMX_U8 *p_cbcr;
+  OMX_U32 width;
+  OMX_U32 height;
+  OMX_U32 stride;
+  OMX_U32 scanline;
+  int color_fmt;
+  OMX_CONFIG_RECTTYPE crop;
+  OMX_U32 out_width;
+  OMX_U32 out_height;
+  OMX_U32 rotation;
+  OMX_U32 quality;
+} qomx_swenc_image_t;
+
+/** qomx_swenc_strip_t: scratch memory of one band
+*    @p_rows: raw data rows handed to the encoder
+*    @rows_size: size of @p_rows
+*    @p_buf: bitstream of the band, unused for the first band which
+*          is written straight into the output buffer
+*    @buf_size: size of @p_buf
+*    @filled: number of bytes written by the last encode
+*    @rc: result of the last encode
+**/
+typedef struct {
+  OMX_U8 *p_rows;
+  size_t rows_size;
+  OMX_U8 *p_buf;
+  size_t buf_size;
+  size_t filled;
+  OMX_ERRORTYPE rc;
+} qomx_swenc_strip_t;
+
+/** qomx_swenc_work_t: scratch memory reused across jobs
+*    @p_map: source coordinate lookup tables
+*    @map_size: size of @p_map in entries
+*    @p_strips: per band scratch memory
+*    @strip_cnt: number of entries in @p_strips
+**/
+typedef struct {
+  OMX_U32 *p_map;
+  size_t map_size;
+  qomx_swenc_strip_t *p_strips;
+  OMX_U32 strip_cnt;
+} qomx_swenc_work_t;
+
+typedef void (*qomx_swenc_task_fn)(void *p_arg, OMX_U32 idx);
+
+/** qomx_swenc_pool_t: worker threads encoding the bands
+*    @threads: worker threads
+*    @num_threads: number of worker threads, the caller of
+*                qomx_swenc_pool_run works as well
+*    @lock: protects the task state
+*    @cond: signalled when tasks are posted or on exit
+*    @done_cond: signalled when the last task completes
+*    @fn: task function
+*    @p_arg: task argument
+*    @task_cnt: number of tasks of the current run
+*    @next_task: next task to pick
+*    @done_cnt: number of completed tasks
+*    @exit: set to stop the workers
+**/
+typedef struct {
+  pthread_t threads[QOMX_SWENC_MAX_THREADS];
+  OMX_U32 num_threads;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_cond_t done_cond;
+  qomx_swenc_task_fn fn;
+  void *p_arg;
+  OMX_U32 task_cnt;
+  OMX_U32 next_task;
+  OMX_U32 done_cnt;
+  OMX_BOOL exit;
+} qomx_swenc_pool_t;
+
+/** qomx_swenc_comp_t: software jpeg encoder component
+*    @omx: OMX component handle given to the client
+*    @callbacks: client callbacks
+*    @app_data: client data passed back with the callbacks
+*    @state: current OMX state
+*    @target_state: state of an ongoing transition
+*    @port: port bookkeeping
+*    @lock: protects the component state and message queue
+*    @cond: signalled when a message is posted
+*    @thread_id: component thread
+*    @msg_q: message ring
+*    @msg_head: index of the oldest message
+*    @msg_cnt: number of queued messages
+*    @thread_exit: set to stop the component thread
+*    @main_offset: main image plane offsets
+*    @in_crop: main image crop
+*    @out_crop: main image output size
+*    @rotation: main image rotation
+*    @quality: main image quality
+*    @thumb_info: thumbnail configuration
+*    @qtable: client quantization tables
+*    @qtable_set: flags for the valid quantization tables
+*    @encoding_mode: parallel splits the main image into bands
+*    @speed_mode: speed hint, maps to the DCT method
+*    @mem_ops: client memory ops
+*    @exif: exif tags for the next job
+*    @exif_cnt: number of exif tags
+*    @p_thumb: thumbnail bitstream
+*    @thumb_size: size of the thumbnail bitstream
+*    @work: scratch memory
+*    @pool: strip encoding workers
+**/
+typedef struct {
+  OMX_COMPONENTTYPE omx;
+  OMX_CALLBACKTYPE callbacks;
+  OMX_PTR app_data;
+  OMX_STATETYPE state;
+  OMX_STATETYPE target_state;
+  qomx_swenc_port_t port[QOMX_SWENC_NUM_PORTS];
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_t thread_id;
+  qomx_swenc_msg_t msg_q[QOMX_SWENC_MSG_Q_SIZE];
+  uint32_t msg_head;
+  uint32_t msg_cnt;
+  OMX_BOOL thread_exit;
+
+  QOMX_YUV_FRAME_INFO main_offset;
+  OMX_CONFIG_RECTTYPE in_crop;
+  OMX_CONFIG_RECTTYPE out_crop;
+  OMX_U32 rotation;
+  OMX_U32 quality;
+  QOMX_THUMBNAIL_INFO thumb_info;
+  OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE qtable[2];
+  OMX_BOOL qtable_set[2];
+  QOMX_ENCODING_MODE encoding_mode;
+  QOMX_JPEG_SPEED_MODE speed_mode;
+  QOMX_MEM_OPS mem_ops;
+  QEXIF_INFO_DATA exif[QOMX_SWENC_MAX_EXIF_ENTRIES];
+  OMX_U32 exif_cnt;
+
+  OMX_U8 *p_thumb;
+  size_t thumb_size;
+  qomx_swenc_work_t work;
+  qomx_swenc_pool_t pool;
+} qomx_swenc_comp_t;
+
+OMX_ERRORTYPE qomx_swenc_encode(qomx_swenc_image_t *p_img,
+  QOMX_JPEG_SPEED_MODE speed_mode,
+  OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE *p_qtable,
+  OMX_BOOL *p_qtable_set,
+  OMX_BOOL write_jfif,
+  qomx_swenc_work_t *p_work, qomx_swenc_pool_t *p_pool,
+  OMX_U8 *p_out, size_t out_size, size_t *p_filled);
+
+void qomx_swenc_work_free(qomx_swenc_work_t *p_work);
+
+OMX_BOOL qomx_swenc_is_fmt_supported(int color_fmt);
+
+OMX_ERRORTYPE qomx_swenc_exif_build(QEXIF_INFO_DATA *p_exif,
+  OMX_U32 exif_cnt,
+  OMX_U8 *p_thumb, size_t thumb_size,
+  OMX_U8 *p_out, size_t out_size, size_t *p_filled);
+
+OMX_ERRORTYPE qomx_swenc_exif_write_header(QEXIF_INFO_DATA *p_exif,
+  OMX_U32 exif_cnt,
+  OMX_U8 *p_thumb, size_t thumb_size,
+  OMX_U8 *p_out, size_t app1_size);
+
+int qomx_swenc_pool_init(qomx_swenc_pool_t *p_pool, OMX_U32 num_threads);
+
+void qomx_swenc_pool_run(qomx_swenc_pool_t *p_pool, qomx_swenc_task_fn fn,
+  void *p_arg, OMX_U32 task_cnt);
+
+void qomx_swenc_pool_deinit(qomx_swenc_pool_t *p_pool);
+
+#endif
@@ -0,0 +1,446 @@
+/*Copyright (c) 2015, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#define LOG_NDEBUG 0
+#define LOG_NIDEBUG 0
+#define LOG_TAG "qomx_jpegenc_sw"
+#include <utils/Log.h>
+
+#include "qomx_swenc.h"
+
+#define QOMX_SWENC_EXIF_HDR_SIZE 6
+#define QOMX_SWENC_TIFF_HDR_SIZE 8
+#define QOMX_SWENC_IFD_ENTRY_SIZE 12
+#define QOMX_SWENC_IFD_MAX_FIELDS (QOMX_SWENC_MAX_EXIF_ENTRIES + 3)
+
+#define QOMX_SWENC_TAG_EXIF_IFD_PTR 0x8769
+#define QOMX_SWENC_TAG_GPS_IFD_PTR 0x8825
+#define QOMX_SWENC_TAG_COMPRESSION 0x0103
+#define QOMX_SWENC_TAG_JPEG_IF 0x0201
+#define QOMX_SWENC_TAG_JPEG_IF_LEN 0x0202
+#define QOMX_SWENC_COMPRESSION_JPEG 6
+
+/** qomx_swenc_ifd_idx_t: IFDs written into the APP1 segment
+**/
+typedef enum {
+  QOMX_SWENC_IFD0,
+  QOMX_SWENC_IFD_EXIF,
+  QOMX_SWENC_IFD_GPS,
+  QOMX_SWENC_IFD1,
+  QOMX_SWENC_IFD_MAX,
+  QOMX_SWENC_IFD_NONE = QOMX_SWENC_IFD_MAX,
+} qomx_swenc_ifd_idx_t;
+
+/** qomx_swenc_field_t: one IFD entry
+*    @tag: 16 bit tag number
+*    @type: exif data type
+*    @count: number of values
+*    @p_data: values in host byte order
+**/
+typedef struct {
+  uint16_t tag;
+  uint16_t type;
+  uint32_t count;
+  const void *p_data;
+} qomx_swenc_field_t;
+
+/** qomx_swenc_ifd_t: IFD under construction, kept sorted by tag
+*    @field: entries
+*    @cnt: number of entries
+**/
+typedef struct {
+  qomx_swenc_field_t field[QOMX_SWENC_IFD_MAX_FIELDS];
+  uint32_t cnt;
+} qomx_swenc_ifd_t;
+
+static uint32_t qomx_swenc_type_size(uint16_t type)
+{
+  switch (type) {
+  case EXIF_SHORT:
+    return 2;
+  case EXIF_LONG:
+  case EXIF_SLONG:
+    return 4;
+  case EXIF_RATIONAL:
+  case EXIF_SRATIONAL:
+    return 8;
+  default:
+    return 1;
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_exif_ifd
+* Parameters: tag_id
+* Return Value : IFD the tag belongs to, QOMX_SWENC_IFD_NONE if the tag
+* is generated by the encoder or not supported
+* Description: Map the qexif tag offset onto its IFD
+==============================================================================*/
+static qomx_swenc_ifd_idx_t qomx_swenc_exif_ifd(exif_tag_id_t tag_id)
+{
+  uint32_t offset = tag_id >> 16;
+
+  if (offset <= GPS_DIFFERENTIAL) {
+    return QOMX_SWENC_IFD_GPS;
+  }
+  if ((offset == JPEG_INTERCHANGE_FORMAT) ||
+    (offset == JPEG_INTERCHANGE_FORMAT_LENGTH) ||
+    (offset == TN_JPEGINTERCHANGE_FORMAT) ||
+    (offset == TN_JPEGINTERCHANGE_FORMAT_L) ||
+    (offset == EXIF_IFD) || (offset == GPS_IFD) ||
+    (offset == ICC_PROFILE) || (offset == INTEROP) ||
+    (offset >= EXIF_TAG_MAX_OFFSET)) {
+    return QOMX_SWENC_IFD_NONE;
+  }
+  if (offset < EXIF_IFD) {
+    return QOMX_SWENC_IFD0;
+  }
+  if ((offset >= TN_IMAGE_WIDTH) && (offset <= TN_COPYRIGHT)) {
+    return QOMX_SWENC_IFD1;
+  }
+  return QOMX_SWENC_IFD_EXIF;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_exif_data
+* Parameters: p_entry
+* Return Value : pointer to the tag values
+* Description: Single values are stored inline in the tag entry, arrays
+* and strings are referenced
+==============================================================================*/
+static const void *qomx_swenc_exif_data(exif_tag_entry_t *p_entry)
+{
+  switch (p_entry->type) {
+  case EXIF_ASCII:
+    return p_entry->data._ascii;
+  case EXIF_UNDEFINED:
+    return p_entry->data._undefined;
+  case EXIF_BYTE:
+    return (p_entry->count > 1) ? (void *)p_entry->data._bytes :
+      (void *)&p_entry->data._byte;
+  case EXIF_SHORT:
+    return (p_entry->count > 1) ? (void *)p_entry->data._shorts :
+      (void *)&p_entry->data._short;
+  case EXIF_LONG:
+    return (p_entry->count > 1) ? (void *)p_entry->data._longs :
+      (void *)&p_entry->data._long;
+  case EXIF_RATIONAL:
+    return (p_entry->count > 1) ? (void *)p_entry->data._rats :
+      (void *)&p_entry->data._rat;
+  case EXIF_SLONG:
+    return (p_entry->count > 1) ? (void *)p_entry->data._slongs :
+      (void *)&p_entry->data._slong;
+  case EXIF_SRATIONAL:
+    return (p_entry->count > 1) ? (void *)p_entry->data._srats :
+      (void *)&p_entry->data._srat;
+  default:
+    return NULL;
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_ifd_add
+* Parameters: p_ifd, tag, type, count, p_data
+* Return Value : None
+* Description: Insert a field keeping the IFD sorted. A repeated tag
+* replaces the earlier value, so metadata derived tags can override the
+* ones set by the HAL.
+==============================================================================*/
+static void qomx_swenc_ifd_add(qomx_swenc_ifd_t *p_ifd, uint16_t tag,
+  uint16_t type, uint32_t count, const void *p_data)
+{
+  uint32_t i = p_ifd->cnt;
+
+  while ((i > 0) && (p_ifd->field[i - 1].tag > tag)) {
+    i--;
+  }
+  if ((i > 0) && (p_ifd->field[i - 1].tag == tag)) {
+    i--;
+  } else {
+    if (p_ifd->cnt >= QOMX_SWENC_IFD_MAX_FIELDS) {
+      ALOGE("%s:%d] IFD full, dropping tag 0x%x", __func__, __LINE__, tag);
+      return;
+    }
+    memmove(&p_ifd->field[i + 1], &p_ifd->field[i],
+      (p_ifd->cnt - i) * sizeof(p_ifd->field[0]));
+    p_ifd->cnt++;
+  }
+  p_ifd->field[i].tag = tag;
+  p_ifd->field[i].type = type;
+  p_ifd->field[i].count = count;
+  p_ifd->field[i].p_data = p_data;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_ifd_size
+* Parameters: p_ifd
+* Return Value : bytes taken by the IFD and its out of line values
+* Description: Compute the IFD size
+==============================================================================*/
+static uint32_t qomx_swenc_ifd_size(qomx_swenc_ifd_t *p_ifd)
+{
+  uint32_t i, size, len;
+
+  size = 2 + p_ifd->cnt * QOMX_SWENC_IFD_ENTRY_SIZE + 4;
+  for (i = 0; i < p_ifd->cnt; i++) {
+    len = p_ifd->field[i].count * qomx_swenc_type_size(p_ifd->field[i].type);
+    if (len > 4) {
+      size += (len + 1) & ~1U;
+    }
+  }
+  return size;
+}
+
+static OMX_U8 *qomx_swenc_put16(OMX_U8 *p, uint16_t val)
+{
+  p[0] = (OMX_U8)(val & 0xFF);
+  p[1] = (OMX_U8)(val >> 8);
+  return p + 2;
+}
+
+static OMX_U8 *qomx_swenc_put32(OMX_U8 *p, uint32_t val)
+{
+  p[0] = (OMX_U8)(val & 0xFF);
+  p[1] = (OMX_U8)((val >> 8) & 0xFF);
+  p[2] = (OMX_U8)((val >> 16) & 0xFF);
+  p[3] = (OMX_U8)(val >> 24);
+  return p + 4;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_put_values
+* Parameters: p, p_field
+* Return Value : None
+* Description: Serialize the field values in little endian order
+==============================================================================*/
+static void qomx_swenc_put_values(OMX_U8 *p, qomx_swenc_field_t *p_field)
+{
+  uint32_t i;
+
+  switch (qomx_swenc_type_size(p_field->type)) {
+  case 2: {
+    const uint16_t *p_val = (const uint16_t *)p_field->p_data;
+    for (i = 0; i < p_field->count; i++) {
+      p = qomx_swenc_put16(p, p_val[i]);
+    }
+    break;
+  }
+  case 4:
+  case 8: {
+    /* rationals are pairs of 32 bit words */
+    const uint32_t *p_val = (const uint32_t *)p_field->p_data;
+    uint32_t words = p_field->count *
+      (qomx_swenc_type_size(p_field->type) / 4);
+    for (i = 0; i < words; i++) {
+      p = qomx_swenc_put32(p, p_val[i]);
+    }
+    break;
+  }
+  default:
+    memcpy(p, p_field->p_data, p_field->count);
+    break;
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_ifd_write
+* Parameters: p_tiff, ifd_off, p_ifd, next_off
+* Return Value : None
+* Description: Write the IFD at @ifd_off followed by its out of line
+* values. Offsets are relative to the TIFF header.
+==============================================================================*/
+static void qomx_swenc_ifd_write(OMX_U8 *p_tiff, uint32_t ifd_off,
+  qomx_swenc_ifd_t *p_ifd, uint32_t next_off)
+{
+  uint32_t i, len;
+  uint32_t data_off = ifd_off + 2 + p_ifd->cnt * QOMX_SWENC_IFD_ENTRY_SIZE + 4;
+  OMX_U8 *p = p_tiff + ifd_off;
+
+  p = qomx_swenc_put16(p, (uint16_t)p_ifd->cnt);
+  for (i = 0; i < p_ifd->cnt; i++) {
+    qomx_swenc_field_t *p_field = &p_ifd->field[i];
+
+    p = qomx_swenc_put16(p, p_field->tag);
+    p = qomx_swenc_put16(p, p_field->type);
+    p = qomx_swenc_put32(p, p_field->count);
+    len = p_field->count * qomx_swenc_type_size(p_field->type);
+    if (len <= 4) {
+      memset(p, 0x0, 4);
+      qomx_swenc_put_values(p, p_field);
+    } else {
+      qomx_swenc_put32(p, data_off);
+      qomx_swenc_put_values(p_tiff + data_off, p_field);
+      if (len & 1) {
+        p_tiff[data_off + len] = 0;
+      }
+      data_off += (len + 1) & ~1U;
+    }
+    p += 4;
+  }
+  qomx_swenc_put32(p, next_off);
+}
+
+/*==============================================================================
+* Function : qomx_swenc_exif_build
+* Parameters: p_exif, exif_cnt, p_thumb, thumb_size, p_out, out_size,
+*             p_filled
+* Return Value : OMX_ERRORTYPE
+* Description: Serialize the exif tags and the optional thumbnail into
+* an APP1 payload (without the marker and length). All IFD offsets are
+* computed up front so the payload is written in a single pass. With a
+* NULL @p_out only the payload size is returned, so the caller can reserve
+* room for the segment before the bitstream is produced.
+==============================================================================*/
+OMX_ERRORTYPE qomx_swenc_exif_build(QEXIF_INFO_DATA *p_exif,
+  OMX_U32 exif_cnt,
+  OMX_U8 *p_thumb, size_t thumb_size,
+  OMX_U8 *p_out, size_t out_size, size_t *p_filled)
+{
+  qomx_swenc_ifd_t ifd[QOMX_SWENC_IFD_MAX];
+  uint32_t i, idx;
+  uint32_t exif_off = 0, gps_off = 0, ifd1_off = 0, thumb_off = 0;
+  uint32_t thumb_len = (uint32_t)thumb_size;
+  uint16_t compression = QOMX_SWENC_COMPRESSION_JPEG;
+  uint32_t end_off;
+  OMX_U8 *p_tiff;
+  const void *p_data;
+
+  memset(ifd, 0x0, sizeof(ifd));
+
+  for (i = 0; i < exif_cnt; i++) {
+    exif_tag_entry_t *p_entry = &p_exif[i].tag_entry;
+
+    idx = qomx_swenc_exif_ifd(p_exif[i].tag_id);
+    if ((QOMX_SWENC_IFD_NONE == idx) ||
+      ((QOMX_SWENC_IFD1 == idx) && !p_thumb)) {
+      continue;
+    }
+    p_data = qomx_swenc_exif_data(p_entry);
+    if (!p_data || !p_entry->count) {
+      continue;
+    }
+    qomx_swenc_ifd_add(&ifd[idx], (uint16_t)(p_exif[i].tag_id & 0xFFFF),
+      (uint16_t)p_entry->type, p_entry->count, p_data);
+  }
+
+  if (ifd[QOMX_SWENC_IFD_EXIF].cnt) {
+    qomx_swenc_ifd_add(&ifd[QOMX_SWENC_IFD0], QOMX_SWENC_TAG_EXIF_IFD_PTR,
+      EXIF_LONG, 1, &exif_off);
+  }
+  if (ifd[QOMX_SWENC_IFD_GPS].cnt) {
+    qomx_swenc_ifd_add(&ifd[QOMX_SWENC_IFD0], QOMX_SWENC_TAG_GPS_IFD_PTR,
+      EXIF_LONG, 1, &gps_off);
+  }
+  if (p_thumb) {
+    qomx_swenc_ifd_add(&ifd[QOMX_SWENC_IFD1], QOMX_SWENC_TAG_COMPRESSION,
+      EXIF_SHORT, 1, &compression);
+    qomx_swenc_ifd_add(&ifd[QOMX_SWENC_IFD1], QOMX_SWENC_TAG_JPEG_IF,
+      EXIF_LONG, 1, &thumb_off);
+    qomx_swenc_ifd_add(&ifd[QOMX_SWENC_IFD1], QOMX_SWENC_TAG_JPEG_IF_LEN,
+      EXIF_LONG, 1, &thumb_len);
+  }
+
+  exif_off = QOMX_SWENC_TIFF_HDR_SIZE + qomx_swenc_ifd_size(&ifd[QOMX_SWENC_IFD0]);
+  gps_off = exif_off;
+  if (ifd[QOMX_SWENC_IFD_EXIF].cnt) {
+    gps_off += qomx_swenc_ifd_size(&ifd[QOMX_SWENC_IFD_EXIF]);
+  }
+  ifd1_off = gps_off;
+  if (ifd[QOMX_SWENC_IFD_GPS].cnt) {
+    ifd1_off += qomx_swenc_ifd_size(&ifd[QOMX_SWENC_IFD_GPS]);
+  }
+  end_off = ifd1_off;
+  if (p_thumb) {
+    thumb_off = ifd1_off + qomx_swenc_ifd_size(&ifd[QOMX_SWENC_IFD1]);
+    end_off = thumb_off + thumb_len;
+  }
+
+  if (QOMX_SWENC_EXIF_HDR_SIZE + (size_t)end_off > out_size) {
+    ALOGE("%s:%d] APP1 too large %u", __func__, __LINE__,
+      QOMX_SWENC_EXIF_HDR_SIZE + end_off);
+    return OMX_ErrorOverflow;
+  }
+  *p_filled = QOMX_SWENC_EXIF_HDR_SIZE + end_off;
+  if (NULL == p_out) {
+    return OMX_ErrorNone;
+  }
+
+  memcpy(p_out, "Exif\0\0", QOMX_SWENC_EXIF_HDR_SIZE);
+  p_tiff = p_out + QOMX_SWENC_EXIF_HDR_SIZE;
+  p_tiff[0] = 'I';
+  p_tiff[1] = 'I';
+  qomx_swenc_put16(p_tiff + 2, 0x002A);
+  qomx_swenc_put32(p_tiff + 4, QOMX_SWENC_TIFF_HDR_SIZE);
+
+  qomx_swenc_ifd_write(p_tiff, QOMX_SWENC_TIFF_HDR_SIZE,
+    &ifd[QOMX_SWENC_IFD0], p_thumb ? ifd1_off : 0);
+  if (ifd[QOMX_SWENC_IFD_EXIF].cnt) {
+    qomx_swenc_ifd_write(p_tiff, exif_off, &ifd[QOMX_SWENC_IFD_EXIF], 0);
+  }
+  if (ifd[QOMX_SWENC_IFD_GPS].cnt) {
+    qomx_swenc_ifd_write(p_tiff, gps_off, &ifd[QOMX_SWENC_IFD_GPS], 0);
+  }
+  if (p_thumb) {
+    qomx_swenc_ifd_write(p_tiff, ifd1_off, &ifd[QOMX_SWENC_IFD1], 0);
+    memcpy(p_tiff + thumb_off, p_thumb, thumb_len);
+  }
+  return OMX_ErrorNone;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_exif_write_header
+* Parameters: p_exif, exif_cnt, p_thumb, thumb_size, p_out, app1_size
+* Return Value : OMX_ERRORTYPE
+* Description: Write SOI and the APP1 segment straight into the output
+* buffer. @app1_size is the payload size measured by qomx_swenc_exif_build
+* before the main image was encoded behind the segment; the SOI of that
+* bitstream falls inside the segment and is overwritten.
+==============================================================================*/
+OMX_ERRORTYPE qomx_swenc_exif_write_header(QEXIF_INFO_DATA *p_exif,
+  OMX_U32 exif_cnt,
+  OMX_U8 *p_thumb, size_t thumb_size,
+  OMX_U8 *p_out, size_t app1_size)
+{
+  OMX_ERRORTYPE rc;
+  size_t filled = 0;
+  uint16_t len = (uint16_t)(app1_size + 2);
+
+  rc = qomx_swenc_exif_build(p_exif, exif_cnt, p_thumb, thumb_size,
+    p_out + 2 + QOMX_SWENC_APP1_HDR_SIZE, app1_size, &filled);
+  if ((OMX_ErrorNone != rc) || (filled != app1_size)) {
+    ALOGE("%s:%d] Cannot write APP1, size %zu expected %zu", __func__, __LINE__,
+      filled, app1_size);
+    return OMX_ErrorUndefined;
+  }
+  p_out[0] = 0xFF;
+  p_out[1] = 0xD8;
+  p_out[2] = 0xFF;
+  p_out[3] = 0xE1;
+  p_out[4] = (OMX_U8)(len >> 8);
+  p_out[5] = (OMX_U8)(len & 0xFF);
+  return OMX_ErrorNone;
+}
@@ -0,0 +1,724 @@
+/*Copyright (c) 2015, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#define LOG_NDEBUG 0
+#define LOG_NIDEBUG 0
+#define LOG_TAG "qomx_jpegenc_sw"
+#include <utils/Log.h>
+#include <setjmp.h>
+
+#include "qomx_swenc.h"
+#include <jpeglib.h>
+#include <jerror.h>
+
+#define QOMX_SWENC_ALIGN(x, a) (((x) + (a) - 1) & ~((a) - 1))
+#define QOMX_SWENC_MAX_ROWS (2 * DCTSIZE)
+
+/* markers parsed when joining bands, jpeglib.h only defines a few */
+#define QOMX_SWENC_M_SOF0 0xC0
+#define QOMX_SWENC_M_SOF1 0xC1
+#define QOMX_SWENC_M_SOI 0xD8
+#define QOMX_SWENC_M_SOS 0xDA
+
+/** qomx_swenc_fmt_t: layout of a supported source format
+*    @color_fmt: OMX color format
+*    @h_sub: horizontal chroma subsampling, 0 for monochrome
+*    @v_sub: vertical chroma subsampling, 0 for monochrome
+*    @cr_first: chroma is stored CrCb
+**/
+typedef struct {
+  int color_fmt;
+  uint8_t h_sub;
+  uint8_t v_sub;
+  uint8_t cr_first;
+} qomx_swenc_fmt_t;
+
+static const qomx_swenc_fmt_t g_fmt_tbl[] = {
+  { OMX_COLOR_FormatYUV420SemiPlanar, 2, 2, 0 },
+  { OMX_QCOM_IMG_COLOR_FormatYVU420SemiPlanar, 2, 2, 1 },
+  { OMX_COLOR_FormatYUV422SemiPlanar, 2, 1, 0 },
+  { OMX_QCOM_IMG_COLOR_FormatYVU422SemiPlanar, 2, 1, 1 },
+  { OMX_QCOM_IMG_COLOR_FormatYUV422SemiPlanar_h1v2, 1, 2, 0 },
+  { OMX_QCOM_IMG_COLOR_FormatYVU422SemiPlanar_h1v2, 1, 2, 1 },
+  { OMX_QCOM_IMG_COLOR_FormatYUV444SemiPlanar, 1, 1, 0 },
+  { OMX_QCOM_IMG_COLOR_FormatYVU444SemiPlanar, 1, 1, 1 },
+  { OMX_COLOR_FormatMonochrome, 0, 0, 0 },
+};
+
+/** qomx_swenc_err_t: libjpeg error manager
+*    @pub: libjpeg fields
+*    @jmp: context to return to on a fatal error
+**/
+typedef struct {
+  struct jpeg_error_mgr pub;
+  jmp_buf jmp;
+} qomx_swenc_err_t;
+
+/** qomx_swenc_dest_t: libjpeg destination writing into the
+*   client output buffer or into a growing band buffer
+*    @pub: libjpeg fields
+*    @p_buf: output buffer
+*    @size: size of the output buffer
+*    @p_strip: band owning the buffer, NULL for client buffers
+*    @overflow: set when the bitstream did not fit
+*    @no_mem: set when a band buffer could not grow
+**/
+typedef struct {
+  struct jpeg_destination_mgr pub;
+  OMX_U8 *p_buf;
+  size_t size;
+  qomx_swenc_strip_t *p_strip;
+  OMX_BOOL overflow;
+  OMX_BOOL no_mem;
+} qomx_swenc_dest_t;
+
+/** qomx_swenc_map_t: precomputed source lookup for one encode
+*    @p_col: source coordinate for each encoded column
+*    @p_row: source coordinate for each encoded row
+*    @transposed: @p_col holds source rows and @p_row source
+*               columns (90/270 degree rotation)
+*    @direct: rows can be copied straight from the source
+**/
+typedef struct {
+  OMX_U32 *p_col;
+  OMX_U32 *p_row;
+  OMX_BOOL transposed;
+  OMX_BOOL direct;
+} qomx_swenc_map_t;
+
+/** qomx_swenc_job_t: state shared by the bands of one encode
+*    @p_img: image to encode
+*    @p_fmt: source layout
+*    @map: source lookup tables
+*    @enc_w: encoded width
+*    @enc_h: encoded height
+*    @pad_w: encoded width aligned to the MCU size
+*    @speed_mode: speed hint
+*    @p_qtable: client quantization tables
+*    @p_qtable_set: flags for the valid quantization tables
+*    @write_jfif: write the JFIF header, cleared when the caller
+*                 places an APP1 segment in front of the bitstream
+*    @band_h: rows per band, a multiple of the MCU height
+*    @restart_interval: MCUs per band, 0 for a single band
+*    @p_strips: per band scratch memory
+*    @p_out: output buffer
+*    @out_size: size of @p_out
+**/
+typedef struct {
+  qomx_swenc_image_t *p_img;
+  const qomx_swenc_fmt_t *p_fmt;
+  qomx_swenc_map_t map;
+  OMX_U32 enc_w;
+  OMX_U32 enc_h;
+  OMX_U32 pad_w;
+  QOMX_JPEG_SPEED_MODE speed_mode;
+  OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE *p_qtable;
+  OMX_BOOL *p_qtable_set;
+  OMX_BOOL write_jfif;
+  OMX_U32 band_h;
+  OMX_U32 restart_interval;
+  qomx_swenc_strip_t *p_strips;
+  OMX_U8 *p_out;
+  size_t out_size;
+} qomx_swenc_job_t;
+
+/*==============================================================================
+* Function : qomx_swenc_get_fmt
+* Parameters: color_fmt
+* Return Value : format descriptor, NULL if unsupported
+* Description: Look up the layout of the source color format
+==============================================================================*/
+static const qomx_swenc_fmt_t *qomx_swenc_get_fmt(int color_fmt)
+{
+  uint32_t i;
+
+  for (i = 0; i < sizeof(g_fmt_tbl)/sizeof(g_fmt_tbl[0]); i++) {
+    if (g_fmt_tbl[i].color_fmt == color_fmt) {
+      return &g_fmt_tbl[i];
+    }
+  }
+  return NULL;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_is_fmt_supported
+* Parameters: color_fmt
+* Return Value : OMX_TRUE if the format can be encoded
+* Description: Check if the source color format is supported
+==============================================================================*/
+OMX_BOOL qomx_swenc_is_fmt_supported(int color_fmt)
+{
+  return (NULL != qomx_swenc_get_fmt(color_fmt)) ? OMX_TRUE : OMX_FALSE;
+}
+
+static void qomx_swenc_error_exit(j_common_ptr cinfo)
+{
+  qomx_swenc_err_t *p_err = (qomx_swenc_err_t *)cinfo->err;
+  char msg[JMSG_LENGTH_MAX];
+
+  (*cinfo->err->format_message)(cinfo, msg);
+  ALOGE("%s:%d] libjpeg error: %s", __func__, __LINE__, msg);
+  longjmp(p_err->jmp, 1);
+}
+
+static void qomx_swenc_init_dest(j_compress_ptr cinfo)
+{
+  qomx_swenc_dest_t *p_dest = (qomx_swenc_dest_t *)cinfo->dest;
+
+  p_dest->pub.next_output_byte = p_dest->p_buf;
+  p_dest->pub.free_in_buffer = p_dest->size;
+  p_dest->overflow = OMX_FALSE;
+}
+
+static boolean qomx_swenc_empty_dest(j_compress_ptr cinfo)
+{
+  qomx_swenc_dest_t *p_dest = (qomx_swenc_dest_t *)cinfo->dest;
+  qomx_swenc_strip_t *p_strip = p_dest->p_strip;
+  OMX_U8 *p_buf;
+
+  if (!p_strip) {
+    /* client buffers cannot grow, abort the encode */
+    p_dest->overflow = OMX_TRUE;
+    ERREXIT(cinfo, JERR_BUFFER_SIZE);
+    return FALSE;
+  }
+
+  /* band buffers double, libjpeg only calls this once the buffer is
+   * full so the whole old content is kept */
+  p_buf = realloc(p_strip->p_buf, p_strip->buf_size * 2);
+  if (!p_buf) {
+    p_dest->no_mem = OMX_TRUE;
+    ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 0);
+    return FALSE;
+  }
+  p_dest->pub.next_output_byte = p_buf + p_strip->buf_size;
+  p_dest->pub.free_in_buffer = p_strip->buf_size;
+  p_strip->p_buf = p_buf;
+  p_strip->buf_size *= 2;
+  p_dest->p_buf = p_buf;
+  p_dest->size = p_strip->buf_size;
+  return TRUE;
+}
+
+static void qomx_swenc_term_dest(j_compress_ptr cinfo)
+{
+  (void)cinfo;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_build_axis
+* Parameters: p_map, count, valid, out_len, crop_off, crop_len, reverse
+* Return Value : None
+* Description: Fill the source coordinates for one output axis. Entries
+* past @valid replicate the last pixel so the encoder sees full MCUs.
+==============================================================================*/
+static void qomx_swenc_build_axis(OMX_U32 *p_map, OMX_U32 count,
+  OMX_U32 valid, OMX_U32 out_len, OMX_U32 crop_off, OMX_U32 crop_len,
+  OMX_BOOL reverse)
+{
+  OMX_U32 i, j;
+
+  for (i = 0; i < count; i++) {
+    j = (i < valid) ? i : (valid - 1);
+    if (reverse) {
+      j = out_len - 1 - j;
+    }
+    p_map[i] = crop_off + (OMX_U32)(((uint64_t)j * crop_len) / out_len);
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_fill_rows
+* Parameters: p_img, p_fmt, p_map, y0, pad_w, y_rows, cb_rows, cr_rows
+* Return Value : None
+* Description: Gather one MCU row of planar samples from the semi-planar
+* source, applying crop, scaling and rotation through the lookup tables.
+==============================================================================*/
+static void qomx_swenc_fill_rows(qomx_swenc_image_t *p_img,
+  const qomx_swenc_fmt_t *p_fmt, qomx_swenc_map_t *p_map, OMX_U32 y0,
+  OMX_U32 enc_w, OMX_U32 pad_w, JSAMPROW *y_rows, JSAMPROW *cb_rows,
+  JSAMPROW *cr_rows)
+{
+  OMX_U32 r, x, col;
+  OMX_U8 *p_src;
+  OMX_U8 *p_dst;
+  OMX_U32 num_rows = p_fmt->h_sub ? QOMX_SWENC_MAX_ROWS : DCTSIZE;
+  OMX_U32 c_stride;
+  OMX_U32 cb_idx, cr_idx;
+
+  for (r = 0; r < num_rows; r++) {
+    p_dst = y_rows[r];
+    if (!p_map->transposed) {
+      p_src = p_img->p_y + p_map->p_row[y0 + r] * p_img->stride;
+      if (p_map->direct) {
+        memcpy(p_dst, p_src + p_map->p_col[0], enc_w);
+        memset(p_dst + enc_w, p_dst[enc_w - 1], pad_w - enc_w);
+      } else {
+        for (x = 0; x < pad_w; x++) {
+          p_dst[x] = p_src[p_map->p_col[x]];
+        }
+      }
+    } else {
+      col = p_map->p_row[y0 + r];
+      for (x = 0; x < pad_w; x++) {
+        p_dst[x] = p_img->p_y[p_map->p_col[x] * p_img->stride + col];
+      }
+    }
+  }
+
+  if (!p_fmt->h_sub) {
+    return;
+  }
+
+  c_stride = p_img->stride * 2 / p_fmt->h_sub;
+  cb_idx = p_fmt->cr_first ? 1 : 0;
+  cr_idx = 1 - cb_idx;
+  for (r = 0; r < DCTSIZE; r++) {
+    OMX_U32 y = y0 + 2 * r;
+    OMX_U8 *p_cb = cb_rows[r];
+    OMX_U8 *p_cr = cr_rows[r];
+
+    if (!p_map->transposed) {
+      p_src = p_img->p_cbcr + (p_map->p_row[y] / p_fmt->v_sub) * c_stride;
+      for (x = 0; x < pad_w / 2; x++) {
+        OMX_U8 *p_c = p_src + (p_map->p_col[2 * x] / p_fmt->h_sub) * 2;
+        p_cb[x] = p_c[cb_idx];
+        p_cr[x] = p_c[cr_idx];
+      }
+    } else {
+      col = (p_map->p_row[y] / p_fmt->h_sub) * 2;
+      for (x = 0; x < pad_w / 2; x++) {
+        OMX_U8 *p_c = p_img->p_cbcr +
+          (p_map->p_col[2 * x] / p_fmt->v_sub) * c_stride + col;
+        p_cb[x] = p_c[cb_idx];
+        p_cr[x] = p_c[cr_idx];
+      }
+    }
+  }
+}
+
+/*==============================================================================
+* Function : qomx_swenc_encode_band
+* Parameters: p_arg - job, idx - band index
+* Return Value : None, the result is stored in the band
+* Description: Encode one horizontal band as a standalone JPEG. The first
+* band goes straight into the output buffer and carries the APP1 segment,
+* the others go into their band buffer. With a restart interval equal to
+* the MCU count of a band no RST marker is emitted inside a band and each
+* band starts with fresh DC predictors, exactly like a restart interval of
+* a single encode.
+==============================================================================*/
+static void qomx_swenc_encode_band(void *p_arg, OMX_U32 idx)
+{
+  qomx_swenc_job_t *p_job = (qomx_swenc_job_t *)p_arg;
+  qomx_swenc_strip_t *p_strip = &p_job->p_strips[idx];
+  struct jpeg_compress_struct cinfo;
+  qomx_swenc_err_t jerr;
+  qomx_swenc_dest_t dest;
+  JSAMPROW y_rows[QOMX_SWENC_MAX_ROWS];
+  JSAMPROW cb_rows[DCTSIZE];
+  JSAMPROW cr_rows[DCTSIZE];
+  JSAMPARRAY planes[3];
+  OMX_U32 pad_w = p_job->pad_w;
+  OMX_U32 y_start, y_end, num_rows, y0, i, j;
+  OMX_BOOL mono = p_job->p_fmt->h_sub ? OMX_FALSE : OMX_TRUE;
+  size_t rows_size, buf_size;
+  unsigned int qtbl[DCTSIZE2];
+
+  p_strip->filled = 0;
+  y_start = idx * p_job->band_h;
+  y_end = (p_job->enc_h - y_start > p_job->band_h) ?
+    y_start + p_job->band_h : p_job->enc_h;
+
+  /* scratch: 16 luma rows and 8 rows per chroma component */
+  rows_size = (size_t)pad_w * (QOMX_SWENC_MAX_ROWS + DCTSIZE);
+  if (p_strip->rows_size < rows_size) {
+    free(p_strip->p_rows);
+    p_strip->p_rows = malloc(rows_size);
+    p_strip->rows_size = p_strip->p_rows ? rows_size : 0;
+  }
+  if (!p_strip->p_rows) {
+    ALOGE("%s:%d] Cannot allocate scratch memory", __func__, __LINE__);
+    p_strip->rc = OMX_ErrorInsufficientResources;
+    return;
+  }
+
+  memset(&dest, 0x0, sizeof(dest));
+  if (idx) {
+    /* start at half the luma size, most bands never grow past it */
+    buf_size = (size_t)pad_w * (y_end - y_start) / 2 + 4096;
+    if (p_strip->buf_size < buf_size) {
+      free(p_strip->p_buf);
+      p_strip->p_buf = malloc(buf_size);
+      p_strip->buf_size = p_strip->p_buf ? buf_size : 0;
+    }
+    if (!p_strip->p_buf) {
+      ALOGE("%s:%d] Cannot allocate band %u buffer", __func__, __LINE__, idx);
+      p_strip->rc = OMX_ErrorInsufficientResources;
+      return;
+    }
+    dest.p_buf = p_strip->p_buf;
+    dest.size = p_strip->buf_size;
+    dest.p_strip = p_strip;
+  } else {
+    dest.p_buf = p_job->p_out;
+    dest.size = p_job->out_size;
+  }
+
+  for (i = 0; i < QOMX_SWENC_MAX_ROWS; i++) {
+    y_rows[i] = p_strip->p_rows + i * pad_w;
+  }
+  for (i = 0; i < DCTSIZE; i++) {
+    cb_rows[i] = p_strip->p_rows + QOMX_SWENC_MAX_ROWS * pad_w +
+      i * (pad_w / 2);
+    cr_rows[i] = cb_rows[i] + DCTSIZE * (pad_w / 2);
+  }
+  planes[0] = y_rows;
+  planes[1] = cb_rows;
+  planes[2] = cr_rows;
+
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = qomx_swenc_error_exit;
+  if (setjmp(jerr.jmp)) {
+    jpeg_destroy_compress(&cinfo);
+    p_strip->rc = dest.overflow ? OMX_ErrorOverflow :
+      dest.no_mem ? OMX_ErrorInsufficientResources : OMX_ErrorUndefined;
+    return;
+  }
+  jpeg_create_compress(&cinfo);
+
+  dest.pub.init_destination = qomx_swenc_init_dest;
+  dest.pub.empty_output_buffer = qomx_swenc_empty_dest;
+  dest.pub.term_destination = qomx_swenc_term_dest;
+  cinfo.dest = &dest.pub;
+
+  cinfo.image_width = p_job->enc_w;
+  cinfo.image_height = y_end - y_start;
+  cinfo.input_components = mono ? 1 : 3;
+  cinfo.in_color_space = mono ? JCS_GRAYSCALE : JCS_YCbCr;
+  jpeg_set_defaults(&cinfo);
+  cinfo.raw_data_in = TRUE;
+  cinfo.restart_interval = p_job->restart_interval;
+  cinfo.dct_method = (QOMX_JPEG_SPEED_MODE_HIGH == p_job->speed_mode) ?
+    JDCT_IFAST : JDCT_ISLOW;
+  if (!mono) {
+    cinfo.comp_info[0].h_samp_factor = 2;
+    cinfo.comp_info[0].v_samp_factor = 2;
+    cinfo.comp_info[1].h_samp_factor = 1;
+    cinfo.comp_info[1].v_samp_factor = 1;
+    cinfo.comp_info[2].h_samp_factor = 1;
+    cinfo.comp_info[2].v_samp_factor = 1;
+  }
+  jpeg_set_quality(&cinfo, (int)p_job->p_img->quality, TRUE);
+  if (p_job->p_qtable && p_job->p_qtable_set) {
+    for (i = 0; i < 2; i++) {
+      if (!p_job->p_qtable_set[i]) {
+        continue;
+      }
+      for (j = 0; j < DCTSIZE2; j++) {
+        qtbl[j] = p_job->p_qtable[i].nQuantizationMatrix[j];
+      }
+      jpeg_add_quant_table(&cinfo, (int)i, qtbl, 100, TRUE);
+    }
+  }
+  /* only the scan data of the following bands is kept */
+  if (idx || !p_job->write_jfif) {
+    cinfo.write_JFIF_header = FALSE;
+  }
+
+  jpeg_start_compress(&cinfo, TRUE);
+
+  num_rows = mono ? DCTSIZE : QOMX_SWENC_MAX_ROWS;
+  for (y0 = y_start; y0 < y_end; y0 += num_rows) {
+    qomx_swenc_fill_rows(p_job->p_img, p_job->p_fmt, &p_job->map, y0,
+      p_job->enc_w, pad_w, y_rows, cb_rows, cr_rows);
+    jpeg_write_raw_data(&cinfo, planes, num_rows);
+  }
+  jpeg_finish_compress(&cinfo);
+
+  p_strip->filled = dest.size - dest.pub.free_in_buffer;
+  p_strip->rc = OMX_ErrorNone;
+  jpeg_destroy_compress(&cinfo);
+}
+
+/*==============================================================================
+* Function : qomx_swenc_find_scan
+* Parameters: p_buf, size, p_sof
+* Return Value : offset of the entropy coded data, 0 if not found
+* Description: Walk the markers of a band up to the start of scan and
+* report the offset of the frame header in @p_sof
+==============================================================================*/
+static size_t qomx_swenc_find_scan(OMX_U8 *p_buf, size_t size,
+  size_t *p_sof)
+{
+  size_t pos = 2;
+  size_t len;
+
+  if ((size < 4) || (0xFF != p_buf[0]) || (QOMX_SWENC_M_SOI != p_buf[1])) {
+    return 0;
+  }
+  while (pos + 4 <= size) {
+    if (0xFF != p_buf[pos]) {
+      return 0;
+    }
+    len = ((size_t)p_buf[pos + 2] << 8) | p_buf[pos + 3];
+    if ((QOMX_SWENC_M_SOF0 == p_buf[pos + 1]) ||
+      (QOMX_SWENC_M_SOF1 == p_buf[pos + 1])) {
+      *p_sof = pos;
+    } else if (QOMX_SWENC_M_SOS == p_buf[pos + 1]) {
+      return pos + 2 + len;
+    }
+    pos += 2 + len;
+  }
+  return 0;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_join_bands
+* Parameters: p_job, num_bands, p_filled
+* Return Value : OMX_ERRORTYPE
+* Description: Turn the first band into the header of the whole image and
+* append the scan data of the other bands behind RSTn markers. All bands
+* share the quantization and the default huffman tables, so the result is
+* a single baseline scan with a restart interval of one band.
+==============================================================================*/
+static OMX_ERRORTYPE qomx_swenc_join_bands(qomx_swenc_job_t *p_job,
+  OMX_U32 num_bands, size_t *p_filled)
+{
+  OMX_U8 *p_out = p_job->p_out;
+  qomx_swenc_strip_t *p_strip = &p_job->p_strips[0];
+  size_t pos, sof = 0, scan, len;
+  OMX_U32 i;
+
+  if (!qomx_swenc_find_scan(p_out, p_strip->filled, &sof) || !sof ||
+    (p_strip->filled < 2)) {
+    ALOGE("%s:%d] Cannot parse the first band", __func__, __LINE__);
+    return OMX_ErrorUndefined;
+  }
+  /* frame height lives at offset 5 of SOFn, after length and precision */
+  p_out[sof + 5] = (OMX_U8)(p_job->enc_h >> 8);
+  p_out[sof + 6] = (OMX_U8)(p_job->enc_h & 0xFF);
+
+  /* drop EOI, it is written after the last band */
+  pos = p_strip->filled - 2;
+  for (i = 1; i < num_bands; i++) {
+    p_strip = &p_job->p_strips[i];
+    scan = qomx_swenc_find_scan(p_strip->p_buf, p_strip->filled, &sof);
+    if (!scan || (scan + 2 > p_strip->filled)) {
+      ALOGE("%s:%d] Cannot parse band %u", __func__, __LINE__, i);
+      return OMX_ErrorUndefined;
+    }
+    len = p_strip->filled - 2 - scan;
+    if (pos + 2 + len + 2 > p_job->out_size) {
+      return OMX_ErrorOverflow;
+    }
+    p_out[pos++] = 0xFF;
+    p_out[pos++] = (OMX_U8)(JPEG_RST0 + ((i - 1) & 0x7));
+    memcpy(p_out + pos, p_strip->p_buf + scan, len);
+    pos += len;
+  }
+  p_out[pos++] = 0xFF;
+  p_out[pos++] = JPEG_EOI;
+  *p_filled = pos;
+  return OMX_ErrorNone;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_work_free
+* Parameters: p_work
+* Return Value : None
+* Description: Release the scratch memory
+==============================================================================*/
+void qomx_swenc_work_free(qomx_swenc_work_t *p_work)
+{
+  OMX_U32 i;
+
+  for (i = 0; i < p_work->strip_cnt; i++) {
+    free(p_work->p_strips[i].p_rows);
+    free(p_work->p_strips[i].p_buf);
+  }
+  free(p_work->p_strips);
+  free(p_work->p_map);
+  memset(p_work, 0x0, sizeof(*p_work));
+}
+
+/*==============================================================================
+* Function : qomx_swenc_encode
+* Parameters: p_img, speed_mode, p_qtable, p_qtable_set, write_jfif,
+*             p_work, p_pool, p_out, out_size, p_filled
+* Return Value : OMX_ERRORTYPE
+* Description: Encode one semi-planar image into a baseline 4:2:0 JPEG.
+* The samples are fed to libjpeg as raw data so color conversion and
+* downsampling are skipped, leaving only the (SIMD) DCT, quantization and
+* entropy coding. Without @write_jfif the stream starts with SOI followed
+* directly by the tables, leaving the caller to put APP1 in front of it.
+* With a pool, large images are split into one band per thread and the
+* bands are joined with restart markers.
+==============================================================================*/
+OMX_ERRORTYPE qomx_swenc_encode(qomx_swenc_image_t *p_img,
+  QOMX_JPEG_SPEED_MODE speed_mode,
+  OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE *p_qtable,
+  OMX_BOOL *p_qtable_set,
+  OMX_BOOL write_jfif,
+  qomx_swenc_work_t *p_work, qomx_swenc_pool_t *p_pool,
+  OMX_U8 *p_out, size_t out_size, size_t *p_filled)
+{
+  qomx_swenc_job_t job;
+  qomx_swenc_strip_t *p_strips;
+  OMX_U32 crop_w, crop_h, out_w, out_h, pad_h;
+  OMX_U32 mcu_size, mcu_cols, mcu_rows, max_rows;
+  OMX_U32 band_rows = 0;
+  OMX_U32 num_threads, num_bands, i;
+  size_t map_size;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  memset(&job, 0x0, sizeof(job));
+  job.p_fmt = qomx_swenc_get_fmt(p_img->color_fmt);
+  if (NULL == job.p_fmt) {
+    ALOGE("%s:%d] Unsupported color format %d", __func__, __LINE__,
+      p_img->color_fmt);
+    return OMX_ErrorUnsupportedSetting;
+  }
+
+  crop_w = p_img->crop.nWidth ? p_img->crop.nWidth : p_img->width;
+  crop_h = p_img->crop.nHeight ? p_img->crop.nHeight : p_img->height;
+  if (!crop_w || !crop_h || (p_img->crop.nLeft < 0) ||
+    (p_img->crop.nTop < 0) ||
+    ((OMX_U32)p_img->crop.nLeft + crop_w > p_img->width) ||
+    ((OMX_U32)p_img->crop.nTop + crop_h > p_img->height)) {
+    ALOGE("%s:%d] Invalid crop %dx%d+%d+%d for %dx%d", __func__, __LINE__,
+      (int)crop_w, (int)crop_h, (int)p_img->crop.nLeft,
+      (int)p_img->crop.nTop, (int)p_img->width, (int)p_img->height);
+    return OMX_ErrorBadParameter;
+  }
+  out_w = p_img->out_width ? p_img->out_width : crop_w;
+  out_h = p_img->out_height ? p_img->out_height : crop_h;
+
+  job.map.transposed = ((p_img->rotation == 90) || (p_img->rotation == 270)) ?
+    OMX_TRUE : OMX_FALSE;
+  job.enc_w = job.map.transposed ? out_h : out_w;
+  job.enc_h = job.map.transposed ? out_w : out_h;
+  job.pad_w = QOMX_SWENC_ALIGN(job.enc_w, QOMX_SWENC_MAX_ROWS);
+  pad_h = QOMX_SWENC_ALIGN(job.enc_h, QOMX_SWENC_MAX_ROWS);
+
+  /* one band per thread, bounded by the 16 bit restart interval */
+  mcu_size = job.p_fmt->h_sub ? QOMX_SWENC_MAX_ROWS : DCTSIZE;
+  mcu_cols = (job.enc_w + mcu_size - 1) / mcu_size;
+  mcu_rows = (job.enc_h + mcu_size - 1) / mcu_size;
+  num_threads = p_pool ? p_pool->num_threads + 1 : 1;
+  num_bands = 1;
+  if ((num_threads > 1) &&
+    ((uint64_t)job.enc_w * job.enc_h >= QOMX_SWENC_STRIP_MIN_PIXELS)) {
+    band_rows = (mcu_rows + num_threads - 1) / num_threads;
+    max_rows = 0xFFFF / mcu_cols;
+    if (band_rows > max_rows) {
+      band_rows = max_rows;
+    }
+    if (band_rows) {
+      num_bands = (mcu_rows + band_rows - 1) / band_rows;
+    }
+  }
+  if (num_bands > 1) {
+    job.band_h = band_rows * mcu_size;
+    job.restart_interval = band_rows * mcu_cols;
+  } else {
+    job.band_h = job.enc_h;
+    job.restart_interval = 0;
+  }
+
+  map_size = (size_t)job.pad_w + pad_h;
+  if (p_work->map_size < map_size) {
+    free(p_work->p_map);
+    p_work->p_map = malloc(map_size * sizeof(OMX_U32));
+    p_work->map_size = p_work->p_map ? map_size : 0;
+  }
+  if (p_work->strip_cnt < num_bands) {
+    p_strips = realloc(p_work->p_strips, num_bands * sizeof(*p_strips));
+    if (p_strips) {
+      memset(p_strips + p_work->strip_cnt, 0x0,
+        (num_bands - p_work->strip_cnt) * sizeof(*p_strips));
+      p_work->p_strips = p_strips;
+      p_work->strip_cnt = num_bands;
+    }
+  }
+  if (!p_work->p_map || (p_work->strip_cnt < num_bands)) {
+    ALOGE("%s:%d] Cannot allocate scratch memory", __func__, __LINE__);
+    return OMX_ErrorInsufficientResources;
+  }
+
+  job.map.p_col = p_work->p_map;
+  job.map.p_row = p_work->p_map + job.pad_w;
+  switch (p_img->rotation) {
+  case 90:
+    qomx_swenc_build_axis(job.map.p_col, job.pad_w, job.enc_w, out_h,
+      (OMX_U32)p_img->crop.nTop, crop_h, OMX_TRUE);
+    qomx_swenc_build_axis(job.map.p_row, pad_h, job.enc_h, out_w,
+      (OMX_U32)p_img->crop.nLeft, crop_w, OMX_FALSE);
+    break;
+  case 270:
+    qomx_swenc_build_axis(job.map.p_col, job.pad_w, job.enc_w, out_h,
+      (OMX_U32)p_img->crop.nTop, crop_h, OMX_FALSE);
+    qomx_swenc_build_axis(job.map.p_row, pad_h, job.enc_h, out_w,
+      (OMX_U32)p_img->crop.nLeft, crop_w, OMX_TRUE);
+    break;
+  default:
+    qomx_swenc_build_axis(job.map.p_col, job.pad_w, job.enc_w, out_w,
+      (OMX_U32)p_img->crop.nLeft, crop_w, p_img->rotation == 180);
+    qomx_swenc_build_axis(job.map.p_row, pad_h, job.enc_h, out_h,
+      (OMX_U32)p_img->crop.nTop, crop_h, p_img->rotation == 180);
+    break;
+  }
+  job.map.direct = ((p_img->rotation == 0) && (crop_w == out_w)) ?
+    OMX_TRUE : OMX_FALSE;
+
+  job.p_img = p_img;
+  job.speed_mode = speed_mode;
+  job.p_qtable = p_qtable;
+  job.p_qtable_set = p_qtable_set;
+  job.write_jfif = write_jfif;
+  job.p_strips = p_work->p_strips;
+  job.p_out = p_out;
+  job.out_size = out_size;
+
+  if (num_bands > 1) {
+    qomx_swenc_pool_run(p_pool, qomx_swenc_encode_band, &job, num_bands);
+  } else {
+    qomx_swenc_encode_band(&job, 0);
+  }
+
+  for (i = 0; i < num_bands; i++) {
+    if (OMX_ErrorNone != job.p_strips[i].rc) {
+      return job.p_strips[i].rc;
+    }
+  }
+  if (num_bands > 1) {
+    rc = qomx_swenc_join_bands(&job, num_bands, p_filled);
+  } else {
+    *p_filled = job.p_strips[0].filled;
+  }
+  return rc;
+}
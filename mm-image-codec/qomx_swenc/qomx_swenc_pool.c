@@ -0,0 +1,157 @@
+/*Copyright (c) 2015, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#define LOG_NDEBUG 0
+#define LOG_NIDEBUG 0
+#define LOG_TAG "qomx_jpegenc_sw"
+#include <utils/Log.h>
+#include <sys/prctl.h>
+
+#include "qomx_swenc.h"
+
+/*==============================================================================
+* Function : qomx_swenc_pool_thread
+* Parameters: data - pool
+* Return Value : NULL
+* Description: Worker loop, picks tasks of the current run until the pool
+* is torn down
+==============================================================================*/
+static void *qomx_swenc_pool_thread(void *data)
+{
+  qomx_swenc_pool_t *p_pool = (qomx_swenc_pool_t *)data;
+  OMX_U32 idx;
+
+  prctl(PR_SET_NAME, (unsigned long)"qomx_swenc_strip", 0, 0, 0);
+  pthread_mutex_lock(&p_pool->lock);
+  while (1) {
+    while (!p_pool->exit && (p_pool->next_task >= p_pool->task_cnt)) {
+      pthread_cond_wait(&p_pool->cond, &p_pool->lock);
+    }
+    if (p_pool->exit) {
+      break;
+    }
+    idx = p_pool->next_task++;
+    pthread_mutex_unlock(&p_pool->lock);
+
+    p_pool->fn(p_pool->p_arg, idx);
+
+    pthread_mutex_lock(&p_pool->lock);
+    if (++p_pool->done_cnt == p_pool->task_cnt) {
+      pthread_cond_signal(&p_pool->done_cond);
+    }
+  }
+  pthread_mutex_unlock(&p_pool->lock);
+  return NULL;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_pool_init
+* Parameters: p_pool, num_threads - total number of encoding threads,
+*             including the caller of qomx_swenc_pool_run
+* Return Value : 0 on success, -1 if no worker could be started
+* Description: Start the worker threads. A pool that fails to start
+* leaves num_threads at 0 and the encode stays single threaded.
+==============================================================================*/
+int qomx_swenc_pool_init(qomx_swenc_pool_t *p_pool, OMX_U32 num_threads)
+{
+  OMX_U32 i;
+
+  memset(p_pool, 0x0, sizeof(*p_pool));
+  pthread_mutex_init(&p_pool->lock, NULL);
+  pthread_cond_init(&p_pool->cond, NULL);
+  pthread_cond_init(&p_pool->done_cond, NULL);
+
+  if (num_threads > QOMX_SWENC_MAX_THREADS) {
+    num_threads = QOMX_SWENC_MAX_THREADS;
+  }
+  for (i = 0; i + 1 < num_threads; i++) {
+    if (pthread_create(&p_pool->threads[i], NULL, qomx_swenc_pool_thread,
+      p_pool)) {
+      ALOGE("%s:%d] Cannot create worker %u", __func__, __LINE__, i);
+      break;
+    }
+    p_pool->num_threads++;
+  }
+  return (num_threads > 1 && !p_pool->num_threads) ? -1 : 0;
+}
+
+/*==============================================================================
+* Function : qomx_swenc_pool_run
+* Parameters: p_pool, fn, p_arg, task_cnt
+* Return Value : None
+* Description: Run fn(p_arg, idx) for idx in [0, task_cnt) on the workers
+* and the calling thread, and return once all tasks completed
+==============================================================================*/
+void qomx_swenc_pool_run(qomx_swenc_pool_t *p_pool, qomx_swenc_task_fn fn,
+  void *p_arg, OMX_U32 task_cnt)
+{
+  OMX_U32 idx;
+
+  pthread_mutex_lock(&p_pool->lock);
+  p_pool->fn = fn;
+  p_pool->p_arg = p_arg;
+  p_pool->task_cnt = task_cnt;
+  p_pool->next_task = 0;
+  p_pool->done_cnt = 0;
+  pthread_cond_broadcast(&p_pool->cond);
+
+  while (p_pool->next_task < p_pool->task_cnt) {
+    idx = p_pool->next_task++;
+    pthread_mutex_unlock(&p_pool->lock);
+    fn(p_arg, idx);
+    pthread_mutex_lock(&p_pool->lock);
+    p_pool->done_cnt++;
+  }
+  while (p_pool->done_cnt < p_pool->task_cnt) {
+    pthread_cond_wait(&p_pool->done_cond, &p_pool->lock);
+  }
+  p_pool->task_cnt = 0;
+  p_pool->next_task = 0;
+  pthread_mutex_unlock(&p_pool->lock);
+}
+
+/*==============================================================================
+* Function : qomx_swenc_pool_deinit
+* Parameters: p_pool
+* Return Value : None
+* Description: Stop and join the worker threads
+==============================================================================*/
+void qomx_swenc_pool_deinit(qomx_swenc_pool_t *p_pool)
+{
+  OMX_U32 i;
+
+  pthread_mutex_lock(&p_pool->lock);
+  p_pool->exit = OMX_TRUE;
+  pthread_cond_broadcast(&p_pool->cond);
+  pthread_mutex_unlock(&p_pool->lock);
+  for (i = 0; i < p_pool->num_threads; i++) {
+    pthread_join(p_pool->threads[i], NULL);
+  }
+  pthread_mutex_destroy(&p_pool->lock);
+  pthread_cond_destroy(&p_pool->cond);
+  pthread_cond_destroy(&p_pool->done_cond);
+}
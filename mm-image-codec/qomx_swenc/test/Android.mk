@@ -0,0 +1,37 @@
+OMX_SWENC_TEST_PATH := $(call my-dir)
+
+# Driver for libqomx_jpegenc_sw, loaded through libqomx_core the same way
+# mm-jpeg-interface does. Run on the host with the host libraries on
+# LD_LIBRARY_PATH so qomx_core can dlopen the component. The band vs
+# single session benchmark (-b) decodes its outputs with libjpeg.
+
+omx_swenc_test_includes := frameworks/native/include/media/openmax
+omx_swenc_test_includes += $(OMX_SWENC_TEST_PATH)/../../qexif
+omx_swenc_test_includes += $(OMX_SWENC_TEST_PATH)/../../qomx_core
+
+ifneq ($(MM_IMAGE_CODEC_HOST_ONLY),true)
+include $(CLEAR_VARS)
+LOCAL_PATH := $(OMX_SWENC_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+LOCAL_C_INCLUDES := $(omx_swenc_test_includes)
+LOCAL_C_INCLUDES += external/jpeg
+LOCAL_SRC_FILES := qomx_swenc_test.c
+LOCAL_MODULE           := qomx-swenc-test
+LOCAL_SHARED_LIBRARIES := libqomx_core libjpeg
+LOCAL_32_BIT_ONLY := true
+include $(BUILD_EXECUTABLE)
+endif
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(OMX_SWENC_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+LOCAL_C_INCLUDES := $(omx_swenc_test_includes)
+LOCAL_C_INCLUDES += external/libjpeg-turbo
+LOCAL_SRC_FILES := qomx_swenc_test.c
+LOCAL_MODULE           := qomx-swenc-test
+LOCAL_SHARED_LIBRARIES := libqomx_core libjpeg
+LOCAL_REQUIRED_MODULES := libqomx_jpegenc_sw
+LOCAL_LDLIBS           := -lpthread -lrt
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,893 @@
+/*Copyright (c) 2015, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+
+/* Host and target driver for the software jpeg encoder component. It opens
+ * OMX.qcom.image.jpeg.encoder.sw through the OMX core and issues the same
+ * call sequence mm_jpeg_start_job does for a session: port definitions,
+ * buffer offsets, thumbnail, EXIF, quality, speed and encoding mode, then
+ * one EmptyThisBuffer/FillThisBuffer round trip per job. Per job latency
+ * and throughput are reported over the requested number of jobs.
+ *
+ * With -b it compares band (parallel) encoding against a single session
+ * (serial) at 8, 13 and 21 MP and checks that both outputs decode to the
+ * same pixels without decoder warnings. The bench forces at least two
+ * encoder threads through QOMX_IMAGE_EXT_ENCODING_THREADS, so the band
+ * path runs even on a single CPU host, and fails when the parallel output
+ * carries no restart markers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <jerror.h>
+#include "OMX_Types.h"
+#include "OMX_Index.h"
+#include "OMX_Core.h"
+#include "OMX_Component.h"
+#include "QOMX_JpegExtensions.h"
+
+#define SWENC_TEST_COMP_NAME "OMX.qcom.image.jpeg.encoder.sw"
+#define SWENC_TEST_TIMEOUT_SEC 30
+#define SWENC_TEST_NUM_EXIF 4
+
+/** swenc_test_args_t: command line options
+*    @width: main image width
+*    @height: main image height
+*    @iters: number of jobs to run
+*    @quality: main image quality
+*    @rotation: output rotation in degrees
+*    @thumb: encode a thumbnail when set
+*    @parallel: encode the main image in bands when set
+*    @high_speed: select the fast DCT when set
+*    @bench: run the band vs single session benchmark when set
+*    @threads: encoder threads including the caller, 0 for the default
+*    @in_file: optional NV21 input file, synthetic image when NULL
+*    @out_file: optional file receiving the last encoded image
+**/
+typedef struct {
+  OMX_U32 width;
+  OMX_U32 height;
+  OMX_U32 iters;
+  OMX_U32 quality;
+  OMX_U32 rotation;
+  int thumb;
+  int parallel;
+  int high_speed;
+  int bench;
+  OMX_U32 threads;
+  const char *in_file;
+  const char *out_file;
+} swenc_test_args_t;
+
+/** swenc_test_t: test session
+*    @p_handle: component handle
+*    @lock: protects the event state
+*    @cond: signalled on component events
+*    @cmd_cnt: number of completed commands
+*    @error: set by OMX_EventError
+*    @done: set when the output buffer is returned
+*    @filled: encoded size of the last job
+*    @p_main: main image buffer
+*    @main_size: size of @p_main
+*    @p_thumb: thumbnail source buffer
+*    @thumb_size: size of @p_thumb
+*    @p_out: output buffer
+*    @out_size: size of @p_out
+*    @p_in_hdr: main port buffer header
+*    @p_thumb_hdr: thumbnail port buffer header
+*    @p_out_hdr: output port buffer header
+*    @lat_avg_ms: average job latency of the last run
+**/
+typedef struct {
+  OMX_HANDLETYPE p_handle;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int cmd_cnt;
+  int error;
+  int done;
+  OMX_U32 filled;
+  OMX_U8 *p_main;
+  OMX_U32 main_size;
+  OMX_U8 *p_thumb;
+  OMX_U32 thumb_size;
+  OMX_U8 *p_out;
+  OMX_U32 out_size;
+  OMX_BUFFERHEADERTYPE *p_in_hdr;
+  OMX_BUFFERHEADERTYPE *p_thumb_hdr;
+  OMX_BUFFERHEADERTYPE *p_out_hdr;
+  double lat_avg_ms;
+} swenc_test_t;
+
+/** swenc_test_size_t: benchmark resolution
+*    @name: label printed with the results
+*    @width: image width
+*    @height: image height
+**/
+typedef struct {
+  const char *name;
+  OMX_U32 width;
+  OMX_U32 height;
+} swenc_test_size_t;
+
+/** swenc_test_decoded_t: decoded image used for the equivalence check
+*    @p_pix: interleaved YCbCr samples
+*    @width: image width
+*    @height: image height
+*    @restart_interval: restart interval in MCUs
+*    @warnings: number of decoder warnings
+**/
+typedef struct {
+  OMX_U8 *p_pix;
+  OMX_U32 width;
+  OMX_U32 height;
+  OMX_U32 restart_interval;
+  long warnings;
+} swenc_test_decoded_t;
+
+/** swenc_test_jpeg_err_t: libjpeg error manager returning to the caller
+*    @pub: libjpeg error manager
+*    @jmp: return point on fatal errors
+**/
+typedef struct {
+  struct jpeg_error_mgr pub;
+  jmp_buf jmp;
+} swenc_test_jpeg_err_t;
+
+static const swenc_test_size_t g_bench_sizes[] = {
+  { "8MP", 3264, 2448 },
+  { "13MP", 4160, 3120 },
+  { "21MP", 5344, 4016 },
+};
+
+static OMX_U32 g_thumb_width = 320;
+static OMX_U32 g_thumb_height = 240;
+
+static long long swenc_test_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/*==============================================================================
+* Function : swenc_test_event_handler
+* Parameters: p_handle, p_app_data, event, data1, data2, p_event_data
+* Return Value : OMX_ERRORTYPE
+* Description: Counts completed commands and records errors
+==============================================================================*/
+static OMX_ERRORTYPE swenc_test_event_handler(OMX_HANDLETYPE p_handle,
+  OMX_PTR p_app_data, OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2,
+  OMX_PTR p_event_data)
+{
+  swenc_test_t *p_test = (swenc_test_t *)p_app_data;
+
+  (void)p_handle;
+  (void)p_event_data;
+  pthread_mutex_lock(&p_test->lock);
+  if (OMX_EventCmdComplete == event) {
+    p_test->cmd_cnt++;
+  } else if (OMX_EventError == event) {
+    fprintf(stderr, "component error 0x%x 0x%x\n", data1, data2);
+    p_test->error = 1;
+  }
+  pthread_cond_broadcast(&p_test->cond);
+  pthread_mutex_unlock(&p_test->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE swenc_test_ebd(OMX_HANDLETYPE p_handle,
+  OMX_PTR p_app_data, OMX_BUFFERHEADERTYPE *p_buf)
+{
+  (void)p_handle;
+  (void)p_app_data;
+  (void)p_buf;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE swenc_test_fbd(OMX_HANDLETYPE p_handle,
+  OMX_PTR p_app_data, OMX_BUFFERHEADERTYPE *p_buf)
+{
+  swenc_test_t *p_test = (swenc_test_t *)p_app_data;
+
+  (void)p_handle;
+  pthread_mutex_lock(&p_test->lock);
+  p_test->filled = p_buf->nFilledLen;
+  p_test->done = 1;
+  pthread_cond_broadcast(&p_test->cond);
+  pthread_mutex_unlock(&p_test->lock);
+  return OMX_ErrorNone;
+}
+
+/*==============================================================================
+* Function : swenc_test_wait
+* Parameters: p_test, cmd_cnt - number of completed commands to wait for,
+*   0 to wait for the output buffer instead
+* Return Value : 0 on success, -1 on error or timeout
+* Description: Blocks until the component reports progress
+==============================================================================*/
+static int swenc_test_wait(swenc_test_t *p_test, int cmd_cnt)
+{
+  struct timespec ts;
+  int rc = 0;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += SWENC_TEST_TIMEOUT_SEC;
+  pthread_mutex_lock(&p_test->lock);
+  while (!p_test->error && (cmd_cnt ? (p_test->cmd_cnt < cmd_cnt) :
+    !p_test->done)) {
+    if (pthread_cond_timedwait(&p_test->cond, &p_test->lock, &ts)) {
+      fprintf(stderr, "timeout waiting for the component\n");
+      rc = -1;
+      break;
+    }
+  }
+  if (p_test->error) {
+    rc = -1;
+  }
+  pthread_mutex_unlock(&p_test->lock);
+  return rc;
+}
+
+/*==============================================================================
+* Function : swenc_test_fill_input
+* Parameters: p_test, p_args
+* Return Value : 0 on success, -1 on error
+* Description: Reads the NV21 main image from file or generates a gradient
+* with enough detail to keep the entropy coder busy
+==============================================================================*/
+static int swenc_test_fill_input(swenc_test_t *p_test,
+  swenc_test_args_t *p_args)
+{
+  OMX_U32 w = p_args->width, h = p_args->height;
+  OMX_U8 *p_c = p_test->p_main + w * h;
+  OMX_U32 x, y;
+  FILE *fp;
+
+  if (p_args->in_file) {
+    fp = fopen(p_args->in_file, "rb");
+    if (!fp) {
+      fprintf(stderr, "cannot open %s\n", p_args->in_file);
+      return -1;
+    }
+    if (fread(p_test->p_main, 1, p_test->main_size, fp) !=
+      p_test->main_size) {
+      fprintf(stderr, "%s is smaller than %ux%u NV21\n", p_args->in_file,
+        w, h);
+      fclose(fp);
+      return -1;
+    }
+    fclose(fp);
+  } else {
+    srand(1);
+    for (y = 0; y < h; y++) {
+      for (x = 0; x < w; x++) {
+        p_test->p_main[y * w + x] = (OMX_U8)((x * 255 / w + y * 100 / h +
+          (rand() & 0xf)) & 0xff);
+      }
+    }
+    for (y = 0; y < h / 2; y++) {
+      for (x = 0; x < w; x += 2) {
+        p_c[y * w + x] = (OMX_U8)(64 + y * 128 / h);
+        p_c[y * w + x + 1] = (OMX_U8)(x * 255 / w);
+      }
+    }
+  }
+
+  for (x = 0; x < g_thumb_width * g_thumb_height; x++) {
+    p_test->p_thumb[x] = (OMX_U8)x;
+  }
+  memset(p_test->p_thumb + g_thumb_width * g_thumb_height, 128,
+    g_thumb_width * g_thumb_height / 2);
+  return 0;
+}
+
+/*==============================================================================
+* Function : swenc_test_set_port
+* Parameters: p_test, port, width, height, size
+* Return Value : OMX_ERRORTYPE
+* Description: Configures an image port for one NV21 buffer
+==============================================================================*/
+static OMX_ERRORTYPE swenc_test_set_port(swenc_test_t *p_test, OMX_U32 port,
+  OMX_U32 width, OMX_U32 height, OMX_U32 size)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE def;
+  OMX_ERRORTYPE rc;
+
+  memset(&def, 0, sizeof(def));
+  def.nPortIndex = port;
+  rc = OMX_GetParameter(p_test->p_handle, OMX_IndexParamPortDefinition, &def);
+  if (OMX_ErrorNone != rc) {
+    return rc;
+  }
+  def.nBufferCountActual = 1;
+  def.nBufferSize = size;
+  if (width) {
+    def.format.image.nFrameWidth = width;
+    def.format.image.nFrameHeight = height;
+    def.format.image.nStride = (OMX_S32)width;
+    def.format.image.nSliceHeight = height;
+    def.format.image.eColorFormat =
+      (OMX_COLOR_FORMATTYPE)OMX_QCOM_IMG_COLOR_FormatYVU420SemiPlanar;
+  }
+  return OMX_SetParameter(p_test->p_handle, OMX_IndexParamPortDefinition,
+    &def);
+}
+
+/*==============================================================================
+* Function : swenc_test_set_ext
+* Parameters: p_test, name - extension name, p_data, config - use SetConfig
+* Return Value : OMX_ERRORTYPE
+* Description: Sets a vendor extension by name
+==============================================================================*/
+static OMX_ERRORTYPE swenc_test_set_ext(swenc_test_t *p_test,
+  const char *name, OMX_PTR p_data, int config)
+{
+  OMX_INDEXTYPE idx;
+  OMX_ERRORTYPE rc;
+
+  rc = OMX_GetExtensionIndex(p_test->p_handle, (OMX_STRING)name, &idx);
+  if (OMX_ErrorNone != rc) {
+    fprintf(stderr, "no extension %s\n", name);
+    return rc;
+  }
+  return config ? OMX_SetConfig(p_test->p_handle, idx, p_data) :
+    OMX_SetParameter(p_test->p_handle, idx, p_data);
+}
+
+/*==============================================================================
+* Function : swenc_test_configure
+* Parameters: p_test, p_args
+* Return Value : 0 on success, -1 on error
+* Description: Port and parameter setup done by mm_jpeg before the
+* component is moved to Idle
+==============================================================================*/
+static int swenc_test_configure(swenc_test_t *p_test,
+  swenc_test_args_t *p_args)
+{
+  QOMX_YUV_FRAME_INFO frame_info;
+  QOMX_JPEG_SPEED speed;
+  QOMX_ENCODING_MODE mode;
+  QOMX_ENCODING_THREADS threads;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  if (p_args->threads) {
+    threads.numThreads = p_args->threads;
+    rc = swenc_test_set_ext(p_test, QOMX_IMAGE_EXT_ENCODING_THREADS_NAME,
+      &threads, 0);
+  }
+  if (OMX_ErrorNone == rc) {
+    rc = swenc_test_set_port(p_test, 0, p_args->width, p_args->height,
+      p_test->main_size);
+  }
+  if ((OMX_ErrorNone == rc) && p_args->thumb) {
+    rc = swenc_test_set_port(p_test, 2, g_thumb_width, g_thumb_height,
+      p_test->thumb_size);
+    if (OMX_ErrorNone == rc) {
+      rc = OMX_SendCommand(p_test->p_handle, OMX_CommandPortEnable, 2, NULL);
+    }
+    if ((OMX_ErrorNone == rc) && swenc_test_wait(p_test, 1)) {
+      rc = OMX_ErrorTimeout;
+    }
+  }
+  if (OMX_ErrorNone == rc) {
+    rc = swenc_test_set_port(p_test, 1, 0, 0, p_test->out_size);
+  }
+  if (OMX_ErrorNone == rc) {
+    memset(&frame_info, 0, sizeof(frame_info));
+    frame_info.cbcrStartOffset[0] = p_args->width * p_args->height;
+    rc = swenc_test_set_ext(p_test, QOMX_IMAGE_EXT_BUFFER_OFFSET_NAME,
+      &frame_info, 0);
+  }
+  if (OMX_ErrorNone == rc) {
+    speed.speedMode = p_args->high_speed ? QOMX_JPEG_SPEED_MODE_HIGH :
+      QOMX_JPEG_SPEED_MODE_NORMAL;
+    rc = swenc_test_set_ext(p_test, QOMX_IMAGE_EXT_JPEG_SPEED_NAME, &speed,
+      0);
+  }
+  if (OMX_ErrorNone == rc) {
+    mode = p_args->parallel ? OMX_Parallel_Encoding : OMX_Serial_Encoding;
+    rc = swenc_test_set_ext(p_test, QOMX_IMAGE_EXT_ENCODING_MODE_NAME, &mode,
+      0);
+  }
+  if (OMX_ErrorNone != rc) {
+    fprintf(stderr, "configuration failed %d\n", rc);
+    return -1;
+  }
+  return 0;
+}
+
+/*==============================================================================
+* Function : swenc_test_configure_job
+* Parameters: p_test, p_args
+* Return Value : 0 on success, -1 on error
+* Description: Per job configuration mm_jpeg applies in Executing state:
+* rotation, crop, EXIF, quality and thumbnail
+==============================================================================*/
+static int swenc_test_configure_job(swenc_test_t *p_test,
+  swenc_test_args_t *p_args)
+{
+  static rat_t latitude[3] = {{37, 1}, {25, 1}, {1234, 100}};
+  QEXIF_INFO_DATA exif[SWENC_TEST_NUM_EXIF];
+  OMX_CONFIG_ROTATIONTYPE rotation;
+  OMX_CONFIG_RECTTYPE crop;
+  OMX_IMAGE_PARAM_QFACTORTYPE qfactor;
+  QOMX_EXIF_INFO exif_info;
+  QOMX_THUMBNAIL_INFO thumb_info;
+  OMX_ERRORTYPE rc;
+
+  memset(&rotation, 0, sizeof(rotation));
+  rotation.nPortIndex = 1;
+  rotation.nRotation = (OMX_S32)p_args->rotation;
+  rc = OMX_SetConfig(p_test->p_handle, OMX_IndexConfigCommonRotate,
+    &rotation);
+
+  memset(&crop, 0, sizeof(crop));
+  if (OMX_ErrorNone == rc) {
+    rc = OMX_SetConfig(p_test->p_handle, OMX_IndexConfigCommonInputCrop,
+      &crop);
+  }
+  if (OMX_ErrorNone == rc) {
+    rc = OMX_SetConfig(p_test->p_handle, OMX_IndexConfigCommonOutputCrop,
+      &crop);
+  }
+
+  if (OMX_ErrorNone == rc) {
+    memset(exif, 0, sizeof(exif));
+    exif[0].tag_id = EXIFTAGID_MAKE;
+    exif[0].tag_entry.type = EXIF_ASCII;
+    exif[0].tag_entry.count = 5;
+    exif[0].tag_entry.data._ascii = "QCOM";
+    exif[1].tag_id = EXIFTAGID_MODEL;
+    exif[1].tag_entry.type = EXIF_ASCII;
+    exif[1].tag_entry.count = 6;
+    exif[1].tag_entry.data._ascii = "SWENC";
+    exif[2].tag_id = EXIFTAGID_ISO_SPEED_RATING;
+    exif[2].tag_entry.type = EXIF_SHORT;
+    exif[2].tag_entry.count = 1;
+    exif[2].tag_entry.data._short = 400;
+    exif[3].tag_id = EXIFTAGID_GPS_LATITUDE;
+    exif[3].tag_entry.type = EXIF_RATIONAL;
+    exif[3].tag_entry.count = 3;
+    exif[3].tag_entry.data._rats = latitude;
+    exif_info.exif_data = exif;
+    exif_info.numOfEntries = SWENC_TEST_NUM_EXIF;
+    rc = swenc_test_set_ext(p_test, QOMX_IMAGE_EXT_EXIF_NAME, &exif_info, 1);
+  }
+
+  if (OMX_ErrorNone == rc) {
+    memset(&qfactor, 0, sizeof(qfactor));
+    qfactor.nPortIndex = 0;
+    qfactor.nQFactor = p_args->quality;
+    rc = OMX_SetConfig(p_test->p_handle, OMX_IndexParamQFactor, &qfactor);
+  }
+
+  if ((OMX_ErrorNone == rc) && p_args->thumb) {
+    memset(&thumb_info, 0, sizeof(thumb_info));
+    thumb_info.input_width = g_thumb_width;
+    thumb_info.input_height = g_thumb_height;
+    thumb_info.scaling_enabled = 1;
+    thumb_info.output_width = g_thumb_width / 2;
+    thumb_info.output_height = g_thumb_height / 2;
+    thumb_info.quality = 75;
+    thumb_info.crop_info.nWidth = g_thumb_width;
+    thumb_info.crop_info.nHeight = g_thumb_height;
+    thumb_info.tmbOffset.cbcrStartOffset[0] = g_thumb_width * g_thumb_height;
+    rc = swenc_test_set_ext(p_test, QOMX_IMAGE_EXT_THUMBNAIL_NAME,
+      &thumb_info, 1);
+  }
+
+  if (OMX_ErrorNone != rc) {
+    fprintf(stderr, "job configuration failed %d\n", rc);
+    return -1;
+  }
+  return 0;
+}
+
+/*==============================================================================
+* Function : swenc_test_run
+* Parameters: p_test, p_args
+* Return Value : 0 on success, -1 on error
+* Description: Brings the component up, runs the jobs and reports the
+* per job latency and the throughput
+==============================================================================*/
+static int swenc_test_run(swenc_test_t *p_test, swenc_test_args_t *p_args)
+{
+  OMX_CALLBACKTYPE callbacks = {
+    swenc_test_event_handler, swenc_test_ebd, swenc_test_fbd
+  };
+  long long start, lat, lat_min = 0, lat_max = 0, lat_sum = 0;
+  int cmd_cnt;
+  OMX_U32 i;
+  FILE *fp;
+  int rc = -1;
+
+  if (OMX_ErrorNone != OMX_GetHandle(&p_test->p_handle,
+    (OMX_STRING)SWENC_TEST_COMP_NAME, p_test, &callbacks)) {
+    fprintf(stderr, "cannot load %s\n", SWENC_TEST_COMP_NAME);
+    return -1;
+  }
+
+  if (swenc_test_configure(p_test, p_args)) {
+    goto free_handle;
+  }
+  cmd_cnt = p_test->cmd_cnt;
+
+  OMX_SendCommand(p_test->p_handle, OMX_CommandStateSet, OMX_StateIdle,
+    NULL);
+  OMX_UseBuffer(p_test->p_handle, &p_test->p_in_hdr, 0, NULL,
+    p_test->main_size, p_test->p_main);
+  if (p_args->thumb) {
+    OMX_UseBuffer(p_test->p_handle, &p_test->p_thumb_hdr, 2, NULL,
+      p_test->thumb_size, p_test->p_thumb);
+  }
+  OMX_UseBuffer(p_test->p_handle, &p_test->p_out_hdr, 1, NULL,
+    p_test->out_size, p_test->p_out);
+  if (swenc_test_wait(p_test, ++cmd_cnt)) {
+    goto free_handle;
+  }
+  OMX_SendCommand(p_test->p_handle, OMX_CommandStateSet, OMX_StateExecuting,
+    NULL);
+  if (swenc_test_wait(p_test, ++cmd_cnt)) {
+    goto free_handle;
+  }
+
+  for (i = 0; i < p_args->iters; i++) {
+    start = swenc_test_now_us();
+    if (swenc_test_configure_job(p_test, p_args)) {
+      goto stop;
+    }
+    p_test->done = 0;
+    OMX_EmptyThisBuffer(p_test->p_handle, p_test->p_in_hdr);
+    if (p_args->thumb) {
+      OMX_EmptyThisBuffer(p_test->p_handle, p_test->p_thumb_hdr);
+    }
+    OMX_FillThisBuffer(p_test->p_handle, p_test->p_out_hdr);
+    if (swenc_test_wait(p_test, 0)) {
+      goto stop;
+    }
+    lat = swenc_test_now_us() - start;
+    lat_sum += lat;
+    if (!i || (lat < lat_min)) {
+      lat_min = lat;
+    }
+    if (lat > lat_max) {
+      lat_max = lat;
+    }
+  }
+
+  p_test->lat_avg_ms = lat_sum / 1000.0 / p_args->iters;
+  printf("%ux%u %s rot %u q %u%s: %u jobs, %u bytes, latency "
+    "min %.2f avg %.2f max %.2f ms, %.1f MP/s\n",
+    p_args->width, p_args->height,
+    p_args->parallel ? "parallel" : "serial", p_args->rotation,
+    p_args->quality, p_args->thumb ? " +thumb" : "", p_args->iters,
+    p_test->filled, lat_min / 1000.0, p_test->lat_avg_ms, lat_max / 1000.0,
+    (double)p_args->width * p_args->height * p_args->iters / lat_sum);
+
+  if (p_args->out_file) {
+    fp = fopen(p_args->out_file, "wb");
+    if (fp) {
+      fwrite(p_test->p_out, 1, p_test->filled, fp);
+      fclose(fp);
+    } else {
+      fprintf(stderr, "cannot write %s\n", p_args->out_file);
+    }
+  }
+  rc = 0;
+
+stop:
+  OMX_SendCommand(p_test->p_handle, OMX_CommandStateSet, OMX_StateIdle,
+    NULL);
+  swenc_test_wait(p_test, ++cmd_cnt);
+  OMX_SendCommand(p_test->p_handle, OMX_CommandStateSet, OMX_StateLoaded,
+    NULL);
+  OMX_FreeBuffer(p_test->p_handle, 0, p_test->p_in_hdr);
+  if (p_args->thumb) {
+    OMX_FreeBuffer(p_test->p_handle, 2, p_test->p_thumb_hdr);
+  }
+  OMX_FreeBuffer(p_test->p_handle, 1, p_test->p_out_hdr);
+  swenc_test_wait(p_test, ++cmd_cnt);
+
+free_handle:
+  OMX_FreeHandle(p_test->p_handle);
+  return rc;
+}
+
+/*==============================================================================
+* Function : swenc_test_encode
+* Parameters: p_test, p_args
+* Return Value : 0 on success, -1 on error
+* Description: Allocates the buffers for @p_args and runs the jobs. The
+* encoded image stays in p_test->p_out until swenc_test_release
+==============================================================================*/
+static int swenc_test_encode(swenc_test_t *p_test, swenc_test_args_t *p_args)
+{
+  memset(p_test, 0, sizeof(*p_test));
+  pthread_mutex_init(&p_test->lock, NULL);
+  pthread_cond_init(&p_test->cond, NULL);
+  p_test->main_size = p_args->width * p_args->height * 3 / 2;
+  p_test->thumb_size = g_thumb_width * g_thumb_height * 3 / 2;
+  p_test->out_size = p_args->width * p_args->height * 2;
+  p_test->p_main = malloc(p_test->main_size);
+  p_test->p_thumb = malloc(p_test->thumb_size);
+  p_test->p_out = malloc(p_test->out_size);
+  if (!p_test->p_main || !p_test->p_thumb || !p_test->p_out) {
+    fprintf(stderr, "cannot allocate buffers for %ux%u\n", p_args->width,
+      p_args->height);
+    return -1;
+  }
+  if (swenc_test_fill_input(p_test, p_args)) {
+    return -1;
+  }
+  return swenc_test_run(p_test, p_args);
+}
+
+static void swenc_test_release(swenc_test_t *p_test)
+{
+  free(p_test->p_main);
+  free(p_test->p_thumb);
+  free(p_test->p_out);
+  pthread_cond_destroy(&p_test->cond);
+  pthread_mutex_destroy(&p_test->lock);
+}
+
+static void swenc_test_jpeg_error_exit(j_common_ptr cinfo)
+{
+  swenc_test_jpeg_err_t *p_err = (swenc_test_jpeg_err_t *)cinfo->err;
+
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(p_err->jmp, 1);
+}
+
+static void swenc_test_src_init(j_decompress_ptr cinfo)
+{
+  (void)cinfo;
+}
+
+/* all data is in memory, running out means the stream is truncated */
+static boolean swenc_test_src_fill(j_decompress_ptr cinfo)
+{
+  static const JOCTET eoi[2] = { 0xFF, JPEG_EOI };
+
+  WARNMS(cinfo, JWRN_JPEG_EOF);
+  cinfo->src->next_input_byte = eoi;
+  cinfo->src->bytes_in_buffer = sizeof(eoi);
+  return TRUE;
+}
+
+static void swenc_test_src_skip(j_decompress_ptr cinfo, long num_bytes)
+{
+  if (num_bytes <= 0) {
+    return;
+  }
+  if ((size_t)num_bytes > cinfo->src->bytes_in_buffer) {
+    swenc_test_src_fill(cinfo);
+    return;
+  }
+  cinfo->src->next_input_byte += num_bytes;
+  cinfo->src->bytes_in_buffer -= num_bytes;
+}
+
+static void swenc_test_src_term(j_decompress_ptr cinfo)
+{
+  (void)cinfo;
+}
+
+/*==============================================================================
+* Function : swenc_test_decode
+* Parameters: p_data, size - encoded image, p_out - decoded image
+* Return Value : 0 on success, -1 on error
+* Description: Decodes a jpeg held in memory into YCbCr samples with the
+* platform libjpeg, without color conversion
+==============================================================================*/
+static int swenc_test_decode(const OMX_U8 *p_data, OMX_U32 size,
+  swenc_test_decoded_t *p_out)
+{
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_source_mgr src;
+  swenc_test_jpeg_err_t err;
+  JSAMPROW row;
+  size_t row_size;
+
+  memset(p_out, 0, sizeof(*p_out));
+  cinfo.err = jpeg_std_error(&err.pub);
+  err.pub.error_exit = swenc_test_jpeg_error_exit;
+  if (setjmp(err.jmp)) {
+    jpeg_destroy_decompress(&cinfo);
+    free(p_out->p_pix);
+    p_out->p_pix = NULL;
+    return -1;
+  }
+  jpeg_create_decompress(&cinfo);
+
+  memset(&src, 0, sizeof(src));
+  src.init_source = swenc_test_src_init;
+  src.fill_input_buffer = swenc_test_src_fill;
+  src.skip_input_data = swenc_test_src_skip;
+  src.resync_to_restart = jpeg_resync_to_restart;
+  src.term_source = swenc_test_src_term;
+  src.next_input_byte = p_data;
+  src.bytes_in_buffer = size;
+  cinfo.src = &src;
+
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_YCbCr;
+  jpeg_start_decompress(&cinfo);
+  p_out->width = cinfo.output_width;
+  p_out->height = cinfo.output_height;
+  p_out->restart_interval = cinfo.restart_interval;
+  row_size = (size_t)cinfo.output_width * cinfo.output_components;
+  p_out->p_pix = malloc(row_size * cinfo.output_height);
+  if (!p_out->p_pix) {
+    ERREXIT(&cinfo, JERR_OUT_OF_MEMORY);
+  }
+  while (cinfo.output_scanline < cinfo.output_height) {
+    row = p_out->p_pix + row_size * cinfo.output_scanline;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  p_out->warnings = err.pub.num_warnings;
+  jpeg_destroy_decompress(&cinfo);
+  return 0;
+}
+
+/*==============================================================================
+* Function : swenc_test_bench
+* Parameters: p_args
+* Return Value : 0 if every band encode decodes like the single session one
+* Description: Runs the serial and the parallel encode at each benchmark
+* size, reports the speedup and compares the decoded images
+==============================================================================*/
+static int swenc_test_bench(swenc_test_args_t *p_args)
+{
+  swenc_test_args_t args = *p_args;
+  swenc_test_decoded_t dec[2];
+  swenc_test_t test;
+  double lat[2];
+  OMX_U32 i, m;
+  int same, rc = 0;
+
+  for (i = 0; i < sizeof(g_bench_sizes) / sizeof(g_bench_sizes[0]); i++) {
+    args.width = g_bench_sizes[i].width;
+    args.height = g_bench_sizes[i].height;
+    memset(dec, 0, sizeof(dec));
+
+    for (m = 0; m < 2; m++) {
+      args.parallel = (int)m;
+      if (swenc_test_encode(&test, &args) ||
+        swenc_test_decode(test.p_out, test.filled, &dec[m])) {
+        fprintf(stderr, "%s %s encode failed\n", g_bench_sizes[i].name,
+          m ? "parallel" : "serial");
+        rc = -1;
+      }
+      lat[m] = test.lat_avg_ms;
+      swenc_test_release(&test);
+    }
+
+    same = dec[0].p_pix && dec[1].p_pix &&
+      (dec[0].width == dec[1].width) && (dec[0].height == dec[1].height) &&
+      !dec[0].warnings && !dec[1].warnings &&
+      !memcmp(dec[0].p_pix, dec[1].p_pix,
+        (size_t)dec[0].width * dec[0].height * 3);
+    printf("%-5s %ux%u: single %.2f ms, bands %.2f ms (restart interval "
+      "%u), speedup %.2fx, decode %s\n", g_bench_sizes[i].name,
+      args.width, args.height, lat[0], lat[1], dec[1].restart_interval,
+      lat[1] > 0 ? lat[0] / lat[1] : 0.0, same ? "identical" : "MISMATCH");
+    if (!same) {
+      rc = -1;
+    }
+    if (!dec[1].restart_interval) {
+      fprintf(stderr, "%s: no restart markers, band path did not run\n",
+        g_bench_sizes[i].name);
+      rc = -1;
+    }
+    free(dec[0].p_pix);
+    free(dec[1].p_pix);
+  }
+  return rc;
+}
+
+static void swenc_test_usage(const char *name)
+{
+  printf("Usage: %s [options]\n"
+    "  -W width        main image width (default 4000)\n"
+    "  -H height       main image height (default 3000)\n"
+    "  -n jobs         number of jobs (default 10)\n"
+    "  -q quality      main image quality (default 85)\n"
+    "  -r rotation     0, 90, 180 or 270\n"
+    "  -p              encode the main image in parallel bands\n"
+    "  -s              high speed (fast DCT) mode\n"
+    "  -T              no thumbnail\n"
+    "  -b              band vs single session benchmark at 8/13/21 MP\n"
+    "                  with decode equivalence check\n"
+    "  -j threads      encoder threads (default: CPU count, 4 with -b)\n"
+    "  -i file         NV21 input, synthetic image when omitted\n"
+    "  -o file         write the last encoded image\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+  swenc_test_args_t args;
+  swenc_test_t test;
+  int opt, rc = 1;
+
+  memset(&args, 0, sizeof(args));
+  args.width = 4000;
+  args.height = 3000;
+  args.iters = 10;
+  args.quality = 85;
+  args.thumb = 1;
+
+  while ((opt = getopt(argc, argv, "W:H:n:q:r:psTbj:i:o:")) != -1) {
+    switch (opt) {
+    case 'W': args.width = (OMX_U32)atoi(optarg); break;
+    case 'H': args.height = (OMX_U32)atoi(optarg); break;
+    case 'n': args.iters = (OMX_U32)atoi(optarg); break;
+    case 'q': args.quality = (OMX_U32)atoi(optarg); break;
+    case 'r': args.rotation = (OMX_U32)atoi(optarg); break;
+    case 'p': args.parallel = 1; break;
+    case 's': args.high_speed = 1; break;
+    case 'T': args.thumb = 0; break;
+    case 'b': args.bench = 1; break;
+    case 'j': args.threads = (OMX_U32)atoi(optarg); break;
+    case 'i': args.in_file = optarg; break;
+    case 'o': args.out_file = optarg; break;
+    default:
+      swenc_test_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!args.width || !args.height || (args.width & 1) ||
+    (args.height & 1) || !args.iters || (args.bench && args.in_file)) {
+    swenc_test_usage(argv[0]);
+    return 1;
+  }
+  if (args.bench && !args.threads) {
+    /* the band path needs a second thread regardless of the host CPUs */
+    args.threads = 4;
+  }
+
+  if (OMX_ErrorNone != OMX_Init()) {
+    fprintf(stderr, "OMX_Init failed\n");
+    return 1;
+  }
+  if (args.bench) {
+    rc = swenc_test_bench(&args) ? 1 : 0;
+  } else {
+    rc = swenc_test_encode(&test, &args) ? 1 : 0;
+    swenc_test_release(&test);
+  }
+  OMX_Deinit();
+  return rc;
+}